@@ -6,6 +6,7 @@
 #include "../core/api-build_p.h"
 #if !defined(ASMJIT_NO_AARCH64)
 
+#include "../core/codesizereport.h"
 #include "../core/codewriter_p.h"
 #include "../core/cpuinfo.h"
 #include "../core/emitterutils_p.h"
@@ -4897,14 +4898,15 @@ EmitOp_Rel:
         // TODO: [ARM] Always create relocation entry.
       }
 
-      if (label->isBoundTo(_section)) {
+      uint64_t labelBoundOffset;
+      if (_code->labelBinding(label, &labelBoundOffset) == _section) {
         // Label bound to the current section.
-        offsetValue = label->offset() - uint64_t(offset()) + uint64_t(labelOffset);
+        offsetValue = labelBoundOffset - uint64_t(offset()) + uint64_t(labelOffset);
         goto EmitOp_DispImm;
       }
       else {
         // Record non-bound label.
-        size_t codeOffset = writer.offsetFrom(_bufferData);
+        size_t codeOffset = _bufferOffset + writer.offsetFrom(_bufferData);
         LabelLink* link = _code->newLabelLink(label, _section->id(), codeOffset, intptr_t(labelOffset), offsetFormat);
 
         if (ASMJIT_UNLIKELY(!link))
@@ -4919,7 +4921,7 @@ EmitOp_Rel:
     uint64_t baseAddress = _code->baseAddress();
     uint64_t targetOffset = rmRel->as<Imm>().valueAs<uint64_t>();
 
-    size_t codeOffset = writer.offsetFrom(_bufferData);
+    size_t codeOffset = _bufferOffset + writer.offsetFrom(_bufferData);
 
     if (baseAddress == Globals::kNoBaseAddress || _section->id() != 0) {
       // Create a new RelocEntry as we cannot calculate the offset right now.
@@ -4991,6 +4993,16 @@ EmitOp:
 
 EmitDone:
   if (Support::test(options, InstOptions::kReserved)) {
+    CodeSizeReport* codeSizeReport = _code->codeSizeReport();
+    if (codeSizeReport) {
+      // Instructions have a fixed size, all bytes are opcode bytes.
+      size_t instSize = size_t(writer.cursor() - _bufferPtr);
+      err = codeSizeReport->_addInst(arch(), instId, instInfo->_encoding, instSize, Inst::_kIdCount, InstDB::kEncodingSimdTblTbx + 1u);
+      if (ASMJIT_UNLIKELY(err))
+        goto Failed;
+      codeSizeReport->_addBytes(CodeSizeCategory::kOpcode, instSize);
+    }
+
 #ifndef ASMJIT_NO_LOGGING
     if (_logger)
       EmitterUtils::logInstructionEmitted(this, BaseInst::composeARMInstId(instId, instCC), options, o0, o1, o2, opExt, 0, 0, writer.cursor());
@@ -5062,6 +5074,9 @@ Error Assembler::align(AlignMode alignMode, uint32_t alignment) {
   CodeWriter writer(this);
   ASMJIT_PROPAGATE(writer.ensureSpace(this, i));
 
+  if (_code->codeSizeReport())
+    _code->codeSizeReport()->_addBytes(CodeSizeCategory::kAlignment, i);
+
   switch (alignMode) {
     case AlignMode::kCode: {
       uint32_t pattern = kNopA64;
@@ -0,0 +1,85 @@
+// This file is part of AsmJit project <https://asmjit.com>
+//
+// See asmjit.h or LICENSE.md for license and copyright information
+// SPDX-License-Identifier: Zlib
+
+#include "../core/api-build_p.h"
+#if !defined(ASMJIT_NO_AARCH64) && !defined(ASMJIT_NO_COMPILER)
+
+#include "../arm/a64cfgsimplifypass_p.h"
+
+ASMJIT_BEGIN_SUB_NAMESPACE(a64)
+
+// a64::ARMCFGSimplifyPass - Construction & Destruction
+// ====================================================
+
+ARMCFGSimplifyPass::ARMCFGSimplifyPass(bool afterRA) noexcept
+  : BaseCFGSimplifyPass(afterRA ? "ARMCFGSimplifyPass(PostRA)" : "ARMCFGSimplifyPass") {}
+ARMCFGSimplifyPass::~ARMCFGSimplifyPass() noexcept {}
+
+// a64::ARMCFGSimplifyPass - Interface
+// ===================================
+
+InstControlFlow ARMCFGSimplifyPass::controlFlow(const InstNode* node) const noexcept {
+  InstId instId = node->id();
+
+  switch (BaseInst::extractRealId(instId)) {
+    case Inst::kIdB:
+    case Inst::kIdBr:
+      if (BaseInst::extractARMCondCode(instId) == CondCode::kAL)
+        return InstControlFlow::kJump;
+      else
+        return InstControlFlow::kBranch;
+    case Inst::kIdBl:
+    case Inst::kIdBlr:
+      return InstControlFlow::kCall;
+    case Inst::kIdCbz:
+    case Inst::kIdCbnz:
+    case Inst::kIdTbz:
+    case Inst::kIdTbnz:
+      return InstControlFlow::kBranch;
+    case Inst::kIdRet:
+      return InstControlFlow::kReturn;
+    default:
+      return InstControlFlow::kRegular;
+  }
+}
+
+bool ARMCFGSimplifyPass::canInvertBranch(const InstNode* node) const noexcept {
+  InstId instId = node->id();
+
+  switch (BaseInst::extractRealId(instId)) {
+    case Inst::kIdB: {
+      CondCode cond = BaseInst::extractARMCondCode(instId);
+      return cond != CondCode::kAL && cond != CondCode::kNA;
+    }
+    case Inst::kIdCbz:
+    case Inst::kIdCbnz:
+    case Inst::kIdTbz:
+    case Inst::kIdTbnz:
+      return true;
+    default:
+      return false;
+  }
+}
+
+void ARMCFGSimplifyPass::invertBranch(InstNode* node) noexcept {
+  InstId instId = node->id();
+
+  switch (BaseInst::extractRealId(instId)) {
+    case Inst::kIdB:
+      node->setId(BaseInst::composeARMInstId(Inst::kIdB, negateCond(BaseInst::extractARMCondCode(instId))));
+      break;
+    case Inst::kIdCbz : node->setId(Inst::kIdCbnz); break;
+    case Inst::kIdCbnz: node->setId(Inst::kIdCbz ); break;
+    case Inst::kIdTbz : node->setId(Inst::kIdTbnz); break;
+    case Inst::kIdTbnz: node->setId(Inst::kIdTbz ); break;
+    default:
+      ASMJIT_ASSERT(false);
+      break;
+  }
+}
+
+ASMJIT_END_SUB_NAMESPACE
+
+#endif // !ASMJIT_NO_AARCH64 && !ASMJIT_NO_COMPILER
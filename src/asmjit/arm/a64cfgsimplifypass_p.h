@@ -0,0 +1,52 @@
+// This file is part of AsmJit project <https://asmjit.com>
+//
+// See asmjit.h or LICENSE.md for license and copyright information
+// SPDX-License-Identifier: Zlib
+
+#ifndef ASMJIT_ARM_A64CFGSIMPLIFYPASS_P_H_INCLUDED
+#define ASMJIT_ARM_A64CFGSIMPLIFYPASS_P_H_INCLUDED
+
+#include "../core/api-config.h"
+#ifndef ASMJIT_NO_COMPILER
+
+#include "../core/cfgsimplifypass_p.h"
+#include "../arm/a64compiler.h"
+
+ASMJIT_BEGIN_SUB_NAMESPACE(a64)
+
+//! \cond INTERNAL
+//! \addtogroup asmjit_a64
+//! \{
+
+//! AArch64 control flow graph simplification pass, see \ref BaseCFGSimplifyPass.
+class ARMCFGSimplifyPass : public BaseCFGSimplifyPass {
+public:
+  ASMJIT_NONCOPYABLE(ARMCFGSimplifyPass)
+  typedef BaseCFGSimplifyPass Base;
+
+  //! \name Construction & Destruction
+  //! \{
+
+  //! Creates the pass, `afterRA` specifies whether the pass runs after the register allocation pass.
+  explicit ARMCFGSimplifyPass(bool afterRA) noexcept;
+  virtual ~ARMCFGSimplifyPass() noexcept;
+
+  //! \}
+
+  //! \name Interface
+  //! \{
+
+  InstControlFlow controlFlow(const InstNode* node) const noexcept override;
+  bool canInvertBranch(const InstNode* node) const noexcept override;
+  void invertBranch(InstNode* node) noexcept override;
+
+  //! \}
+};
+
+//! \}
+//! \endcond
+
+ASMJIT_END_SUB_NAMESPACE
+
+#endif // !ASMJIT_NO_COMPILER
+#endif // ASMJIT_ARM_A64CFGSIMPLIFYPASS_P_H_INCLUDED
@@ -7,8 +7,12 @@
 #if !defined(ASMJIT_NO_AARCH64) && !defined(ASMJIT_NO_COMPILER)
 
 #include "../arm/a64assembler.h"
+#include "../arm/a64cfgsimplifypass_p.h"
 #include "../arm/a64compiler.h"
 #include "../arm/a64emithelper_p.h"
+#include "../arm/a64ifconvertpass_p.h"
+#include "../arm/a64peepholepass_p.h"
+#include "../arm/a64phipass_p.h"
 #include "../arm/a64rapass_p.h"
 
 ASMJIT_BEGIN_SUB_NAMESPACE(a64)
@@ -30,7 +34,17 @@ Compiler::~Compiler() noexcept {}
 
 Error Compiler::onAttach(CodeHolder* code) noexcept {
   ASMJIT_PROPAGATE(Base::onAttach(code));
-  Error err = addPassT<ARMRAPass>();
+  Error err = addPassT<ARMPhiPass>();
+  if (!err)
+    err = addPassT<ARMIfConvertPass>();
+  if (!err)
+    err = addPassT<ARMCFGSimplifyPass>(false);
+  if (!err)
+    err = addPassT<ARMRAPass>();
+  if (!err)
+    err = addPassT<ARMCFGSimplifyPass>(true);
+  if (!err)
+    err = addPassT<ARMPeepholePass>();
 
   if (ASMJIT_UNLIKELY(err)) {
     onDetach(code);
@@ -166,6 +166,8 @@ public:
 
   //! Force the compiler to not follow the conditional or unconditional jump.
   inline Compiler& unfollow() noexcept { _instOptions |= InstOptions::kUnfollow; return *this; }
+  //! Tell the compiler that the conditional jump is unpredictable, see \ref InstOptions::kUnpredictable.
+  inline Compiler& unpredictable() noexcept { addInstOptions(InstOptions::kUnpredictable); return *this; }
 
   //! \}
 
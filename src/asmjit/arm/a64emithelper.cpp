@@ -306,7 +306,8 @@ ASMJIT_FAVOR_SIZE Error EmitHelper::emitProlog(const FuncFrame& frame) {
   PrologEpilogInfo pei;
   ASMJIT_PROPAGATE(pei.init(frame));
 
-  static const Support::Array<Reg, 2> groupRegs = {{ x0, d0 }};
+  // Vector registers are saved entirely only if the calling convention preserves all their bits.
+  const Support::Array<Reg, 2> groupRegs = {{ x0, frame.saveRestoreRegSize(RegGroup::kVec) > 8 ? Reg(q0) : Reg(d0) }};
   static const Support::Array<LoadStoreInstructions, 2> groupInsts = {{
     { Inst::kIdStr  , Inst::kIdStp   },
     { Inst::kIdStr_v, Inst::kIdStp_v }
@@ -372,7 +373,7 @@ ASMJIT_FAVOR_SIZE Error EmitHelper::emitEpilog(const FuncFrame& frame) {
   PrologEpilogInfo pei;
   ASMJIT_PROPAGATE(pei.init(frame));
 
-  static const Support::Array<Reg, 2> groupRegs = {{ x0, d0 }};
+  const Support::Array<Reg, 2> groupRegs = {{ x0, frame.saveRestoreRegSize(RegGroup::kVec) > 8 ? Reg(q0) : Reg(d0) }};
   static const Support::Array<LoadStoreInstructions, 2> groupInsts = {{
     { Inst::kIdLdr  , Inst::kIdLdp   },
     { Inst::kIdLdr_v, Inst::kIdLdp_v }
@@ -445,10 +446,20 @@ static Error ASMJIT_CDECL Emitter_emitArgsAssignment(BaseEmitter* emitter, const
   return emitHelper.emitArgsAssignment(frame, args);
 }
 
+static Error ASMJIT_CDECL Emitter_emitPreserveWrapper(BaseEmitter* emitter, const FuncFrame& frame, const void* target) {
+  // IP0 (x16) is an intra-procedure-call scratch register, which none of the calling conventions preserves.
+  EmitHelper emitHelper(emitter);
+  ASMJIT_PROPAGATE(emitHelper.emitProlog(frame));
+  ASMJIT_PROPAGATE(emitter->emit(Inst::kIdMov, x16, Imm(uint64_t(uintptr_t(target)))));
+  ASMJIT_PROPAGATE(emitter->emit(Inst::kIdBlr, x16));
+  return emitHelper.emitEpilog(frame);
+}
+
 void assignEmitterFuncs(BaseEmitter* emitter) {
   emitter->_funcs.emitProlog = Emitter_emitProlog;
   emitter->_funcs.emitEpilog = Emitter_emitEpilog;
   emitter->_funcs.emitArgsAssignment = Emitter_emitArgsAssignment;
+  emitter->_funcs.emitPreserveWrapper = Emitter_emitPreserveWrapper;
 
 #ifndef ASMJIT_NO_LOGGING
   emitter->_funcs.formatInstruction = FormatterInternal::formatInstruction;
@@ -58,6 +58,16 @@ ASMJIT_FAVOR_SIZE Error initCallConv(CallConv& cc, CallConvId ccId, const Enviro
     cc.setPreservedRegs(RegGroup::kGp, Support::bitMask(Gp::kIdOs, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30));
     cc.setPreservedRegs(RegGroup::kVec, Support::bitMask(8, 9, 10, 11, 12, 13, 14, 15));
   }
+  else if (ccId == CallConvId::kPreserveMost || ccId == CallConvId::kPreserveAll) {
+    cc.setId(ccId);
+    cc.setPreservedRegs(RegGroup::kGp, Support::bitMask(9, 10, 11, 12, 13, 14, 15, Gp::kIdOs, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30));
+    cc.setPreservedRegs(RegGroup::kVec, Support::bitMask(8, 9, 10, 11, 12, 13, 14, 15));
+
+    if (ccId == CallConvId::kPreserveAll) {
+      cc.setSaveRestoreRegSize(RegGroup::kVec, 16);
+      cc.setPreservedRegs(RegGroup::kVec, Support::lsbMask<uint32_t>(32) & ~Support::lsbMask<uint32_t>(8));
+    }
+  }
   else {
     cc.setId(ccId);
     cc.setSaveRestoreRegSize(RegGroup::kVec, 16);
@@ -0,0 +1,109 @@
+// This file is part of AsmJit project <https://asmjit.com>
+//
+// See asmjit.h or LICENSE.md for license and copyright information
+// SPDX-License-Identifier: Zlib
+
+#include "../core/api-build_p.h"
+#if !defined(ASMJIT_NO_AARCH64) && !defined(ASMJIT_NO_COMPILER)
+
+#include "../arm/a64compiler.h"
+#include "../arm/a64ifconvertpass_p.h"
+
+ASMJIT_BEGIN_SUB_NAMESPACE(a64)
+
+// a64::ARMIfConvertPass - Utilities
+// =================================
+
+static inline bool ARMIfConvertPass_isImm(const Operand& op, int64_t value) noexcept {
+  return op.isImm() && op.as<Imm>().value() == value;
+}
+
+// Converts `op` to a register that can be used by CSEL - zero is ZR and other immediates are moved to a new register.
+static Error ARMIfConvertPass_toReg(Compiler* cc, const Gp& dst, const Operand& op, Gp* out) noexcept {
+  if (op.isReg()) {
+    *out = op.as<Gp>();
+    return kErrorOk;
+  }
+
+  if (op.as<Imm>().value() == 0) {
+    *out = dst.isGpW() ? Gp(wzr) : Gp(xzr);
+    return kErrorOk;
+  }
+
+  ASMJIT_PROPAGATE(cc->_newReg(out, dst));
+  return cc->emit(Inst::kIdMov, *out, op);
+}
+
+// a64::ARMIfConvertPass - Construction & Destruction
+// ==================================================
+
+ARMIfConvertPass::ARMIfConvertPass() noexcept
+  : BaseIfConvertPass("ARMIfConvertPass") {}
+ARMIfConvertPass::~ARMIfConvertPass() noexcept {}
+
+// a64::ARMIfConvertPass - Interface
+// =================================
+
+bool ARMIfConvertPass::isCondJump(const InstNode* node, uint32_t* condOut) const noexcept {
+  InstId instId = node->id();
+  CondCode cond = BaseInst::extractARMCondCode(instId);
+
+  if (BaseInst::extractRealId(instId) != Inst::kIdB || cond == CondCode::kAL || cond == CondCode::kNA)
+    return false;
+
+  if (node->opCount() != 1 || !node->op(0).isLabel())
+    return false;
+
+  *condOut = uint32_t(cond);
+  return true;
+}
+
+bool ARMIfConvertPass::isJump(const InstNode* node) const noexcept {
+  return node->id() == Inst::kIdB && node->opCount() == 1 && node->op(0).isLabel();
+}
+
+bool ARMIfConvertPass::isMove(const InstNode* node) const noexcept {
+  if (node->id() != Inst::kIdMov || node->opCount() != 2)
+    return false;
+
+  // A 32-bit CSEL clears the upper part of 64-bit register even when the condition is false, so only moves that
+  // write the whole virtual register can be selected.
+  const Operand& dst = node->op(0);
+  const Operand& src = node->op(1);
+
+  if (!(Reg::isGpW(dst) || Reg::isGpX(dst)) || !cc()->isVirtIdValid(dst.id()))
+    return false;
+
+  if (cc()->virtRegById(dst.id())->virtSize() != dst.as<Reg>().size())
+    return false;
+
+  if (src.isReg())
+    return src.as<Reg>().type() == dst.as<Reg>().type() && !src.as<Gp>().isSP();
+  else
+    return src.isImm();
+}
+
+Error ARMIfConvertPass::emitSelect(uint32_t cond, const Select& select) noexcept {
+  Compiler* cc = this->cc();
+  CondCode condCode = CondCode(cond);
+  Gp dst = select.dst.as<Gp>();
+
+  // Select of 1 and 0 is `cset` (an alias of `csinc dst, zr, zr, !cond`).
+  if (ARMIfConvertPass_isImm(select.taken, 1) && ARMIfConvertPass_isImm(select.notTaken, 0))
+    return cc->emit(Inst::kIdCset, dst, Imm(condCode));
+
+  if (ARMIfConvertPass_isImm(select.taken, 0) && ARMIfConvertPass_isImm(select.notTaken, 1))
+    return cc->emit(Inst::kIdCset, dst, Imm(negateCond(condCode)));
+
+  Gp taken;
+  Gp notTaken;
+
+  ASMJIT_PROPAGATE(ARMIfConvertPass_toReg(cc, dst, select.taken, &taken));
+  ASMJIT_PROPAGATE(ARMIfConvertPass_toReg(cc, dst, select.notTaken, &notTaken));
+
+  return cc->emit(Inst::kIdCsel, dst, taken, notTaken, Imm(condCode));
+}
+
+ASMJIT_END_SUB_NAMESPACE
+
+#endif // !ASMJIT_NO_AARCH64 && !ASMJIT_NO_COMPILER
@@ -0,0 +1,62 @@
+// This file is part of AsmJit project <https://asmjit.com>
+//
+// See asmjit.h or LICENSE.md for license and copyright information
+// SPDX-License-Identifier: Zlib
+
+#ifndef ASMJIT_ARM_A64IFCONVERTPASS_P_H_INCLUDED
+#define ASMJIT_ARM_A64IFCONVERTPASS_P_H_INCLUDED
+
+#include "../core/api-config.h"
+#ifndef ASMJIT_NO_COMPILER
+
+#include "../core/ifconvertpass_p.h"
+#include "../arm/a64compiler.h"
+
+ASMJIT_BEGIN_SUB_NAMESPACE(a64)
+
+//! \cond INTERNAL
+//! \addtogroup asmjit_a64
+//! \{
+
+//! AArch64 if-conversion pass.
+//!
+//! Converts branches marked by \ref InstOptions::kUnpredictable into `csel` and `cset` instructions.
+class ARMIfConvertPass : public BaseIfConvertPass {
+public:
+  ASMJIT_NONCOPYABLE(ARMIfConvertPass)
+  typedef BaseIfConvertPass Base;
+
+  //! \name Construction & Destruction
+  //! \{
+
+  ARMIfConvertPass() noexcept;
+  virtual ~ARMIfConvertPass() noexcept;
+
+  //! \}
+
+  //! \name Accessors
+  //! \{
+
+  //! Returns the compiler casted to `a64::Compiler`.
+  inline Compiler* cc() const noexcept { return static_cast<Compiler*>(_cb); }
+
+  //! \}
+
+  //! \name Interface
+  //! \{
+
+  bool isCondJump(const InstNode* node, uint32_t* condOut) const noexcept override;
+  bool isJump(const InstNode* node) const noexcept override;
+  bool isMove(const InstNode* node) const noexcept override;
+  Error emitSelect(uint32_t cond, const Select& select) noexcept override;
+
+  //! \}
+};
+
+//! \}
+//! \endcond
+
+ASMJIT_END_SUB_NAMESPACE
+
+#endif // !ASMJIT_NO_COMPILER
+#endif // ASMJIT_ARM_A64IFCONVERTPASS_P_H_INCLUDED
@@ -74,6 +74,124 @@ InstId InstInternal::stringToInstId(Arch arch, const char* s, size_t len) noexce
 
   return Inst::kIdNone;
 }
+
+// Names of `InstDB::EncodingId` values, see `encodingIdToString()`.
+static const char encodingNameData[] =
+  "None\0"
+  "BaseAddSub\0"
+  "BaseAdr\0"
+  "BaseAtDcIcTlbi\0"
+  "BaseAtomicCasp\0"
+  "BaseAtomicOp\0"
+  "BaseAtomicSt\0"
+  "BaseBfc\0"
+  "BaseBfi\0"
+  "BaseBfm\0"
+  "BaseBfx\0"
+  "BaseBranchCmp\0"
+  "BaseBranchReg\0"
+  "BaseBranchRel\0"
+  "BaseBranchTst\0"
+  "BaseCCmp\0"
+  "BaseCInc\0"
+  "BaseCSel\0"
+  "BaseCSet\0"
+  "BaseCmpCmn\0"
+  "BaseExtend\0"
+  "BaseExtract\0"
+  "BaseLdSt\0"
+  "BaseLdpStp\0"
+  "BaseLdxp\0"
+  "BaseLogical\0"
+  "BaseMov\0"
+  "BaseMovKNZ\0"
+  "BaseMrs\0"
+  "BaseMsr\0"
+  "BaseMvnNeg\0"
+  "BaseOp\0"
+  "BaseOpImm\0"
+  "BaseR\0"
+  "BaseRM_NoImm\0"
+  "BaseRM_SImm10\0"
+  "BaseRM_SImm9\0"
+  "BaseRR\0"
+  "BaseRRII\0"
+  "BaseRRR\0"
+  "BaseRRRR\0"
+  "BaseRev\0"
+  "BaseShift\0"
+  "BaseStx\0"
+  "BaseStxp\0"
+  "BaseSys\0"
+  "BaseTst\0"
+  "FSimdPair\0"
+  "FSimdSV\0"
+  "FSimdVV\0"
+  "FSimdVVV\0"
+  "FSimdVVVV\0"
+  "FSimdVVVe\0"
+  "ISimdPair\0"
+  "ISimdSV\0"
+  "ISimdVV\0"
+  "ISimdVVV\0"
+  "ISimdVVVI\0"
+  "ISimdVVVV\0"
+  "ISimdVVVVx\0"
+  "ISimdVVVe\0"
+  "ISimdVVVx\0"
+  "ISimdVVx\0"
+  "ISimdWWV\0"
+  "SimdBicOrr\0"
+  "SimdCmp\0"
+  "SimdDot\0"
+  "SimdDup\0"
+  "SimdFcadd\0"
+  "SimdFccmpFccmpe\0"
+  "SimdFcm\0"
+  "SimdFcmla\0"
+  "SimdFcmpFcmpe\0"
+  "SimdFcsel\0"
+  "SimdFcvt\0"
+  "SimdFcvtLN\0"
+  "SimdFcvtSV\0"
+  "SimdFmlal\0"
+  "SimdFmov\0"
+  "SimdIns\0"
+  "SimdLdNStN\0"
+  "SimdLdSt\0"
+  "SimdLdpStp\0"
+  "SimdLdurStur\0"
+  "SimdMov\0"
+  "SimdMoviMvni\0"
+  "SimdShift\0"
+  "SimdShiftES\0"
+  "SimdSm3tt\0"
+  "SimdSmovUmov\0"
+  "SimdSxtlUxtl\0"
+  "SimdTblTbx\0"
+  ;
+
+static const uint16_t encodingNameIndex[] = {
+  0, 5, 16, 24, 39, 54, 67, 80, 88, 96, 104, 112,
+  126, 140, 154, 168, 177, 186, 195, 204, 215, 226, 238, 247,
+  258, 267, 279, 287, 298, 306, 314, 325, 332, 342, 348, 361,
+  375, 388, 395, 404, 412, 421, 429, 439, 447, 456, 464, 472,
+  482, 490, 498, 507, 517, 527, 537, 545, 553, 562, 572, 582,
+  593, 603, 613, 622, 631, 642, 650, 658, 666, 676, 692, 700,
+  710, 724, 734, 743, 754, 765, 775, 784, 792, 803, 812, 823,
+  836, 844, 857, 867, 879, 889, 902, 915
+};
+static_assert(ASMJIT_ARRAY_SIZE(encodingNameIndex) == InstDB::kEncodingSimdTblTbx + 1u,
+              "InstDB::EncodingId: update 'encodingNameIndex' table");
+
+Error InstInternal::encodingIdToString(Arch arch, uint32_t encodingId, String& output) noexcept {
+  DebugUtils::unused(arch);
+
+  if (ASMJIT_UNLIKELY(encodingId >= ASMJIT_ARRAY_SIZE(encodingNameIndex)))
+    return DebugUtils::errored(kErrorInvalidArgument);
+
+  return output.append(encodingNameData + encodingNameIndex[encodingId]);
+}
 #endif // !ASMJIT_NO_TEXT
 
 // a64::InstInternal - Validate
@@ -20,6 +20,7 @@ namespace InstInternal {
 #ifndef ASMJIT_NO_TEXT
 Error ASMJIT_CDECL instIdToString(Arch arch, InstId instId, String& output) noexcept;
 InstId ASMJIT_CDECL stringToInstId(Arch arch, const char* s, size_t len) noexcept;
+Error ASMJIT_CDECL encodingIdToString(Arch arch, uint32_t encodingId, String& output) noexcept;
 #endif // !ASMJIT_NO_TEXT
 
 #ifndef ASMJIT_NO_VALIDATION
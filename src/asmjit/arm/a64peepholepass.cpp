@@ -0,0 +1,579 @@
+// This file is part of AsmJit project <https://asmjit.com>
+//
+// See asmjit.h or LICENSE.md for license and copyright information
+// SPDX-License-Identifier: Zlib
+
+#include "../core/api-build_p.h"
+#if !defined(ASMJIT_NO_AARCH64) && !defined(ASMJIT_NO_COMPILER)
+
+#include "../arm/a64peepholepass_p.h"
+
+ASMJIT_BEGIN_SUB_NAMESPACE(a64)
+
+// a64::ARMPeepholePass - Liveness
+// ===============================
+
+//! What is checked by `ARMPeepholePass_isUnused()` - either condition flags or a general purpose register.
+struct ARMLiveQuery {
+  bool flags;
+  uint32_t regId;
+};
+
+//! How an instruction accesses the queried flags or register.
+enum class ARMLiveAccess : uint32_t {
+  //! Not accessed.
+  kNone = 0,
+  //! Read (or possibly read, if unknown) before written.
+  kUse = 1,
+  //! Overwritten without being read.
+  kKill = 2
+};
+
+// Returns the next node that is not informative (comments are skipped).
+static BaseNode* ARMPeepholePass_nextNode(BaseNode* node) noexcept {
+  do {
+    node = node->next();
+  } while (node && node->isInformative());
+  return node;
+}
+
+static ARMLiveAccess ARMPeepholePass_flagsAccess(InstId instId) noexcept {
+  switch (BaseInst::extractRealId(instId)) {
+    case Inst::kIdB:
+      return BaseInst::extractARMCondCode(instId) == CondCode::kAL ? ARMLiveAccess::kNone : ARMLiveAccess::kUse;
+
+    case Inst::kIdAdc:
+    case Inst::kIdAdcs:
+    case Inst::kIdAxflag:
+    case Inst::kIdCcmn:
+    case Inst::kIdCcmp:
+    case Inst::kIdCfinv:
+    case Inst::kIdCinc:
+    case Inst::kIdCinv:
+    case Inst::kIdCneg:
+    case Inst::kIdCsel:
+    case Inst::kIdCset:
+    case Inst::kIdCsetm:
+    case Inst::kIdCsinc:
+    case Inst::kIdCsinv:
+    case Inst::kIdCsneg:
+    case Inst::kIdFccmp_v:
+    case Inst::kIdFccmpe_v:
+    case Inst::kIdFcsel_v:
+    case Inst::kIdMrs:
+    case Inst::kIdMsr:
+    case Inst::kIdNgc:
+    case Inst::kIdNgcs:
+    case Inst::kIdSbc:
+    case Inst::kIdSbcs:
+    case Inst::kIdSetf8:
+    case Inst::kIdSetf16:
+    case Inst::kIdXaflag:
+    case Inst::kIdBr:
+      return ARMLiveAccess::kUse;
+
+    case Inst::kIdAdds:
+    case Inst::kIdAnds:
+    case Inst::kIdBics:
+    case Inst::kIdCmn:
+    case Inst::kIdCmp:
+    case Inst::kIdFcmp_v:
+    case Inst::kIdFcmpe_v:
+    case Inst::kIdNegs:
+    case Inst::kIdSubs:
+    case Inst::kIdTst:
+    // Flags are not preserved across calls and returns.
+    case Inst::kIdBl:
+    case Inst::kIdBlr:
+    case Inst::kIdRet:
+      return ARMLiveAccess::kKill;
+
+    default:
+      return ARMLiveAccess::kNone;
+  }
+}
+
+static ARMLiveAccess ARMPeepholePass_regAccess(const InstNode* inst, uint32_t regId) noexcept {
+  InstId realId = BaseInst::extractRealId(inst->id());
+
+  // Calls read argument registers and clobber other caller-saved registers, returns read return values and registers
+  // that must be preserved for the caller, see AAPCS64.
+  if (realId == Inst::kIdBl || realId == Inst::kIdBlr || inst->type() == NodeType::kInvoke) {
+    if (regId <= 8)
+      return ARMLiveAccess::kUse;
+    if (regId <= 18 || regId == 30)
+      return ARMLiveAccess::kKill;
+  }
+  else if (realId == Inst::kIdRet) {
+    return regId >= 8 && regId <= 17 ? ARMLiveAccess::kKill : ARMLiveAccess::kUse;
+  }
+  else if (realId == Inst::kIdBr) {
+    return ARMLiveAccess::kUse;
+  }
+
+  InstRWInfo rwInfo;
+  if (InstAPI::queryRWInfo(Arch::kAArch64, inst->baseInst(), inst->operands(), inst->opCount(), &rwInfo) != kErrorOk)
+    return ARMLiveAccess::kUse;
+
+  bool written = false;
+  for (uint32_t i = 0; i < inst->opCount(); i++) {
+    const Operand& op = inst->op(i);
+
+    if (op.isReg()) {
+      if (!op.as<Reg>().isGp() || op.id() != regId)
+        continue;
+
+      const OpRWInfo& opRwInfo = rwInfo.operand(i);
+      if (opRwInfo.isRead())
+        return ARMLiveAccess::kUse;
+      written |= opRwInfo.isWrite();
+    }
+    else if (op.isMem()) {
+      const Mem& mem = op.as<Mem>();
+      if ((mem.hasBaseReg() && mem.baseId() == regId) || (mem.hasIndexReg() && mem.indexId() == regId))
+        return ARMLiveAccess::kUse;
+    }
+  }
+
+  return written ? ARMLiveAccess::kKill : ARMLiveAccess::kNone;
+}
+
+// Tests whether the queried flags or register are unused by code that follows `node` - each path that follows must
+// overwrite them before reading them. Returns false if that cannot be proven within the scan limits.
+static bool ARMPeepholePass_isUnused(BaseCompiler* cc, BaseNode* node, const ARMLiveQuery& query, uint32_t depth, uint32_t& budget) noexcept {
+  while ((node = node->next()) != nullptr) {
+    if (node->isInformative() || node->isLabel())
+      continue;
+
+    if (budget == 0 || !(node->type() == NodeType::kInst || node->type() == NodeType::kInvoke))
+      return false;
+    budget--;
+
+    InstNode* inst = node->as<InstNode>();
+    InstId instId = inst->id();
+    InstId realId = BaseInst::extractRealId(instId);
+
+    ARMLiveAccess access = query.flags ? ARMPeepholePass_flagsAccess(instId) : ARMPeepholePass_regAccess(inst, query.regId);
+    if (access != ARMLiveAccess::kNone)
+      return access == ARMLiveAccess::kKill;
+
+    bool isJump = realId == Inst::kIdB && BaseInst::extractARMCondCode(instId) == CondCode::kAL;
+    bool isBranch = (realId == Inst::kIdB && !isJump) ||
+                    realId == Inst::kIdCbz || realId == Inst::kIdCbnz ||
+                    realId == Inst::kIdTbz || realId == Inst::kIdTbnz;
+
+    if (isJump || isBranch) {
+      const Operand& target = inst->op(inst->opCount() - 1);
+      LabelNode* labelNode;
+
+      if (!target.isLabel() || cc->labelNodeOf(&labelNode, target.id()) != kErrorOk)
+        return false;
+
+      if (isJump) {
+        node = labelNode;
+        continue;
+      }
+
+      if (depth == 0 || !ARMPeepholePass_isUnused(cc, labelNode, query, depth - 1, budget))
+        return false;
+    }
+  }
+
+  return false;
+}
+
+// Tests whether flags are unused by both paths that follow the conditional branch `br` - its fall-through and its
+// target, which is only read by `br` itself before it's rewritten to a branch that doesn't read flags.
+static bool ARMPeepholePass_isFlagsUnusedAfterBranch(BaseCompiler* cc, InstNode* br) noexcept {
+  const Operand& target = br->op(br->opCount() - 1);
+  LabelNode* labelNode;
+
+  if (!target.isLabel() || cc->labelNodeOf(&labelNode, target.id()) != kErrorOk)
+    return false;
+
+  ARMLiveQuery query{true, 0};
+  uint32_t budget = ARMPeepholePass::kMaxScanNodes;
+
+  return ARMPeepholePass_isUnused(cc, br, query, ARMPeepholePass::kMaxScanDepth, budget) &&
+         ARMPeepholePass_isUnused(cc, labelNode, query, ARMPeepholePass::kMaxScanDepth - 1, budget);
+}
+
+static inline bool ARMPeepholePass_isRegUnused(BaseCompiler* cc, BaseNode* node, uint32_t regId) noexcept {
+  uint32_t budget = ARMPeepholePass::kMaxScanNodes;
+  return ARMPeepholePass_isUnused(cc, node, ARMLiveQuery{false, regId}, ARMPeepholePass::kMaxScanDepth, budget);
+}
+
+// a64::ARMPeepholePass - Utilities
+// ================================
+
+static inline bool ARMPeepholePass_isGp(const Operand& op) noexcept {
+  return op.isReg() && op.as<Reg>().isGp() && op.id() < Gp::kIdSp;
+}
+
+static inline bool ARMPeepholePass_isImm(const Operand& op, int64_t value) noexcept {
+  return op.isImm() && op.as<Imm>().value() == value;
+}
+
+static inline InstNode* ARMPeepholePass_nextInst(BaseNode* node) noexcept {
+  node = ARMPeepholePass_nextNode(node);
+  return node && node->type() == NodeType::kInst ? node->as<InstNode>() : nullptr;
+}
+
+static size_t ARMPeepholePass_nodeSize(const BaseNode* node) noexcept {
+  switch (node->type()) {
+    case NodeType::kInst:
+    case NodeType::kJump:
+    case NodeType::kInvoke:
+    case NodeType::kFuncRet:
+      return 4;
+    case NodeType::kAlign:
+      return node->as<AlignNode>()->alignment();
+    case NodeType::kEmbedData:
+      return node->as<EmbedDataNode>()->dataSize();
+    case NodeType::kEmbedLabel:
+    case NodeType::kEmbedLabelDelta:
+      return 8;
+    case NodeType::kConstPool:
+      return node->as<ConstPoolNode>()->size();
+    default:
+      return 0;
+  }
+}
+
+// Tests whether the branch `node` is at most `maxDistance` bytes from its target `labelId`.
+static bool ARMPeepholePass_isNear(BaseCompiler* cc, BaseNode* node, uint32_t labelId, uint32_t maxDistance) noexcept {
+  LabelNode* labelNode;
+  if (cc->labelNodeOf(&labelNode, labelId) != kErrorOk)
+    return false;
+
+  size_t distance = 0;
+  for (BaseNode* n = node; n && distance <= maxDistance; n = n->next()) {
+    if (n == labelNode)
+      return true;
+    distance += ARMPeepholePass_nodeSize(n);
+  }
+
+  distance = 0;
+  for (BaseNode* n = node; n && distance <= maxDistance; n = n->prev()) {
+    if (n == labelNode)
+      return true;
+    distance += ARMPeepholePass_nodeSize(n);
+  }
+
+  return false;
+}
+
+// a64::ARMPeepholePass - Rewrites
+// ===============================
+
+// `cmp r, #0; b.cond L` -> `cbz|cbnz|tbz|tbnz r, L` and `tst r, #(1 << n); b.cond L` -> `tbz|tbnz r, #n, L`.
+static bool ARMPeepholePass_fuseCompareBranch(BaseCompiler* cc, InstNode* cmp) noexcept {
+  InstId cmpId = cmp->id();
+  if (cmp->opCount() != 2 || !ARMPeepholePass_isGp(cmp->op(0)) || !cmp->op(1).isImm())
+    return false;
+
+  InstNode* br = ARMPeepholePass_nextInst(cmp);
+  if (!br || BaseInst::extractRealId(br->id()) != Inst::kIdB || br->opCount() != 1 || !br->op(0).isLabel())
+    return false;
+
+  const Gp& reg = cmp->op(0).as<Gp>();
+  uint32_t regBits = reg.size() * 8u;
+  uint64_t imm = cmp->op(1).as<Imm>().valueAs<uint64_t>();
+
+  InstId newId = Inst::kIdNone;
+  uint32_t bitIndex = 0;
+
+  switch (BaseInst::extractARMCondCode(br->id())) {
+    case CondCode::kEQ:
+    case CondCode::kNE: {
+      bool isEq = BaseInst::extractARMCondCode(br->id()) == CondCode::kEQ;
+      if (cmpId == Inst::kIdCmp && imm == 0) {
+        newId = isEq ? Inst::kIdCbz : Inst::kIdCbnz;
+      }
+      else if (cmpId == Inst::kIdTst && Support::isPowerOf2(imm) && Support::ctz(imm) < regBits) {
+        newId = isEq ? Inst::kIdTbz : Inst::kIdTbnz;
+        bitIndex = Support::ctz(imm);
+      }
+      break;
+    }
+
+    // Compared with zero the result is negative only if the sign bit is set (the overflow flag is never set).
+    case CondCode::kLT:
+    case CondCode::kMI:
+      if (cmpId == Inst::kIdCmp && imm == 0) {
+        newId = Inst::kIdTbnz;
+        bitIndex = regBits - 1u;
+      }
+      break;
+
+    case CondCode::kGE:
+    case CondCode::kPL:
+      if (cmpId == Inst::kIdCmp && imm == 0) {
+        newId = Inst::kIdTbz;
+        bitIndex = regBits - 1u;
+      }
+      break;
+
+    default:
+      break;
+  }
+
+  if (newId == Inst::kIdNone)
+    return false;
+
+  Label target = br->op(0).as<Label>();
+  bool isTestBranch = newId == Inst::kIdTbz || newId == Inst::kIdTbnz;
+
+  if (isTestBranch && !ARMPeepholePass_isNear(cc, br, target.id(), ARMPeepholePass::kMaxTestBranchDistance))
+    return false;
+
+  if (!ARMPeepholePass_isFlagsUnusedAfterBranch(cc, br))
+    return false;
+
+  br->setId(newId);
+  br->clearOptions(InstOptions::kShortForm);
+  br->setOp(0, reg);
+
+  if (isTestBranch) {
+    br->setOp(1, Imm(bitIndex));
+    br->setOp(2, target);
+    br->setOpCount(3);
+  }
+  else {
+    br->setOp(1, target);
+    br->setOpCount(2);
+  }
+
+  cc->removeNode(cmp);
+  return true;
+}
+
+// `and rd, rn, op; cmp rd, #0; b.cond L` -> `tst rn, op; b.cond L` or `ands rd, rn, op; b.cond L`.
+static bool ARMPeepholePass_fuseAndCompare(BaseCompiler* cc, InstNode* andInst) noexcept {
+  uint32_t opCount = andInst->opCount();
+  if (andInst->id() != Inst::kIdAnd || opCount < 3 || !ARMPeepholePass_isGp(andInst->op(0)))
+    return false;
+
+  const Gp& rd = andInst->op(0).as<Gp>();
+  InstNode* cmp = ARMPeepholePass_nextInst(andInst);
+
+  if (!cmp || cmp->id() != Inst::kIdCmp || cmp->opCount() != 2 || !ARMPeepholePass_isImm(cmp->op(1), 0))
+    return false;
+
+  if (!cmp->op(0).isReg() || cmp->op(0).as<Reg>() != rd)
+    return false;
+
+  // ANDS clears the carry flag, which CMP with zero sets, so the comparison can only be used by a branch that
+  // doesn't test the carry flag (the overflow flag is cleared by both).
+  InstNode* br = ARMPeepholePass_nextInst(cmp);
+  if (!br || BaseInst::extractRealId(br->id()) != Inst::kIdB)
+    return false;
+
+  switch (BaseInst::extractARMCondCode(br->id())) {
+    case CondCode::kEQ:
+    case CondCode::kNE:
+    case CondCode::kMI:
+    case CondCode::kPL:
+    case CondCode::kGE:
+    case CondCode::kLT:
+    case CondCode::kGT:
+    case CondCode::kLE:
+      break;
+
+    default:
+      return false;
+  }
+
+  if (!ARMPeepholePass_isFlagsUnusedAfterBranch(cc, br))
+    return false;
+
+  if (ARMPeepholePass_isRegUnused(cc, cmp, rd.id())) {
+    andInst->setId(Inst::kIdTst);
+    for (uint32_t i = 1; i < opCount; i++)
+      andInst->setOp(i - 1, andInst->op(i));
+    andInst->resetOpRange(opCount - 1, opCount);
+    andInst->setOpCount(opCount - 1);
+  }
+  else {
+    andInst->setId(Inst::kIdAnds);
+  }
+
+  cc->removeNode(cmp);
+  return true;
+}
+
+// `ldr|str rt, [rn]; add rn, rn, #imm` -> `ldr|str rt, [rn], #imm`.
+static bool ARMPeepholePass_foldPostIndex(BaseCompiler* cc, InstNode* inst) noexcept {
+  uint32_t opCount = inst->opCount();
+  bool isPair = false;
+
+  switch (inst->id()) {
+    case Inst::kIdLdr:
+    case Inst::kIdLdrb:
+    case Inst::kIdLdrh:
+    case Inst::kIdLdrsb:
+    case Inst::kIdLdrsh:
+    case Inst::kIdLdrsw:
+    case Inst::kIdStr:
+    case Inst::kIdStrb:
+    case Inst::kIdStrh:
+      if (opCount != 2)
+        return false;
+      break;
+
+    case Inst::kIdLdp:
+    case Inst::kIdStp:
+      if (opCount != 3)
+        return false;
+      isPair = true;
+      break;
+
+    default:
+      return false;
+  }
+
+  if (!inst->op(opCount - 1).isMem() || !inst->op(0).isReg())
+    return false;
+
+  const Mem& mem = inst->op(opCount - 1).as<Mem>();
+  if (!mem.hasBaseReg() || mem.hasIndex() || mem.offset() != 0 || !mem.isFixedOffset())
+    return false;
+
+  uint32_t baseId = mem.baseId();
+  for (uint32_t i = 0; i < opCount - 1u; i++)
+    if (inst->op(i).as<Reg>().isGp() && inst->op(i).id() == baseId)
+      return false;
+
+  InstNode* add = ARMPeepholePass_nextInst(inst);
+  if (!add || (add->id() != Inst::kIdAdd && add->id() != Inst::kIdSub) || add->opCount() != 3 || !add->op(2).isImm())
+    return false;
+
+  const Operand& addDst = add->op(0);
+  const Operand& addSrc = add->op(1);
+
+  if (!addDst.isReg() || !addDst.as<Reg>().isGpX() || addDst.id() != baseId || addSrc != addDst)
+    return false;
+
+  int64_t offset = add->op(2).as<Imm>().value();
+  if (add->id() == Inst::kIdSub)
+    offset = -offset;
+
+  if (isPair) {
+    int64_t scale = int64_t(inst->op(0).as<Reg>().size());
+    if (scale == 0 || offset % scale != 0 || !Support::isInt7(offset / scale))
+      return false;
+  }
+  else if (!Support::isInt9(offset)) {
+    return false;
+  }
+
+  Mem postIndex(mem);
+  postIndex.setOffset(offset);
+  postIndex.makePostIndex();
+
+  inst->setOp(opCount - 1, postIndex);
+  cc->removeNode(add);
+  return true;
+}
+
+// `mul rt, ra, rb; add|sub rd, rc, rt` -> `madd|msub rd, ra, rb, rc`.
+static bool ARMPeepholePass_fuseMulAdd(BaseCompiler* cc, InstNode* mul) noexcept {
+  if (mul->id() != Inst::kIdMul || mul->opCount() != 3)
+    return false;
+
+  for (uint32_t i = 0; i < 3; i++)
+    if (!ARMPeepholePass_isGp(mul->op(i)) || mul->op(i).as<Reg>().type() != mul->op(0).as<Reg>().type())
+      return false;
+
+  InstNode* add = ARMPeepholePass_nextInst(mul);
+  if (!add || (add->id() != Inst::kIdAdd && add->id() != Inst::kIdSub) || add->opCount() != 3 || add->opCapacity() < 4)
+    return false;
+
+  for (uint32_t i = 0; i < 3; i++)
+    if (!ARMPeepholePass_isGp(add->op(i)) || add->op(i).as<Reg>().type() != mul->op(0).as<Reg>().type())
+      return false;
+
+  uint32_t rt = mul->op(0).id();
+  Operand rc;
+
+  if (add->op(2).id() == rt && add->op(1).id() != rt)
+    rc = add->op(1);
+  else if (add->id() == Inst::kIdAdd && add->op(1).id() == rt && add->op(2).id() != rt)
+    rc = add->op(2);
+  else
+    return false;
+
+  if (add->op(0).id() != rt && !ARMPeepholePass_isRegUnused(cc, add, rt))
+    return false;
+
+  add->setId(add->id() == Inst::kIdAdd ? Inst::kIdMadd : Inst::kIdMsub);
+  add->setOp(1, mul->op(1));
+  add->setOp(2, mul->op(2));
+  add->setOp(3, rc);
+  add->setOpCount(4);
+
+  cc->removeNode(mul);
+  return true;
+}
+
+// a64::ARMPeepholePass - Construction & Destruction
+// =================================================
+
+ARMPeepholePass::ARMPeepholePass() noexcept
+  : Pass("ARMPeepholePass") {}
+ARMPeepholePass::~ARMPeepholePass() noexcept {}
+
+// a64::ARMPeepholePass - Run
+// ==========================
+
+Error ARMPeepholePass::run(Zone* zone, Logger* logger) {
+  DebugUtils::unused(zone, logger);
+
+  BaseCompiler* cc = this->cc();
+  if (!cc->hasCompilerOption(CompilerOptions::kPeephole))
+    return kErrorOk;
+
+  BaseNode* node = cc->firstNode();
+
+  while (node) {
+    if (node->type() != NodeType::kInst) {
+      node = node->next();
+      continue;
+    }
+
+    InstNode* inst = node->as<InstNode>();
+    BaseNode* prev = inst->prev();
+    bool changed = false;
+
+    switch (inst->id()) {
+      case Inst::kIdAnd:
+        changed = ARMPeepholePass_fuseAndCompare(cc, inst);
+        break;
+
+      case Inst::kIdCmp:
+      case Inst::kIdTst:
+        changed = ARMPeepholePass_fuseCompareBranch(cc, inst);
+        break;
+
+      case Inst::kIdMul:
+        changed = ARMPeepholePass_fuseMulAdd(cc, inst);
+        break;
+
+      default:
+        changed = ARMPeepholePass_foldPostIndex(cc, inst);
+        break;
+    }
+
+    // Revisit the rewritten code as it could match another rewrite (`and` + `cmp` produces `tst`, for example).
+    if (changed)
+      node = prev ? prev->next() : cc->firstNode();
+    else
+      node = node->next();
+  }
+
+  return kErrorOk;
+}
+
+ASMJIT_END_SUB_NAMESPACE
+
+#endif // !ASMJIT_NO_AARCH64 && !ASMJIT_NO_COMPILER
@@ -0,0 +1,80 @@
+// This file is part of AsmJit project <https://asmjit.com>
+//
+// See asmjit.h or LICENSE.md for license and copyright information
+// SPDX-License-Identifier: Zlib
+
+#ifndef ASMJIT_ARM_A64PEEPHOLEPASS_P_H_INCLUDED
+#define ASMJIT_ARM_A64PEEPHOLEPASS_P_H_INCLUDED
+
+#include "../core/api-config.h"
+#ifndef ASMJIT_NO_COMPILER
+
+#include "../core/compiler.h"
+#include "../arm/a64compiler.h"
+
+ASMJIT_BEGIN_SUB_NAMESPACE(a64)
+
+//! \cond INTERNAL
+//! \addtogroup asmjit_a64
+//! \{
+
+//! AArch64 peephole pass.
+//!
+//! Runs after the register allocator and rewrites adjacent instructions into shorter sequences:
+//!
+//!   - `cmp r, #0` followed by `b.eq|b.ne` to `cbz|cbnz r` and followed by `b.lt|b.ge|b.mi|b.pl` to `tbnz|tbz` of
+//!     the sign bit. `tst r, #(1 << n)` followed by `b.eq|b.ne` to `tbz|tbnz r, #n`.
+//!
+//!   - `and rd, rn, op` followed by `cmp rd, #0` to `tst rn, op` (or `ands rd, rn, op` if `rd` is used later) if the
+//!     comparison is only used by a branch that doesn't test the carry flag.
+//!
+//!   - Load or store `[rn]` followed by `add|sub rn, rn, #imm` to a post-index load or store `[rn], #imm`.
+//!
+//!   - `mul rt, ra, rb` followed by `add|sub rd, rc, rt` to `madd|msub rd, ra, rb, rc` if `rt` is not used later.
+//!
+//! Registers and flags are only considered unused if they are overwritten on all paths that follow before being read,
+//! which is checked by a bounded scan that uses RW information of instructions; anything the scan cannot prove
+//! keeps the code as is.
+class ARMPeepholePass : public Pass {
+public:
+  ASMJIT_NONCOPYABLE(ARMPeepholePass)
+  typedef Pass Base;
+
+  //! Maximum number of branches followed when checking whether a register or flags are unused.
+  static constexpr uint32_t kMaxScanDepth = 4;
+  //! Maximum number of instructions visited when checking whether a register or flags are unused.
+  static constexpr uint32_t kMaxScanNodes = 64;
+  //! Maximum distance in bytes between `tbz|tbnz` and its target (the instruction encodes +/-32KiB).
+  static constexpr uint32_t kMaxTestBranchDistance = 16384;
+
+  //! \name Construction & Destruction
+  //! \{
+
+  ARMPeepholePass() noexcept;
+  virtual ~ARMPeepholePass() noexcept;
+
+  //! \}
+
+  //! \name Accessors
+  //! \{
+
+  //! Returns the associated `a64::Compiler`.
+  inline Compiler* cc() const noexcept { return static_cast<Compiler*>(_cb); }
+
+  //! \}
+
+  //! \name Run
+  //! \{
+
+  Error run(Zone* zone, Logger* logger) override;
+
+  //! \}
+};
+
+//! \}
+//! \endcond
+
+ASMJIT_END_SUB_NAMESPACE
+
+#endif // !ASMJIT_NO_COMPILER
+#endif // ASMJIT_ARM_A64PEEPHOLEPASS_P_H_INCLUDED
@@ -0,0 +1,60 @@
+// This file is part of AsmJit project <https://asmjit.com>
+//
+// See asmjit.h or LICENSE.md for license and copyright information
+// SPDX-License-Identifier: Zlib
+
+#include "../core/api-build_p.h"
+#if !defined(ASMJIT_NO_AARCH64) && !defined(ASMJIT_NO_COMPILER)
+
+#include "../arm/a64emithelper_p.h"
+#include "../arm/a64phipass_p.h"
+
+ASMJIT_BEGIN_SUB_NAMESPACE(a64)
+
+// a64::ARMPhiPass - Construction & Destruction
+// ============================================
+
+ARMPhiPass::ARMPhiPass() noexcept
+  : BasePhiPass("ARMPhiPass") {}
+ARMPhiPass::~ARMPhiPass() noexcept {}
+
+// a64::ARMPhiPass - Interface
+// ===========================
+
+InstControlFlow ARMPhiPass::controlFlow(const InstNode* node) const noexcept {
+  InstId instId = node->id();
+
+  switch (BaseInst::extractRealId(instId)) {
+    case Inst::kIdB:
+    case Inst::kIdBr:
+      if (BaseInst::extractARMCondCode(instId) == CondCode::kAL)
+        return InstControlFlow::kJump;
+      else
+        return InstControlFlow::kBranch;
+    case Inst::kIdBl:
+    case Inst::kIdBlr:
+      return InstControlFlow::kCall;
+    case Inst::kIdCbz:
+    case Inst::kIdCbnz:
+    case Inst::kIdTbz:
+    case Inst::kIdTbnz:
+      return InstControlFlow::kBranch;
+    case Inst::kIdRet:
+      return InstControlFlow::kReturn;
+    default:
+      return InstControlFlow::kRegular;
+  }
+}
+
+Error ARMPhiPass::emitMove(const BaseReg& dst, const BaseReg& src, TypeId typeId) noexcept {
+  EmitHelper emitHelper(cc());
+  return emitHelper.emitRegMove(dst, src, typeId);
+}
+
+Error ARMPhiPass::emitJump(const Label& label) noexcept {
+  return cc()->emit(Inst::kIdB, label);
+}
+
+ASMJIT_END_SUB_NAMESPACE
+
+#endif // !ASMJIT_NO_AARCH64 && !ASMJIT_NO_COMPILER
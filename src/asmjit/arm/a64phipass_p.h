@@ -0,0 +1,51 @@
+// This file is part of AsmJit project <https://asmjit.com>
+//
+// See asmjit.h or LICENSE.md for license and copyright information
+// SPDX-License-Identifier: Zlib
+
+#ifndef ASMJIT_ARM_A64PHIPASS_P_H_INCLUDED
+#define ASMJIT_ARM_A64PHIPASS_P_H_INCLUDED
+
+#include "../core/api-config.h"
+#ifndef ASMJIT_NO_COMPILER
+
+#include "../core/phipass_p.h"
+#include "../arm/a64compiler.h"
+
+ASMJIT_BEGIN_SUB_NAMESPACE(a64)
+
+//! \cond INTERNAL
+//! \addtogroup asmjit_a64
+//! \{
+
+//! AArch64 phi node lowering pass, see \ref BasePhiPass.
+class ARMPhiPass : public BasePhiPass {
+public:
+  ASMJIT_NONCOPYABLE(ARMPhiPass)
+  typedef BasePhiPass Base;
+
+  //! \name Construction & Destruction
+  //! \{
+
+  ARMPhiPass() noexcept;
+  virtual ~ARMPhiPass() noexcept;
+
+  //! \}
+
+  //! \name Interface
+  //! \{
+
+  InstControlFlow controlFlow(const InstNode* node) const noexcept override;
+  Error emitMove(const BaseReg& dst, const BaseReg& src, TypeId typeId) noexcept override;
+  Error emitJump(const Label& label) noexcept override;
+
+  //! \}
+};
+
+//! \}
+//! \endcond
+
+ASMJIT_END_SUB_NAMESPACE
+
+#endif // !ASMJIT_NO_COMPILER
+#endif // ASMJIT_ARM_A64PHIPASS_P_H_INCLUDED
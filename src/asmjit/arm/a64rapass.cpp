@@ -311,6 +311,11 @@ Error RACFGBuilder::onInst(InstNode* inst, InstControlFlow& controlType, RAInstB
       }
     }
 
+    // A move of a whole 64-bit register can be removed if both registers are allocated to the same physical register
+    // (32-bit moves zero the upper half of the destination, so they are never removed).
+    if (instId == Inst::kIdMov && opCount == 2 && opArray[0].as<Reg>().isGpX() && opArray[1].as<Reg>().isGpX())
+      ib.addInstRWFlags(InstRWFlags::kMovOp);
+
     controlType = getControlFlowType(instId);
   }
 
@@ -675,6 +680,13 @@ ASMJIT_FAVOR_SPEED Error ARMRAPass::_rewrite(BaseNode* first, BaseNode* stop) no
         // prevent having a dead pointer after the RA pass is complete.
         node->resetPassData();
 
+        // Remove moves that do not do anything, which happens when the global allocator coalesced both registers.
+        if (raInst->hasInstRWFlag(InstRWFlags::kMovOp) && inst->op(0) == inst->op(1)) {
+          cc()->removeNode(node);
+          node = next;
+          continue;
+        }
+
         if (ASMJIT_UNLIKELY(node->type() != NodeType::kInst)) {
           // FuncRet terminates the flow, it must either be removed if the exit
           // label is next to it (optimization) or patched to an architecture
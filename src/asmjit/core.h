@@ -1829,6 +1829,7 @@ namespace asmjit {
 #include "core/assembler.h"
 #include "core/builder.h"
 #include "core/codeholder.h"
+#include "core/codesizereport.h"
 #include "core/compiler.h"
 #include "core/constpool.h"
 #include "core/cpuinfo.h"
@@ -1840,13 +1841,16 @@ namespace asmjit {
 #include "core/globals.h"
 #include "core/inst.h"
 #include "core/jitallocator.h"
+#include "core/jitmodule.h"
 #include "core/jitruntime.h"
 #include "core/logger.h"
+#include "core/memallocator.h"
 #include "core/operand.h"
 #include "core/osutils.h"
 #include "core/string.h"
 #include "core/support.h"
 #include "core/target.h"
+#include "core/telemetry.h"
 #include "core/type.h"
 #include "core/virtmem.h"
 #include "core/zone.h"
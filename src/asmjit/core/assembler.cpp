@@ -5,6 +5,7 @@
 
 #include "../core/api-build_p.h"
 #include "../core/assembler.h"
+#include "../core/codesizereport.h"
 #include "../core/codewriter_p.h"
 #include "../core/constpool.h"
 #include "../core/emitterutils_p.h"
@@ -30,10 +31,10 @@ Error BaseAssembler::setOffset(size_t offset) {
     return reportError(DebugUtils::errored(kErrorNotInitialized));
 
   size_t size = Support::max<size_t>(_section->bufferSize(), this->offset());
-  if (ASMJIT_UNLIKELY(offset > size))
+  if (ASMJIT_UNLIKELY(offset > size || offset < _bufferOffset))
     return reportError(DebugUtils::errored(kErrorInvalidArgument));
 
-  _bufferPtr = _bufferData + offset;
+  _bufferPtr = _bufferData + (offset - _bufferOffset);
   return kErrorOk;
 }
 
@@ -41,12 +42,14 @@ Error BaseAssembler::setOffset(size_t offset) {
 // ==================================
 
 static void BaseAssembler_initSection(BaseAssembler* self, Section* section) noexcept {
-  uint8_t* p = section->_buffer._data;
+  const CodeBuffer& buffer = section->_buffer;
+  uint8_t* p = buffer._data;
 
   self->_section = section;
   self->_bufferData = p;
-  self->_bufferPtr  = p + section->_buffer._size;
-  self->_bufferEnd  = p + section->_buffer._capacity;
+  self->_bufferPtr  = p + (buffer._size - buffer._segmentOffset);
+  self->_bufferEnd  = p + buffer._capacity;
+  self->_bufferOffset = buffer._segmentOffset;
 }
 
 Error BaseAssembler::section(Section* section) {
@@ -115,6 +118,12 @@ Error BaseAssembler::bind(const Label& label) {
 // BaseAssembler - Embed
 // =====================
 
+static inline void BaseAssembler_addCodeSize(BaseAssembler* self, CodeSizeCategory category, size_t size) noexcept {
+  CodeSizeReport* report = self->code()->codeSizeReport();
+  if (ASMJIT_UNLIKELY(report))
+    report->_addBytes(category, size);
+}
+
 Error BaseAssembler::embed(const void* data, size_t dataSize) {
   if (ASMJIT_UNLIKELY(!_code))
     return reportError(DebugUtils::errored(kErrorNotInitialized));
@@ -127,6 +136,7 @@ Error BaseAssembler::embed(const void* data, size_t dataSize) {
 
   writer.emitData(data, dataSize);
   writer.done(this);
+  BaseAssembler_addCodeSize(this, CodeSizeCategory::kData, dataSize);
 
 #ifndef ASMJIT_NO_LOGGING
   if (_logger) {
@@ -166,6 +176,7 @@ Error BaseAssembler::embedDataArray(TypeId typeId, const void* data, size_t item
     writer.emitData(data, dataSize);
 
   writer.done(this);
+  BaseAssembler_addCodeSize(this, CodeSizeCategory::kData, totalSize);
 
 #ifndef ASMJIT_NO_LOGGING
   if (_logger) {
@@ -217,6 +228,7 @@ Error BaseAssembler::embedConstPool(const Label& label, const ConstPool& pool) {
   pool.fill(writer.cursor());
   writer.advance(size);
   writer.done(this);
+  BaseAssembler_addCodeSize(this, CodeSizeCategory::kConstPool, size);
 
 #ifndef ASMJIT_NO_LOGGING
   if (_logger) {
@@ -273,24 +285,26 @@ Error BaseAssembler::embedLabel(const Label& label, size_t dataSize) {
   re->_sourceOffset = offset();
   re->_format.resetToSimpleValue(OffsetType::kUnsignedOffset, dataSize);
 
-  if (le->isBound()) {
-    re->_targetSectionId = le->section()->id();
-    re->_payload = le->offset();
+  uint64_t labelOffset;
+  Section* labelSection = _code->labelBinding(le, &labelOffset);
+
+  if (labelSection) {
+    re->_targetSectionId = labelSection->id();
+    re->_payload = labelOffset;
   }
   else {
     OffsetFormat of;
     of.resetToSimpleValue(OffsetType::kUnsignedOffset, dataSize);
 
-    LabelLink* link = _code->newLabelLink(le, _section->id(), offset(), 0, of);
+    LabelLink* link = _code->newLabelLink(le, _section->id(), offset(), 0, of, re->id());
     if (ASMJIT_UNLIKELY(!link))
       return reportError(DebugUtils::errored(kErrorOutOfMemory));
-
-    link->relocId = re->id();
   }
 
   // Emit dummy DWORD/QWORD depending on the data size.
   writer.emitZeros(dataSize);
   writer.done(this);
+  BaseAssembler_addCodeSize(this, CodeSizeCategory::kData, dataSize);
 
   return kErrorOk;
 }
@@ -328,9 +342,14 @@ Error BaseAssembler::embedLabelDelta(const Label& label, const Label& base, size
   }
 #endif
 
+  uint64_t labelOffset;
+  uint64_t baseOffset;
+  Section* labelSection = _code->labelBinding(labelEntry, &labelOffset);
+  Section* baseSection = _code->labelBinding(baseEntry, &baseOffset);
+
   // If both labels are bound within the same section it means the delta can be calculated now.
-  if (labelEntry->isBound() && baseEntry->isBound() && labelEntry->section() == baseEntry->section()) {
-    uint64_t delta = labelEntry->offset() - baseEntry->offset();
+  if (labelSection && labelSection == baseSection) {
+    uint64_t delta = labelOffset - baseOffset;
     writer.emitValueLE(delta, dataSize);
   }
   else {
@@ -339,11 +358,7 @@ Error BaseAssembler::embedLabelDelta(const Label& label, const Label& base, size
     if (ASMJIT_UNLIKELY(err))
       return reportError(err);
 
-    Expression* exp = _code->_zone.newT<Expression>();
-    if (ASMJIT_UNLIKELY(!exp))
-      return reportError(DebugUtils::errored(kErrorOutOfMemory));
-
-    exp->reset();
+    Expression* exp = re->payloadAsExpression();
     exp->opType = ExpressionOpType::kSub;
     exp->setValueAsLabel(0, labelEntry);
     exp->setValueAsLabel(1, baseEntry);
@@ -351,12 +366,12 @@ Error BaseAssembler::embedLabelDelta(const Label& label, const Label& base, size
     re->_format.resetToSimpleValue(OffsetType::kSignedOffset, dataSize);
     re->_sourceSectionId = _section->id();
     re->_sourceOffset = offset();
-    re->_payload = (uint64_t)(uintptr_t)exp;
 
     writer.emitZeros(dataSize);
   }
 
   writer.done(this);
+  BaseAssembler_addCodeSize(this, CodeSizeCategory::kData, dataSize);
   return kErrorOk;
 }
 
@@ -400,6 +415,7 @@ Error BaseAssembler::onDetach(CodeHolder* code) noexcept {
   _bufferData = nullptr;
   _bufferEnd  = nullptr;
   _bufferPtr  = nullptr;
+  _bufferOffset = 0;
   return Base::onDetach(code);
 }
 
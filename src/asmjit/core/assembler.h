@@ -38,6 +38,8 @@ public:
   uint8_t* _bufferEnd = nullptr;
   //! Pointer in the CodeBuffer of the current section.
   uint8_t* _bufferPtr = nullptr;
+  //! Offset of `_bufferData` from the start of the current section (non-zero if the CodeBuffer is segmented).
+  size_t _bufferOffset = 0;
 
   //! \name Construction & Destruction
   //! \{
@@ -53,21 +55,24 @@ public:
   //! \{
 
   //! Returns the capacity of the current CodeBuffer.
-  inline size_t bufferCapacity() const noexcept { return (size_t)(_bufferEnd - _bufferData); }
+  inline size_t bufferCapacity() const noexcept { return _bufferOffset + (size_t)(_bufferEnd - _bufferData); }
   //! Returns the number of remaining bytes in the current CodeBuffer.
   inline size_t remainingSpace() const noexcept { return (size_t)(_bufferEnd - _bufferPtr); }
 
   //! Returns the current position in the CodeBuffer.
-  inline size_t offset() const noexcept { return (size_t)(_bufferPtr - _bufferData); }
+  inline size_t offset() const noexcept { return _bufferOffset + (size_t)(_bufferPtr - _bufferData); }
 
   //! Sets the current position in the CodeBuffer to `offset`.
   //!
   //! \note The `offset` cannot be greater than buffer size even if it's
-  //! within the buffer's capacity.
+  //! within the buffer's capacity. If the CodeBuffer is segmented, the
+  //! `offset` cannot point to a closed segment either.
   ASMJIT_API Error setOffset(size_t offset);
 
-  //! Returns the start of the CodeBuffer in the current section.
+  //! Returns the start of the CodeBuffer in the current section (the start of its active segment if it's segmented).
   inline uint8_t* bufferData() const noexcept { return _bufferData; }
+  //! Returns the offset of \ref bufferData() from the start of the current section.
+  inline size_t bufferOffset() const noexcept { return _bufferOffset; }
   //! Returns the end (first invalid byte) in the current section.
   inline uint8_t* bufferEnd() const noexcept { return _bufferEnd; }
   //! Returns the current pointer in the CodeBuffer in the current section.
@@ -12,6 +12,7 @@
 #include "../core/formatter.h"
 #include "../core/logger.h"
 #include "../core/support.h"
+#include "../core/telemetry_p.h"
 
 ASMJIT_BEGIN_NAMESPACE
 
@@ -40,6 +41,20 @@ static void BaseBuilder_deletePasses(BaseBuilder* self) noexcept {
   self->_passes.reset();
 }
 
+static size_t BaseBuilder_countInstNodes(const BaseBuilder* self) noexcept {
+  size_t count = 0;
+  for (const BaseNode* node = self->firstNode(); node; node = node->next())
+    count += size_t(node->isInst());
+  return count;
+}
+
+static size_t BaseBuilder_sumBufferSizes(const CodeHolder* code) noexcept {
+  size_t size = 0;
+  for (const Section* section : code->sections())
+    size += section->bufferSize();
+  return size;
+}
+
 // BaseBuilder - Construction & Destruction
 // ========================================
 
@@ -552,6 +567,10 @@ Error BaseBuilder::runPasses() {
   if (_passes.empty())
     return kErrorOk;
 
+  TelemetrySink* telemetrySink = _code->telemetrySink();
+  TelemetryScope telemetry(telemetrySink, TelemetryStage::kRunPasses, _code, nullptr,
+                           telemetrySink ? BaseBuilder_countInstNodes(this) : 0u);
+
   ErrorHandler* prev = errorHandler();
   PostponedErrorHandler postponed;
 
@@ -559,6 +578,8 @@ Error BaseBuilder::runPasses() {
   setErrorHandler(&postponed);
 
   for (Pass* pass : _passes) {
+    TelemetryScope passTelemetry(telemetrySink, TelemetryStage::kRunPass, _code, pass->name());
+
     _passZone.reset();
     err = pass->run(&_passZone, _logger);
     if (err)
@@ -567,6 +588,9 @@ Error BaseBuilder::runPasses() {
   _passZone.reset();
   setErrorHandler(prev);
 
+  if (telemetry.isActive())
+    telemetry.setInstCount(BaseBuilder_countInstNodes(this));
+
   if (ASMJIT_UNLIKELY(err))
     return reportError(err, !postponed._message.empty() ? postponed._message.data() : nullptr);
 
@@ -758,6 +782,11 @@ Error BaseBuilder::serializeTo(BaseEmitter* dst) {
   Error err = kErrorOk;
   BaseNode* node_ = _firstNode;
 
+  CodeHolder* dstCode = dst->code();
+  TelemetryScope telemetry(_code ? _code->telemetrySink() : nullptr, TelemetryStage::kSerialize, _code);
+  size_t instCount = 0;
+  size_t bufferSize = telemetry.isActive() && dstCode ? BaseBuilder_sumBufferSizes(dstCode) : size_t(0);
+
   Operand_ opArray[Globals::kMaxOpCount];
 
   do {
@@ -790,6 +819,7 @@ Error BaseBuilder::serializeTo(BaseEmitter* dst) {
       }
 
       err = dst->_emit(node->id(), op[0], op[1], op[2], opExt);
+      instCount++;
     }
     else if (node_->isLabel()) {
       if (node_->isConstPool()) {
@@ -830,6 +860,12 @@ Error BaseBuilder::serializeTo(BaseEmitter* dst) {
     node_ = node_->next();
   } while (node_);
 
+  if (telemetry.isActive()) {
+    telemetry.setInstCount(instCount);
+    if (dstCode)
+      telemetry.setByteCount(BaseBuilder_sumBufferSizes(dstCode) - bufferSize);
+  }
+
   return err;
 }
 
@@ -839,6 +875,11 @@ Error BaseBuilder::serializeTo(BaseEmitter* dst) {
 Error BaseBuilder::onAttach(CodeHolder* code) noexcept {
   ASMJIT_PROPAGATE(Base::onAttach(code));
 
+  // Zones of the Builder allocate their blocks through the memory allocator of the CodeHolder.
+  _codeZone.setMemAllocator(code->memAllocator());
+  _dataZone.setMemAllocator(code->memAllocator());
+  _passZone.setMemAllocator(code->memAllocator());
+
   SectionNode* initialSection;
   Error err = sectionNodeOf(&initialSection, 0);
 
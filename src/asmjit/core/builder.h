@@ -79,6 +79,10 @@ enum class NodeType : uint8_t {
   kFuncRet = 17,
   //! Node is \ref InvokeNode (acts as InstNode).
   kInvoke = 18,
+  //! Node is \ref PhiNode.
+  kPhi = 19,
+  //! Node is \ref OsrEntryNode (acts as LabelNode).
+  kOsrEntry = 20,
 
   // [UserDefined]
 
@@ -597,6 +601,10 @@ public:
   inline bool isFuncRet() const noexcept { return type() == NodeType::kFuncRet; }
   //! Tests whether this node is `InvokeNode`.
   inline bool isInvoke() const noexcept { return type() == NodeType::kInvoke; }
+  //! Tests whether this node is `PhiNode`.
+  inline bool isPhi() const noexcept { return type() == NodeType::kPhi; }
+  //! Tests whether this node is `OsrEntryNode`.
+  inline bool isOsrEntry() const noexcept { return type() == NodeType::kOsrEntry; }
 
   //! Returns the node flags.
   inline NodeFlags flags() const noexcept { return _any._nodeFlags; }
@@ -0,0 +1,359 @@
+// This file is part of AsmJit project <https://asmjit.com>
+//
+// See asmjit.h or LICENSE.md for license and copyright information
+// SPDX-License-Identifier: Zlib
+
+#include "../core/api-build_p.h"
+#ifndef ASMJIT_NO_COMPILER
+
+#include "../core/cfgsimplifypass_p.h"
+#include "../core/compilerutils_p.h"
+
+ASMJIT_BEGIN_NAMESPACE
+
+// BaseCFGSimplifyPass - Utilities
+// ===============================
+
+// Added to references of labels that must never be removed, which are function exit labels and labels that were not
+// referenced before the pass (they could be used to get an offset of the code after it's finalized).
+static constexpr uint32_t kPinnedLabelRefs = 0x40000000u;
+
+static inline BaseNode* BaseCFGSimplifyPass_nextNode(BaseNode* node) noexcept {
+  do {
+    node = node->next();
+  } while (node && node->isInformative());
+  return node;
+}
+
+static inline BaseNode* BaseCFGSimplifyPass_prevNode(BaseNode* node) noexcept {
+  do {
+    node = node->prev();
+  } while (node && node->isInformative());
+  return node;
+}
+
+// Returns the first node starting at `node` that is neither a label nor informative.
+static inline BaseNode* BaseCFGSimplifyPass_skipLabels(BaseNode* node) noexcept {
+  while (node && (node->type() == NodeType::kLabel || node->isInformative()))
+    node = node->next();
+  return node;
+}
+
+// Tests whether `labelId` is bound by a label that follows `node` with only labels and informative nodes between.
+static inline bool BaseCFGSimplifyPass_isLabelNext(BaseNode* node, uint32_t labelId) noexcept {
+  for (node = node->next(); node && (node->type() == NodeType::kLabel || node->isInformative()); node = node->next())
+    if (node->type() == NodeType::kLabel && node->as<LabelNode>()->labelId() == labelId)
+      return true;
+  return false;
+}
+
+static InstControlFlow BaseCFGSimplifyPass_nodeFlow(const BaseCFGSimplifyPass* self, const BaseNode* node) noexcept {
+  switch (node->type()) {
+    case NodeType::kInst:
+    case NodeType::kJump:
+      return self->controlFlow(node->as<InstNode>());
+
+    case NodeType::kFuncRet:
+      return InstControlFlow::kReturn;
+
+    case NodeType::kInvoke:
+      return InstControlFlow::kCall;
+
+    default:
+      return InstControlFlow::kRegular;
+  }
+}
+
+static inline bool BaseCFGSimplifyPass_isTerminator(InstControlFlow flow) noexcept {
+  return flow == InstControlFlow::kJump || flow == InstControlFlow::kReturn;
+}
+
+// Tests whether `node` is a jump or a branch to a label that can be modified, the label is always the last operand.
+static inline bool BaseCFGSimplifyPass_isDirect(const BaseNode* node, InstControlFlow flow) noexcept {
+  if (node->type() != NodeType::kInst || (flow != InstControlFlow::kJump && flow != InstControlFlow::kBranch))
+    return false;
+
+  const InstNode* inst = node->as<InstNode>();
+  uint32_t opCount = inst->opCount();
+  return opCount && inst->op(opCount - 1).isLabel() && !inst->hasOption(InstOptions::kUnfollow);
+}
+
+static inline uint32_t BaseCFGSimplifyPass_targetOf(const BaseNode* node) noexcept {
+  const InstNode* inst = node->as<InstNode>();
+  return inst->op(inst->opCount() - 1).id();
+}
+
+static inline void BaseCFGSimplifyPass_addRef(BaseCFGSimplifyPass* self, uint32_t labelId, int32_t n) noexcept {
+  if (labelId < self->_labelCount)
+    self->_labelRefs[labelId] += uint32_t(n);
+}
+
+static inline void BaseCFGSimplifyPass_setTarget(BaseCFGSimplifyPass* self, BaseNode* node, uint32_t labelId) noexcept {
+  InstNode* inst = node->as<InstNode>();
+  uint32_t index = inst->opCount() - 1;
+
+  BaseCFGSimplifyPass_addRef(self, inst->op(index).id(), -1);
+  BaseCFGSimplifyPass_addRef(self, labelId, 1);
+
+  inst->setOp(index, Label(labelId));
+  // The SHORT form might not be encodable anymore (X86 specific).
+  inst->clearOptions(InstOptions::kShortForm);
+}
+
+static void BaseCFGSimplifyPass_removeNode(BaseCFGSimplifyPass* self, BaseNode* node) noexcept {
+  CompilerUtils::forEachLabelRef(node, [&](uint32_t labelId) {
+    BaseCFGSimplifyPass_addRef(self, labelId, -1);
+  });
+
+  node->resetPassData();
+  self->cc()->removeNode(node);
+}
+
+// Returns a label node of `labelId` if it's a regular label within `func`.
+static LabelNode* BaseCFGSimplifyPass_labelNodeOf(BaseCFGSimplifyPass* self, FuncNode* func, uint32_t labelId) noexcept {
+  const ZoneVector<LabelNode*>& labelNodes = self->cc()->labelNodes();
+  if (labelId >= labelNodes.size() || labelId >= self->_labelCount)
+    return nullptr;
+
+  LabelNode* node = labelNodes[labelId];
+  if (!node || node->type() != NodeType::kLabel || !node->isActive() || node->passData<FuncNode>() != func)
+    return nullptr;
+
+  return node;
+}
+
+// Follows unconditional jumps that directly follow `labelId` and returns the final target.
+static uint32_t BaseCFGSimplifyPass_threadTarget(BaseCFGSimplifyPass* self, FuncNode* func, uint32_t labelId) noexcept {
+  uint32_t target = labelId;
+
+  for (uint32_t hop = 0; hop < BaseCFGSimplifyPass::kMaxThreadingHops; hop++) {
+    LabelNode* labelNode = BaseCFGSimplifyPass_labelNodeOf(self, func, target);
+    if (!labelNode)
+      break;
+
+    BaseNode* node = BaseCFGSimplifyPass_skipLabels(labelNode->next());
+    if (!node)
+      break;
+
+    InstControlFlow flow = BaseCFGSimplifyPass_nodeFlow(self, node);
+    if (flow != InstControlFlow::kJump || !BaseCFGSimplifyPass_isDirect(node, flow))
+      break;
+
+    uint32_t next = BaseCFGSimplifyPass_targetOf(node);
+    if (next == target || next == labelId)
+      break;
+
+    target = next;
+  }
+
+  return target;
+}
+
+// Returns the last node of a block that starts at `labelNode` if the block ends with an unconditional jump or return
+// and only consists of instructions and labels.
+static BaseNode* BaseCFGSimplifyPass_blockEnd(const BaseCFGSimplifyPass* self, LabelNode* labelNode, BaseNode* stop) noexcept {
+  for (BaseNode* node = labelNode->next(); node && node != stop; node = node->next()) {
+    if (node->type() == NodeType::kLabel || node->isInformative())
+      continue;
+
+    if (!node->isInst())
+      return nullptr;
+
+    if (BaseCFGSimplifyPass_isTerminator(BaseCFGSimplifyPass_nodeFlow(self, node)))
+      return node;
+  }
+
+  return nullptr;
+}
+
+// Simplifies a single function, returns true if anything has changed.
+static bool BaseCFGSimplifyPass_simplifyRound(BaseCFGSimplifyPass* self, FuncNode* func) noexcept {
+  BaseCompiler* cc = self->cc();
+  BaseNode* stop = func->endNode();
+  BaseNode* node = func->next();
+  bool changed = false;
+
+  while (node && node != stop) {
+    InstControlFlow flow = BaseCFGSimplifyPass_nodeFlow(self, node);
+
+    // Remove unreachable instructions that follow a terminator.
+    if (BaseCFGSimplifyPass_isTerminator(flow)) {
+      BaseNode* unreachable = node->next();
+      while (unreachable && unreachable != stop && (unreachable->isInst() || unreachable->isInformative())) {
+        BaseNode* next = unreachable->next();
+        if (unreachable->isInst()) {
+          BaseCFGSimplifyPass_removeNode(self, unreachable);
+          changed = true;
+        }
+        unreachable = next;
+      }
+    }
+
+    if (!BaseCFGSimplifyPass_isDirect(node, flow)) {
+      node = node->next();
+      continue;
+    }
+
+    // Thread the jump through jumps that follow its target.
+    uint32_t target = BaseCFGSimplifyPass_targetOf(node);
+    uint32_t threaded = BaseCFGSimplifyPass_threadTarget(self, func, target);
+
+    if (threaded != target) {
+      BaseCFGSimplifyPass_setTarget(self, node, threaded);
+      target = threaded;
+      changed = true;
+    }
+
+    bool isJump = flow == InstControlFlow::kJump;
+    bool isPureBranch = !isJump && self->canInvertBranch(node->as<InstNode>());
+
+    // Remove a jump to a label that directly follows it.
+    if ((isJump || isPureBranch) && BaseCFGSimplifyPass_isLabelNext(node, target)) {
+      BaseNode* next = node->next();
+      BaseCFGSimplifyPass_removeNode(self, node);
+      changed = true;
+      node = next;
+      continue;
+    }
+
+    // Invert a branch over an unconditional jump.
+    if (isPureBranch) {
+      BaseNode* jump = BaseCFGSimplifyPass_nextNode(node);
+      if (jump && jump != stop) {
+        InstControlFlow jumpFlow = BaseCFGSimplifyPass_nodeFlow(self, jump);
+        if (jumpFlow == InstControlFlow::kJump && BaseCFGSimplifyPass_isDirect(jump, jumpFlow) && BaseCFGSimplifyPass_isLabelNext(jump, target)) {
+          self->invertBranch(node->as<InstNode>());
+          BaseCFGSimplifyPass_setTarget(self, node, BaseCFGSimplifyPass_targetOf(jump));
+          BaseCFGSimplifyPass_removeNode(self, jump);
+          changed = true;
+          continue;
+        }
+      }
+    }
+
+    // Move a block that is only entered by this jump in place of the jump.
+    if (isJump && target < self->_labelCount && self->_labelRefs[target] == 1) {
+      LabelNode* labelNode = BaseCFGSimplifyPass_labelNodeOf(self, func, target);
+      BaseNode* before = labelNode ? BaseCFGSimplifyPass_prevNode(labelNode) : nullptr;
+
+      if (before && BaseCFGSimplifyPass_isTerminator(BaseCFGSimplifyPass_nodeFlow(self, before))) {
+        BaseNode* end = BaseCFGSimplifyPass_blockEnd(self, labelNode, stop);
+
+        // The jump itself is a terminator, so it would end the block if the block contained it.
+        if (end && end != node) {
+          BaseNode* ref = node;
+          BaseNode* moved = labelNode;
+
+          for (;;) {
+            BaseNode* next = moved->next();
+            cc->removeNode(moved);
+            cc->addAfter(moved, ref);
+
+            if (moved == end)
+              break;
+
+            ref = moved;
+            moved = next;
+          }
+
+          BaseNode* next = node->next();
+          BaseCFGSimplifyPass_removeNode(self, node);
+          changed = true;
+          node = next;
+          continue;
+        }
+      }
+    }
+
+    node = node->next();
+  }
+
+  // Remove labels that lost all their references.
+  node = func->next();
+  while (node && node != stop) {
+    BaseNode* next = node->next();
+    if (node->type() == NodeType::kLabel) {
+      uint32_t labelId = node->as<LabelNode>()->labelId();
+      if (labelId < self->_labelCount && self->_labelRefs[labelId] == 0) {
+        BaseCFGSimplifyPass_removeNode(self, node);
+        changed = true;
+      }
+    }
+    node = next;
+  }
+
+  return changed;
+}
+
+// BaseCFGSimplifyPass - Construction & Destruction
+// ================================================
+
+BaseCFGSimplifyPass::BaseCFGSimplifyPass(const char* name) noexcept
+  : Pass(name) {}
+BaseCFGSimplifyPass::~BaseCFGSimplifyPass() noexcept {}
+
+// BaseCFGSimplifyPass - Run
+// =========================
+
+Error BaseCFGSimplifyPass::run(Zone* zone, Logger* logger) {
+  DebugUtils::unused(logger);
+
+  BaseCompiler* cc = this->cc();
+  if (!cc->hasCompilerOption(CompilerOptions::kSimplifyCFG))
+    return kErrorOk;
+
+  ASMJIT_PROPAGATE(CompilerUtils::countLabelRefs(cc, zone, &_labelRefs, &_labelCount));
+
+  for (uint32_t i = 0; i < _labelCount; i++)
+    if (_labelRefs[i] == 0)
+      _labelRefs[i] = kPinnedLabelRefs;
+
+  BaseNode* prevCursor = cc->cursor();
+  BaseNode* node = cc->firstNode();
+
+  while (node) {
+    if (node->type() != NodeType::kFunc) {
+      node = node->next();
+      continue;
+    }
+
+    FuncNode* func = node->as<FuncNode>();
+    BaseNode* stop = func->endNode();
+
+    if (!stop || !stop->isActive()) {
+      node = node->next();
+      continue;
+    }
+
+    LabelNode* exitNode = func->exitNode();
+    if (exitNode && exitNode->labelId() < _labelCount)
+      _labelRefs[exitNode->labelId()] += kPinnedLabelRefs;
+
+    // Mark nodes of the function so jumps are only threaded and blocks only moved within the function.
+    for (BaseNode* n = func->next(); n && n != stop; n = n->next())
+      n->setPassData<FuncNode>(func);
+
+    for (uint32_t round = 0; round < kMaxRounds; round++)
+      if (!BaseCFGSimplifyPass_simplifyRound(this, func))
+        break;
+
+    for (BaseNode* n = func->next(); n && n != stop; n = n->next())
+      n->resetPassData();
+
+    node = stop->next();
+  }
+
+  _labelRefs = nullptr;
+  _labelCount = 0;
+
+  // The cursor could have been removed together with unreachable code or labels.
+  if (prevCursor && !prevCursor->isActive())
+    prevCursor = cc->lastNode();
+  cc->_setCursor(prevCursor);
+
+  return kErrorOk;
+}
+
+ASMJIT_END_NAMESPACE
+
+#endif // !ASMJIT_NO_COMPILER
@@ -0,0 +1,105 @@
+// This file is part of AsmJit project <https://asmjit.com>
+//
+// See asmjit.h or LICENSE.md for license and copyright information
+// SPDX-License-Identifier: Zlib
+
+#ifndef ASMJIT_CORE_CFGSIMPLIFYPASS_P_H_INCLUDED
+#define ASMJIT_CORE_CFGSIMPLIFYPASS_P_H_INCLUDED
+
+#include "../core/api-config.h"
+#ifndef ASMJIT_NO_COMPILER
+
+#include "../core/compiler.h"
+
+ASMJIT_BEGIN_NAMESPACE
+
+//! \cond INTERNAL
+//! \addtogroup asmjit_ra
+//! \{
+
+//! Control flow graph simplification pass.
+//!
+//! Simplifies jumps and labels of each function. The pass runs before the register allocator, to shrink the CFG it
+//! has to process, and after it to clean up jumps to blocks inserted by the allocator. The following rewrites are
+//! performed until there is nothing to simplify:
+//!
+//!   - Jumps and branches to a label that is followed by an unconditional jump are threaded to the target of that
+//!     jump (`jcc L1 ... L1: jmp L2` -> `jcc L2`).
+//!
+//!   - Code that follows an unconditional jump or return and is not preceded by a label is unreachable and removed.
+//!
+//!   - Jumps and branches to a label that directly follows them are removed (`jmp L1; L1:` -> `L1:`).
+//!
+//!   - A branch over an unconditional jump is inverted (`jcc L1; jmp L2; L1:` -> `j!cc L2; L1:`).
+//!
+//!   - A block that is only entered by an unconditional jump (nothing falls through to it) is moved in place of the
+//!     jump, which merges straight-line blocks (`jmp L1; ... jmp X; L1: {code} jmp L2` -> `{code} jmp L2; ...`).
+//!
+//!   - Labels that are no longer referenced after the rewrites above are removed, so they don't split blocks of the
+//!     register allocator. Labels that were not referenced before the pass and function exit labels are never
+//!     removed - a label used to query an offset of the code after it's finalized must not be a jump target, bind
+//!     another label at the same position instead.
+class BaseCFGSimplifyPass : public Pass {
+public:
+  ASMJIT_NONCOPYABLE(BaseCFGSimplifyPass)
+  typedef Pass Base;
+
+  //! Maximum number of jumps followed when threading a single jump.
+  static constexpr uint32_t kMaxThreadingHops = 8;
+  //! Maximum number of simplification rounds of a single function.
+  static constexpr uint32_t kMaxRounds = 4;
+
+  //! \name Members
+  //! \{
+
+  //! Number of references of each label (only valid during `run()`).
+  uint32_t* _labelRefs = nullptr;
+  //! Number of labels `_labelRefs` holds.
+  uint32_t _labelCount = 0;
+
+  //! \}
+
+  //! \name Construction & Destruction
+  //! \{
+
+  BaseCFGSimplifyPass(const char* name) noexcept;
+  virtual ~BaseCFGSimplifyPass() noexcept;
+
+  //! \}
+
+  //! \name Accessors
+  //! \{
+
+  //! Returns the associated `BaseCompiler`.
+  inline BaseCompiler* cc() const noexcept { return static_cast<BaseCompiler*>(_cb); }
+
+  //! \}
+
+  //! \name Run
+  //! \{
+
+  Error run(Zone* zone, Logger* logger) override;
+
+  //! \}
+
+  //! \name Architecture Interface
+  //! \{
+
+  //! Returns control flow of the instruction `node`.
+  virtual InstControlFlow controlFlow(const InstNode* node) const noexcept = 0;
+
+  //! Tests whether the conditional branch `node` can be inverted, which also means that it has no side effects.
+  virtual bool canInvertBranch(const InstNode* node) const noexcept = 0;
+  //! Inverts the condition of the conditional branch `node`, see \ref canInvertBranch().
+  virtual void invertBranch(InstNode* node) noexcept = 0;
+
+  //! \}
+};
+
+//! \}
+//! \endcond
+
+ASMJIT_END_NAMESPACE
+
+#endif // !ASMJIT_NO_COMPILER
+#endif // ASMJIT_CORE_CFGSIMPLIFYPASS_P_H_INCLUDED
@@ -25,19 +25,45 @@ enum class CodeBufferFlags : uint32_t {
 };
 ASMJIT_DEFINE_ENUM_FLAGS(CodeBufferFlags)
 
+//! A closed segment of a segmented \ref CodeBuffer.
+struct CodeBufferSegment {
+  //! Segment data.
+  uint8_t* data;
+  //! Offset of the segment from the start of the buffer.
+  size_t offset;
+  //! Number of bytes used by the segment.
+  size_t size;
+  //! Capacity of the segment (in bytes).
+  size_t capacity;
+};
+
 //! Code or data buffer.
+//!
+//! A buffer is contiguous by default. If \ref CodeHolder::setBufferSegmentSize() was used to enable segmented
+//! buffers, a buffer that needs to grow can continue in a new segment instead of being reallocated. In that case
+//! `_data` and `_capacity` describe the active (last) segment, which starts at `_segmentOffset`, and all previous
+//! segments are stored in `_segments`. Use \ref dataAt() to access data of a segmented buffer and \ref
+//! CodeHolder::copySectionData() to gather it.
 struct CodeBuffer {
   //! \name Members
   //! \{
 
-  //! The content of the buffer (data).
+  //! The content of the buffer (data of the active segment if the buffer is segmented).
   uint8_t* _data;
-  //! Number of bytes of `data` used.
+  //! Number of bytes of the buffer used (including closed segments).
   size_t _size;
-  //! Buffer capacity (in bytes).
+  //! Capacity of the active segment (in bytes).
   size_t _capacity;
   //! Buffer flags.
   CodeBufferFlags _flags;
+  //! Number of closed segments.
+  uint32_t _segmentCount;
+  //! Capacity of `_segments` array.
+  uint32_t _segmentCapacity;
+  //! Closed segments, sorted by offset.
+  CodeBufferSegment* _segments;
+  //! Offset of the active segment from the start of the buffer.
+  size_t _segmentOffset;
 
   //! \}
 
@@ -47,12 +73,12 @@ struct CodeBuffer {
   //! Returns a referebce to the byte at the given `index`.
   inline uint8_t& operator[](size_t index) noexcept {
     ASMJIT_ASSERT(index < _size);
-    return _data[index];
+    return *dataAt(index);
   }
   //! \overload
   inline const uint8_t& operator[](size_t index) const noexcept {
     ASMJIT_ASSERT(index < _size);
-    return _data[index];
+    return *dataAt(index);
   }
 
   //! \}
@@ -78,23 +104,62 @@ struct CodeBuffer {
   //! Tests whether the data in this code buffer is allocated (non-null).
   inline bool isAllocated() const noexcept { return _data != nullptr; }
 
+  //! Tests whether the data in this code buffer is split into multiple segments.
+  inline bool isSegmented() const noexcept { return _segmentCount != 0; }
+
   //! Tests whether the code buffer is empty.
   inline bool empty() const noexcept { return !_size; }
 
   //! Returns the size of the data.
   inline size_t size() const noexcept { return _size; }
-  //! Returns the capacity of the data.
-  inline size_t capacity() const noexcept { return _capacity; }
+  //! Returns the capacity of the data (including closed segments).
+  inline size_t capacity() const noexcept { return _segmentOffset + _capacity; }
 
   //! Returns the pointer to the data the buffer references.
+  //!
+  //! \note The whole data can only be accessed this way if the buffer is not segmented, otherwise the returned
+  //! pointer only points to the active segment, see \ref isSegmented().
   inline uint8_t* data() noexcept { return _data; }
   //! \overload
   inline const uint8_t* data() const noexcept { return _data; }
 
+  //! Returns the pointer to the byte at the given `offset`, which works for both contiguous and segmented buffers.
+  //!
+  //! \note Data that follow the returned pointer are only contiguous until the end of the segment that contains it.
+  //! Assemblers never split a single instruction or embedded data across segments.
+  inline uint8_t* dataAt(size_t offset) noexcept {
+    return const_cast<uint8_t*>(static_cast<const CodeBuffer*>(this)->dataAt(offset));
+  }
+  //! \overload
+  inline const uint8_t* dataAt(size_t offset) const noexcept {
+    if (offset >= _segmentOffset)
+      return _data + (offset - _segmentOffset);
+
+    // Binary search of the last closed segment that starts at or before `offset`.
+    const CodeBufferSegment* base = _segments;
+    size_t n = _segmentCount;
+    while (n > 1) {
+      size_t half = n / 2;
+      if (base[half].offset <= offset)
+        base += half;
+      n -= half;
+    }
+    return base->data + (offset - base->offset);
+  }
+
+  //! Returns the number of closed segments.
+  inline uint32_t segmentCount() const noexcept { return _segmentCount; }
+  //! Returns closed segments.
+  inline const CodeBufferSegment* segments() const noexcept { return _segments; }
+  //! Returns the offset of the active segment from the start of the buffer.
+  inline size_t segmentOffset() const noexcept { return _segmentOffset; }
+
   //! \}
 
   //! \name Iterators
   //! \{
+  //!
+  //! \note Iterators are only valid if the buffer is not segmented, see \ref isSegmented().
 
   inline uint8_t* begin() noexcept { return _data; }
   inline const uint8_t* begin() const noexcept { return _data; }
@@ -5,9 +5,12 @@
 
 #include "../core/api-build_p.h"
 #include "../core/assembler.h"
+#include "../core/codesizereport.h"
 #include "../core/codewriter_p.h"
 #include "../core/logger.h"
+#include "../core/osutils_p.h"
 #include "../core/support.h"
+#include "../core/telemetry_p.h"
 
 #include <algorithm>
 #include <tuple>
@@ -24,6 +27,28 @@ static inline uint32_t x86EncodeMod(uint32_t m, uint32_t o, uint32_t rm) noexcep
   return (m << 6) | (o << 3) | rm;
 }
 
+// CodeHolderLockGuard
+// ===================
+
+//! Locks the CodeHolder for the lifetime of the guard if it's thread-safe, see \ref CodeHolder::setThreadSafe().
+class CodeHolderLockGuard {
+public:
+  ASMJIT_NONCOPYABLE(CodeHolderLockGuard)
+
+  Lock* _lock;
+
+  inline explicit CodeHolderLockGuard(const CodeHolder* code) noexcept
+    : _lock(code->isThreadSafe() ? &code->_lock : nullptr) {
+    if (_lock)
+      _lock->lock();
+  }
+
+  inline ~CodeHolderLockGuard() noexcept {
+    if (_lock)
+      _lock->unlock();
+  }
+};
+
 // LabelLinkIterator
 // =================
 
@@ -77,15 +102,31 @@ static void CodeHolder_resetInternal(CodeHolder* self, ResetPolicy resetPolicy)
   self->_baseAddress = Globals::kNoBaseAddress;
   self->_logger = nullptr;
   self->_errorHandler = nullptr;
+  self->_telemetrySink = nullptr;
+  self->_codeSizeReport = nullptr;
 
   // Reset all sections.
+  MemAllocator* memAllocator = self->memAllocator();
   uint32_t numSections = self->_sections.size();
   for (i = 0; i < numSections; i++) {
     Section* section = self->_sections[i];
-    if (section->_buffer.data() && !section->_buffer.isExternal())
-      ::free(section->_buffer._data);
-    section->_buffer._data = nullptr;
-    section->_buffer._capacity = 0;
+    CodeBuffer& buffer = section->_buffer;
+
+    if (buffer.data() && !buffer.isExternal())
+      memAllocator->release(buffer._data, buffer._capacity, Globals::kAllocAlignment);
+
+    for (uint32_t j = 0; j < buffer._segmentCount; j++)
+      memAllocator->release(buffer._segments[j].data, buffer._segments[j].capacity, Globals::kAllocAlignment);
+
+    if (buffer._segments)
+      memAllocator->release(buffer._segments, buffer._segmentCapacity * sizeof(CodeBufferSegment), Globals::kAllocAlignment);
+
+    buffer._data = nullptr;
+    buffer._capacity = 0;
+    buffer._segments = nullptr;
+    buffer._segmentCount = 0;
+    buffer._segmentCapacity = 0;
+    buffer._segmentOffset = 0;
   }
 
   // Reset zone allocator and all containers using it.
@@ -101,6 +142,9 @@ static void CodeHolder_resetInternal(CodeHolder* self, ResetPolicy resetPolicy)
   self->_unresolvedLinkCount = 0;
   self->_addressTableSection = nullptr;
   self->_addressTableEntries.reset();
+  self->_addressTableSlotCount = 0;
+  self->_stackMaps.reset();
+  self->_stackMapEntries.reset();
 
   allocator->reset(&self->_zone);
   self->_zone.reset(resetPolicy);
@@ -121,10 +165,15 @@ CodeHolder::CodeHolder(const Support::Temporary* temporary) noexcept
     _baseAddress(Globals::kNoBaseAddress),
     _logger(nullptr),
     _errorHandler(nullptr),
+    _telemetrySink(nullptr),
+    _codeSizeReport(nullptr),
     _zone(16384 - Zone::kBlockOverhead, 1, temporary),
     _allocator(&_zone),
     _unresolvedLinkCount(0),
-    _addressTableSection(nullptr) {}
+    _addressTableSection(nullptr),
+    _addressTableSlotCount(0),
+    _threadSafe(false),
+    _bufferSegmentSize(0) {}
 
 CodeHolder::~CodeHolder() noexcept {
   CodeHolder_resetInternal(this, ResetPolicy::kHard);
@@ -181,6 +230,14 @@ void CodeHolder::reset(ResetPolicy resetPolicy) noexcept {
   CodeHolder_resetInternal(this, resetPolicy);
 }
 
+Error CodeHolder::setMemAllocator(MemAllocator* memAllocator) noexcept {
+  if (isInitialized())
+    return DebugUtils::errored(kErrorAlreadyInitialized);
+
+  _zone.setMemAllocator(memAllocator);
+  return kErrorOk;
+}
+
 // CodeHolder - Attach / Detach
 // ============================
 
@@ -253,6 +310,14 @@ void CodeHolder::setLogger(Logger* logger) noexcept {
 #endif
 }
 
+// CodeHolder - Code Size Analysis
+// ===============================
+
+void CodeHolder::setCodeSizeReport(CodeSizeReport* report) noexcept {
+  _codeSizeReport = report;
+  CodeHolder_onSettingsUpdated(this);
+}
+
 // CodeHolder - Error Handling
 // ===========================
 
@@ -264,14 +329,83 @@ void CodeHolder::setErrorHandler(ErrorHandler* errorHandler) noexcept {
 // CodeHolder - Code Buffer
 // ========================
 
+static void CodeHolder_updateAssemblers(CodeHolder* self, CodeBuffer* cb) noexcept {
+  for (BaseEmitter* emitter : self->emitters()) {
+    if (emitter->isAssembler()) {
+      BaseAssembler* a = static_cast<BaseAssembler*>(emitter);
+      if (&a->_section->_buffer == cb) {
+        size_t offset = a->offset();
+        ASMJIT_ASSERT(offset >= cb->_segmentOffset);
+
+        a->_bufferData = cb->_data;
+        a->_bufferEnd = cb->_data + cb->_capacity;
+        a->_bufferPtr = cb->_data + (offset - cb->_segmentOffset);
+        a->_bufferOffset = cb->_segmentOffset;
+      }
+    }
+  }
+}
+
+// Tests whether all assemblers that emit to `cb` are at its end, in which case no instruction is being overwritten
+// and the buffer can continue in a new segment.
+static bool CodeHolder_canStartSegment(CodeHolder* self, CodeBuffer* cb) noexcept {
+  for (BaseEmitter* emitter : self->emitters()) {
+    if (emitter->isAssembler()) {
+      BaseAssembler* a = static_cast<BaseAssembler*>(emitter);
+      if (&a->_section->_buffer == cb && a->offset() != cb->_size)
+        return false;
+    }
+  }
+  return true;
+}
+
+// Closes the active segment of `cb` and continues in a new segment having `n` bytes, nothing is copied.
+static Error CodeHolder_startSegment(CodeHolder* self, CodeBuffer* cb, size_t n) noexcept {
+  if (cb->_segmentCount == cb->_segmentCapacity) {
+    uint32_t newCapacity = Support::max<uint32_t>(cb->_segmentCapacity * 2u, 8u);
+    size_t oldSize = cb->_segmentCapacity * sizeof(CodeBufferSegment);
+    size_t newSize = newCapacity * sizeof(CodeBufferSegment);
+
+    MemAllocator* memAllocator = self->memAllocator();
+    CodeBufferSegment* newSegments = static_cast<CodeBufferSegment*>(
+      cb->_segments ? memAllocator->realloc(cb->_segments, oldSize, newSize, Globals::kAllocAlignment)
+                    : memAllocator->alloc(newSize, Globals::kAllocAlignment));
+
+    if (ASMJIT_UNLIKELY(!newSegments))
+      return DebugUtils::errored(kErrorOutOfMemory);
+
+    cb->_segments = newSegments;
+    cb->_segmentCapacity = newCapacity;
+  }
+
+  uint8_t* newData = static_cast<uint8_t*>(self->memAllocator()->alloc(n, Globals::kAllocAlignment));
+  if (ASMJIT_UNLIKELY(!newData))
+    return DebugUtils::errored(kErrorOutOfMemory);
+
+  CodeBufferSegment& segment = cb->_segments[cb->_segmentCount++];
+  segment.data = cb->_data;
+  segment.offset = cb->_segmentOffset;
+  segment.size = cb->_size - cb->_segmentOffset;
+  segment.capacity = cb->_capacity;
+
+  cb->_data = newData;
+  cb->_capacity = n;
+  cb->_segmentOffset = cb->_size;
+
+  CodeHolder_updateAssemblers(self, cb);
+  return kErrorOk;
+}
+
+// Reserves `n` bytes of the active segment of `cb`.
 static Error CodeHolder_reserveInternal(CodeHolder* self, CodeBuffer* cb, size_t n) noexcept {
   uint8_t* oldData = cb->_data;
   uint8_t* newData;
 
+  MemAllocator* memAllocator = self->memAllocator();
   if (oldData && !cb->isExternal())
-    newData = static_cast<uint8_t*>(::realloc(oldData, n));
+    newData = static_cast<uint8_t*>(memAllocator->realloc(oldData, cb->_capacity, n, Globals::kAllocAlignment));
   else
-    newData = static_cast<uint8_t*>(::malloc(n));
+    newData = static_cast<uint8_t*>(memAllocator->alloc(n, Globals::kAllocAlignment));
 
   if (ASMJIT_UNLIKELY(!newData))
     return DebugUtils::errored(kErrorOutOfMemory);
@@ -280,19 +414,7 @@ static Error CodeHolder_reserveInternal(CodeHolder* self, CodeBuffer* cb, size_t
   cb->_capacity = n;
 
   // Update pointers used by assemblers, if attached.
-  for (BaseEmitter* emitter : self->emitters()) {
-    if (emitter->isAssembler()) {
-      BaseAssembler* a = static_cast<BaseAssembler*>(emitter);
-      if (&a->_section->_buffer == cb) {
-        size_t offset = a->offset();
-
-        a->_bufferData = newData;
-        a->_bufferEnd  = newData + n;
-        a->_bufferPtr  = newData + offset;
-      }
-    }
-  }
-
+  CodeHolder_updateAssemblers(self, cb);
   return kErrorOk;
 }
 
@@ -312,6 +434,17 @@ Error CodeHolder::growBuffer(CodeBuffer* cb, size_t n) noexcept {
   if (cb->isFixed())
     return DebugUtils::errored(kErrorTooLarge);
 
+  // Segmented buffers continue in a new segment once the active segment reached the segment size. Otherwise only
+  // the active segment grows, which is the whole buffer if the buffer is contiguous.
+  size_t segmentSize = _bufferSegmentSize;
+  size_t activeSize = size - cb->_segmentOffset;
+
+  if (segmentSize && activeSize && cb->_capacity >= segmentSize && !cb->isExternal() && CodeHolder_canStartSegment(this, cb))
+    return CodeHolder_startSegment(this, cb, Support::max(segmentSize, n));
+
+  capacity = cb->_capacity;
+  required = activeSize + n;
+
   size_t kInitialCapacity = 8096;
   if (capacity < kInitialCapacity)
     capacity = kInitialCapacity;
@@ -330,7 +463,13 @@ Error CodeHolder::growBuffer(CodeBuffer* cb, size_t n) noexcept {
       return DebugUtils::errored(kErrorOutOfMemory);
   } while (capacity - Globals::kAllocOverhead < required);
 
-  return CodeHolder_reserveInternal(this, cb, capacity - Globals::kAllocOverhead);
+  capacity -= Globals::kAllocOverhead;
+
+  // Don't grow the active segment past the segment size unless required, the next growth would start a new one.
+  if (segmentSize && cb->_capacity < segmentSize && capacity > segmentSize)
+    capacity = Support::max(segmentSize, required);
+
+  return CodeHolder_reserveInternal(this, cb, capacity);
 }
 
 Error CodeHolder::reserveBuffer(CodeBuffer* cb, size_t n) noexcept {
@@ -342,13 +481,22 @@ Error CodeHolder::reserveBuffer(CodeBuffer* cb, size_t n) noexcept {
   if (cb->isFixed())
     return DebugUtils::errored(kErrorTooLarge);
 
-  return CodeHolder_reserveInternal(this, cb, n);
+  return CodeHolder_reserveInternal(this, cb, n - cb->_segmentOffset);
+}
+
+void CodeHolder::setBufferSegmentSize(size_t segmentSize) noexcept {
+  // Very small segments would only add overhead.
+  constexpr size_t kMinSegmentSize = 4096;
+
+  if (segmentSize)
+    segmentSize = Support::max(segmentSize, kMinSegmentSize);
+  _bufferSegmentSize = segmentSize;
 }
 
 // CodeHolder - Sections
 // =====================
 
-Error CodeHolder::newSection(Section** sectionOut, const char* name, size_t nameSize, SectionFlags flags, uint32_t alignment, int32_t order) noexcept {
+static Error CodeHolder_newSection(CodeHolder* self, Section** sectionOut, const char* name, size_t nameSize, SectionFlags flags, uint32_t alignment, int32_t order) noexcept {
   *sectionOut = nullptr;
 
   if (nameSize == SIZE_MAX)
@@ -363,14 +511,14 @@ Error CodeHolder::newSection(Section** sectionOut, const char* name, size_t name
   if (ASMJIT_UNLIKELY(nameSize > Globals::kMaxSectionNameSize))
     return DebugUtils::errored(kErrorInvalidSectionName);
 
-  uint32_t sectionId = _sections.size();
+  uint32_t sectionId = self->_sections.size();
   if (ASMJIT_UNLIKELY(sectionId == Globals::kInvalidId))
     return DebugUtils::errored(kErrorTooManySections);
 
-  ASMJIT_PROPAGATE(_sections.willGrow(&_allocator));
-  ASMJIT_PROPAGATE(_sectionsByOrder.willGrow(&_allocator));
+  ASMJIT_PROPAGATE(self->_sections.willGrow(&self->_allocator));
+  ASMJIT_PROPAGATE(self->_sectionsByOrder.willGrow(&self->_allocator));
 
-  Section* section = _allocator.allocZeroedT<Section>();
+  Section* section = self->_allocator.allocZeroedT<Section>();
   if (ASMJIT_UNLIKELY(!section))
     return DebugUtils::errored(kErrorOutOfMemory);
 
@@ -380,17 +528,22 @@ Error CodeHolder::newSection(Section** sectionOut, const char* name, size_t name
   section->_order = order;
   memcpy(section->_name.str, name, nameSize);
 
-  Section** insertPosition = std::lower_bound(_sectionsByOrder.begin(), _sectionsByOrder.end(), section, [](const Section* a, const Section* b) {
+  Section** insertPosition = std::lower_bound(self->_sectionsByOrder.begin(), self->_sectionsByOrder.end(), section, [](const Section* a, const Section* b) {
     return std::make_tuple(a->order(), a->id()) < std::make_tuple(b->order(), b->id());
   });
 
-  _sections.appendUnsafe(section);
-  _sectionsByOrder.insertUnsafe((size_t)(insertPosition - _sectionsByOrder.data()), section);
+  self->_sections.appendUnsafe(section);
+  self->_sectionsByOrder.insertUnsafe((size_t)(insertPosition - self->_sectionsByOrder.data()), section);
 
   *sectionOut = section;
   return kErrorOk;
 }
 
+Error CodeHolder::newSection(Section** sectionOut, const char* name, size_t nameSize, SectionFlags flags, uint32_t alignment, int32_t order) noexcept {
+  CodeHolderLockGuard guard(this);
+  return CodeHolder_newSection(this, sectionOut, name, nameSize, flags, alignment, order);
+}
+
 Section* CodeHolder::sectionByName(const char* name, size_t nameSize) const noexcept {
   if (nameSize == SIZE_MAX)
     nameSize = strlen(name);
@@ -407,25 +560,33 @@ Section* CodeHolder::sectionByName(const char* name, size_t nameSize) const noex
   return nullptr;
 }
 
+static Section* CodeHolder_ensureAddressTableSection(CodeHolder* self) noexcept {
+  if (self->_addressTableSection)
+    return self->_addressTableSection;
+
+  CodeHolder_newSection(self,
+                        &self->_addressTableSection,
+                        CodeHolder_addrTabName,
+                        sizeof(CodeHolder_addrTabName) - 1,
+                        SectionFlags::kNone,
+                        self->_environment.registerSize(),
+                        std::numeric_limits<int32_t>::max());
+  return self->_addressTableSection;
+}
+
 Section* CodeHolder::ensureAddressTableSection() noexcept {
-  if (_addressTableSection)
-    return _addressTableSection;
-
-  newSection(&_addressTableSection,
-             CodeHolder_addrTabName,
-             sizeof(CodeHolder_addrTabName) - 1,
-             SectionFlags::kNone,
-             _environment.registerSize(),
-             std::numeric_limits<int32_t>::max());
-  return _addressTableSection;
+  CodeHolderLockGuard guard(this);
+  return CodeHolder_ensureAddressTableSection(this);
 }
 
 Error CodeHolder::addAddressToAddressTable(uint64_t address) noexcept {
+  CodeHolderLockGuard guard(this);
+
   AddressTableEntry* entry = _addressTableEntries.get(address);
   if (entry)
     return kErrorOk;
 
-  Section* section = ensureAddressTableSection();
+  Section* section = CodeHolder_ensureAddressTableSection(this);
   if (ASMJIT_UNLIKELY(!section))
     return DebugUtils::errored(kErrorOutOfMemory);
 
@@ -488,24 +649,36 @@ static uint32_t CodeHolder_hashNameAndGetSize(const char* name, size_t& nameSize
   return hashCode;
 }
 
-LabelLink* CodeHolder::newLabelLink(LabelEntry* le, uint32_t sectionId, size_t offset, intptr_t rel, const OffsetFormat& format) noexcept {
+LabelLink* CodeHolder::newLabelLink(LabelEntry* le, uint32_t sectionId, size_t offset, intptr_t rel, const OffsetFormat& format, uint32_t relocId) noexcept {
+  CodeHolderLockGuard guard(this);
+
   LabelLink* link = _allocator.allocT<LabelLink>();
   if (ASMJIT_UNLIKELY(!link)) return nullptr;
 
-  link->next = le->_links;
-  le->_links = link;
-
   link->sectionId = sectionId;
-  link->relocId = Globals::kInvalidId;
+  link->relocId = relocId;
   link->offset = offset;
   link->rel = rel;
   link->format = format;
 
+  // The label could have been bound by another thread since the caller checked it. A relocation is updated now as
+  // `resolveUnresolvedLinks()` only resolves links that patch the code.
+  if (relocId != Globals::kInvalidId && le->isBound()) {
+    RelocEntry* re = _relocations[relocId];
+    re->_payload += le->offset();
+    re->_targetSectionId = le->section()->id();
+    return link;
+  }
+
+  link->next = le->_links;
+  le->_links = link;
+
   _unresolvedLinkCount++;
   return link;
 }
 
 Error CodeHolder::newLabelEntry(LabelEntry** entryOut) noexcept {
+  CodeHolderLockGuard guard(this);
   *entryOut = nullptr;
 
   uint32_t labelId = _labelEntries.size();
@@ -541,6 +714,8 @@ Error CodeHolder::newNamedLabelEntry(LabelEntry** entryOut, const char* name, si
   if (ASMJIT_UNLIKELY(nameSize > Globals::kMaxLabelNameSize))
     return DebugUtils::errored(kErrorLabelNameTooLong);
 
+  CodeHolderLockGuard guard(this);
+
   switch (type) {
     case LabelType::kAnonymous: {
       // Anonymous labels cannot have a parent (or more specifically, parent is useless here).
@@ -630,11 +805,26 @@ uint32_t CodeHolder::labelIdByName(const char* name, size_t nameSize, uint32_t p
   if (parentId != Globals::kInvalidId)
     hashCode ^= parentId;
 
+  CodeHolderLockGuard guard(this);
   LabelEntry* le = _namedLabels.get(LabelByName(name, nameSize, hashCode, parentId));
   return le ? le->id() : uint32_t(Globals::kInvalidId);
 }
 
+LabelEntry* CodeHolder::_labelEntryThreadSafe(uint32_t labelId) const noexcept {
+  CodeHolderLockGuard guard(this);
+  return labelId < _labelEntries.size() ? _labelEntries[labelId] : static_cast<LabelEntry*>(nullptr);
+}
+
+Section* CodeHolder::_labelBindingThreadSafe(const LabelEntry* le, uint64_t* offsetOut) const noexcept {
+  CodeHolderLockGuard guard(this);
+  *offsetOut = le->_offset;
+  return le->_section;
+}
+
 ASMJIT_API Error CodeHolder::resolveUnresolvedLinks() noexcept {
+  TelemetryScope telemetry(_telemetrySink, TelemetryStage::kResolveLinks, this);
+  size_t unresolvedLinkCount = _unresolvedLinkCount;
+
   if (!hasUnresolvedLinks())
     return kErrorOk;
 
@@ -668,7 +858,7 @@ ASMJIT_API Error CodeHolder::resolveUnresolvedLinks() noexcept {
             ASMJIT_ASSERT(buf.size() - size_t(linkOffset) >= link->format.valueSize());
 
             // Overwrite a real displacement in the CodeBuffer.
-            if (CodeWriterUtils::writeOffset(buf._data + linkOffset, displacement, link->format)) {
+            if (CodeWriterUtils::writeOffset(buf.dataAt(linkOffset), displacement, link->format)) {
               link.resolveAndNext(this);
               continue;
             }
@@ -683,11 +873,14 @@ ASMJIT_API Error CodeHolder::resolveUnresolvedLinks() noexcept {
     }
   }
 
+  telemetry.setInstCount(unresolvedLinkCount - _unresolvedLinkCount);
   return err;
 }
 
 ASMJIT_API Error CodeHolder::bindLabel(const Label& label, uint32_t toSectionId, uint64_t toOffset) noexcept {
-  LabelEntry* le = labelEntry(label);
+  CodeHolderLockGuard guard(this);
+
+  LabelEntry* le = label.id() < _labelEntries.size() ? _labelEntries[label.id()] : nullptr;
   if (ASMJIT_UNLIKELY(!le))
     return DebugUtils::errored(kErrorInvalidLabel);
 
@@ -734,7 +927,7 @@ ASMJIT_API Error CodeHolder::bindLabel(const Label& label, uint32_t toSectionId,
       ASMJIT_ASSERT(buf.size() - size_t(linkOffset) >= link->format.regionSize());
 
       // Overwrite a real displacement in the CodeBuffer.
-      if (!CodeWriterUtils::writeOffset(buf._data + linkOffset, displacement, link->format)) {
+      if (!CodeWriterUtils::writeOffset(buf.dataAt(linkOffset), displacement, link->format)) {
         err = DebugUtils::errored(kErrorInvalidDisplacement);
         link.next();
         continue;
@@ -751,6 +944,7 @@ ASMJIT_API Error CodeHolder::bindLabel(const Label& label, uint32_t toSectionId,
 // ========================
 
 Error CodeHolder::newRelocEntry(RelocEntry** dst, RelocType relocType) noexcept {
+  CodeHolderLockGuard guard(this);
   ASMJIT_PROPAGATE(_relocations.willGrow(&_allocator));
 
   uint32_t relocId = _relocations.size();
@@ -765,12 +959,45 @@ Error CodeHolder::newRelocEntry(RelocEntry** dst, RelocType relocType) noexcept
   re->_relocType = relocType;
   re->_sourceSectionId = Globals::kInvalidId;
   re->_targetSectionId = Globals::kInvalidId;
+
+  if (relocType == RelocType::kExpression) {
+    Expression* exp = _zone.newT<Expression>();
+    if (ASMJIT_UNLIKELY(!exp))
+      return DebugUtils::errored(kErrorOutOfMemory);
+
+    exp->reset();
+    re->_payload = uint64_t(uintptr_t(exp));
+  }
+
   _relocations.appendUnsafe(re);
 
   *dst = re;
   return kErrorOk;
 }
 
+// CodeHolder - Stack Maps
+// =======================
+
+Error CodeHolder::addStackMap(const Label& label, const StackMapEntry* entries, uint32_t entryCount) noexcept {
+  CodeHolderLockGuard guard(this);
+
+  if (ASMJIT_UNLIKELY(!isLabelValid(label)))
+    return DebugUtils::errored(kErrorInvalidLabel);
+
+  uint32_t entryIndex = _stackMapEntries.size();
+  if (ASMJIT_UNLIKELY(entryCount > std::numeric_limits<uint32_t>::max() - entryIndex))
+    return DebugUtils::errored(kErrorTooLarge);
+
+  ASMJIT_PROPAGATE(_stackMaps.willGrow(&_allocator));
+  ASMJIT_PROPAGATE(_stackMapEntries.reserve(&_allocator, entryIndex + entryCount));
+
+  for (uint32_t i = 0; i < entryCount; i++)
+    _stackMapEntries.appendUnsafe(entries[i]);
+
+  _stackMaps.appendUnsafe(StackMap{label.id(), entryIndex, entryCount});
+  return kErrorOk;
+}
+
 // CodeHolder - Expression Evaluation
 // ==================================
 
@@ -851,6 +1078,8 @@ static Error CodeHolder_evaluateExpression(CodeHolder* self, Expression* exp, ui
 // ======================
 
 Error CodeHolder::flatten() noexcept {
+  TelemetryScope telemetry(_telemetrySink, TelemetryStage::kFlatten, this);
+
   uint64_t offset = 0;
   for (Section* section : _sectionsByOrder) {
     uint64_t realSize = section->realSize();
@@ -884,6 +1113,7 @@ Error CodeHolder::flatten() noexcept {
     offset += realSize;
   }
 
+  telemetry.setByteCount(offset);
   return kErrorOk;
 }
 
@@ -908,6 +1138,12 @@ size_t CodeHolder::codeSize() const noexcept {
 }
 
 Error CodeHolder::relocateToBase(uint64_t baseAddress) noexcept {
+  TelemetryScope telemetry(_telemetrySink, TelemetryStage::kRelocate, this);
+  if (telemetry.isActive()) {
+    telemetry.setByteCount(codeSize());
+    telemetry.setInstCount(_relocations.size());
+  }
+
   // Base address must be provided.
   if (ASMJIT_UNLIKELY(baseAddress == Globals::kNoBaseAddress))
     return DebugUtils::errored(kErrorInvalidArgument);
@@ -915,8 +1151,9 @@ Error CodeHolder::relocateToBase(uint64_t baseAddress) noexcept {
   _baseAddress = baseAddress;
   uint32_t addressSize = _environment.registerSize();
 
+  // Slots assigned by a previous relocation are kept, new entries are appended after them.
   Section* addressTableSection = _addressTableSection;
-  uint32_t addressTableEntryCount = 0;
+  uint32_t addressTableFirstNewSlot = _addressTableSlotCount;
   uint8_t* addressTableEntryData = nullptr;
 
   if (addressTableSection) {
@@ -947,7 +1184,8 @@ Error CodeHolder::relocateToBase(uint64_t baseAddress) noexcept {
                         sourceSection->bufferSize() - size_t(re->sourceOffset()) < regionSize))
       return DebugUtils::errored(kErrorInvalidRelocEntry);
 
-    uint8_t* buffer = sourceSection->data();
+    // A relocated region never crosses a segment boundary of a segmented buffer.
+    uint8_t* region = sourceSection->buffer().dataAt(size_t(sourceOffset));
 
     switch (re->relocType()) {
       case RelocType::kExpression: {
@@ -988,9 +1226,15 @@ Error CodeHolder::relocateToBase(uint64_t baseAddress) noexcept {
         if (re->format().valueSize() != 4 || valueOffset < 2)
           return DebugUtils::errored(kErrorInvalidRelocEntry);
 
+        // The instruction could have been patched to use the address table by a previous relocation, in that case
+        // it must use the address table again as it's no longer a `jmp/call` with a relative displacement.
+        uint8_t* valuePtr = region + re->format().valueOffset();
+        bool usesAddressTable = valuePtr[-2] == 0xFF && (valuePtr[-1] == x86EncodeMod(0, 2, 5) ||
+                                                         valuePtr[-1] == x86EncodeMod(0, 4, 5));
+
         // First try whether a relative 32-bit displacement would work.
         value -= baseAddress + sectionOffset + sourceOffset + regionSize;
-        if (!Support::isInt32(int64_t(value))) {
+        if (usesAddressTable || !Support::isInt32(int64_t(value))) {
           // Relative 32-bit displacement is not possible, use '.addrtab' section.
           AddressTableEntry* atEntry = _addressTableEntries.get(re->payload());
           if (ASMJIT_UNLIKELY(!atEntry))
@@ -1000,7 +1244,7 @@ Error CodeHolder::relocateToBase(uint64_t baseAddress) noexcept {
           ASMJIT_ASSERT(addressTableSection != nullptr);
 
           if (!atEntry->hasAssignedSlot())
-            atEntry->_slot = addressTableEntryCount++;
+            atEntry->_slot = _addressTableSlotCount++;
 
           size_t atEntryIndex = size_t(atEntry->slot()) * addressSize;
           uint64_t addrSrc = sectionOffset + sourceOffset + regionSize;
@@ -1012,7 +1256,7 @@ Error CodeHolder::relocateToBase(uint64_t baseAddress) noexcept {
 
           // Bytes that replace [REX, OPCODE] bytes.
           uint32_t byte0 = 0xFF;
-          uint32_t byte1 = buffer[valueOffset - 1];
+          uint32_t byte1 = valuePtr[-1];
 
           if (byte1 == 0xE8) {
             // Patch CALL/MOD byte to FF /2 (-> 0x15).
@@ -1022,13 +1266,13 @@ Error CodeHolder::relocateToBase(uint64_t baseAddress) noexcept {
             // Patch JMP/MOD byte to FF /4 (-> 0x25).
             byte1 = x86EncodeMod(0, 4, 5);
           }
-          else {
+          else if (!usesAddressTable) {
             return DebugUtils::errored(kErrorInvalidRelocEntry);
           }
 
           // Patch `jmp/call` instruction.
-          buffer[valueOffset - 2] = uint8_t(byte0);
-          buffer[valueOffset - 1] = uint8_t(byte1);
+          valuePtr[-2] = uint8_t(byte0);
+          valuePtr[-1] = uint8_t(byte1);
 
           Support::writeU64uLE(addressTableEntryData + atEntryIndex, re->payload());
         }
@@ -1039,7 +1283,7 @@ Error CodeHolder::relocateToBase(uint64_t baseAddress) noexcept {
         return DebugUtils::errored(kErrorInvalidRelocEntry);
     }
 
-    if (!CodeWriterUtils::writeOffset(buffer + re->sourceOffset(), int64_t(value), re->format())) {
+    if (!CodeWriterUtils::writeOffset(region, int64_t(value), re->format())) {
       return DebugUtils::errored(kErrorInvalidRelocEntry);
     }
   }
@@ -1048,14 +1292,30 @@ Error CodeHolder::relocateToBase(uint64_t baseAddress) noexcept {
   if (_sectionsByOrder.last() == addressTableSection) {
     ASMJIT_ASSERT(addressTableSection != nullptr);
 
-    size_t addressTableSize = addressTableEntryCount * addressSize;
+    size_t addressTableSize = size_t(_addressTableSlotCount) * addressSize;
     addressTableSection->_buffer._size = addressTableSize;
     addressTableSection->_virtualSize = addressTableSize;
   }
 
+  // Only entries that got a slot by this relocation are accounted, so relocating again doesn't count them twice.
+  if (_codeSizeReport) {
+    size_t newEntryCount = _addressTableSlotCount - addressTableFirstNewSlot;
+    _codeSizeReport->_addBytes(CodeSizeCategory::kAddressTable, newEntryCount * addressSize);
+  }
+
   return kErrorOk;
 }
 
+// Copies the content of `buffer` to `dst`, gathering all segments if the buffer is segmented.
+static void CodeHolder_copyBufferData(uint8_t* dst, const CodeBuffer& buffer) noexcept {
+  for (uint32_t i = 0; i < buffer._segmentCount; i++) {
+    const CodeBufferSegment& segment = buffer._segments[i];
+    memcpy(dst + segment.offset, segment.data, segment.size);
+  }
+
+  memcpy(dst + buffer._segmentOffset, buffer._data, buffer._size - buffer._segmentOffset);
+}
+
 Error CodeHolder::copySectionData(void* dst, size_t dstSize, uint32_t sectionId, CopySectionFlags copyFlags) noexcept {
   if (ASMJIT_UNLIKELY(!isSectionValid(sectionId)))
     return DebugUtils::errored(kErrorInvalidSection);
@@ -1066,7 +1326,7 @@ Error CodeHolder::copySectionData(void* dst, size_t dstSize, uint32_t sectionId,
   if (ASMJIT_UNLIKELY(dstSize < bufferSize))
     return DebugUtils::errored(kErrorInvalidArgument);
 
-  memcpy(dst, section->data(), bufferSize);
+  CodeHolder_copyBufferData(static_cast<uint8_t*>(dst), section->buffer());
 
   if (bufferSize < dstSize && Support::test(copyFlags, CopySectionFlags::kPadSectionBuffer)) {
     size_t paddingSize = dstSize - bufferSize;
@@ -1090,7 +1350,7 @@ Error CodeHolder::copyFlattenedData(void* dst, size_t dstSize, CopySectionFlags
 
     uint8_t* dstTarget = static_cast<uint8_t*>(dst) + offset;
     size_t paddingSize = 0;
-    memcpy(dstTarget, section->data(), bufferSize);
+    CodeHolder_copyBufferData(dstTarget, section->buffer());
 
     if (Support::test(copyFlags, CopySectionFlags::kPadSectionBuffer) && bufferSize < section->virtualSize()) {
       paddingSize = Support::min<size_t>(dstSize - offset, size_t(section->virtualSize())) - bufferSize;
@@ -10,6 +10,7 @@
 #include "../core/codebuffer.h"
 #include "../core/errorhandler.h"
 #include "../core/operand.h"
+#include "../core/osutils.h"
 #include "../core/string.h"
 #include "../core/support.h"
 #include "../core/target.h"
@@ -26,8 +27,10 @@ ASMJIT_BEGIN_NAMESPACE
 
 class BaseEmitter;
 class CodeHolder;
+class CodeSizeReport;
 class LabelEntry;
 class Logger;
+class TelemetrySink;
 
 //! Operator type that can be used within an \ref Expression.
 enum class ExpressionOpType : uint8_t {
@@ -180,6 +183,8 @@ public:
   inline const char* name() const noexcept { return _name.str; }
 
   //! Returns the section data.
+  //!
+  //! \note Only data of the active segment are returned if the buffer is segmented, see \ref CodeBuffer::data().
   inline uint8_t* data() noexcept { return _buffer.data(); }
   //! \overload
   inline const uint8_t* data() const noexcept { return _buffer.data(); }
@@ -474,6 +479,84 @@ struct RelocEntry {
   //! \}
 };
 
+//! Location of a value described by \ref StackMapEntry.
+enum class StackMapLocation : uint8_t {
+  //! The value is in a physical register.
+  kReg = 0,
+  //! The value is in memory addressed by a base register (stack or frame pointer) and an offset.
+  kStack = 1,
+
+  //! Maximum value of `StackMapLocation`.
+  kMaxValue = kStack
+};
+
+//! Location of a single value that is live at a call site, see \ref StackMap.
+struct StackMapEntry {
+  //! \name Members
+  //! \{
+
+  //! Id of the virtual register that holds the value.
+  uint32_t _virtId;
+  //! Location of the value.
+  StackMapLocation _location;
+  //! Group of the register (always \ref RegGroup::kGp if the value is in memory).
+  RegGroup _regGroup;
+  //! Physical register that holds the value or base register of the memory that holds the value.
+  uint8_t _regId;
+  //! Reserved for future use.
+  uint8_t _reserved;
+  //! Offset relative to the base register (only used by \ref StackMapLocation::kStack).
+  int32_t _offset;
+
+  //! \}
+
+  //! \name Accessors
+  //! \{
+
+  inline uint32_t virtId() const noexcept { return _virtId; }
+  inline StackMapLocation location() const noexcept { return _location; }
+
+  inline bool isReg() const noexcept { return _location == StackMapLocation::kReg; }
+  inline bool isStack() const noexcept { return _location == StackMapLocation::kStack; }
+
+  inline RegGroup regGroup() const noexcept { return _regGroup; }
+  inline uint32_t regId() const noexcept { return _regId; }
+  inline int32_t offset() const noexcept { return _offset; }
+
+  //! \}
+};
+
+//! Stack map of a single call site.
+//!
+//! Describes where each tagged virtual register (see \ref VirtReg::isTagged()) that is live across a call is while
+//! the callee executes. Stack maps are keyed by a label that is bound at the return address of the call, so its
+//! offset is the offset of the return address. Registers are physical registers that survive the call (the callee
+//! must preserve them) and memory locations are relative to the stack pointer or frame pointer of the function, which
+//! don't change during the call. A collector that moves objects must update the values at these locations before the
+//! call returns.
+struct StackMap {
+  //! \name Members
+  //! \{
+
+  //! Label bound at the return address of the call.
+  uint32_t _labelId;
+  //! Index of the first entry in \ref CodeHolder::stackMapEntries().
+  uint32_t _entryIndex;
+  //! Number of entries.
+  uint32_t _entryCount;
+
+  //! \}
+
+  //! \name Accessors
+  //! \{
+
+  inline uint32_t labelId() const noexcept { return _labelId; }
+  inline uint32_t entryIndex() const noexcept { return _entryIndex; }
+  inline uint32_t entryCount() const noexcept { return _entryCount; }
+
+  //! \}
+};
+
 //! Type of the \ref Label.
 enum class LabelType : uint8_t {
   //! Anonymous label that can optionally have a name, which is only used for debugging purposes.
@@ -647,6 +730,10 @@ public:
   Logger* _logger;
   //! Attached `ErrorHandler`.
   ErrorHandler* _errorHandler;
+  //! Attached `TelemetrySink`.
+  TelemetrySink* _telemetrySink;
+  //! Attached `CodeSizeReport`.
+  CodeSizeReport* _codeSizeReport;
 
   //! Code zone (used to allocate core structures).
   Zone _zone;
@@ -672,6 +759,19 @@ public:
   Section* _addressTableSection;
   //! Address table entries.
   ZoneTree<AddressTableEntry> _addressTableEntries;
+  //! Number of address table entries that have a slot assigned by \ref relocateToBase().
+  uint32_t _addressTableSlotCount;
+  //! Stack maps of call sites.
+  ZoneVector<StackMap> _stackMaps;
+  //! Entries of all stack maps.
+  ZoneVector<StackMapEntry> _stackMapEntries;
+
+  //! Lock that synchronizes emitters running in multiple threads, only used if the CodeHolder is thread-safe.
+  mutable Lock _lock;
+  //! Whether the CodeHolder is thread-safe, see \ref setThreadSafe().
+  bool _threadSafe;
+  //! Size of a segment of segmented code buffers or zero if buffers are contiguous, see \ref setBufferSegmentSize().
+  size_t _bufferSegmentSize;
 
   //! \}
 
@@ -713,6 +813,33 @@ public:
 
   //! \}
 
+  //! \name Thread Safety
+  //! \{
+
+  //! Tests whether the CodeHolder is thread-safe, see \ref setThreadSafe().
+  inline bool isThreadSafe() const noexcept { return _threadSafe; }
+
+  //! Makes the CodeHolder safe to be used by multiple assemblers that emit code concurrently from multiple threads.
+  //!
+  //! Each assembler must emit into its own \ref Section. Only the following functions are then synchronized and can
+  //! be called from multiple threads, so a label created by one assembler can be used by others:
+  //!
+  //!   - \ref newSection(), \ref newLabelEntry(), \ref newNamedLabelEntry(), and \ref labelIdByName().
+  //!   - \ref labelEntry(), \ref isLabelValid(), \ref isLabelBound(), \ref labelBinding(), and \ref bindLabel().
+  //!   - \ref newLabelLink(), \ref newRelocEntry(), \ref addAddressToAddressTable(), and \ref addStackMap().
+  //!
+  //! Assemblers only access the CodeHolder through these functions. Fields of \ref LabelEntry are not synchronized,
+  //! use \ref labelBinding() to query where a label is bound while other threads can bind it. Links to labels bound
+  //! in a different section are resolved by \ref resolveUnresolvedLinks() after all assemblers have finished, which
+  //! \ref JitRuntime::add() does implicitly.
+  //!
+  //! \note Synchronization has a cost, so CodeHolder is not thread-safe by default. Everything else, for example
+  //! attaching and detaching emitters, changing the logger or error handler, and functions that process the whole
+  //! code, like \ref flatten() and \ref relocateToBase(), must still be called from a single thread.
+  inline void setThreadSafe(bool value) noexcept { _threadSafe = value; }
+
+  //! \}
+
   //! \name Allocators
   //! \{
 
@@ -723,6 +850,16 @@ public:
   //! destructor.
   inline ZoneAllocator* allocator() const noexcept { return const_cast<ZoneAllocator*>(&_allocator); }
 
+  //! Returns the memory allocator of the `CodeHolder`, see \ref setMemAllocator().
+  inline MemAllocator* memAllocator() const noexcept { return _zone.memAllocator(); }
+
+  //! Sets the memory allocator that allocates the zone of the `CodeHolder`, data of its code buffers, and zones of
+  //! emitters attached to it. \ref MemAllocator::host() is used if `memAllocator` is null.
+  //!
+  //! Returns \ref kErrorAlreadyInitialized if the `CodeHolder` is initialized - the allocator can only be changed
+  //! before \ref init() or after \ref reset().
+  ASMJIT_API Error setMemAllocator(MemAllocator* memAllocator) noexcept;
+
   //! \}
 
   //! \name Code & Architecture
@@ -775,6 +912,33 @@ public:
 
   //! \}
 
+  //! \name Telemetry
+  //! \{
+
+  //! Returns the attached telemetry sink, see \ref TelemetrySink.
+  inline TelemetrySink* telemetrySink() const noexcept { return _telemetrySink; }
+  //! Attaches a telemetry sink to this `CodeHolder`, which receives events of \ref TelemetryStage::kRunPasses,
+  //! \ref TelemetryStage::kRunPass, and \ref TelemetryStage::kSerialize of attached emitters, and events of
+  //! \ref flatten(), \ref resolveUnresolvedLinks(), and \ref relocateToBase().
+  inline void setTelemetrySink(TelemetrySink* sink) noexcept { _telemetrySink = sink; }
+  //! Resets the telemetry sink to none.
+  inline void resetTelemetrySink() noexcept { setTelemetrySink(nullptr); }
+
+  //! \}
+
+  //! \name Code Size Analysis
+  //! \{
+
+  //! Returns the attached code size report, see \ref CodeSizeReport.
+  inline CodeSizeReport* codeSizeReport() const noexcept { return _codeSizeReport; }
+  //! Attaches a code size report to this `CodeHolder`, which accounts all bytes emitted by attached assemblers
+  //! from now on, and entries of the address table created by \ref relocateToBase().
+  ASMJIT_API void setCodeSizeReport(CodeSizeReport* report) noexcept;
+  //! Resets the code size report to none.
+  inline void resetCodeSizeReport() noexcept { setCodeSizeReport(nullptr); }
+
+  //! \}
+
   //! \name Code Buffer
   //! \{
 
@@ -785,9 +949,27 @@ public:
 
   //! Reserves the size of `cb` to at least `n` bytes.
   //!
+  //! If `cb` is segmented only its active segment is reserved, in which case `n` still describes the size of the
+  //! whole buffer.
+  //!
   //! \note The buffer `cb` must be managed by `CodeHolder` - otherwise the behavior of the function is undefined.
   ASMJIT_API Error reserveBuffer(CodeBuffer* cb, size_t n) noexcept;
 
+  //! Returns the size of a segment of segmented code buffers, or zero if code buffers are always contiguous.
+  inline size_t bufferSegmentSize() const noexcept { return _bufferSegmentSize; }
+
+  //! Sets the size of a segment of segmented code buffers, zero (the default) makes code buffers contiguous.
+  //!
+  //! When a buffer that has at least `segmentSize` bytes needs to grow, it continues in a new segment of at least
+  //! `segmentSize` bytes instead of being reallocated, so the data already emitted is never copied. This is mostly
+  //! useful for very large sections, which would otherwise be reallocated and copied many times. Assemblers switch
+  //! segments only between instructions and only if all assemblers that emit to the buffer are at its end. Data
+  //! of segmented buffers are gathered by \ref copySectionData() and \ref copyFlattenedData(), see \ref
+  //! CodeBuffer::isSegmented() for more details.
+  //!
+  //! \note An assembler cannot use \ref BaseAssembler::setOffset() to move to a closed segment.
+  ASMJIT_API void setBufferSegmentSize(size_t segmentSize) noexcept;
+
   //! \}
 
   //! \name Sections
@@ -859,17 +1041,21 @@ public:
 
   //! Tests whether the label having `id` is valid (i.e. created by `newLabelEntry()`).
   inline bool isLabelValid(uint32_t labelId) const noexcept {
+    if (ASMJIT_UNLIKELY(_threadSafe))
+      return _labelEntryThreadSafe(labelId) != nullptr;
     return labelId < _labelEntries.size();
   }
 
   //! Tests whether the `label` is valid (i.e. created by `newLabelEntry()`).
   inline bool isLabelValid(const Label& label) const noexcept {
-    return label.id() < _labelEntries.size();
+    return isLabelValid(label.id());
   }
 
   //! \overload
   inline bool isLabelBound(uint32_t labelId) const noexcept {
-    return isLabelValid(labelId) && _labelEntries[labelId]->isBound();
+    LabelEntry* le = labelEntry(labelId);
+    uint64_t offset;
+    return le && labelBinding(le, &offset) != nullptr;
   }
 
   //! Tests whether the `label` is already bound.
@@ -881,9 +1067,29 @@ public:
 
   //! Returns LabelEntry of the given label `id`.
   inline LabelEntry* labelEntry(uint32_t labelId) const noexcept {
-    return isLabelValid(labelId) ? _labelEntries[labelId] : static_cast<LabelEntry*>(nullptr);
+    if (ASMJIT_UNLIKELY(_threadSafe))
+      return _labelEntryThreadSafe(labelId);
+    return labelId < _labelEntries.size() ? _labelEntries[labelId] : static_cast<LabelEntry*>(nullptr);
+  }
+
+  //! Returns LabelEntry of the given label `id` while holding the lock (thread-safe version of `labelEntry()`).
+  ASMJIT_API LabelEntry* _labelEntryThreadSafe(uint32_t labelId) const noexcept;
+
+  //! Returns the section the label `le` is bound to and stores the label offset to `offsetOut`, returns null if the
+  //! label is not bound.
+  //!
+  //! Unlike \ref LabelEntry::section() and \ref LabelEntry::offset() this is synchronized if the CodeHolder is
+  //! thread-safe (see \ref setThreadSafe()), so it can be used while other threads bind labels.
+  inline Section* labelBinding(const LabelEntry* le, uint64_t* offsetOut) const noexcept {
+    if (ASMJIT_UNLIKELY(_threadSafe))
+      return _labelBindingThreadSafe(le, offsetOut);
+    *offsetOut = le->_offset;
+    return le->_section;
   }
 
+  //! Returns binding of the label `le` while holding the lock (thread-safe version of `labelBinding()`).
+  ASMJIT_API Section* _labelBindingThreadSafe(const LabelEntry* le, uint64_t* offsetOut) const noexcept;
+
   //! Returns LabelEntry of the given `label`.
   inline LabelEntry* labelEntry(const Label& label) const noexcept {
     return labelEntry(label.id());
@@ -895,7 +1101,7 @@ public:
   //! which is their initial offset value.
   inline uint64_t labelOffset(uint32_t labelId) const noexcept {
     ASMJIT_ASSERT(isLabelValid(labelId));
-    return _labelEntries[labelId]->offset();
+    return labelEntry(labelId)->offset();
   }
 
   //! \overload
@@ -909,7 +1115,7 @@ public:
   //! otherwise the value returned will not be reliable.
   inline uint64_t labelOffsetFromBase(uint32_t labelId) const noexcept {
     ASMJIT_ASSERT(isLabelValid(labelId));
-    const LabelEntry* le = _labelEntries[labelId];
+    const LabelEntry* le = labelEntry(labelId);
     return (le->isBound() ? le->section()->offset() : uint64_t(0)) + le->offset();
   }
 
@@ -960,8 +1166,12 @@ public:
 
   //! Creates a new label-link used to store information about yet unbound labels.
   //!
+  //! If `relocId` is a valid relocation id the link updates the relocation instead of patching the code when the
+  //! label gets bound. If the label has already been bound (which can only happen if the CodeHolder is thread-safe
+  //! and the label was bound by another thread) the relocation is updated immediately.
+  //!
   //! Returns `null` if the allocation failed.
-  ASMJIT_API LabelLink* newLabelLink(LabelEntry* le, uint32_t sectionId, size_t offset, intptr_t rel, const OffsetFormat& format) noexcept;
+  ASMJIT_API LabelLink* newLabelLink(LabelEntry* le, uint32_t sectionId, size_t offset, intptr_t rel, const OffsetFormat& format, uint32_t relocId = Globals::kInvalidId) noexcept;
 
   //! Resolves cross-section links (`LabelLink`) associated with each label that was used as a destination in code
   //! of a different section. It's only useful to people that use multiple sections as it will do nothing if the code
@@ -988,11 +1198,39 @@ public:
 
   //! Creates a new relocation entry of type `relocType`.
   //!
-  //! Additional fields can be set after the relocation entry was created.
+  //! Additional fields can be set after the relocation entry was created. If `relocType` is \ref RelocType::kExpression
+  //! the payload of the relocation entry is set to a new \ref Expression, which must be initialized by the caller.
   ASMJIT_API Error newRelocEntry(RelocEntry** dst, RelocType relocType) noexcept;
 
   //! \}
 
+  //! \name Stack Maps
+  //! \{
+
+  //! Tests whether the code contains stack maps.
+  inline bool hasStackMaps() const noexcept { return !_stackMaps.empty(); }
+  //! Returns stack maps of all call sites.
+  inline const ZoneVector<StackMap>& stackMaps() const noexcept { return _stackMaps; }
+  //! Returns entries of all stack maps, each \ref StackMap references a range of this array.
+  inline const ZoneVector<StackMapEntry>& stackMapEntries() const noexcept { return _stackMapEntries; }
+
+  //! Returns entries of the given `stackMap`.
+  inline const StackMapEntry* stackMapEntries(const StackMap& stackMap) const noexcept {
+    return _stackMapEntries.data() + stackMap.entryIndex();
+  }
+
+  //! Returns the offset of the return address of the given `stackMap` relative to the base address.
+  //!
+  //! \remarks The offset is only final after the code has been flattened, see \ref labelOffsetFromBase().
+  inline uint64_t stackMapOffset(const StackMap& stackMap) const noexcept {
+    return labelOffsetFromBase(stackMap.labelId());
+  }
+
+  //! Adds a stack map of a call site, which returns to `label`, that consists of `entryCount` entries.
+  ASMJIT_API Error addStackMap(const Label& label, const StackMapEntry* entries, uint32_t entryCount) noexcept;
+
+  //! \}
+
   //! \name Utilities
   //! \{
 
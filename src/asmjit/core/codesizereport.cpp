@@ -0,0 +1,193 @@
+// This file is part of AsmJit project <https://asmjit.com>
+//
+// See asmjit.h or LICENSE.md for license and copyright information
+// SPDX-License-Identifier: Zlib
+
+#include "../core/api-build_p.h"
+#include "../core/codesizereport.h"
+#include "../core/environment.h"
+#include "../core/support.h"
+
+ASMJIT_BEGIN_NAMESPACE
+
+// CodeSizeReport - Construction & Destruction
+// ===========================================
+
+CodeSizeReport::CodeSizeReport() noexcept
+  : _zone(4096 - Zone::kBlockOverhead),
+    _allocator(&_zone),
+    _arch(Arch::kUnknown),
+    _instCount(0) {
+  memset(_categorySizes, 0, sizeof(_categorySizes));
+}
+
+CodeSizeReport::~CodeSizeReport() noexcept {}
+
+void CodeSizeReport::reset() noexcept {
+  _instStats.reset();
+  _encodingStats.reset();
+  _allocator.reset(&_zone);
+  _zone.reset();
+
+  _arch = Arch::kUnknown;
+  _instCount = 0;
+  memset(_categorySizes, 0, sizeof(_categorySizes));
+}
+
+// CodeSizeReport - Accessors
+// ==========================
+
+uint64_t CodeSizeReport::totalSize() const noexcept {
+  uint64_t size = 0;
+  for (uint64_t categorySize : _categorySizes)
+    size += categorySize;
+  return size;
+}
+
+// CodeSizeReport - Internal
+// =========================
+
+Error CodeSizeReport::_addInst(Arch arch, InstId instId, uint32_t encodingId, size_t size, uint32_t instIdCount, uint32_t encodingIdCount) noexcept {
+  ASMJIT_ASSERT(instId < instIdCount);
+  ASMJIT_ASSERT(encodingId < encodingIdCount);
+
+  if (ASMJIT_UNLIKELY(_arch != arch)) {
+    // Instruction and encoding ids are only meaningful within a single architecture family.
+    if (_arch != Arch::kUnknown && !(Environment::isFamilyX86(_arch) && Environment::isFamilyX86(arch)))
+      return DebugUtils::errored(kErrorInvalidArch);
+    _arch = arch;
+  }
+
+  if (ASMJIT_UNLIKELY(_instStats.size() < instIdCount))
+    ASMJIT_PROPAGATE(_instStats.resize(&_allocator, instIdCount));
+
+  if (ASMJIT_UNLIKELY(_encodingStats.size() < encodingIdCount))
+    ASMJIT_PROPAGATE(_encodingStats.resize(&_allocator, encodingIdCount));
+
+  Statistics& instStats = _instStats[instId];
+  instStats.count++;
+  instStats.size += size;
+
+  Statistics& encodingStats = _encodingStats[encodingId];
+  encodingStats.count++;
+  encodingStats.size += size;
+
+  _instCount++;
+  return kErrorOk;
+}
+
+// CodeSizeReport - Formatting
+// ===========================
+
+static const char codeSizeCategoryNames[] =
+  "Opcode\0"
+  "LegacyPrefix\0"
+  "Rex\0"
+  "Vex2\0"
+  "Vex3\0"
+  "Xop\0"
+  "Evex\0"
+  "Displacement\0"
+  "Immediate\0"
+  "Alignment\0"
+  "Data\0"
+  "ConstPool\0"
+  "AddressTable\0";
+
+static const uint8_t codeSizeCategoryNameIndex[] = {
+  0, 7, 20, 24, 29, 34, 38, 43, 56, 66, 76, 81, 91
+};
+
+static_assert(ASMJIT_ARRAY_SIZE(codeSizeCategoryNameIndex) == uint32_t(CodeSizeCategory::kMaxValue) + 1,
+              "CodeSizeCategory: update 'codeSizeCategoryNameIndex' table");
+
+static inline double CodeSizeReport_percent(uint64_t size, uint64_t total) noexcept {
+  return total ? double(size) * 100.0 / double(total) : 0.0;
+}
+
+// Stores ids of at most `maxCount` entries of `stats` that use most bytes to `out`, sorted by size (descending).
+static uint32_t CodeSizeReport_selectLargest(const ZoneVector<CodeSizeReport::Statistics>& stats, uint32_t* out, uint32_t maxCount) noexcept {
+  uint32_t count = 0;
+
+  for (uint32_t id = 0; id < stats.size(); id++) {
+    uint64_t size = stats[id].size;
+    if (!size)
+      continue;
+
+    uint32_t i = count;
+    while (i > 0 && stats[out[i - 1]].size < size)
+      i--;
+
+    if (i >= maxCount)
+      continue;
+
+    uint32_t last = Support::min(count, maxCount - 1);
+    for (uint32_t j = last; j > i; j--)
+      out[j] = out[j - 1];
+
+    out[i] = id;
+    count = Support::min(count + 1, maxCount);
+  }
+
+  return count;
+}
+
+static Error CodeSizeReport_formatStats(String& sb, const CodeSizeReport* self, const ZoneVector<CodeSizeReport::Statistics>& stats, const char* title, bool isEncoding, uint32_t maxEntries) noexcept {
+  uint32_t ids[32];
+  uint32_t count = CodeSizeReport_selectLargest(stats, ids, Support::min<uint32_t>(maxEntries, ASMJIT_ARRAY_SIZE(ids)));
+
+  if (!count)
+    return kErrorOk;
+
+  uint64_t total = self->totalSize();
+  ASMJIT_PROPAGATE(sb.appendFormat("\n%-24s %10s %12s %8s %8s\n", title, "Count", "Bytes", "Avg", "%"));
+
+  for (uint32_t i = 0; i < count; i++) {
+    uint32_t id = ids[i];
+    const CodeSizeReport::Statistics& s = stats[id];
+
+    StringTmp<64> name;
+#ifndef ASMJIT_NO_TEXT
+    Error err = isEncoding ? InstAPI::encodingIdToString(self->arch(), id, name)
+                           : InstAPI::instIdToString(self->arch(), id, name);
+    if (err)
+      name.assignFormat("#%u", id);
+#else
+    DebugUtils::unused(isEncoding);
+    name.assignFormat("#%u", id);
+#endif
+
+    ASMJIT_PROPAGATE(sb.appendFormat("%-24s %10llu %12llu %8.2f %7.2f%%\n",
+      name.data(),
+      (unsigned long long)s.count,
+      (unsigned long long)s.size,
+      double(s.size) / double(s.count),
+      CodeSizeReport_percent(s.size, total)));
+  }
+
+  return kErrorOk;
+}
+
+Error CodeSizeReport::format(String& sb, uint32_t maxEntries) const noexcept {
+  uint64_t total = totalSize();
+
+  ASMJIT_PROPAGATE(sb.appendFormat("%-24s %12s %8s\n", "Category", "Bytes", "%"));
+  for (uint32_t i = 0; i <= uint32_t(CodeSizeCategory::kMaxValue); i++) {
+    uint64_t size = _categorySizes[i];
+    if (!size)
+      continue;
+
+    ASMJIT_PROPAGATE(sb.appendFormat("%-24s %12llu %7.2f%%\n",
+      codeSizeCategoryNames + codeSizeCategoryNameIndex[i],
+      (unsigned long long)size,
+      CodeSizeReport_percent(size, total)));
+  }
+  ASMJIT_PROPAGATE(sb.appendFormat("%-24s %12llu (%llu instructions)\n", "Total", (unsigned long long)total, (unsigned long long)_instCount));
+
+  ASMJIT_PROPAGATE(CodeSizeReport_formatStats(sb, this, _instStats, "Instruction", false, maxEntries));
+  ASMJIT_PROPAGATE(CodeSizeReport_formatStats(sb, this, _encodingStats, "Encoding", true, maxEntries));
+
+  return kErrorOk;
+}
+
+ASMJIT_END_NAMESPACE
@@ -0,0 +1,181 @@
+// This file is part of AsmJit project <https://asmjit.com>
+//
+// See asmjit.h or LICENSE.md for license and copyright information
+// SPDX-License-Identifier: Zlib
+
+#ifndef ASMJIT_CORE_CODESIZEREPORT_H_INCLUDED
+#define ASMJIT_CORE_CODESIZEREPORT_H_INCLUDED
+
+#include "../core/archtraits.h"
+#include "../core/inst.h"
+#include "../core/string.h"
+#include "../core/zone.h"
+#include "../core/zonevector.h"
+
+ASMJIT_BEGIN_NAMESPACE
+
+//! \addtogroup asmjit_core
+//! \{
+
+//! Category of bytes accounted by \ref CodeSizeReport.
+enum class CodeSizeCategory : uint32_t {
+  //! Opcode bytes of instructions including X86 ModR/M and SIB bytes (all bytes of instructions on architectures
+  //! that use fixed-size instructions).
+  kOpcode = 0,
+  //! X86 legacy prefixes - operand-size and address-size overrides, segment overrides, LOCK, REP, and mandatory
+  //! prefixes of SSE instructions.
+  kLegacyPrefix,
+  //! X86 REX prefix.
+  kRex,
+  //! X86 2-byte VEX prefix.
+  kVex2,
+  //! X86 3-byte VEX prefix.
+  kVex3,
+  //! X86 XOP prefix.
+  kXop,
+  //! X86 EVEX prefix.
+  kEvex,
+  //! Displacements of memory operands and relative displacements of branches.
+  kDisplacement,
+  //! Immediate values.
+  kImmediate,
+  //! Padding emitted by \ref BaseEmitter::align() (including padding of constant pools).
+  kAlignment,
+  //! Data embedded by \ref BaseEmitter::embed(), \ref BaseEmitter::embedDataArray(), \ref BaseEmitter::embedLabel(),
+  //! and \ref BaseEmitter::embedLabelDelta().
+  kData,
+  //! Constant pools embedded by \ref BaseEmitter::embedConstPool().
+  kConstPool,
+  //! Entries of the address table created by \ref CodeHolder::relocateToBase().
+  kAddressTable,
+
+  //! Maximum value of `CodeSizeCategory`.
+  kMaxValue = kAddressTable
+};
+
+//! Code size report.
+//!
+//! Attributes bytes emitted by assemblers to instructions, encodings, and \ref CodeSizeCategory, which shows what
+//! the code size is spent on - for example how many bytes are spent on REX and EVEX prefixes, or on displacements
+//! that don't fit into 8 bits. Attach the report to \ref CodeHolder by \ref CodeHolder::setCodeSizeReport() before
+//! the code is emitted, the report accumulates all instructions emitted by assemblers attached to it (including
+//! instructions serialized by \ref BaseBuilder and \ref BaseCompiler) and address table entries created by
+//! \ref CodeHolder::relocateToBase(). A single report can be attached to multiple code holders of the same
+//! architecture to analyze a whole workload, but it's not thread-safe.
+//!
+//! Encodings are identifiers that assemblers use to group instructions that are encoded the same way, see
+//! \ref InstAPI::encodingIdToString().
+//!
+//! \note Assemblers take a slower path to emit each instruction when a report is attached.
+class CodeSizeReport {
+public:
+  ASMJIT_NONCOPYABLE(CodeSizeReport)
+
+  //! Statistics of a single instruction or encoding.
+  struct Statistics {
+    //! Number of instructions emitted.
+    uint64_t count;
+    //! Number of bytes emitted.
+    uint64_t size;
+  };
+
+  //! \name Members
+  //! \{
+
+  //! Zone used to allocate statistics.
+  Zone _zone;
+  //! Allocator used by statistics.
+  ZoneAllocator _allocator;
+  //! Architecture of the code accounted by the report.
+  Arch _arch;
+  //! Number of instructions accounted by the report.
+  uint64_t _instCount;
+  //! Number of bytes of each category.
+  uint64_t _categorySizes[uint32_t(CodeSizeCategory::kMaxValue) + 1];
+  //! Statistics of instructions indexed by instruction id.
+  ZoneVector<Statistics> _instStats;
+  //! Statistics of encodings indexed by encoding id.
+  ZoneVector<Statistics> _encodingStats;
+
+  //! \}
+
+  //! \name Construction & Destruction
+  //! \{
+
+  //! Creates a new `CodeSizeReport` instance.
+  ASMJIT_API CodeSizeReport() noexcept;
+  //! Destroys the `CodeSizeReport` instance.
+  ASMJIT_API ~CodeSizeReport() noexcept;
+
+  //! Resets the report to its construction state.
+  ASMJIT_API void reset() noexcept;
+
+  //! \}
+
+  //! \name Accessors
+  //! \{
+
+  //! Returns the architecture of the code accounted by the report, \ref Arch::kUnknown if the report is empty.
+  inline Arch arch() const noexcept { return _arch; }
+
+  //! Returns the number of instructions accounted by the report.
+  inline uint64_t instCount() const noexcept { return _instCount; }
+
+  //! Returns the number of bytes of the given `category`.
+  inline uint64_t categorySize(CodeSizeCategory category) const noexcept {
+    ASMJIT_ASSERT(category <= CodeSizeCategory::kMaxValue);
+    return _categorySizes[uint32_t(category)];
+  }
+
+  //! Returns the number of bytes of all categories.
+  ASMJIT_API uint64_t totalSize() const noexcept;
+
+  //! Returns the size of the instruction id space recorded by the report, all instruction ids are less than it.
+  inline uint32_t instIdCount() const noexcept { return _instStats.size(); }
+  //! Returns statistics of the instruction `instId`.
+  inline Statistics instStats(InstId instId) const noexcept {
+    return instId < _instStats.size() ? _instStats[instId] : Statistics{0, 0};
+  }
+
+  //! Returns the size of the encoding id space recorded by the report, all encoding ids are less than it.
+  inline uint32_t encodingIdCount() const noexcept { return _encodingStats.size(); }
+  //! Returns statistics of the encoding `encodingId`.
+  inline Statistics encodingStats(uint32_t encodingId) const noexcept {
+    return encodingId < _encodingStats.size() ? _encodingStats[encodingId] : Statistics{0, 0};
+  }
+
+  //! \}
+
+  //! \name Formatting
+  //! \{
+
+  //! Appends the report to `sb` - sizes of all categories followed by at most `maxEntries` instructions and
+  //! encodings that use most bytes.
+  ASMJIT_API Error format(String& sb, uint32_t maxEntries = 20) const noexcept;
+
+  //! \}
+
+  //! \cond INTERNAL
+  //! \name Internal
+  //! \{
+
+  //! Adds `size` bytes of the given `category`, which don't belong to an instruction.
+  inline void _addBytes(CodeSizeCategory category, size_t size) noexcept {
+    ASMJIT_ASSERT(category <= CodeSizeCategory::kMaxValue);
+    _categorySizes[uint32_t(category)] += size;
+  }
+
+  //! Adds an instruction of `size` bytes, the bytes must be added to categories separately by \ref _addBytes().
+  //!
+  //! `instIdCount` and `encodingIdCount` describe id spaces of the architecture, so statistics are allocated only once.
+  ASMJIT_API Error _addInst(Arch arch, InstId instId, uint32_t encodingId, size_t size, uint32_t instIdCount, uint32_t encodingIdCount) noexcept;
+
+  //! \}
+  //! \endcond
+};
+
+//! \}
+
+ASMJIT_END_NAMESPACE
+
+#endif // ASMJIT_CORE_CODESIZEREPORT_H_INCLUDED
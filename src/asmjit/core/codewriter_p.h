@@ -153,7 +153,7 @@ public:
 
   ASMJIT_FORCE_INLINE void done(BaseAssembler* a) noexcept {
     CodeBuffer& buffer = a->_section->_buffer;
-    size_t newSize = (size_t)(_cursor - a->_bufferData);
+    size_t newSize = a->_bufferOffset + (size_t)(_cursor - a->_bufferData);
     ASMJIT_ASSERT(newSize <= buffer.capacity());
 
     a->_bufferPtr = _cursor;
@@ -17,6 +17,27 @@
 
 ASMJIT_BEGIN_NAMESPACE
 
+// BaseCompiler - Constant Pools
+// =============================
+
+// Adds a constant pool after `ref` or at the end of the constant pool section if the compiler has one.
+static Error BaseCompiler_addConstPool(BaseCompiler* self, ConstPoolNode* pool, BaseNode* ref) noexcept {
+  Section* section = self->constPoolSection();
+  if (!section) {
+    self->addAfter(pool, ref);
+    return kErrorOk;
+  }
+
+  BaseNode* prevCursor = self->cursor();
+  Error err = self->section(section);
+
+  if (err == kErrorOk)
+    self->addNode(pool);
+
+  self->setCursor(prevCursor);
+  return err;
+}
+
 // GlobalConstPoolPass
 // ===================
 
@@ -36,8 +57,8 @@ public:
     ConstPoolNode* globalConstPool = compiler->_constPools[uint32_t(ConstPoolScope::kGlobal)];
 
     if (globalConstPool) {
-      compiler->addAfter(globalConstPool, compiler->lastNode());
       compiler->_constPools[uint32_t(ConstPoolScope::kGlobal)] = nullptr;
+      return BaseCompiler_addConstPool(compiler, globalConstPool, compiler->lastNode());
     }
 
     return kErrorOk;
@@ -52,7 +73,10 @@ BaseCompiler::BaseCompiler() noexcept
     _func(nullptr),
     _vRegZone(4096 - Zone::kBlockOverhead),
     _vRegArray(),
-    _constPools { nullptr, nullptr } {
+    _constPools { nullptr, nullptr },
+    _constPoolSection(nullptr),
+    _targetCpuInfo(),
+    _compilerOptions(CompilerOptions::kDefault) {
   _emitterType = EmitterType::kCompiler;
   _validationFlags = ValidationFlags::kEnableVirtRegs;
 }
@@ -153,9 +177,8 @@ Error BaseCompiler::endFunc() {
   // Add the local constant pool at the end of the function (if exists).
   ConstPoolNode* localConstPool = _constPools[uint32_t(ConstPoolScope::kLocal)];
   if (localConstPool) {
-    setCursor(func->endNode()->prev());
-    addNode(localConstPool);
     _constPools[uint32_t(ConstPoolScope::kLocal)] = nullptr;
+    ASMJIT_PROPAGATE(BaseCompiler_addConstPool(this, localConstPool, func->endNode()->prev()));
   }
 
   // Mark as finished.
@@ -201,6 +224,94 @@ Error BaseCompiler::addInvokeNode(InvokeNode** out, InstId instId, const Operand
   return kErrorOk;
 }
 
+// BaseCompiler - Phi Nodes
+// ========================
+
+Error BaseCompiler::newPhiNode(PhiNode** out, const BaseReg& dst, uint32_t incomingCount) {
+  PhiNode* node;
+  ASMJIT_PROPAGATE(_newNodeT<PhiNode>(&node, dst));
+
+  if (incomingCount) {
+    node->_incoming = static_cast<PhiNode::Incoming*>(_allocator.alloc(incomingCount * sizeof(PhiNode::Incoming)));
+    if (!node->_incoming)
+      return reportError(DebugUtils::errored(kErrorOutOfMemory));
+
+    for (uint32_t i = 0; i < incomingCount; i++) {
+      node->_incoming[i].value.reset();
+      node->_incoming[i].labelId = Globals::kInvalidId;
+    }
+    node->_incomingCount = incomingCount;
+  }
+
+  *out = node;
+  return kErrorOk;
+}
+
+Error BaseCompiler::addPhiNode(PhiNode** out, const BaseReg& dst, uint32_t incomingCount) {
+  ASMJIT_PROPAGATE(newPhiNode(out, dst, incomingCount));
+  addNode(*out);
+  return kErrorOk;
+}
+
+Error BaseCompiler::phi(const BaseReg& dst, const BaseReg& a, const Label& aFrom, const BaseReg& b, const Label& bFrom) {
+  PhiNode* node;
+  ASMJIT_PROPAGATE(addPhiNode(&node, dst, 2));
+
+  node->setIncoming(0, a, aFrom);
+  node->setIncoming(1, b, bFrom);
+  return kErrorOk;
+}
+
+// BaseCompiler - On-Stack Replacement
+// ====================================
+
+Error BaseCompiler::newOsrEntryNode(OsrEntryNode** out, const FuncSignature& signature) {
+  *out = nullptr;
+
+  // OSR entry shares the frame of the current function, so it must be created within one.
+  FuncNode* func = _func;
+  if (ASMJIT_UNLIKELY(!func))
+    return reportError(DebugUtils::errored(kErrorInvalidState));
+
+  OsrEntryNode* node;
+  ASMJIT_PROPAGATE(_newNodeT<OsrEntryNode>(&node));
+
+  Error err = node->detail().init(signature, environment());
+  if (ASMJIT_UNLIKELY(err))
+    return reportError(err);
+
+  // The prolog and epilog of the function are used, which means that the entry must be compatible with it - it must
+  // use the same calling convention, return the same values, and it cannot have arguments passed by stack.
+  const FuncDetail& funcDetail = func->detail();
+  const FuncDetail& osrDetail = node->detail();
+
+  if (ASMJIT_UNLIKELY(osrDetail.callConv().id() != funcDetail.callConv().id() || osrDetail.hasStackArgs()))
+    return reportError(DebugUtils::errored(kErrorInvalidArgument));
+
+  for (uint32_t valueIndex = 0; valueIndex < Globals::kMaxValuePack; valueIndex++)
+    if (ASMJIT_UNLIKELY(osrDetail.ret(valueIndex)._data != funcDetail.ret(valueIndex)._data))
+      return reportError(DebugUtils::errored(kErrorInvalidArgument));
+
+  node->_args = nullptr;
+  if (node->argCount() != 0) {
+    node->_args = _allocator.allocT<OsrEntryNode::ArgPack>(node->argCount() * sizeof(OsrEntryNode::ArgPack));
+    if (ASMJIT_UNLIKELY(!node->_args))
+      return reportError(DebugUtils::errored(kErrorOutOfMemory));
+    memset(node->_args, 0, node->argCount() * sizeof(OsrEntryNode::ArgPack));
+  }
+
+  ASMJIT_PROPAGATE(registerLabelNode(node));
+
+  *out = node;
+  return kErrorOk;
+}
+
+Error BaseCompiler::addOsrEntryNode(OsrEntryNode** out, const FuncSignature& signature) {
+  ASMJIT_PROPAGATE(newOsrEntryNode(out, signature));
+  addNode(*out);
+  return kErrorOk;
+}
+
 // BaseCompiler - Virtual Registers
 // ================================
 
@@ -462,6 +573,15 @@ void BaseCompiler::rename(const BaseReg& reg, const char* fmt, ...) {
   }
 }
 
+void BaseCompiler::setTagged(const BaseReg& reg, bool value) {
+  if (!reg.isVirtReg()) return;
+
+  VirtReg* vReg = virtRegById(reg.id());
+  if (!vReg) return;
+
+  vReg->setTagged(value);
+}
+
 // BaseCompiler - Jump Annotations
 // ===============================
 
@@ -524,6 +644,8 @@ JumpAnnotation* BaseCompiler::newJumpAnnotation() {
 Error BaseCompiler::onAttach(CodeHolder* code) noexcept {
   ASMJIT_PROPAGATE(Base::onAttach(code));
 
+  _vRegZone.setMemAllocator(code->memAllocator());
+
   const ArchTraits& archTraits = ArchTraits::byArch(code->arch());
   RegType nativeRegType = Environment::is32Bit(code->arch()) ? RegType::kGp32 : RegType::kGp64;
   _gpSignature = archTraits.regTypeToSignature(nativeRegType);
@@ -541,6 +663,7 @@ Error BaseCompiler::onDetach(CodeHolder* code) noexcept {
   _func = nullptr;
   _constPools[uint32_t(ConstPoolScope::kLocal)] = nullptr;
   _constPools[uint32_t(ConstPoolScope::kGlobal)] = nullptr;
+  _constPoolSection = nullptr;
 
   _vRegArray.reset();
   _vRegZone.reset();
@@ -12,6 +12,7 @@
 #include "../core/assembler.h"
 #include "../core/builder.h"
 #include "../core/constpool.h"
+#include "../core/cpuinfo.h"
 #include "../core/compilerdefs.h"
 #include "../core/func.h"
 #include "../core/inst.h"
@@ -27,10 +28,59 @@ class JumpNode;
 class FuncNode;
 class FuncRetNode;
 class InvokeNode;
+class PhiNode;
+class OsrEntryNode;
 
 //! \addtogroup asmjit_compiler
 //! \{
 
+//! Compiler options that select optimization passes \ref BaseCompiler runs in addition to register allocation.
+//!
+//! Each option enables a single pass. Clearing an option makes the pass keep the code as it was emitted, clearing all
+//! of them (see \ref BaseCompiler::clearCompilerOptions()) restores the output of a compiler without these passes.
+enum class CompilerOptions : uint32_t {
+  //! No optimization passes.
+  kNone = 0,
+
+  //! Replaces short conditional branches over a single move by conditional moves (before RA).
+  //!
+  //! Default: true.
+  kIfConvert = 0x00000001u,
+
+  //! Removes jumps to the next node and threads jumps to jumps (before and after RA).
+  //!
+  //! Default: true.
+  kSimplifyCFG = 0x00000002u,
+
+  //! Folds address computations into memory operands of their users (X86 only, before RA).
+  //!
+  //! Default: true.
+  kFoldAddresses = 0x00000004u,
+
+  //! Replaces shifts by a register with BMI2 shifts if the target supports them (X86 only, before RA).
+  //!
+  //! Default: true.
+  kPreferBmi2 = 0x00000008u,
+
+  //! Breaks false dependencies of instructions that only partially write their destination, which depends on the
+  //! micro-architecture of the target (X86 only, before and after RA).
+  //!
+  //! This option inserts additional instructions (for example `xorps` before scalar SSE conversions), so it's not
+  //! enabled by default.
+  //!
+  //! Default: false.
+  kBreakDependencies = 0x00000010u,
+
+  //! Combines adjacent instructions into a single one after RA (AArch64 only).
+  //!
+  //! Default: true.
+  kPeephole = 0x00000020u,
+
+  //! Options used by default.
+  kDefault = kIfConvert | kSimplifyCFG | kFoldAddresses | kPreferBmi2 | kPeephole
+};
+ASMJIT_DEFINE_ENUM_FLAGS(CompilerOptions)
+
 //! Code emitter that uses virtual registers and performs register allocation.
 //!
 //! Compiler is a high-level code-generation tool that provides register allocation and automatic handling of function
@@ -68,6 +118,12 @@ public:
   //!
   //! Local constant pool is flushed with each function, global constant pool is flushed only by \ref finalize().
   ConstPoolNode* _constPools[2];
+  //! Section where constant pools are placed, null if they are placed into the code (see \ref setConstPoolSection()).
+  Section* _constPoolSection;
+  //! CPU of the target, which passes can take advantage of (see \ref setTargetCpuInfo()).
+  CpuInfo _targetCpuInfo;
+  //! Optimization passes to run, see \ref CompilerOptions.
+  CompilerOptions _compilerOptions;
 
   //! \}
 
@@ -146,6 +202,42 @@ public:
 
   //! \}
 
+  //! \name Phi Nodes
+  //! \{
+
+  //! Creates a new \ref PhiNode that defines `dst` from `incomingCount` values, which have to be set by
+  //! \ref PhiNode::setIncoming().
+  ASMJIT_API Error newPhiNode(PhiNode** ASMJIT_NONNULL(out), const BaseReg& dst, uint32_t incomingCount);
+  //! Creates a new \ref PhiNode and adds it to the instruction stream.
+  ASMJIT_API Error addPhiNode(PhiNode** ASMJIT_NONNULL(out), const BaseReg& dst, uint32_t incomingCount);
+
+  //! Adds a \ref PhiNode that defines `dst` as `a` when entered from the block at `aFrom` and as `b` when entered
+  //! from the block at `bFrom`.
+  ASMJIT_API Error phi(const BaseReg& dst, const BaseReg& a, const Label& aFrom, const BaseReg& b, const Label& bFrom);
+
+  //! \}
+
+  //! \name On-Stack Replacement
+  //! \{
+
+  //! Creates a new \ref OsrEntryNode, which is a secondary entry of the current function that has the given
+  //! `signature`.
+  //!
+  //! The signature must use the same calling convention and return value as the current function and all of its
+  //! arguments must be passed in registers, otherwise \ref kErrorInvalidArgument is returned.
+  ASMJIT_API Error newOsrEntryNode(OsrEntryNode** ASMJIT_NONNULL(out), const FuncSignature& signature);
+  //! Creates a new \ref OsrEntryNode and adds it to the instruction stream.
+  ASMJIT_API Error addOsrEntryNode(OsrEntryNode** ASMJIT_NONNULL(out), const FuncSignature& signature);
+
+  //! Creates a new \ref OsrEntryNode and adds it to the instruction stream, returns null on failure.
+  inline OsrEntryNode* addOsrEntry(const FuncSignature& signature) {
+    OsrEntryNode* node;
+    addOsrEntryNode(&node, signature);
+    return node;
+  }
+
+  //! \}
+
   //! \name Virtual Registers
   //! \{
 
@@ -226,6 +318,54 @@ public:
   //! constant to the `out` operand.
   ASMJIT_API Error _newConst(BaseMem* ASMJIT_NONNULL(out), ConstPoolScope scope, const void* data, size_t size);
 
+  //! Returns the section where constant pools are placed, null if they are placed into the code.
+  inline Section* constPoolSection() const noexcept { return _constPoolSection; }
+
+  //! Places constant pools at the end of the given `section` instead of placing them after the function (local
+  //! pools) or at the end of the code (global pool).
+  //!
+  //! Use it together with \ref JitRuntimeOptions::kSeparateDataSections to keep constants out of executable pages,
+  //! the section must be a data section (without \ref SectionFlags::kExecutable) that belongs to the attached
+  //! \ref CodeHolder. Only constant pools that are flushed after this call are affected.
+  inline void setConstPoolSection(Section* section) noexcept { _constPoolSection = section; }
+  //! Places constant pools into the code, which is the default.
+  inline void resetConstPoolSection() noexcept { _constPoolSection = nullptr; }
+
+  //! \}
+
+  //! \name Compiler Options
+  //! \{
+
+  //! Returns compiler options, which select optimization passes to run, see \ref CompilerOptions.
+  inline CompilerOptions compilerOptions() const noexcept { return _compilerOptions; }
+  //! Tests whether the given compiler `option` is enabled.
+  inline bool hasCompilerOption(CompilerOptions option) const noexcept { return Support::test(_compilerOptions, option); }
+
+  //! Enables the given compiler `options`, which are used by the next \ref runPasses() or \ref finalize().
+  inline void addCompilerOptions(CompilerOptions options) noexcept { _compilerOptions |= options; }
+  //! Disables the given compiler `options`, which are used by the next \ref runPasses() or \ref finalize().
+  inline void clearCompilerOptions(CompilerOptions options) noexcept { _compilerOptions &= ~options; }
+
+  //! \}
+
+  //! \name Target
+  //! \{
+
+  //! Returns CPU information of the target the code is generated for.
+  inline const CpuInfo& targetCpuInfo() const noexcept { return _targetCpuInfo; }
+  //! Returns CPU features of the target the code is generated for.
+  inline const CpuFeatures& targetCpuFeatures() const noexcept { return _targetCpuInfo.features(); }
+
+  //! Sets CPU of the target the code is generated for. Passes use its features to replace instructions the user
+  //! emitted (for example by BMI2 shifts on X86) and its microarchitecture to tune the code (see \ref
+  //! x86::Compiler::targetUArch()).
+  //!
+  //! No CPU is assumed by default as the code can be generated for a different machine. Use \ref Target::cpuInfo()
+  //! of \ref JitRuntime if the code is added to it.
+  inline void setTargetCpuInfo(const CpuInfo& cpuInfo) noexcept { _targetCpuInfo = cpuInfo; }
+  //! Resets CPU information of the target, which is the default.
+  inline void resetTargetCpuInfo() noexcept { _targetCpuInfo.reset(); }
+
   //! \}
 
   //! \name Miscellaneous
@@ -234,6 +374,12 @@ public:
   //! Rename the given virtual register `reg` to a formatted string `fmt`.
   ASMJIT_API void rename(const BaseReg& reg, const char* fmt, ...);
 
+  //! Marks the given virtual register `reg` as tagged, see \ref VirtReg::isTagged().
+  //!
+  //! Each function call made by a function that uses tagged virtual registers gets a \ref StackMap, which describes
+  //! locations of all tagged virtual registers that are live across the call.
+  ASMJIT_API void setTagged(const BaseReg& reg, bool value = true);
+
   //! \}
 
   //! \name Jump Annotations
@@ -684,6 +830,180 @@ public:
   //! \}
 };
 
+//! Phi node, used by \ref BaseCompiler.
+//!
+//! Defines a virtual register at the beginning of a basic block by selecting one of its incoming values depending on
+//! the predecessor the block was entered from, which allows SSA based front ends to use \ref BaseCompiler without
+//! destructing SSA form into copies first. Phi nodes must directly follow the label of the block they belong to (only
+//! other phi nodes and informative nodes can be in between) and all phi nodes of a block are evaluated in parallel.
+//!
+//! Each incoming value is associated with the label of a predecessor, which is the basic block that starts at that
+//! label (use the function's label for the entry block). The predecessor must either jump to the block or fall
+//! through to it.
+//!
+//! Phi nodes are lowered by the Compiler before other passes run. Copies are only inserted on the incoming edges and
+//! the register allocator coalesces them, so a copy disappears if both registers end up in the same register.
+class PhiNode : public BaseNode {
+public:
+  ASMJIT_NONCOPYABLE(PhiNode)
+
+  //! Incoming value of a phi node.
+  struct Incoming {
+    //! Register that holds the value when entered from the predecessor.
+    RegOnly value;
+    //! Label of the predecessor.
+    uint32_t labelId;
+  };
+
+  //! \name Members
+  //! \{
+
+  //! Defined register.
+  RegOnly _dst;
+  //! Number of incoming values.
+  uint32_t _incomingCount;
+  //! Incoming values.
+  Incoming* _incoming;
+
+  //! \}
+
+  //! \name Construction & Destruction
+  //! \{
+
+  //! Creates a new `PhiNode` instance.
+  inline PhiNode(BaseBuilder* ASMJIT_NONNULL(cb), const BaseReg& dst) noexcept
+    : BaseNode(cb, NodeType::kPhi, NodeFlags::kIsCode),
+      _incomingCount(0),
+      _incoming(nullptr) {
+    _dst.init(dst);
+  }
+
+  //! \}
+
+  //! \name Accessors
+  //! \{
+
+  //! Returns the defined register.
+  inline const RegOnly& dst() const noexcept { return _dst; }
+
+  //! Returns the number of incoming values.
+  inline uint32_t incomingCount() const noexcept { return _incomingCount; }
+
+  //! Returns the incoming value at `index`.
+  inline Incoming& incoming(uint32_t index) noexcept {
+    ASMJIT_ASSERT(index < _incomingCount);
+    return _incoming[index];
+  }
+  //! \overload
+  inline const Incoming& incoming(uint32_t index) const noexcept {
+    ASMJIT_ASSERT(index < _incomingCount);
+    return _incoming[index];
+  }
+
+  //! Sets the incoming value at `index` to `value` when the block is entered from the block at `from`.
+  inline void setIncoming(uint32_t index, const BaseReg& value, const Label& from) noexcept {
+    ASMJIT_ASSERT(index < _incomingCount);
+    _incoming[index].value.init(value);
+    _incoming[index].labelId = from.id();
+  }
+
+  //! \}
+};
+
+//! On-stack replacement (OSR) entry, used by \ref BaseCompiler.
+//!
+//! A secondary entry point of the current function, which makes it possible to enter the function in the middle of
+//! its body - typically at the header of a long-running loop when switching from an interpreter to JIT code. The
+//! entry has its own signature and maps each of its arguments to a virtual register that is used by the code that
+//! follows the entry, usually the registers that are live at the loop header, which the entry jumps to:
+//!
+//! ```
+//! OsrEntryNode* osr = cc.addOsrEntry(FuncSignature::build<int, int, int>());
+//! osr->setArg(0, i);
+//! osr->setArg(1, sum);
+//! cc.jmp(loopHeader);
+//! ```
+//!
+//! The code before the entry must not fall through to it and no jump can target it, the entry is only reachable
+//! from outside of the function. The register allocator emits the prolog of the function at the entry, so the entry
+//! shares the frame and the epilog with the function, and arguments arrive in the registers that the calling
+//! convention assigns to them. Virtual registers that are used after the entry and are not its arguments must be
+//! initialized by the code that follows the entry, for example by loading them from an interpreter frame passed as
+//! an argument.
+//!
+//! Use \ref BaseCompiler::addOsrEntry() to create the node and \ref CodeHolder::labelOffset() (or
+//! \ref CodeHolder::labelOffsetFromBase()) of its label to get the address of the entry.
+class OsrEntryNode : public LabelNode {
+public:
+  ASMJIT_NONCOPYABLE(OsrEntryNode)
+
+  typedef FuncNode::ArgPack ArgPack;
+
+  //! \name Members
+  //! \{
+
+  //! Entry detail.
+  FuncDetail _funcDetail;
+  //! Argument packs.
+  ArgPack* _args;
+
+  //! \}
+
+  //! \name Construction & Destruction
+  //! \{
+
+  //! Creates a new `OsrEntryNode` instance.
+  //!
+  //! Always use `BaseCompiler::addOsrEntry()` to create a new `OsrEntryNode`.
+  inline OsrEntryNode(BaseBuilder* ASMJIT_NONNULL(cb)) noexcept
+    : LabelNode(cb),
+      _funcDetail(),
+      _args(nullptr) {
+    setType(NodeType::kOsrEntry);
+  }
+
+  //! \}
+
+  //! \name Accessors
+  //! \{
+
+  //! Returns entry detail.
+  inline FuncDetail& detail() noexcept { return _funcDetail; }
+  //! Returns entry detail.
+  inline const FuncDetail& detail() const noexcept { return _funcDetail; }
+
+  //! Returns arguments count.
+  inline uint32_t argCount() const noexcept { return _funcDetail.argCount(); }
+  //! Returns argument packs.
+  inline ArgPack* argPacks() const noexcept { return _args; }
+
+  //! Returns argument pack at `argIndex`.
+  inline ArgPack& argPack(size_t argIndex) const noexcept {
+    ASMJIT_ASSERT(argIndex < argCount());
+    return _args[argIndex];
+  }
+
+  //! Sets argument at `argIndex`.
+  inline void setArg(size_t argIndex, const BaseReg& vReg) noexcept {
+    ASMJIT_ASSERT(argIndex < argCount());
+    _args[argIndex][0].init(vReg);
+  }
+
+  //! Sets argument at `argIndex` and `valueIndex`.
+  inline void setArg(size_t argIndex, size_t valueIndex, const BaseReg& vReg) noexcept {
+    ASMJIT_ASSERT(argIndex < argCount());
+    _args[argIndex][valueIndex].init(vReg);
+  }
+
+  //! Resets argument pack at `argIndex`.
+  inline void resetArg(size_t argIndex) noexcept {
+    ASMJIT_ASSERT(argIndex < argCount());
+    _args[argIndex].reset();
+  }
+
+  //! \}
+};
+
 //! Function pass extends \ref Pass with \ref FuncPass::runOnFunction().
 class ASMJIT_VIRTAPI FuncPass : public Pass {
 public:
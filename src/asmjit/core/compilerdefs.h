@@ -44,7 +44,9 @@ public:
   uint8_t _isStack : 1;
   //! True if this virtual register has assigned stack offset (can be only valid after register allocation pass).
   uint8_t _hasStackSlot : 1;
-  uint8_t _reservedBits : 5;
+  //! True if the virtual register is tagged, which means its locations are recorded by stack maps.
+  uint8_t _isTagged : 1;
+  uint8_t _reservedBits : 4;
 
   //! Stack offset assigned by the register allocator relative to stack pointer (can be negative as well).
   int32_t _stackOffset = 0;
@@ -75,6 +77,7 @@ public:
       _isFixed(false),
       _isStack(false),
       _hasStackSlot(false),
+      _isTagged(false),
       _reservedBits(0),
       _stackOffset(0),
       _reservedU32(0) {}
@@ -135,6 +138,15 @@ public:
   //! \note It's an error if a stack is accessed as a register.
   inline bool isStack() const noexcept { return bool(_isStack); }
 
+  //! Tests whether the virtual register is tagged.
+  //!
+  //! The location of a tagged virtual register that is live across a function call is recorded by a \ref StackMap
+  //! of that call, which is stored in \ref CodeHolder. This is mostly useful for references to objects managed by a
+  //! garbage collector, which must be able to find and update them while the callee executes.
+  inline bool isTagged() const noexcept { return bool(_isTagged); }
+  //! Sets whether the virtual register is tagged, see \ref isTagged().
+  inline void setTagged(bool value) noexcept { _isTagged = value; }
+
   //! Tests whether this virtual register (or stack) has assigned a stack offset.
   //!
   //! If this is a virtual register that was never allocated on stack, it would return false, otherwise if
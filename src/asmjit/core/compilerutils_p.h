@@ -0,0 +1,175 @@
+// This file is part of AsmJit project <https://asmjit.com>
+//
+// See asmjit.h or LICENSE.md for license and copyright information
+// SPDX-License-Identifier: Zlib
+
+#ifndef ASMJIT_CORE_COMPILERUTILS_P_H_INCLUDED
+#define ASMJIT_CORE_COMPILERUTILS_P_H_INCLUDED
+
+#include "../core/api-config.h"
+#ifndef ASMJIT_NO_COMPILER
+
+#include "../core/compiler.h"
+
+ASMJIT_BEGIN_NAMESPACE
+
+//! \cond INTERNAL
+//! \addtogroup asmjit_compiler
+//! \{
+
+//! Utilities used by passes that transform code stored in \ref BaseCompiler.
+namespace CompilerUtils {
+
+//! Calls `fn(labelId)` for each label referenced by `node` - label operands, label based memory operands, labels of
+//! a \ref JumpAnnotation, and embedded labels.
+template<typename Fn>
+static inline void forEachLabelRef(const BaseNode* node, Fn&& fn) noexcept {
+  if (node->isInst()) {
+    const InstNode* inst = node->as<InstNode>();
+    uint32_t opCount = inst->opCount();
+
+    for (uint32_t i = 0; i < opCount; i++) {
+      const Operand& op = inst->op(i);
+      if (op.isLabel())
+        fn(op.id());
+      else if (op.isMem() && op.as<BaseMem>().hasBaseLabel())
+        fn(op.as<BaseMem>().baseId());
+    }
+
+    if (node->type() == NodeType::kJump && node->as<JumpNode>()->hasAnnotation()) {
+      for (uint32_t labelId : node->as<JumpNode>()->annotation()->labelIds())
+        fn(labelId);
+    }
+  }
+  else if (node->isEmbedLabel()) {
+    fn(node->as<EmbedLabelNode>()->labelId());
+  }
+  else if (node->isEmbedLabelDelta()) {
+    fn(node->as<EmbedLabelDeltaNode>()->labelId());
+    fn(node->as<EmbedLabelDeltaNode>()->baseLabelId());
+  }
+}
+
+//! Allocates an array of `labelCount` counters from `zone` and stores the number of references of each label of
+//! `cc` to it, see \ref forEachLabelRef().
+static inline Error countLabelRefs(const BaseCompiler* cc, Zone* zone, uint32_t** labelRefsOut, uint32_t* labelCountOut) noexcept {
+  uint32_t labelCount = uint32_t(cc->code()->labelCount());
+  uint32_t* labelRefs = static_cast<uint32_t*>(zone->allocZeroed(Support::max<size_t>(labelCount, 1u) * sizeof(uint32_t)));
+
+  if (ASMJIT_UNLIKELY(!labelRefs))
+    return DebugUtils::errored(kErrorOutOfMemory);
+
+  for (const BaseNode* node = cc->firstNode(); node; node = node->next()) {
+    forEachLabelRef(node, [&](uint32_t labelId) {
+      if (labelId < labelCount)
+        labelRefs[labelId]++;
+    });
+  }
+
+  *labelRefsOut = labelRefs;
+  *labelCountOut = labelCount;
+  return kErrorOk;
+}
+
+//! Calls `fn(virtId)` for each use of a virtual register by `node` - register operands, base and index registers of
+//! memory operands, arguments of a \ref FuncNode and \ref OsrEntryNode, and arguments and return values of an
+//! \ref InvokeNode.
+template<typename Fn>
+static inline void forEachVirtRef(const BaseNode* node, Fn&& fn) noexcept {
+  auto visitOp = [&](const Operand_& op) noexcept {
+    if (op.isReg()) {
+      if (Operand::isVirtId(op.id()))
+        fn(op.id());
+    }
+    else if (op.isMem()) {
+      const BaseMem& mem = op.as<BaseMem>();
+      if (mem.hasBaseReg() && Operand::isVirtId(mem.baseId()))
+        fn(mem.baseId());
+      if (mem.hasIndexReg() && Operand::isVirtId(mem.indexId()))
+        fn(mem.indexId());
+    }
+  };
+
+  if (node->isInst()) {
+    const InstNode* inst = node->as<InstNode>();
+    uint32_t opCount = inst->opCount();
+
+    for (uint32_t i = 0; i < opCount; i++)
+      visitOp(inst->op(i));
+
+    if (node->isInvoke()) {
+      const InvokeNode* invokeNode = node->as<InvokeNode>();
+      for (size_t valueIndex = 0; valueIndex < Globals::kMaxValuePack; valueIndex++)
+        visitOp(invokeNode->ret(valueIndex));
+
+      uint32_t argCount = invokeNode->argCount();
+      for (uint32_t argIndex = 0; argIndex < argCount; argIndex++)
+        for (size_t valueIndex = 0; valueIndex < Globals::kMaxValuePack; valueIndex++)
+          visitOp(invokeNode->arg(argIndex, valueIndex));
+    }
+  }
+  else if (node->isFunc()) {
+    const FuncNode* funcNode = node->as<FuncNode>();
+    uint32_t argCount = funcNode->argCount();
+
+    for (uint32_t argIndex = 0; argIndex < argCount; argIndex++) {
+      for (size_t valueIndex = 0; valueIndex < Globals::kMaxValuePack; valueIndex++) {
+        const RegOnly& reg = funcNode->argPack(argIndex)[valueIndex];
+        if (reg.isVirtReg())
+          fn(reg.id());
+      }
+    }
+  }
+  else if (node->isOsrEntry()) {
+    const OsrEntryNode* osrNode = node->as<OsrEntryNode>();
+    uint32_t argCount = osrNode->argCount();
+
+    for (uint32_t argIndex = 0; argIndex < argCount; argIndex++) {
+      for (size_t valueIndex = 0; valueIndex < Globals::kMaxValuePack; valueIndex++) {
+        const RegOnly& reg = osrNode->argPack(argIndex)[valueIndex];
+        if (reg.isVirtReg())
+          fn(reg.id());
+      }
+    }
+  }
+}
+
+//! Tests whether `flags` written by `node` (or by instructions removed before it) are overwritten before they are
+//! read, which is only known if the basic block doesn't end before that. Flags are not preserved across calls and
+//! returns. Requires an architecture that provides flags in \ref InstRWInfo.
+static inline bool areFlagsDead(Arch arch, const BaseNode* node, CpuRWFlags flags) noexcept {
+  while ((node = node->next()) != nullptr) {
+    if (node->isInformative())
+      continue;
+
+    if (node->isInvoke() || node->isFuncRet())
+      return true;
+
+    if (node->type() != NodeType::kInst)
+      return false;
+
+    const InstNode* inst = node->as<InstNode>();
+    InstRWInfo rwInfo;
+
+    if (InstAPI::queryRWInfo(arch, inst->baseInst(), inst->operands(), inst->opCount(), &rwInfo) != kErrorOk)
+      return false;
+
+    if (Support::test(rwInfo.readFlags(), flags))
+      return false;
+
+    if ((rwInfo.writeFlags() & flags) == flags)
+      return true;
+  }
+
+  return false;
+}
+
+} // {CompilerUtils}
+
+//! \}
+//! \endcond
+
+ASMJIT_END_NAMESPACE
+
+#endif // !ASMJIT_NO_COMPILER
+#endif // ASMJIT_CORE_COMPILERUTILS_P_H_INCLUDED
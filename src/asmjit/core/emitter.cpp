@@ -58,8 +58,8 @@ static ASMJIT_NOINLINE void BaseEmitter_updateForcedOptions(BaseEmitter* self) n
     self->_clearEmitterFlags(EmitterFlags::kLogComments);
 
   // The reserved option tells emitter (Assembler/Builder/Compiler) that there may be either a border
-  // case (CodeHolder not attached, for example) or that logging or validation is required.
-  if (self->_code == nullptr || self->_logger || hasDiagnosticOptions)
+  // case (CodeHolder not attached, for example) or that logging, validation, or code size analysis is required.
+  if (self->_code == nullptr || self->_logger || hasDiagnosticOptions || self->_code->codeSizeReport())
     self->_forcedInstOptions |= InstOptions::kReserved;
   else
     self->_forcedInstOptions &= ~InstOptions::kReserved;
@@ -233,6 +233,48 @@ Error BaseEmitter::emitArgsAssignment(const FuncFrame& frame, const FuncArgsAssi
   return _funcs.emitArgsAssignment(this, frame, args);
 }
 
+Error BaseEmitter::emitPreserveWrapper(const FuncSignature& signature, const void* target) {
+  if (ASMJIT_UNLIKELY(!_code))
+    return DebugUtils::errored(kErrorNotInitialized);
+
+  if (ASMJIT_UNLIKELY(!_funcs.emitPreserveWrapper))
+    return DebugUtils::errored(kErrorInvalidState);
+
+  FuncSignature targetSignature(signature);
+  targetSignature.setCallConvId(CallConvId::kCDecl);
+
+  FuncDetail wrapperDetail;
+  FuncDetail targetDetail;
+
+  ASMJIT_PROPAGATE(wrapperDetail.init(signature, environment()));
+  ASMJIT_PROPAGATE(targetDetail.init(targetSignature, environment()));
+
+  if (ASMJIT_UNLIKELY(wrapperDetail.argStackSize() != 0))
+    return DebugUtils::errored(kErrorInvalidArgument);
+
+  FuncFrame frame;
+  ASMJIT_PROPAGATE(frame.init(wrapperDetail));
+
+  frame.setFuncCalls();
+  frame.updateCallStackSize(targetDetail.argStackSize());
+
+  // Everything the target is allowed to clobber is dirty - `FuncFrame` then saves what the wrapper must preserve.
+  // Registers the target preserves only partially (like the low 64 bits of `v8-v15` on AArch64) are dirty as well.
+  for (RegGroup group : RegGroupVirtValues{}) {
+    RegMask targetPreservedRegs = targetDetail.preservedRegs(group);
+    if (wrapperDetail.callConv().saveRestoreRegSize(group) > targetDetail.callConv().saveRestoreRegSize(group))
+      targetPreservedRegs = 0;
+    frame.addDirtyRegs(group, ~targetPreservedRegs);
+  }
+
+  const ArchTraits& archTraits = ArchTraits::byArch(arch());
+  if (archTraits.hasLinkReg())
+    frame.addDirtyRegs(RegGroup::kGp, Support::bitMask(archTraits.linkRegId()));
+
+  ASMJIT_PROPAGATE(frame.finalize());
+  return _funcs.emitPreserveWrapper(this, frame, target);
+}
+
 // BaseEmitter - Comment
 // =====================
 
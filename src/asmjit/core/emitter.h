@@ -247,6 +247,7 @@ public:
     typedef Error (ASMJIT_CDECL* EmitProlog)(BaseEmitter* emitter, const FuncFrame& frame);
     typedef Error (ASMJIT_CDECL* EmitEpilog)(BaseEmitter* emitter, const FuncFrame& frame);
     typedef Error (ASMJIT_CDECL* EmitArgsAssignment)(BaseEmitter* emitter, const FuncFrame& frame, const FuncArgsAssignment& args);
+    typedef Error (ASMJIT_CDECL* EmitPreserveWrapper)(BaseEmitter* emitter, const FuncFrame& frame, const void* target);
 
     typedef Error (ASMJIT_CDECL* FormatInstruction)(
       String& sb,
@@ -263,6 +264,8 @@ public:
     EmitEpilog emitEpilog;
     //! Emit arguments assignment implementation.
     EmitArgsAssignment emitArgsAssignment;
+    //! Emit preserve wrapper implementation (prolog, call of the target, and epilog).
+    EmitPreserveWrapper emitPreserveWrapper;
     //! Instruction formatter implementation.
     FormatInstruction formatInstruction;
     //! Instruction validation implementation.
@@ -273,6 +276,7 @@ public:
       emitProlog = nullptr;
       emitEpilog = nullptr;
       emitArgsAssignment = nullptr;
+      emitPreserveWrapper = nullptr;
       validate = nullptr;
     }
   };
@@ -627,6 +631,15 @@ public:
   ASMJIT_API Error emitEpilog(const FuncFrame& frame);
   ASMJIT_API Error emitArgsAssignment(const FuncFrame& frame, const FuncArgsAssignment& args);
 
+  //! Emits a function that uses the calling convention of `signature` (\ref CallConvId::kPreserveMost or \ref
+  //! CallConvId::kPreserveAll) and calls `target`, which is a function of the same signature that uses \ref
+  //! CallConvId::kCDecl. The wrapper saves and restores registers the target may clobber, but the wrapper's calling
+  //! convention preserves, so it can be called from code that keeps values in registers across the call.
+  //!
+  //! Returns \ref kErrorInvalidArgument if the signature passes arguments on the stack, as the saved registers would
+  //! be between the arguments and the target.
+  ASMJIT_API Error emitPreserveWrapper(const FuncSignature& signature, const void* target);
+
   //! \}
 
   //! \name Align
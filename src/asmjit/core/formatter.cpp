@@ -509,6 +509,18 @@ Error formatNode(
       break;
     }
 
+    case NodeType::kOsrEntry: {
+      const OsrEntryNode* osrNode = node->as<OsrEntryNode>();
+
+      if (builder->isCompiler()) {
+        ASMJIT_PROPAGATE(formatLabel(sb, formatOptions.flags(), builder, osrNode->labelId()));
+        ASMJIT_PROPAGATE(sb.append(": OsrEntry("));
+        ASMJIT_PROPAGATE(formatFuncArgs(sb, formatOptions.flags(), static_cast<const BaseCompiler*>(builder), osrNode->detail(), osrNode->argPacks()));
+        ASMJIT_PROPAGATE(sb.append(")"));
+      }
+      break;
+    }
+
     case NodeType::kFuncRet: {
       const FuncRetNode* retNode = node->as<FuncRetNode>();
       ASMJIT_PROPAGATE(sb.append("[FuncRet]"));
@@ -530,6 +542,22 @@ Error formatNode(
         invokeNode->baseInst(), invokeNode->operands(), invokeNode->opCount()));
       break;
     }
+
+    case NodeType::kPhi: {
+      const PhiNode* phiNode = node->as<PhiNode>();
+      ASMJIT_PROPAGATE(sb.append("[Phi] "));
+      ASMJIT_PROPAGATE(formatOperand(sb, formatOptions.flags(), builder, builder->arch(), phiNode->dst().toReg<BaseReg>()));
+      ASMJIT_PROPAGATE(sb.append(" <-"));
+
+      for (uint32_t i = 0; i < phiNode->incomingCount(); i++) {
+        const PhiNode::Incoming& incoming = phiNode->incoming(i);
+        ASMJIT_PROPAGATE(sb.append(i == 0 ? " " : ", "));
+        ASMJIT_PROPAGATE(formatOperand(sb, formatOptions.flags(), builder, builder->arch(), incoming.value.toReg<BaseReg>()));
+        ASMJIT_PROPAGATE(sb.append(" from "));
+        ASMJIT_PROPAGATE(formatLabel(sb, formatOptions.flags(), builder, incoming.labelId));
+      }
+      break;
+    }
 #endif
 
     default: {
@@ -126,6 +126,14 @@ ASMJIT_FAVOR_SIZE Error FuncFrame::init(const FuncDetail& func) noexcept {
   // Exclude stack pointer - this register is never included in saved GP regs.
   _preservedRegs[RegGroup::kGp] &= ~Support::bitMask(archTraits.spRegId());
 
+  // Exclude registers used to return values - restoring them in epilog would overwrite the return value. Only calling
+  // conventions that preserve almost everything, like \ref CallConvId::kPreserveMost, preserve such registers.
+  for (uint32_t valueIndex = 0; valueIndex < Globals::kMaxValuePack; valueIndex++) {
+    const FuncValue& ret = func.ret(valueIndex);
+    if (ret.isReg())
+      _preservedRegs[archTraits.regTypeToGroup(ret.regType())] &= ~Support::bitMask(ret.regId());
+  }
+
   // The size and alignment of save/restore area of registers for each virtual register group
   _saveRestoreRegSize = func.callConv()._saveRestoreRegSize;
   _saveRestoreAlignment = func.callConv()._saveRestoreAlignment;
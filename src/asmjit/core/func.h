@@ -81,6 +81,32 @@ enum class CallConvId : uint8_t {
   //! Floating point arguments are passed via SIMD registers.
   kHardFloat = 10,
 
+  //! Calling convention compatible with `__attribute__((preserve_most))` (Clang), designed for calling rarely
+  //! executed code such as slow paths of runtime helpers.
+  //!
+  //! Arguments and return values are passed the same way as with \ref CallConvId::kCDecl, but the callee preserves
+  //! almost all general purpose registers (except registers used to return values), so a caller doesn't have to spill
+  //! values that are live across the call:
+  //!
+  //!   - X64 - all general purpose registers except `r11` are preserved. Vector registers are not.
+  //!   - AArch64 - `x9` to `x15` are preserved in addition to registers preserved by \ref CallConvId::kCDecl.
+  //!
+  //! Use \ref BaseEmitter::emitPreserveWrapper() to create a function of this calling convention that calls a plain
+  //! C function.
+  //!
+  //! \note This calling convention is only supported on X64 and AArch64 architectures. If used on environment that
+  //! doesn't support this calling convention it will be replaced by \ref CallConvId::kCDecl.
+  kPreserveMost = 11,
+
+  //! Calling convention compatible with `__attribute__((preserve_all))` (Clang).
+  //!
+  //! The same as \ref CallConvId::kPreserveMost, but vector registers are preserved as well - all of them on X64 (only
+  //! their low 128 bits, so AVX code must not depend on the upper part) and `v8` to `v31` on AArch64 (all 128 bits).
+  //!
+  //! \note This calling convention is only supported on X64 and AArch64 architectures. If used on environment that
+  //! doesn't support this calling convention it will be replaced by \ref CallConvId::kCDecl.
+  kPreserveAll = 12,
+
   //! AsmJit specific calling convention designed for calling functions inside a multimedia code that don't use many
   //! registers internally, but are long enough to be called and not inlined. These functions are usually used to
   //! calculate trigonometric functions, logarithms, etc...
@@ -320,6 +320,9 @@ enum ErrorCode : uint32_t {
   //! Failed to open anonymous memory handle or file descriptor.
   kErrorFailedToOpenAnonymousMemory,
 
+  //! External symbol referenced by the code is not defined (see \ref JitRuntime::addSymbol()).
+  kErrorSymbolNotFound,
+
   // @EnumValuesEnd@
 
   //! Count of AsmJit error codes.
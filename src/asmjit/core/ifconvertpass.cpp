@@ -0,0 +1,215 @@
+// This file is part of AsmJit project <https://asmjit.com>
+//
+// See asmjit.h or LICENSE.md for license and copyright information
+// SPDX-License-Identifier: Zlib
+
+#include "../core/api-build_p.h"
+#ifndef ASMJIT_NO_COMPILER
+
+#include "../core/compilerutils_p.h"
+#include "../core/ifconvertpass_p.h"
+
+ASMJIT_BEGIN_NAMESPACE
+
+// BaseIfConvertPass - Utilities
+// =============================
+
+// Returns the next node that is not informative (comments are skipped).
+static BaseNode* BaseIfConvertPass_nextNode(BaseNode* node) noexcept {
+  do {
+    node = node->next();
+  } while (node && node->isInformative());
+  return node;
+}
+
+// Tests whether `node` binds `labelId`, which is only referenced by the jump that is being converted.
+static inline bool BaseIfConvertPass_isSingleRefLabel(const BaseIfConvertPass* self, const BaseNode* node, uint32_t labelId) noexcept {
+  if (!node || node->type() != NodeType::kLabel)
+    return false;
+
+  uint32_t nodeLabelId = node->as<LabelNode>()->labelId();
+  return nodeLabelId == labelId && labelId < self->_labelCount && self->_labelRefs[labelId] == 1;
+}
+
+// Collects moves that follow `node` into `selects`, `isTaken` specifies whether the moves are executed when the
+// jump is taken. Returns the last move or `node` if there is no move.
+static BaseNode* BaseIfConvertPass_collectMoves(
+  BaseIfConvertPass* self,
+  BaseNode* node,
+  BaseIfConvertPass::Select* selects, uint32_t& selectCount, bool isTaken,
+  BaseReg* sources, uint32_t& sourceCount) noexcept {
+
+  // Destinations written by this block, each destination can be only written once.
+  uint32_t blockDstIds[BaseIfConvertPass::kMaxSelects];
+  uint32_t blockDstCount = 0;
+
+  for (;;) {
+    BaseNode* next = BaseIfConvertPass_nextNode(node);
+    if (!next || next->type() != NodeType::kInst || !self->isMove(next->as<InstNode>()))
+      return node;
+
+    InstNode* inst = next->as<InstNode>();
+    const BaseReg& dst = inst->op(0).as<BaseReg>();
+    const Operand& src = inst->op(1);
+
+    for (uint32_t i = 0; i < blockDstCount; i++)
+      if (blockDstIds[i] == dst.id())
+        return nullptr;
+
+    if (blockDstCount == BaseIfConvertPass::kMaxSelects)
+      return nullptr;
+    blockDstIds[blockDstCount++] = dst.id();
+
+    uint32_t selectIndex = 0;
+    while (selectIndex < selectCount && selects[selectIndex].dst.id() != dst.id())
+      selectIndex++;
+
+    if (selectIndex == selectCount) {
+      if (selectCount == BaseIfConvertPass::kMaxSelects)
+        return nullptr;
+
+      selects[selectCount].dst = dst;
+      selects[selectCount].taken = dst;
+      selects[selectCount].notTaken = dst;
+      selectCount++;
+    }
+    else if (selects[selectIndex].dst.signature() != dst.signature()) {
+      return nullptr;
+    }
+
+    if (isTaken)
+      selects[selectIndex].taken = src;
+    else
+      selects[selectIndex].notTaken = src;
+
+    if (src.isReg())
+      sources[sourceCount++] = src.as<BaseReg>();
+
+    node = next;
+  }
+}
+
+// BaseIfConvertPass - Construction & Destruction
+// ==============================================
+
+BaseIfConvertPass::BaseIfConvertPass(const char* name) noexcept
+  : Pass(name) {}
+BaseIfConvertPass::~BaseIfConvertPass() noexcept {}
+
+// BaseIfConvertPass - Run
+// =======================
+
+Error BaseIfConvertPass::run(Zone* zone, Logger* logger) {
+  DebugUtils::unused(logger);
+
+  BaseCompiler* cc = this->cc();
+  if (!cc->hasCompilerOption(CompilerOptions::kIfConvert))
+    return kErrorOk;
+
+  BaseNode* node = cc->firstNode();
+  BaseNode* prevCursor = cc->cursor();
+
+  Error err = kErrorOk;
+  _labelRefs = nullptr;
+  _labelCount = 0;
+
+  while (node) {
+    BaseNode* next = node->next();
+    uint32_t cond;
+
+    if (node->type() != NodeType::kInst ||
+        !node->as<InstNode>()->hasOption(InstOptions::kUnpredictable) ||
+        !isCondJump(node->as<InstNode>(), &cond)) {
+      node = next;
+      continue;
+    }
+
+    // Only count label references when there is something to convert.
+    if (!_labelRefs) {
+      err = CompilerUtils::countLabelRefs(cc, zone, &_labelRefs, &_labelCount);
+      if (ASMJIT_UNLIKELY(err))
+        break;
+    }
+
+    InstNode* jcc = node->as<InstNode>();
+    uint32_t jccLabelId = jcc->op(0).id();
+
+    Select selects[kMaxSelects];
+    uint32_t selectCount = 0;
+
+    BaseReg sources[kMaxSelects * 2];
+    uint32_t sourceCount = 0;
+
+    // Match {then} block, which is executed when the jump is not taken.
+    BaseNode* last = BaseIfConvertPass_collectMoves(this, jcc, selects, selectCount, false, sources, sourceCount);
+    BaseNode* end = last ? BaseIfConvertPass_nextNode(last) : nullptr;
+
+    if (end && BaseIfConvertPass_isSingleRefLabel(this, end, jccLabelId)) {
+      // Triangle - the jump skips {then} block.
+    }
+    else if (end && end->type() == NodeType::kInst && isJump(end->as<InstNode>())) {
+      // Diamond - {then} block jumps over {else} block, which is executed when the jump is taken.
+      uint32_t endLabelId = end->as<InstNode>()->op(0).id();
+      BaseNode* elseLabel = BaseIfConvertPass_nextNode(end);
+
+      if (endLabelId != jccLabelId && BaseIfConvertPass_isSingleRefLabel(this, elseLabel, jccLabelId)) {
+        last = BaseIfConvertPass_collectMoves(this, elseLabel, selects, selectCount, true, sources, sourceCount);
+        end = last ? BaseIfConvertPass_nextNode(last) : nullptr;
+
+        if (!BaseIfConvertPass_isSingleRefLabel(this, end, endLabelId))
+          end = nullptr;
+      }
+      else {
+        end = nullptr;
+      }
+    }
+    else {
+      end = nullptr;
+    }
+
+    // Sources must not be destinations as all destinations are selected at the place of the jump.
+    if (end && selectCount) {
+      for (uint32_t i = 0; i < sourceCount && end; i++)
+        for (uint32_t j = 0; j < selectCount; j++)
+          if (sources[i].id() == selects[j].dst.id())
+            end = nullptr;
+    }
+    else {
+      end = nullptr;
+    }
+
+    if (!end) {
+      node = next;
+      continue;
+    }
+
+    next = end->next();
+    cc->_setCursor(jcc->prev());
+
+    for (uint32_t i = 0; i < selectCount; i++) {
+      err = emitSelect(cond, selects[i]);
+      if (ASMJIT_UNLIKELY(err))
+        break;
+    }
+
+    if (ASMJIT_UNLIKELY(err))
+      break;
+
+    cc->removeNodes(jcc, end);
+    node = next;
+  }
+
+  _labelRefs = nullptr;
+  _labelCount = 0;
+
+  // The cursor could have been removed together with the converted nodes.
+  if (prevCursor && !prevCursor->isActive())
+    prevCursor = cc->lastNode();
+  cc->_setCursor(prevCursor);
+
+  return err;
+}
+
+ASMJIT_END_NAMESPACE
+
+#endif // !ASMJIT_NO_COMPILER
@@ -0,0 +1,112 @@
+// This file is part of AsmJit project <https://asmjit.com>
+//
+// See asmjit.h or LICENSE.md for license and copyright information
+// SPDX-License-Identifier: Zlib
+
+#ifndef ASMJIT_CORE_IFCONVERTPASS_P_H_INCLUDED
+#define ASMJIT_CORE_IFCONVERTPASS_P_H_INCLUDED
+
+#include "../core/api-config.h"
+#ifndef ASMJIT_NO_COMPILER
+
+#include "../core/compiler.h"
+
+ASMJIT_BEGIN_NAMESPACE
+
+//! \cond INTERNAL
+//! \addtogroup asmjit_ra
+//! \{
+
+//! If-conversion pass.
+//!
+//! Replaces conditional jumps marked by \ref InstOptions::kUnpredictable that skip over register moves by conditional
+//! selects. The pass runs before the register allocator and matches the following shapes, where each block consists
+//! of at most \ref kMaxSelects moves of a register or an immediate into a virtual register:
+//!
+//! \code{.unparsed}
+//! Triangle:           Diamond:
+//!
+//!   jcc L_end           jcc L_else
+//!   {then}              {then}
+//! L_end:                jmp L_end
+//!                     L_else:
+//!                       {else}
+//!                     L_end:
+//! \endcode
+//!
+//! Labels of the shape must not be referenced by anything else and sources of the moves must not be destinations of
+//! the moves. The jumps and labels are removed and each destination `dst` is selected by `dst = cond ? else : then`
+//! (where a missing move means `dst` itself), which is implemented by the architecture specific pass.
+class BaseIfConvertPass : public Pass {
+public:
+  ASMJIT_NONCOPYABLE(BaseIfConvertPass)
+  typedef Pass Base;
+
+  //! Maximum number of destinations that are selected by a single shape.
+  static constexpr uint32_t kMaxSelects = 4;
+
+  //! A single selection of `dst = cond ? taken : notTaken`.
+  struct Select {
+    BaseReg dst;
+    Operand taken;
+    Operand notTaken;
+  };
+
+  //! \name Members
+  //! \{
+
+  //! Number of references of each label (only valid during `run()`).
+  uint32_t* _labelRefs = nullptr;
+  //! Number of labels `_labelRefs` holds.
+  uint32_t _labelCount = 0;
+
+  //! \}
+
+  //! \name Construction & Destruction
+  //! \{
+
+  BaseIfConvertPass(const char* name) noexcept;
+  virtual ~BaseIfConvertPass() noexcept;
+
+  //! \}
+
+  //! \name Accessors
+  //! \{
+
+  //! Returns the associated `BaseCompiler`.
+  inline BaseCompiler* cc() const noexcept { return static_cast<BaseCompiler*>(_cb); }
+
+  //! \}
+
+  //! \name Run
+  //! \{
+
+  Error run(Zone* zone, Logger* logger) override;
+
+  //! \}
+
+  //! \name Architecture Interface
+  //! \{
+
+  //! Tests whether `node` is a conditional jump to a label and stores its condition to `condOut`.
+  virtual bool isCondJump(const InstNode* node, uint32_t* condOut) const noexcept = 0;
+  //! Tests whether `node` is an unconditional jump to a label.
+  virtual bool isJump(const InstNode* node) const noexcept = 0;
+  //! Tests whether `node` moves a register or an immediate into a virtual register that can be selected.
+  virtual bool isMove(const InstNode* node) const noexcept = 0;
+
+  //! Emits `dst = cond ? taken : notTaken` at the current cursor, either `taken` or `notTaken` can be `dst`.
+  //!
+  //! Emitted instructions must not change flags as multiple selects share the same condition.
+  virtual Error emitSelect(uint32_t cond, const Select& select) noexcept = 0;
+
+  //! \}
+};
+
+//! \}
+//! \endcond
+
+ASMJIT_END_NAMESPACE
+
+#endif // !ASMJIT_NO_COMPILER
+#endif // ASMJIT_CORE_IFCONVERTPASS_P_H_INCLUDED
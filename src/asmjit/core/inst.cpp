@@ -48,6 +48,20 @@ InstId InstAPI::stringToInstId(Arch arch, const char* s, size_t len) noexcept {
 
   return 0;
 }
+
+Error InstAPI::encodingIdToString(Arch arch, uint32_t encodingId, String& output) noexcept {
+#if !defined(ASMJIT_NO_X86)
+  if (Environment::isFamilyX86(arch))
+    return x86::InstInternal::encodingIdToString(arch, encodingId, output);
+#endif
+
+#if !defined(ASMJIT_NO_AARCH64)
+  if (Environment::isFamilyAArch64(arch))
+    return a64::InstInternal::encodingIdToString(arch, encodingId, output);
+#endif
+
+  return DebugUtils::errored(kErrorInvalidArch);
+}
 #endif // !ASMJIT_NO_TEXT
 
 // InstAPI - Validate
@@ -98,6 +98,11 @@ enum class InstOptions : uint32_t {
   //!     - `sqrtss x, y` - only LO element of `x` is changed, if you don't
   //!       use HI elements, use `compiler.overwrite().sqrtss(x, y)`.
   kOverwrite = 0x00000004u,
+  //! Conditional jump is unpredictable (Compiler).
+  //!
+  //! Hint that allows the compiler to replace a conditional jump over a few register moves by conditional selects
+  //! (`cmovcc` and `setcc` on X86, `csel` and `cset` on AArch64), which don't mispredict.
+  kUnpredictable = 0x00000008u,
 
   //! Emit short-form of the instruction.
   kShortForm = 0x00000010u,
@@ -748,6 +753,12 @@ ASMJIT_API Error instIdToString(Arch arch, InstId instId, String& output) noexce
 //!
 //! Returns the parsed instruction id or \ref BaseInst::kIdNone if no such instruction exists.
 ASMJIT_API InstId stringToInstId(Arch arch, const char* s, size_t len) noexcept;
+
+//! Appends the name of the encoding specified by `encodingId` into the `output` string.
+//!
+//! Encodings are identifiers that assemblers use to group instructions that are encoded the same way, they are
+//! reported by \ref CodeSizeReport.
+ASMJIT_API Error encodingIdToString(Arch arch, uint32_t encodingId, String& output) noexcept;
 #endif // !ASMJIT_NO_TEXT
 
 #ifndef ASMJIT_NO_VALIDATION
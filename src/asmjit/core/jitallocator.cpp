@@ -15,6 +15,11 @@
 #include "../core/zonelist.h"
 #include "../core/zonetree.h"
 
+#if defined(ASMJIT_TEST)
+  #include <atomic>
+  #include <thread>
+#endif
+
 ASMJIT_BEGIN_NAMESPACE
 
 // JitAllocator - Constants
@@ -33,6 +38,14 @@ static constexpr uint32_t kJitAllocatorBaseGranularity = 64;
 //! Maximum block size (32MB).
 static constexpr uint32_t kJitAllocatorMaxBlockSize = 1024 * 1024 * 32;
 
+//! Minimum size of an area (in granules) that is searched by using the summary of empty BitWords.
+//!
+//! Every unused area of at least this size contains a whole empty BitWord, so it cannot be missed by the summary.
+static constexpr uint32_t kJitAllocatorLargeAreaSize = Support::kBitWordSizeInBits * 2u - 1u;
+
+//! Default distance of blocks from `CreateParams::nearAddress` (1GB).
+static constexpr size_t kJitAllocatorDefaultNearDistance = size_t(1024) * 1024 * 1024;
+
 // JitAllocator - Fill Pattern
 // ===========================
 
@@ -163,6 +176,8 @@ public:
   size_t totalAreaUsed;
   //! Overhead of all blocks (in bytes).
   size_t totalOverheadBytes;
+  //! Size of decommitted pages of all blocks (in bytes).
+  size_t totalDecommittedSize;
 
   inline JitAllocatorPool(uint32_t granularity) noexcept
     : blocks(),
@@ -173,7 +188,8 @@ public:
       emptyBlockCount(0),
       totalAreaSize(0),
       totalAreaUsed(0),
-      totalOverheadBytes(0) {}
+      totalOverheadBytes(0),
+      totalDecommittedSize(0) {}
 
   inline void reset() noexcept {
     blocks.reset();
@@ -182,6 +198,7 @@ public:
     totalAreaSize = 0;
     totalAreaUsed = 0;
     totalOverheadBytes = 0;
+    totalDecommittedSize = 0;
   }
 
   inline size_t byteSizeFromAreaSize(uint32_t areaSize) const noexcept { return size_t(areaSize) * granularity; }
@@ -230,11 +247,19 @@ public:
   uint32_t _searchStart;
   //! End of a search range (for unused bits).
   uint32_t _searchEnd;
+  //! Number of pages tracked by `_decommittedBitVector` (0 if pages are not decommitted).
+  uint32_t _pageCount;
+  //! Number of decommitted pages.
+  uint32_t _decommittedPageCount;
 
   //! Used bit-vector (0 = unused, 1 = used).
   Support::BitWord* _usedBitVector;
   //! Stop bit-vector (0 = don't care, 1 = stop).
   Support::BitWord* _stopBitVector;
+  //! Decommitted bit-vector (0 = committed, 1 = decommitted), one bit per page.
+  Support::BitWord* _decommittedBitVector;
+  //! Summary of used bit-vector (0 = BitWord has used bits, 1 = BitWord is empty), one bit per BitWord.
+  Support::BitWord* _emptySummaryBitVector;
 
   inline JitAllocatorBlock(
     JitAllocatorPool* pool,
@@ -243,7 +268,10 @@ public:
     uint32_t blockFlags,
     Support::BitWord* usedBitVector,
     Support::BitWord* stopBitVector,
-    uint32_t areaSize) noexcept
+    Support::BitWord* decommittedBitVector,
+    Support::BitWord* emptySummaryBitVector,
+    uint32_t areaSize,
+    uint32_t pageCount) noexcept
     : ZoneTreeNodeT(),
       _pool(pool),
       _mapping(mapping),
@@ -254,8 +282,14 @@ public:
       _largestUnusedArea(areaSize),
       _searchStart(0),
       _searchEnd(areaSize),
+      _pageCount(pageCount),
+      _decommittedPageCount(0),
       _usedBitVector(usedBitVector),
-      _stopBitVector(stopBitVector) {}
+      _stopBitVector(stopBitVector),
+      _decommittedBitVector(decommittedBitVector),
+      _emptySummaryBitVector(emptySummaryBitVector) {
+    Support::bitVectorFill(_emptySummaryBitVector, 0, _pool->bitWordCountFromAreaSize(areaSize));
+  }
 
   inline JitAllocatorPool* pool() const noexcept { return _pool; }
 
@@ -276,6 +310,20 @@ public:
   inline uint32_t areaAvailable() const noexcept { return _areaSize - _areaUsed; }
   inline uint32_t largestUnusedArea() const noexcept { return _largestUnusedArea; }
 
+  inline uint32_t pageCount() const noexcept { return _pageCount; }
+  inline uint32_t decommittedPageCount() const noexcept { return _decommittedPageCount; }
+
+  // Updates the summary of empty BitWords that overlap the area range [areaStart, areaEnd).
+  inline void updateEmptySummary(uint32_t areaStart, uint32_t areaEnd) noexcept {
+    using Support::kBitWordSizeInBits;
+
+    size_t wordStart = areaStart / kBitWordSizeInBits;
+    size_t wordEnd = (areaEnd + kBitWordSizeInBits - 1u) / kBitWordSizeInBits;
+
+    for (size_t i = wordStart; i < wordEnd; i++)
+      Support::bitVectorSetBit(_emptySummaryBitVector, i, _usedBitVector[i] == 0);
+  }
+
   inline void decreaseUsedArea(uint32_t value) noexcept {
     _areaUsed -= value;
     _pool->totalAreaUsed -= value;
@@ -287,6 +335,7 @@ public:
     // Mark the newly allocated space as occupied and also the sentinel.
     Support::bitVectorFill(_usedBitVector, allocatedAreaStart, allocatedAreaSize);
     Support::bitVectorSetBit(_stopBitVector, allocatedAreaEnd - 1, true);
+    updateEmptySummary(allocatedAreaStart, allocatedAreaEnd);
 
     // Update search region and statistics.
     _pool->totalAreaUsed += allocatedAreaSize;
@@ -319,6 +368,7 @@ public:
     // Unmark occupied bits and also the sentinel.
     Support::bitVectorClear(_usedBitVector, releasedAreaStart, releasedAreaSize);
     Support::bitVectorSetBit(_stopBitVector, releasedAreaEnd - 1, false);
+    updateEmptySummary(releasedAreaStart, releasedAreaEnd);
 
     if (areaUsed() == 0) {
       _searchStart = 0;
@@ -350,6 +400,7 @@ public:
     Support::bitVectorClear(_usedBitVector, shrunkAreaStart, shrunkAreaSize);
     Support::bitVectorSetBit(_stopBitVector, shrunkAreaEnd - 1, false);
     Support::bitVectorSetBit(_stopBitVector, shrunkAreaStart - 1, true);
+    updateEmptySummary(shrunkAreaStart, shrunkAreaEnd);
 
     addFlags(kFlagDirty);
   }
@@ -363,6 +414,58 @@ public:
   inline bool operator>(const uint8_t* key) const noexcept { return rxPtr() > key; }
 };
 
+// JitAllocator - Arena
+// ====================
+
+//! A continuous chunk of virtual memory owned by an arena, allocations are bump-allocated from it.
+class JitAllocatorArenaChunk {
+public:
+  ASMJIT_NONCOPYABLE(JitAllocatorArenaChunk)
+
+  //! Next chunk of the same arena (chunks are linked from the most recent one).
+  JitAllocatorArenaChunk* _next;
+  //! Virtual memory mapping - either single mapping (both pointers equal) or dual mapping.
+  VirtMem::DualMapping _mapping;
+  //! Virtual memory size (chunk size) [bytes].
+  size_t _chunkSize;
+  //! Offset of the first unused byte in the chunk [bytes].
+  size_t _usedSize;
+  //! Offset of the most recent allocation in the chunk, equals `_usedSize` if it's not known [bytes].
+  size_t _lastOffset;
+
+  inline JitAllocatorArenaChunk(JitAllocatorArenaChunk* next, VirtMem::DualMapping mapping, size_t chunkSize) noexcept
+    : _next(next),
+      _mapping(mapping),
+      _chunkSize(chunkSize),
+      _usedSize(0),
+      _lastOffset(0) {}
+
+  inline uint8_t* rxPtr() const noexcept { return static_cast<uint8_t*>(_mapping.rx); }
+  inline uint8_t* rwPtr() const noexcept { return static_cast<uint8_t*>(_mapping.rw); }
+
+  inline size_t chunkSize() const noexcept { return _chunkSize; }
+  inline size_t usedSize() const noexcept { return _usedSize; }
+  inline size_t unusedSize() const noexcept { return _chunkSize - _usedSize; }
+};
+
+class JitAllocator::Arena : public ZoneListNode<JitAllocator::Arena> {
+public:
+  ASMJIT_NONCOPYABLE(Arena)
+
+  //! Chunks owned by the arena, the first one is used for new allocations.
+  JitAllocatorArenaChunk* _chunks;
+  //! Size of the most recently allocated chunk, used to calculate the size of the next one [bytes].
+  size_t _lastChunkSize;
+  //! Number of allocations made from the arena.
+  size_t _allocationCount;
+
+  inline Arena() noexcept
+    : ZoneListNode(),
+      _chunks(nullptr),
+      _lastChunkSize(0),
+      _allocationCount(0) {}
+};
+
 // JitAllocator - PrivateImpl
 // ==========================
 
@@ -374,20 +477,40 @@ public:
   uint32_t pageSize;
   //! Number of active allocations.
   size_t allocationCount;
+  //! Address range blocks should be placed in (anchor is null if blocks can be placed anywhere).
+  VirtMem::NearRange nearRange;
+  //! Protection key used to tag blocks (only valid if `JitAllocatorOptions::kUseProtectionKeys` is set).
+  uint32_t protectionKey;
 
   //! Blocks from all pools in RBTree.
   ZoneTree<JitAllocatorBlock> tree;
+  //! Arenas created by `JitAllocator::newArena()`.
+  ZoneList<JitAllocator::Arena> arenas;
+  //! Number of chunks of all arenas.
+  size_t arenaChunkCount;
+  //! Size of all chunks of all arenas [bytes].
+  size_t arenaReservedSize;
+  //! Size of memory allocated from all arenas [bytes].
+  size_t arenaUsedSize;
   //! Allocator pools.
   JitAllocatorPool* pools;
   //! Number of allocator pools.
   size_t poolCount;
+  //! Allocator of the metadata (this instance, blocks, bit-arrays, and arenas).
+  MemAllocator* memAllocator;
 
-  inline JitAllocatorPrivateImpl(JitAllocatorPool* pools, size_t poolCount) noexcept
+  inline JitAllocatorPrivateImpl(JitAllocatorPool* pools, size_t poolCount, MemAllocator* memAllocator) noexcept
     : JitAllocator::Impl {},
       pageSize(0),
       allocationCount(0),
+      nearRange {},
+      protectionKey(0),
+      arenaChunkCount(0),
+      arenaReservedSize(0),
+      arenaUsedSize(0),
       pools(pools),
-      poolCount(poolCount) {}
+      poolCount(poolCount),
+      memAllocator(memAllocator) {}
   inline ~JitAllocatorPrivateImpl() noexcept {}
 };
 
@@ -425,19 +548,42 @@ static inline JitAllocatorPrivateImpl* JitAllocatorImpl_new(const JitAllocator::
   if (uint32_t(options & JitAllocatorOptions::kCustomFillPattern) == 0)
     fillPattern = JitAllocator_defaultFillPattern();
 
+  // Dual mapping makes no sense if the memory is not executable.
+  if (Support::test(options, JitAllocatorOptions::kNonExecutable))
+    options &= ~(JitAllocatorOptions::kUseDualMapping | JitAllocatorOptions::kUseProtectionKeys);
+
+  // Protection keys are not needed when W^X is already provided by dual mapping and dual mapped memory cannot be
+  // decommitted by `VirtMem::decommit()`.
+  if (Support::test(options, JitAllocatorOptions::kUseDualMapping))
+    options &= ~(JitAllocatorOptions::kUseProtectionKeys | JitAllocatorOptions::kDecommitUnusedPages);
+
+  uint32_t protectionKey = 0;
+  if (Support::test(options, JitAllocatorOptions::kUseProtectionKeys)) {
+    // Fall back to regular RWX blocks if protection keys are not available.
+    if (VirtMem::allocProtectionKey(&protectionKey) != kErrorOk)
+      options &= ~JitAllocatorOptions::kUseProtectionKeys;
+  }
+
+  MemAllocator* memAllocator = params->memAllocator ? params->memAllocator : MemAllocator::host();
   size_t size = sizeof(JitAllocatorPrivateImpl) + sizeof(JitAllocatorPool) * poolCount;
-  void* p = ::malloc(size);
-  if (ASMJIT_UNLIKELY(!p))
+  void* p = memAllocator->alloc(size, Globals::kAllocAlignment);
+  if (ASMJIT_UNLIKELY(!p)) {
+    if (Support::test(options, JitAllocatorOptions::kUseProtectionKeys))
+      VirtMem::releaseProtectionKey(protectionKey);
     return nullptr;
+  }
 
   JitAllocatorPool* pools = reinterpret_cast<JitAllocatorPool*>((uint8_t*)p + sizeof(JitAllocatorPrivateImpl));
-  JitAllocatorPrivateImpl* impl = new(p) JitAllocatorPrivateImpl(pools, poolCount);
+  JitAllocatorPrivateImpl* impl = new(p) JitAllocatorPrivateImpl(pools, poolCount, memAllocator);
 
   impl->options = options;
   impl->blockSize = blockSize;
   impl->granularity = granularity;
   impl->fillPattern = fillPattern;
   impl->pageSize = vmInfo.pageSize;
+  impl->protectionKey = protectionKey;
+  impl->nearRange.anchor = params->nearAddress;
+  impl->nearRange.maxDistance = params->nearDistance ? params->nearDistance : kJitAllocatorDefaultNearDistance;
 
   for (size_t poolId = 0; poolId < poolCount; poolId++)
     new(&pools[poolId]) JitAllocatorPool(granularity << poolId);
@@ -446,8 +592,17 @@ static inline JitAllocatorPrivateImpl* JitAllocatorImpl_new(const JitAllocator::
 }
 
 static inline void JitAllocatorImpl_destroy(JitAllocatorPrivateImpl* impl) noexcept {
+  // Chunks of all arenas were already released by `JitAllocator::reset()`.
+  MemAllocator* memAllocator = impl->memAllocator;
+  while (!impl->arenas.empty())
+    memAllocator->release(impl->arenas.popFirst(), sizeof(JitAllocator::Arena), Globals::kAllocAlignment);
+
+  if (Support::test(impl->options, JitAllocatorOptions::kUseProtectionKeys))
+    VirtMem::releaseProtectionKey(impl->protectionKey);
+
+  size_t size = sizeof(JitAllocatorPrivateImpl) + sizeof(JitAllocatorPool) * impl->poolCount;
   impl->~JitAllocatorPrivateImpl();
-  ::free(impl);
+  memAllocator->release(impl, size, Globals::kAllocAlignment);
 }
 
 static inline size_t JitAllocatorImpl_sizeToPoolId(const JitAllocatorPrivateImpl* impl, size_t size) noexcept {
@@ -485,6 +640,12 @@ static inline size_t JitAllocatorImpl_calculateIdealBlockSize(JitAllocatorPrivat
   return blockSize;
 }
 
+static inline VirtMem::MemoryFlags JitAllocatorImpl_memoryFlags(const JitAllocatorPrivateImpl* impl) noexcept {
+  return Support::test(impl->options, JitAllocatorOptions::kNonExecutable)
+    ? VirtMem::MemoryFlags::kAccessRW
+    : VirtMem::MemoryFlags::kAccessRWX;
+}
+
 ASMJIT_FAVOR_SPEED static void JitAllocatorImpl_fillPattern(void* mem, uint32_t pattern, size_t sizeInBytes) noexcept {
   size_t n = sizeInBytes / 4u;
   uint32_t* p = static_cast<uint32_t*>(mem);
@@ -493,6 +654,46 @@ ASMJIT_FAVOR_SPEED static void JitAllocatorImpl_fillPattern(void* mem, uint32_t
     p[i] = pattern;
 }
 
+// Allocates virtual memory of the given `size` for a block or an arena chunk, as specified by allocator options.
+static Error JitAllocatorImpl_allocVirtMem(JitAllocatorPrivateImpl* impl, VirtMem::DualMapping* virtMem, size_t size) noexcept {
+  VirtMem::MemoryFlags memFlags = JitAllocatorImpl_memoryFlags(impl);
+  Error err = kErrorOutOfMemory;
+
+  if (Support::test(impl->options, JitAllocatorOptions::kUseDualMapping)) {
+    if (impl->nearRange.anchor)
+      err = VirtMem::allocDualMappingNear(virtMem, size, memFlags, impl->nearRange);
+
+    if (err != kErrorOk)
+      err = VirtMem::allocDualMapping(virtMem, size, memFlags);
+  }
+  else {
+    if (impl->nearRange.anchor)
+      err = VirtMem::allocNear(&virtMem->rx, size, memFlags, impl->nearRange);
+
+    if (err != kErrorOk)
+      err = VirtMem::alloc(&virtMem->rx, size, memFlags);
+
+    if (err == kErrorOk && Support::test(impl->options, JitAllocatorOptions::kUseProtectionKeys)) {
+      err = VirtMem::protectWithKey(virtMem->rx, size, memFlags, impl->protectionKey);
+      if (err != kErrorOk) {
+        VirtMem::release(virtMem->rx, size);
+        virtMem->rx = nullptr;
+      }
+    }
+    virtMem->rw = virtMem->rx;
+  }
+
+  return err;
+}
+
+// Releases virtual memory allocated by `JitAllocatorImpl_allocVirtMem()`.
+static void JitAllocatorImpl_releaseVirtMem(JitAllocatorPrivateImpl* impl, VirtMem::DualMapping* virtMem, size_t size) noexcept {
+  if (Support::test(impl->options, JitAllocatorOptions::kUseDualMapping))
+    VirtMem::releaseDualMapping(virtMem, size);
+  else
+    VirtMem::release(virtMem->rx, size);
+}
+
 // Allocate a new `JitAllocatorBlock` for the given `blockSize`.
 //
 // NOTE: The block doesn't have `kFlagEmpty` flag set, because the new block
@@ -504,57 +705,76 @@ static JitAllocatorBlock* JitAllocatorImpl_newBlock(JitAllocatorPrivateImpl* imp
   uint32_t areaSize = uint32_t((blockSize + pool->granularity - 1) >> pool->granularityLog2);
   uint32_t numBitWords = (areaSize + kBitWordSizeInBits - 1u) / kBitWordSizeInBits;
 
-  JitAllocatorBlock* block = static_cast<JitAllocatorBlock*>(::malloc(sizeof(JitAllocatorBlock)));
+  uint32_t pageCount = 0;
+  if (Support::test(impl->options, JitAllocatorOptions::kDecommitUnusedPages))
+    pageCount = uint32_t(blockSize / impl->pageSize);
+
+  uint32_t numPageBitWords = (pageCount + kBitWordSizeInBits - 1u) / kBitWordSizeInBits;
+  uint32_t numSummaryBitWords = (numBitWords + kBitWordSizeInBits - 1u) / kBitWordSizeInBits;
+  size_t bitWordsSize = (size_t(numBitWords) * 2 + numSummaryBitWords + numPageBitWords) * sizeof(BitWord);
+
+  MemAllocator* memAllocator = impl->memAllocator;
+  JitAllocatorBlock* block = static_cast<JitAllocatorBlock*>(memAllocator->alloc(sizeof(JitAllocatorBlock), Globals::kAllocAlignment));
   BitWord* bitWords = nullptr;
   VirtMem::DualMapping virtMem {};
   Error err = kErrorOutOfMemory;
 
   if (block != nullptr)
-    bitWords = static_cast<BitWord*>(::malloc(size_t(numBitWords) * 2 * sizeof(BitWord)));
+    bitWords = static_cast<BitWord*>(memAllocator->alloc(bitWordsSize, Globals::kAllocAlignment));
 
   uint32_t blockFlags = 0;
   if (bitWords != nullptr) {
-    if (Support::test(impl->options, JitAllocatorOptions::kUseDualMapping)) {
-      err = VirtMem::allocDualMapping(&virtMem, blockSize, VirtMem::MemoryFlags::kAccessRWX);
+    err = JitAllocatorImpl_allocVirtMem(impl, &virtMem, blockSize);
+    if (Support::test(impl->options, JitAllocatorOptions::kUseDualMapping))
       blockFlags |= JitAllocatorBlock::kFlagDualMapped;
-    }
-    else {
-      err = VirtMem::alloc(&virtMem.rx, blockSize, VirtMem::MemoryFlags::kAccessRWX);
-      virtMem.rw = virtMem.rx;
-    }
   }
 
   // Out of memory.
   if (ASMJIT_UNLIKELY(!block || !bitWords || err != kErrorOk)) {
     if (bitWords)
-      ::free(bitWords);
+      memAllocator->release(bitWords, bitWordsSize, Globals::kAllocAlignment);
 
     if (block)
-      ::free(block);
+      memAllocator->release(block, sizeof(JitAllocatorBlock), Globals::kAllocAlignment);
 
     return nullptr;
   }
 
-  // Fill the memory if the secure mode is enabled.
-  if (Support::test(impl->options, JitAllocatorOptions::kFillUnusedMemory)) {
+  memset(bitWords, 0, bitWordsSize);
+  BitWord* summaryBitWords = bitWords + numBitWords * 2;
+  BitWord* pageBitWords = pageCount ? summaryBitWords + numSummaryBitWords : nullptr;
+  block = new(block) JitAllocatorBlock(pool, virtMem, blockSize, blockFlags, bitWords, bitWords + numBitWords, pageBitWords, summaryBitWords, areaSize, pageCount);
+
+  // Pages of a new block start decommitted if unused pages are decommitted, so only pages that are actually used
+  // get committed (and filled if the secure mode is enabled) by `JitAllocatorImpl_recommitPages()`.
+  if (pageCount && VirtMem::decommit(virtMem.rx, blockSize) == kErrorOk) {
+    Support::bitVectorFill(pageBitWords, 0, pageCount);
+    block->_decommittedPageCount = pageCount;
+  }
+  else if (Support::test(impl->options, JitAllocatorOptions::kFillUnusedMemory)) {
+    // Fill the memory if the secure mode is enabled.
     VirtMem::ProtectJitReadWriteScope scope(virtMem.rw, blockSize);
     JitAllocatorImpl_fillPattern(virtMem.rw, impl->fillPattern, blockSize);
   }
 
-  memset(bitWords, 0, size_t(numBitWords) * 2 * sizeof(BitWord));
-  return new(block) JitAllocatorBlock(pool, virtMem, blockSize, blockFlags, bitWords, bitWords + numBitWords, areaSize);
+  return block;
 }
 
-static void JitAllocatorImpl_deleteBlock(JitAllocatorPrivateImpl* impl, JitAllocatorBlock* block) noexcept {
-  DebugUtils::unused(impl);
+static inline size_t JitAllocatorImpl_calculateBlockOverhead(const JitAllocatorBlock* block) noexcept {
+  size_t numBitWords = block->pool()->bitWordCountFromAreaSize(block->areaSize());
+  return sizeof(JitAllocatorBlock) +
+         JitAllocatorImpl_bitVectorSizeToByteSize(block->areaSize()) * 2u +
+         JitAllocatorImpl_bitVectorSizeToByteSize(uint32_t(numBitWords)) +
+         JitAllocatorImpl_bitVectorSizeToByteSize(block->pageCount());
+}
 
-  if (block->hasFlag(JitAllocatorBlock::kFlagDualMapped))
-    VirtMem::releaseDualMapping(&block->_mapping, block->blockSize());
-  else
-    VirtMem::release(block->rxPtr(), block->blockSize());
+static void JitAllocatorImpl_deleteBlock(JitAllocatorPrivateImpl* impl, JitAllocatorBlock* block) noexcept {
+  JitAllocatorImpl_releaseVirtMem(impl, &block->_mapping, block->blockSize());
 
-  ::free(block->_usedBitVector);
-  ::free(block);
+  // All bit-vectors were allocated together with `_usedBitVector`.
+  size_t bitWordsSize = JitAllocatorImpl_calculateBlockOverhead(block) - sizeof(JitAllocatorBlock);
+  impl->memAllocator->release(block->_usedBitVector, bitWordsSize, Globals::kAllocAlignment);
+  impl->memAllocator->release(block, sizeof(JitAllocatorBlock), Globals::kAllocAlignment);
 }
 
 static void JitAllocatorImpl_insertBlock(JitAllocatorPrivateImpl* impl, JitAllocatorBlock* block) noexcept {
@@ -570,7 +790,8 @@ static void JitAllocatorImpl_insertBlock(JitAllocatorPrivateImpl* impl, JitAlloc
   // Update statistics.
   pool->blockCount++;
   pool->totalAreaSize += block->areaSize();
-  pool->totalOverheadBytes += sizeof(JitAllocatorBlock) + JitAllocatorImpl_bitVectorSizeToByteSize(block->areaSize()) * 2u;
+  pool->totalOverheadBytes += JitAllocatorImpl_calculateBlockOverhead(block);
+  pool->totalDecommittedSize += size_t(block->decommittedPageCount()) * impl->pageSize;
 }
 
 static void JitAllocatorImpl_removeBlock(JitAllocatorPrivateImpl* impl, JitAllocatorBlock* block) noexcept {
@@ -586,7 +807,131 @@ static void JitAllocatorImpl_removeBlock(JitAllocatorPrivateImpl* impl, JitAlloc
   // Update statistics.
   pool->blockCount--;
   pool->totalAreaSize -= block->areaSize();
-  pool->totalOverheadBytes -= sizeof(JitAllocatorBlock) + JitAllocatorImpl_bitVectorSizeToByteSize(block->areaSize()) * 2u;
+  pool->totalOverheadBytes -= JitAllocatorImpl_calculateBlockOverhead(block);
+  pool->totalDecommittedSize -= size_t(block->decommittedPageCount()) * impl->pageSize;
+}
+
+// Tests whether the area range [areaStart, areaEnd) of `block` is entirely unused.
+static inline bool JitAllocatorImpl_isAreaUnused(const JitAllocatorBlock* block, uint32_t areaStart, uint32_t areaEnd) noexcept {
+  const JitAllocatorPool* pool = block->pool();
+  BitVectorRangeIterator<Support::BitWord, 1> it(block->_usedBitVector, pool->bitWordCountFromAreaSize(block->areaSize()), areaStart, areaEnd);
+
+  // The iterator doesn't mask bits past `areaEnd` in the last BitWord, so the range has to be checked.
+  size_t rangeStart;
+  size_t rangeEnd;
+  return !it.nextRange(&rangeStart, &rangeEnd) || rangeStart >= areaEnd;
+}
+
+// Finds the first unused area of at least `areaSize` granules in `block` by using the summary of empty BitWords.
+//
+// Every unused area of at least `kJitAllocatorLargeAreaSize` granules contains at least `minEmptyWords` consecutive
+// empty BitWords, and these are always a single run in the summary. Each run of the summary is then extended by free
+// granules of its neighboring BitWords, so the result is the same as the first fit found by scanning the used bits.
+static uint32_t JitAllocatorImpl_findLargeArea(const JitAllocatorBlock* block, uint32_t areaSize) noexcept {
+  using Support::BitWord;
+  using Support::kBitWordSizeInBits;
+
+  ASMJIT_ASSERT(areaSize >= kJitAllocatorLargeAreaSize);
+
+  const JitAllocatorPool* pool = block->pool();
+  const BitWord* usedBitVector = block->_usedBitVector;
+
+  size_t numBitWords = pool->bitWordCountFromAreaSize(block->areaSize());
+  size_t numSummaryBitWords = (numBitWords + kBitWordSizeInBits - 1u) / kBitWordSizeInBits;
+  size_t minEmptyWords = (areaSize + 1u) / kBitWordSizeInBits - 1u;
+
+  BitVectorRangeIterator<BitWord, 1> it(block->_emptySummaryBitVector, numSummaryBitWords, 0, numBitWords);
+  size_t rangeStart;
+  size_t rangeEnd;
+
+  while (it.nextRange(&rangeStart, &rangeEnd)) {
+    if (rangeEnd - rangeStart < minEmptyWords)
+      continue;
+
+    // BitWords surrounding the run are not empty, so `clz()` and `ctz()` are well defined.
+    size_t start = rangeStart * kBitWordSizeInBits;
+    if (rangeStart > 0)
+      start -= Support::clz(usedBitVector[rangeStart - 1]);
+
+    size_t end = rangeEnd * kBitWordSizeInBits;
+    if (rangeEnd < numBitWords)
+      end += Support::ctz(usedBitVector[rangeEnd]);
+
+    end = Support::min<size_t>(end, block->areaSize());
+    if (end - start >= areaSize)
+      return uint32_t(start);
+  }
+
+  return std::numeric_limits<uint32_t>::max();
+}
+
+// Decommits all pages of `block` that overlap the area range [areaStart, areaEnd) and became entirely unused.
+static void JitAllocatorImpl_decommitUnusedPages(JitAllocatorPrivateImpl* impl, JitAllocatorBlock* block, uint32_t areaStart, uint32_t areaEnd) noexcept {
+  JitAllocatorPool* pool = block->pool();
+  uint32_t areasPerPage = impl->pageSize >> pool->granularityLog2;
+
+  uint32_t pageStart = areaStart / areasPerPage;
+  uint32_t pageEnd = (areaEnd + areasPerPage - 1u) / areasPerPage;
+  uint32_t runStart = pageStart;
+
+  // Decommit continuous runs of pages to minimize the number of syscalls.
+  for (uint32_t page = pageStart; page <= pageEnd; page++) {
+    if (page < pageEnd &&
+        !Support::bitVectorGetBit(block->_decommittedBitVector, page) &&
+        JitAllocatorImpl_isAreaUnused(block, page * areasPerPage, (page + 1u) * areasPerPage)) {
+      continue;
+    }
+
+    if (runStart != page) {
+      uint32_t runSize = page - runStart;
+      if (VirtMem::decommit(block->rxPtr() + size_t(runStart) * impl->pageSize, size_t(runSize) * impl->pageSize) == kErrorOk) {
+        Support::bitVectorFill(block->_decommittedBitVector, runStart, runSize);
+        block->_decommittedPageCount += runSize;
+        pool->totalDecommittedSize += size_t(runSize) * impl->pageSize;
+      }
+    }
+
+    runStart = page + 1u;
+  }
+}
+
+// Recommits all decommitted pages of `block` that overlap the area range [areaStart, areaEnd) so it can be used.
+static Error JitAllocatorImpl_recommitPages(JitAllocatorPrivateImpl* impl, JitAllocatorBlock* block, uint32_t areaStart, uint32_t areaEnd) noexcept {
+  if (!block->decommittedPageCount())
+    return kErrorOk;
+
+  JitAllocatorPool* pool = block->pool();
+  uint32_t areasPerPage = impl->pageSize >> pool->granularityLog2;
+
+  uint32_t pageStart = areaStart / areasPerPage;
+  uint32_t pageEnd = (areaEnd + areasPerPage - 1u) / areasPerPage;
+  uint32_t runStart = pageStart;
+
+  for (uint32_t page = pageStart; page <= pageEnd; page++) {
+    if (page < pageEnd && Support::bitVectorGetBit(block->_decommittedBitVector, page))
+      continue;
+
+    if (runStart != page) {
+      uint32_t runSize = page - runStart;
+      uint8_t* runPtr = block->rwPtr() + size_t(runStart) * impl->pageSize;
+      size_t runByteSize = size_t(runSize) * impl->pageSize;
+
+      ASMJIT_PROPAGATE(VirtMem::recommit(runPtr, runByteSize, JitAllocatorImpl_memoryFlags(impl)));
+      Support::bitVectorClear(block->_decommittedBitVector, runStart, runSize);
+      block->_decommittedPageCount -= runSize;
+      pool->totalDecommittedSize -= runByteSize;
+
+      // The content of decommitted pages is lost, so fill them again if the secure mode is enabled.
+      if (Support::test(impl->options, JitAllocatorOptions::kFillUnusedMemory)) {
+        VirtMem::ProtectJitReadWriteScope scope(runPtr, runByteSize);
+        JitAllocatorImpl_fillPattern(runPtr, impl->fillPattern, runByteSize);
+      }
+    }
+
+    runStart = page + 1u;
+  }
+
+  return kErrorOk;
 }
 
 static void JitAllocatorImpl_wipeOutBlock(JitAllocatorPrivateImpl* impl, JitAllocatorBlock* block) noexcept {
@@ -598,8 +943,14 @@ static void JitAllocatorImpl_wipeOutBlock(JitAllocatorPrivateImpl* impl, JitAllo
   uint32_t granularity = pool->granularity;
   size_t numBitWords = pool->bitWordCountFromAreaSize(areaSize);
 
-  VirtMem::protectJitMemory(VirtMem::ProtectJitAccess::kReadWrite);
-  if (Support::test(impl->options, JitAllocatorOptions::kFillUnusedMemory)) {
+  // Decommit the whole block if pages are decommitted, it will be filled when the pages are recommitted.
+  if (block->pageCount() && VirtMem::decommit(block->rxPtr(), block->blockSize()) == kErrorOk) {
+    Support::bitVectorFill(block->_decommittedBitVector, 0, block->pageCount());
+    block->_decommittedPageCount = block->pageCount();
+  }
+  else if (Support::test(impl->options, JitAllocatorOptions::kFillUnusedMemory)) {
+    VirtMem::protectJitMemory(VirtMem::ProtectJitAccess::kReadWrite);
+
     uint8_t* rwPtr = block->rwPtr();
     BitVectorRangeIterator<Support::BitWord, 0> it(block->_usedBitVector, pool->bitWordCountFromAreaSize(block->areaSize()));
 
@@ -613,11 +964,13 @@ static void JitAllocatorImpl_wipeOutBlock(JitAllocatorPrivateImpl* impl, JitAllo
       JitAllocatorImpl_fillPattern(spanPtr, impl->fillPattern, spanSize);
       VirtMem::flushInstructionCache(spanPtr, spanSize);
     }
+
+    VirtMem::protectJitMemory(VirtMem::ProtectJitAccess::kReadExecute);
   }
-  VirtMem::protectJitMemory(VirtMem::ProtectJitAccess::kReadExecute);
 
   memset(block->_usedBitVector, 0, size_t(numBitWords) * sizeof(Support::BitWord));
   memset(block->_stopBitVector, 0, size_t(numBitWords) * sizeof(Support::BitWord));
+  Support::bitVectorFill(block->_emptySummaryBitVector, 0, numBitWords);
 
   block->_areaUsed = 0;
   block->_largestUnusedArea = areaSize;
@@ -627,6 +980,89 @@ static void JitAllocatorImpl_wipeOutBlock(JitAllocatorPrivateImpl* impl, JitAllo
   block->clearFlags(JitAllocatorBlock::kFlagDirty);
 }
 
+// Releases all chunks of the given `arena`, which can be used again afterwards.
+static void JitAllocatorImpl_releaseArenaChunks(JitAllocatorPrivateImpl* impl, JitAllocator::Arena* arena) noexcept {
+  JitAllocatorArenaChunk* chunk = arena->_chunks;
+
+  while (chunk) {
+    JitAllocatorArenaChunk* next = chunk->_next;
+
+    impl->arenaChunkCount--;
+    impl->arenaReservedSize -= chunk->chunkSize();
+    impl->arenaUsedSize -= chunk->usedSize();
+
+    JitAllocatorImpl_releaseVirtMem(impl, &chunk->_mapping, chunk->chunkSize());
+    impl->memAllocator->release(chunk, sizeof(JitAllocatorArenaChunk), Globals::kAllocAlignment);
+
+    chunk = next;
+  }
+
+  impl->allocationCount -= arena->_allocationCount;
+
+  arena->_chunks = nullptr;
+  arena->_lastChunkSize = 0;
+  arena->_allocationCount = 0;
+}
+
+// Finds an unused area of `areaSize` granules in `block` that is as close to `nearArea` as possible. The first fit
+// after `nearArea` is preferred, then the last fit before it, placed at the end of the unused range.
+static uint32_t JitAllocatorImpl_findAreaNear(const JitAllocatorBlock* block, uint32_t areaSize, uint32_t nearArea) noexcept {
+  const JitAllocatorPool* pool = block->pool();
+  size_t numBitWords = pool->bitWordCountFromAreaSize(block->areaSize());
+
+  // NOTE: The iterator doesn't mask bits past the end of the range in the last BitWord, so ranges that start at or
+  // after the end of the range must be ignored.
+
+  size_t rangeStart;
+  size_t rangeEnd;
+
+  BitVectorRangeIterator<Support::BitWord, 0> after(block->_usedBitVector, numBitWords, nearArea, block->areaSize());
+  while (after.nextRange(&rangeStart, &rangeEnd, areaSize)) {
+    if (rangeStart >= block->areaSize())
+      break;
+
+    if (rangeEnd - rangeStart >= areaSize)
+      return uint32_t(rangeStart);
+  }
+
+  uint32_t areaIndex = std::numeric_limits<uint32_t>::max();
+  BitVectorRangeIterator<Support::BitWord, 0> before(block->_usedBitVector, numBitWords, 0, nearArea);
+
+  while (before.nextRange(&rangeStart, &rangeEnd)) {
+    if (rangeStart >= nearArea)
+      break;
+
+    rangeEnd = Support::min<size_t>(rangeEnd, nearArea);
+    if (rangeEnd - rangeStart >= areaSize)
+      areaIndex = uint32_t(rangeEnd - areaSize);
+  }
+
+  return areaIndex;
+}
+
+// Marks the area [areaIndex, areaIndex + areaSize) of `block` as allocated and returns pointers to it.
+static Error JitAllocatorImpl_allocArea(JitAllocatorPrivateImpl* impl, JitAllocatorBlock* block, uint32_t areaIndex, uint32_t areaSize, void** rxPtrOut, void** rwPtrOut) noexcept {
+  JitAllocatorPool* pool = block->pool();
+  ASMJIT_PROPAGATE(JitAllocatorImpl_recommitPages(impl, block, areaIndex, areaIndex + areaSize));
+
+  if (block->hasFlag(JitAllocatorBlock::kFlagEmpty)) {
+    pool->emptyBlockCount--;
+    block->clearFlags(JitAllocatorBlock::kFlagEmpty);
+  }
+
+  // Update statistics.
+  impl->allocationCount++;
+  block->markAllocatedArea(areaIndex, areaIndex + areaSize);
+
+  // Return a pointer to the allocated memory.
+  size_t offset = pool->byteSizeFromAreaSize(areaIndex);
+  ASMJIT_ASSERT(offset <= block->blockSize() - pool->byteSizeFromAreaSize(areaSize));
+
+  *rxPtrOut = block->rxPtr() + offset;
+  *rwPtrOut = block->rwPtr() + offset;
+  return kErrorOk;
+}
+
 // JitAllocator - Construction & Destruction
 // =========================================
 
@@ -655,12 +1091,16 @@ void JitAllocator::reset(ResetPolicy resetPolicy) noexcept {
   impl->tree.reset();
   size_t poolCount = impl->poolCount;
 
+  // Arenas stay valid, but their memory is released.
+  for (Arena* arena = impl->arenas.first(); arena; arena = arena->next())
+    JitAllocatorImpl_releaseArenaChunks(impl, arena);
+
   for (size_t poolId = 0; poolId < poolCount; poolId++) {
     JitAllocatorPool& pool = impl->pools[poolId];
     JitAllocatorBlock* block = pool.blocks.first();
 
     JitAllocatorBlock* blockToKeep = nullptr;
-    if (resetPolicy != ResetPolicy::kHard && uint32_t(impl->options & JitAllocatorOptions::kImmediateRelease) == 0) {
+    if (block && resetPolicy != ResetPolicy::kHard && uint32_t(impl->options & JitAllocatorOptions::kImmediateRelease) == 0) {
       blockToKeep = block;
       block = block->next();
     }
@@ -701,8 +1141,13 @@ JitAllocator::Statistics JitAllocator::statistics() const noexcept {
       statistics._reservedSize += size_t(pool.totalAreaSize) * pool.granularity;
       statistics._usedSize     += size_t(pool.totalAreaUsed) * pool.granularity;
       statistics._overheadSize += size_t(pool.totalOverheadBytes);
+      statistics._decommittedSize += pool.totalDecommittedSize;
     }
 
+    statistics._blockCount += impl->arenaChunkCount;
+    statistics._reservedSize += impl->arenaReservedSize;
+    statistics._usedSize += impl->arenaUsedSize;
+    statistics._overheadSize += impl->arenaChunkCount * sizeof(JitAllocatorArenaChunk);
     statistics._allocationCount = impl->allocationCount;
   }
 
@@ -744,37 +1189,49 @@ Error JitAllocator::alloc(void** rxPtrOut, void** rwPtrOut, size_t size) noexcep
       JitAllocatorBlock* next = block->hasNext() ? block->next() : pool->blocks.first();
       if (block->areaAvailable() >= areaSize) {
         if (block->isDirty() || block->largestUnusedArea() >= areaSize) {
-          BitVectorRangeIterator<Support::BitWord, 0> it(block->_usedBitVector, pool->bitWordCountFromAreaSize(block->areaSize()), block->_searchStart, block->_searchEnd);
+          if (areaSize >= kJitAllocatorLargeAreaSize) {
+            // Large areas are found by using the summary of empty BitWords, which is much smaller than the used bits.
+            areaIndex = JitAllocatorImpl_findLargeArea(block, areaSize);
+            if (areaIndex != kNoIndex)
+              break;
 
-          size_t rangeStart = 0;
-          size_t rangeEnd = block->areaSize();
+            // There is no unused area of `areaSize` in this block - the hint makes the next search skip it.
+            block->_largestUnusedArea = areaSize - 1u;
+            block->clearFlags(JitAllocatorBlock::kFlagDirty);
+          }
+          else {
+            BitVectorRangeIterator<Support::BitWord, 0> it(block->_usedBitVector, pool->bitWordCountFromAreaSize(block->areaSize()), block->_searchStart, block->_searchEnd);
 
-          size_t searchStart = SIZE_MAX;
-          size_t largestArea = 0;
+            size_t rangeStart = 0;
+            size_t rangeEnd = block->areaSize();
 
-          while (it.nextRange(&rangeStart, &rangeEnd, areaSize)) {
-            size_t rangeSize = rangeEnd - rangeStart;
-            if (rangeSize >= areaSize) {
-              areaIndex = uint32_t(rangeStart);
-              break;
-            }
+            size_t searchStart = SIZE_MAX;
+            size_t largestArea = 0;
 
-            searchStart = Support::min(searchStart, rangeStart);
-            largestArea = Support::max(largestArea, rangeSize);
-          }
+            while (it.nextRange(&rangeStart, &rangeEnd, areaSize)) {
+              size_t rangeSize = rangeEnd - rangeStart;
+              if (rangeSize >= areaSize) {
+                areaIndex = uint32_t(rangeStart);
+                break;
+              }
+
+              searchStart = Support::min(searchStart, rangeStart);
+              largestArea = Support::max(largestArea, rangeSize);
+            }
 
-          if (areaIndex != kNoIndex)
-            break;
+            if (areaIndex != kNoIndex)
+              break;
 
-          if (searchStart != SIZE_MAX) {
-            // Because we have iterated over the entire block, we can now mark the
-            // largest unused area that can be used to cache the next traversal.
-            size_t searchEnd = rangeEnd;
+            if (searchStart != SIZE_MAX) {
+              // Because we have iterated over the entire block, we can now mark the
+              // largest unused area that can be used to cache the next traversal.
+              size_t searchEnd = rangeEnd;
 
-            block->_searchStart = uint32_t(searchStart);
-            block->_searchEnd = uint32_t(searchEnd);
-            block->_largestUnusedArea = uint32_t(largestArea);
-            block->clearFlags(JitAllocatorBlock::kFlagDirty);
+              block->_searchStart = uint32_t(searchStart);
+              block->_searchEnd = uint32_t(searchEnd);
+              block->_largestUnusedArea = uint32_t(largestArea);
+              block->clearFlags(JitAllocatorBlock::kFlagDirty);
+            }
           }
         }
       }
@@ -799,22 +1256,49 @@ Error JitAllocator::alloc(void** rxPtrOut, void** rwPtrOut, size_t size) noexcep
     block->_searchStart = areaSize;
     block->_largestUnusedArea = block->areaSize() - areaSize;
   }
-  else if (block->hasFlag(JitAllocatorBlock::kFlagEmpty)) {
-    pool->emptyBlockCount--;
-    block->clearFlags(JitAllocatorBlock::kFlagEmpty);
-  }
 
-  // Update statistics.
-  impl->allocationCount++;
-  block->markAllocatedArea(areaIndex, areaIndex + areaSize);
+  return JitAllocatorImpl_allocArea(impl, block, areaIndex, areaSize, rxPtrOut, rwPtrOut);
+}
 
-  // Return a pointer to the allocated memory.
-  size_t offset = pool->byteSizeFromAreaSize(areaIndex);
-  ASMJIT_ASSERT(offset <= block->blockSize() - size);
+Error JitAllocator::allocNear(void** rxPtrOut, void** rwPtrOut, size_t size, const void* nearPtr) noexcept {
+  if (ASMJIT_UNLIKELY(_impl == &JitAllocatorImpl_none))
+    return DebugUtils::errored(kErrorNotInitialized);
 
-  *rxPtrOut = block->rxPtr() + offset;
-  *rwPtrOut = block->rwPtr() + offset;
-  return kErrorOk;
+  JitAllocatorPrivateImpl* impl = static_cast<JitAllocatorPrivateImpl*>(_impl);
+  constexpr uint32_t kNoIndex = std::numeric_limits<uint32_t>::max();
+
+  *rxPtrOut = nullptr;
+  *rwPtrOut = nullptr;
+
+  // Align to the minimum granularity by default.
+  size = Support::alignUp<size_t>(size, impl->granularity);
+  if (ASMJIT_UNLIKELY(size == 0))
+    return DebugUtils::errored(kErrorInvalidArgument);
+
+  if (ASMJIT_UNLIKELY(size > std::numeric_limits<uint32_t>::max() / 2))
+    return DebugUtils::errored(kErrorTooLarge);
+
+  if (nearPtr) {
+    LockGuard guard(impl->lock);
+    JitAllocatorBlock* block = impl->tree.get(static_cast<const uint8_t*>(nearPtr));
+
+    // Any pool can hold an allocation of any size, so use the block regardless of the pool it belongs to.
+    if (block) {
+      JitAllocatorPool* pool = block->pool();
+      uint32_t areaSize = uint32_t(pool->areaSizeFromByteSize(size));
+
+      if (block->areaAvailable() >= areaSize) {
+        uint32_t nearArea = uint32_t(size_t(static_cast<const uint8_t*>(nearPtr) - block->rxPtr()) >> pool->granularityLog2);
+        uint32_t areaIndex = JitAllocatorImpl_findAreaNear(block, areaSize, nearArea);
+
+        if (areaIndex != kNoIndex)
+          return JitAllocatorImpl_allocArea(impl, block, areaIndex, areaSize, rxPtrOut, rwPtrOut);
+      }
+    }
+  }
+
+  // Fall back to a regular allocation if the memory cannot be placed into the same block.
+  return alloc(rxPtrOut, rwPtrOut, size);
 }
 
 Error JitAllocator::release(void* rxPtr) noexcept {
@@ -857,12 +1341,15 @@ Error JitAllocator::release(void* rxPtr) noexcept {
     if (pool->emptyBlockCount || Support::test(impl->options, JitAllocatorOptions::kImmediateRelease)) {
       JitAllocatorImpl_removeBlock(impl, block);
       JitAllocatorImpl_deleteBlock(impl, block);
+      return kErrorOk;
     }
-    else {
-      pool->emptyBlockCount++;
-    }
+
+    pool->emptyBlockCount++;
   }
 
+  if (block->pageCount())
+    JitAllocatorImpl_decommitUnusedPages(impl, block, areaIndex, areaEnd);
+
   return kErrorOk;
 }
 
@@ -902,13 +1389,185 @@ Error JitAllocator::shrink(void* rxPtr, size_t newSize) noexcept {
     block->markShrunkArea(areaStart + areaShrunkSize, areaEnd);
 
     // Fill released memory if the secure mode is enabled.
-    if (Support::test(impl->options, JitAllocatorOptions::kFillUnusedMemory))
-      JitAllocatorImpl_fillPattern(block->rwPtr() + (areaStart + areaShrunkSize) * pool->granularity, fillPattern(), areaDiff * pool->granularity);
+    if (Support::test(impl->options, JitAllocatorOptions::kFillUnusedMemory)) {
+      uint8_t* spanPtr = block->rwPtr() + (areaStart + areaShrunkSize) * pool->granularity;
+      size_t spanSize = areaDiff * pool->granularity;
+
+      VirtMem::ProtectJitReadWriteScope scope(spanPtr, spanSize);
+      JitAllocatorImpl_fillPattern(spanPtr, fillPattern(), spanSize);
+    }
+
+    if (block->pageCount())
+      JitAllocatorImpl_decommitUnusedPages(impl, block, areaStart + areaShrunkSize, areaEnd);
   }
 
   return kErrorOk;
 }
 
+// JitAllocator - Arenas
+// =====================
+
+Error JitAllocator::newArena(Arena** arenaOut) noexcept {
+  *arenaOut = nullptr;
+
+  if (ASMJIT_UNLIKELY(_impl == &JitAllocatorImpl_none))
+    return DebugUtils::errored(kErrorNotInitialized);
+
+  JitAllocatorPrivateImpl* impl = static_cast<JitAllocatorPrivateImpl*>(_impl);
+  void* p = impl->memAllocator->alloc(sizeof(Arena), Globals::kAllocAlignment);
+
+  if (ASMJIT_UNLIKELY(!p))
+    return DebugUtils::errored(kErrorOutOfMemory);
+
+  Arena* arena = new(p) Arena();
+  {
+    LockGuard guard(impl->lock);
+    impl->arenas.append(arena);
+  }
+
+  *arenaOut = arena;
+  return kErrorOk;
+}
+
+Error JitAllocator::allocFromArena(Arena* arena, void** rxPtrOut, void** rwPtrOut, size_t size) noexcept {
+  *rxPtrOut = nullptr;
+  *rwPtrOut = nullptr;
+
+  if (ASMJIT_UNLIKELY(_impl == &JitAllocatorImpl_none))
+    return DebugUtils::errored(kErrorNotInitialized);
+
+  if (ASMJIT_UNLIKELY(!arena))
+    return DebugUtils::errored(kErrorInvalidArgument);
+
+  JitAllocatorPrivateImpl* impl = static_cast<JitAllocatorPrivateImpl*>(_impl);
+
+  // Align to the minimum granularity by default.
+  size = Support::alignUp<size_t>(size, impl->granularity);
+  if (ASMJIT_UNLIKELY(size == 0))
+    return DebugUtils::errored(kErrorInvalidArgument);
+
+  if (ASMJIT_UNLIKELY(size > std::numeric_limits<uint32_t>::max() / 2))
+    return DebugUtils::errored(kErrorTooLarge);
+
+  LockGuard guard(impl->lock);
+  JitAllocatorArenaChunk* chunk = arena->_chunks;
+
+  // Allocate a new chunk if the current one cannot hold the allocation, the rest of the current one is not used.
+  if (!chunk || chunk->unusedSize() < size) {
+    // The first chunk has the size of a block, each next chunk doubles the size of the previous one.
+    size_t chunkSize = size_t(impl->blockSize);
+    if (arena->_lastChunkSize) {
+      chunkSize = arena->_lastChunkSize;
+      if (chunkSize < kJitAllocatorMaxBlockSize)
+        chunkSize *= 2u;
+    }
+
+    if (size > chunkSize)
+      chunkSize = Support::alignUp(size, impl->blockSize);
+
+    void* p = impl->memAllocator->alloc(sizeof(JitAllocatorArenaChunk), Globals::kAllocAlignment);
+    if (ASMJIT_UNLIKELY(!p))
+      return DebugUtils::errored(kErrorOutOfMemory);
+
+    VirtMem::DualMapping virtMem {};
+    Error err = JitAllocatorImpl_allocVirtMem(impl, &virtMem, chunkSize);
+
+    if (ASMJIT_UNLIKELY(err != kErrorOk)) {
+      impl->memAllocator->release(p, sizeof(JitAllocatorArenaChunk), Globals::kAllocAlignment);
+      return DebugUtils::errored(kErrorOutOfMemory);
+    }
+
+    // Fill the memory if the secure mode is enabled.
+    if (Support::test(impl->options, JitAllocatorOptions::kFillUnusedMemory)) {
+      VirtMem::ProtectJitReadWriteScope scope(virtMem.rw, chunkSize);
+      JitAllocatorImpl_fillPattern(virtMem.rw, impl->fillPattern, chunkSize);
+    }
+
+    chunk = new(p) JitAllocatorArenaChunk(arena->_chunks, virtMem, chunkSize);
+    arena->_chunks = chunk;
+    arena->_lastChunkSize = chunkSize;
+
+    impl->arenaChunkCount++;
+    impl->arenaReservedSize += chunkSize;
+  }
+
+  size_t offset = chunk->_usedSize;
+  chunk->_usedSize += size;
+  chunk->_lastOffset = offset;
+
+  arena->_allocationCount++;
+  impl->allocationCount++;
+  impl->arenaUsedSize += size;
+
+  *rxPtrOut = chunk->rxPtr() + offset;
+  *rwPtrOut = chunk->rwPtr() + offset;
+  return kErrorOk;
+}
+
+Error JitAllocator::shrinkInArena(Arena* arena, void* rxPtr, size_t newSize) noexcept {
+  if (ASMJIT_UNLIKELY(_impl == &JitAllocatorImpl_none))
+    return DebugUtils::errored(kErrorNotInitialized);
+
+  if (ASMJIT_UNLIKELY(!arena || !rxPtr))
+    return DebugUtils::errored(kErrorInvalidArgument);
+
+  JitAllocatorPrivateImpl* impl = static_cast<JitAllocatorPrivateImpl*>(_impl);
+  newSize = Support::alignUp<size_t>(newSize, impl->granularity);
+
+  LockGuard guard(impl->lock);
+  JitAllocatorArenaChunk* chunk = arena->_chunks;
+
+  // Only the most recent allocation can be shrunk, which is always within the most recent chunk.
+  uint8_t* p = static_cast<uint8_t*>(rxPtr);
+  if (!chunk || p < chunk->rxPtr() || p >= chunk->rxPtr() + chunk->usedSize())
+    return kErrorOk;
+
+  size_t offset = size_t(p - chunk->rxPtr());
+  size_t usedSize = chunk->usedSize();
+
+  if (offset != chunk->_lastOffset || usedSize - offset <= newSize)
+    return kErrorOk;
+
+  size_t releasedSize = usedSize - offset - newSize;
+  chunk->_usedSize = offset + newSize;
+  impl->arenaUsedSize -= releasedSize;
+
+  if (!newSize) {
+    // The allocation that precedes the released one is not known, so it cannot be shrunk anymore.
+    chunk->_lastOffset = offset;
+    arena->_allocationCount--;
+    impl->allocationCount--;
+  }
+
+  // Fill released memory if the secure mode is enabled.
+  if (Support::test(impl->options, JitAllocatorOptions::kFillUnusedMemory)) {
+    uint8_t* spanPtr = chunk->rwPtr() + offset + newSize;
+
+    VirtMem::ProtectJitReadWriteScope scope(spanPtr, releasedSize);
+    JitAllocatorImpl_fillPattern(spanPtr, impl->fillPattern, releasedSize);
+  }
+
+  return kErrorOk;
+}
+
+Error JitAllocator::releaseArena(Arena* arena) noexcept {
+  if (ASMJIT_UNLIKELY(_impl == &JitAllocatorImpl_none))
+    return DebugUtils::errored(kErrorNotInitialized);
+
+  if (ASMJIT_UNLIKELY(!arena))
+    return DebugUtils::errored(kErrorInvalidArgument);
+
+  JitAllocatorPrivateImpl* impl = static_cast<JitAllocatorPrivateImpl*>(_impl);
+  {
+    LockGuard guard(impl->lock);
+    JitAllocatorImpl_releaseArenaChunks(impl, arena);
+    impl->arenas.unlink(arena);
+  }
+
+  impl->memAllocator->release(arena, sizeof(Arena), Globals::kAllocAlignment);
+  return kErrorOk;
+}
+
 // JitAllocator - Tests
 // ====================
 
@@ -1070,6 +1729,7 @@ static void JitAllocatorTest_usage(JitAllocator& allocator) noexcept {
   INFO("    Reserved (VirtMem): %9llu [Bytes]"         , (unsigned long long)(stats.reservedSize()));
   INFO("    Used     (VirtMem): %9llu [Bytes] (%.1f%%)", (unsigned long long)(stats.usedSize()), stats.usedSizeAsPercent());
   INFO("    Overhead (HeapMem): %9llu [Bytes] (%.1f%%)", (unsigned long long)(stats.overheadSize()), stats.overheadSizeAsPercent());
+  INFO("    Decommitted       : %9llu [Bytes]"         , (unsigned long long)(stats.decommittedSize()));
 }
 
 template<typename T, size_t kPatternSize, bool Bit>
@@ -1118,6 +1778,10 @@ UNIT(jit_allocator) {
     { "kUseMultiplePools", JitAllocatorOptions::kUseMultiplePools, 0, 0 },
     { "kFillUnusedMemory", JitAllocatorOptions::kFillUnusedMemory, 0, 0 },
     { "kImmediateRelease", JitAllocatorOptions::kImmediateRelease, 0, 0 },
+    { "kNonExecutable", JitAllocatorOptions::kNonExecutable, 0, 0 },
+    { "kUseProtectionKeys", JitAllocatorOptions::kUseProtectionKeys, 0, 0 },
+    { "kDecommitUnusedPages", JitAllocatorOptions::kDecommitUnusedPages, 0, 0 },
+    { "kDecommitUnusedPages | kFillUnusedMemory", JitAllocatorOptions::kDecommitUnusedPages | JitAllocatorOptions::kFillUnusedMemory, 0, 0 },
     { "kUseDualMapping | kFillUnusedMemory", JitAllocatorOptions::kUseDualMapping | JitAllocatorOptions::kFillUnusedMemory, 0, 0 }
   };
 
@@ -1133,6 +1797,330 @@ UNIT(jit_allocator) {
     BitVectorRangeIterator_testRandom<uint64_t, 64, 0>(rnd, kCount);
   }
 
+#if ASMJIT_ARCH_BITS >= 64
+  INFO("JitAllocator(nearAddress)");
+  {
+    static const uint8_t anchorData[16] {};
+    const uint8_t* anchor = anchorData;
+
+    JitAllocator::CreateParams params {};
+    params.nearAddress = anchor;
+
+    JitAllocator allocator(&params);
+    void* rxPtrs[64];
+    void* rwPtr;
+
+    // Allocate enough to force the allocator to create multiple blocks.
+    for (size_t i = 0; i < ASMJIT_ARRAY_SIZE(rxPtrs); i++) {
+      EXPECT(allocator.alloc(&rxPtrs[i], &rwPtr, 256 * 1024) == kErrorOk);
+
+      int64_t distance = int64_t(static_cast<uint8_t*>(rxPtrs[i]) - anchor);
+      EXPECT(Support::isInt32(distance), "Block [%p] is not within 32-bit displacement of [%p]\n", rxPtrs[i], anchor);
+    }
+
+    for (size_t i = 0; i < ASMJIT_ARRAY_SIZE(rxPtrs); i++)
+      EXPECT(allocator.release(rxPtrs[i]) == kErrorOk);
+  }
+#endif
+
+  INFO("JitAllocator(kUseProtectionKeys) - fallback");
+  {
+    // Allocate more allocators than there are protection keys, so the fallback is always tested - either all of them
+    // fall back if pkeys are not supported, or the last ones fall back when all keys have been already allocated.
+    JitAllocator::CreateParams params {};
+    params.options = JitAllocatorOptions::kUseProtectionKeys;
+
+    JitAllocator* allocators[17] {};
+    size_t fallbackCount = 0;
+
+    for (size_t i = 0; i < ASMJIT_ARRAY_SIZE(allocators); i++) {
+      allocators[i] = new JitAllocator(&params);
+      JitAllocator& allocator = *allocators[i];
+
+      if (!allocator.hasOption(JitAllocatorOptions::kUseProtectionKeys))
+        fallbackCount++;
+
+      void* rxPtr;
+      void* rwPtr;
+      EXPECT(allocator.alloc(&rxPtr, &rwPtr, 128) == kErrorOk);
+
+      {
+        VirtMem::ProtectJitReadWriteScope scope(rxPtr, 128);
+        memset(rwPtr, int(i), 128);
+      }
+
+      EXPECT(static_cast<const uint8_t*>(rxPtr)[127] == uint8_t(i));
+      EXPECT(allocator.release(rxPtr) == kErrorOk);
+    }
+
+    INFO("  %zu of %zu allocators fell back to regular blocks", fallbackCount, ASMJIT_ARRAY_SIZE(allocators));
+    EXPECT(fallbackCount != 0);
+
+    for (size_t i = 0; i < ASMJIT_ARRAY_SIZE(allocators); i++)
+      delete allocators[i];
+  }
+
+  INFO("JitAllocator(kUseProtectionKeys) - multiple threads");
+  {
+    // Threads that already exist would have no access to memory tagged by a new key, so protection keys must not be
+    // used when the process has more than one thread.
+    std::atomic<bool> done(false);
+    std::thread thread([&]() {
+      while (!done.load())
+        std::this_thread::yield();
+    });
+
+    JitAllocator::CreateParams params {};
+    params.options = JitAllocatorOptions::kUseProtectionKeys;
+
+    {
+      JitAllocator allocator(&params);
+      EXPECT(!allocator.hasOption(JitAllocatorOptions::kUseProtectionKeys));
+    }
+
+    done.store(true);
+    thread.join();
+  }
+
+  INFO("JitAllocator(allocNear)");
+  {
+    JitAllocator::CreateParams params {};
+    params.blockSize = 64 * 1024;
+
+    JitAllocator allocator(&params);
+    size_t allocSize = 2048;
+
+    void* rxPtrs[64];
+    void* rwPtr;
+
+    EXPECT(allocator.alloc(&rxPtrs[0], &rwPtr, allocSize) == kErrorOk);
+    size_t count = Support::min<size_t>(allocator.statistics().reservedSize() / allocSize, ASMJIT_ARRAY_SIZE(rxPtrs));
+    EXPECT(count >= 32);
+
+    for (size_t i = 1; i < count; i++)
+      EXPECT(allocator.alloc(&rxPtrs[i], &rwPtr, allocSize) == kErrorOk);
+
+    size_t a = 4;
+    size_t b = count - 4;
+    EXPECT(allocator.release(rxPtrs[a]) == kErrorOk);
+    EXPECT(allocator.release(rxPtrs[b]) == kErrorOk);
+
+    // The first unused area after the hint is preferred.
+    void* rxPtr;
+    EXPECT(allocator.allocNear(&rxPtr, &rwPtr, allocSize, rxPtrs[a + 1]) == kErrorOk);
+    EXPECT(rxPtr == rxPtrs[b], "Expected [%p], got [%p]\n", rxPtrs[b], rxPtr);
+
+    // The last unused area before the hint is used if there is no unused area after it.
+    EXPECT(allocator.allocNear(&rxPtrs[b], &rwPtr, allocSize, rxPtrs[count - 1]) == kErrorOk);
+    EXPECT(rxPtrs[b] == rxPtrs[a], "Expected [%p], got [%p]\n", rxPtrs[a], rxPtrs[b]);
+    rxPtrs[b] = rxPtr;
+
+    // A full block and an unknown address fall back to a regular allocation.
+    EXPECT(allocator.allocNear(&rxPtr, &rwPtr, allocSize, rxPtrs[0]) == kErrorOk);
+    EXPECT(allocator.statistics().blockCount() == 2);
+    EXPECT(allocator.release(rxPtr) == kErrorOk);
+
+    EXPECT(allocator.allocNear(&rxPtr, &rwPtr, allocSize, &allocator) == kErrorOk);
+    EXPECT(allocator.release(rxPtr) == kErrorOk);
+
+    for (size_t i = 0; i < count; i++)
+      EXPECT(allocator.release(rxPtrs[i]) == kErrorOk);
+  }
+
+  INFO("JitAllocator(arena)");
+  {
+    JitAllocator allocator;
+    JitAllocator::Arena* arenas[2];
+
+    EXPECT(allocator.newArena(&arenas[0]) == kErrorOk);
+    EXPECT(allocator.newArena(&arenas[1]) == kErrorOk);
+
+    // Allocations of various sizes including ones that are larger than a block, interleaved between two arenas.
+    uint8_t* rxPtrs[256];
+    size_t sizes[256];
+    Random prng(200);
+
+    for (size_t i = 0; i < ASMJIT_ARRAY_SIZE(rxPtrs); i++) {
+      void* rxPtr;
+      void* rwPtr;
+
+      sizes[i] = (i % 32) == 31 ? size_t(256 * 1024) : size_t(prng.nextUInt32() % 4096) + 1;
+      EXPECT(allocator.allocFromArena(arenas[i & 1], &rxPtr, &rwPtr, sizes[i]) == kErrorOk);
+
+      VirtMem::ProtectJitReadWriteScope scope(rxPtr, sizes[i]);
+      memset(rwPtr, int(i & 0xFF), sizes[i]);
+      rxPtrs[i] = static_cast<uint8_t*>(rxPtr);
+    }
+
+    // Verify that no allocation was overwritten by another one.
+    for (size_t i = 0; i < ASMJIT_ARRAY_SIZE(rxPtrs); i++) {
+      EXPECT(rxPtrs[i][0] == uint8_t(i & 0xFF) && rxPtrs[i][sizes[i] - 1] == uint8_t(i & 0xFF),
+             "Arena allocation [%p] was overwritten\n", rxPtrs[i]);
+    }
+
+    // Memory allocated from an arena cannot be released individually.
+    EXPECT(allocator.release(rxPtrs[0]) != kErrorOk);
+    EXPECT(allocator.statistics().allocationCount() == ASMJIT_ARRAY_SIZE(rxPtrs));
+
+    EXPECT(allocator.releaseArena(arenas[0]) == kErrorOk);
+    EXPECT(allocator.statistics().allocationCount() == ASMJIT_ARRAY_SIZE(rxPtrs) / 2);
+
+    // Resetting the allocator releases the memory of all arenas, but arenas can be still used.
+    allocator.reset();
+    EXPECT(allocator.statistics().allocationCount() == 0);
+    EXPECT(allocator.statistics().reservedSize() == 0);
+
+    void* rxPtr;
+    void* rwPtr;
+    EXPECT(allocator.allocFromArena(arenas[1], &rxPtr, &rwPtr, 64) == kErrorOk);
+    EXPECT(allocator.releaseArena(arenas[1]) == kErrorOk);
+    EXPECT(allocator.statistics().reservedSize() == 0);
+  }
+
+  INFO("JitAllocator(arena) - shrinkInArena");
+  {
+    JitAllocator allocator;
+    JitAllocator::Arena* arena;
+    EXPECT(allocator.newArena(&arena) == kErrorOk);
+
+    void* rxPtrs[3];
+    void* rwPtr;
+
+    EXPECT(allocator.allocFromArena(arena, &rxPtrs[0], &rwPtr, 256) == kErrorOk);
+    EXPECT(allocator.allocFromArena(arena, &rxPtrs[1], &rwPtr, 1024) == kErrorOk);
+    size_t usedSize = allocator.statistics().usedSize();
+
+    // The first chunk of an arena has the size of a block.
+    EXPECT(allocator.statistics().blockCount() == 1u);
+    EXPECT(allocator.statistics().reservedSize() == allocator.blockSize());
+
+    // The most recent allocation can be shrunk, the next allocation follows it.
+    EXPECT(allocator.shrinkInArena(arena, rxPtrs[1], 256) == kErrorOk);
+    EXPECT(allocator.statistics().usedSize() == usedSize - 768);
+    EXPECT(allocator.allocFromArena(arena, &rxPtrs[2], &rwPtr, 64) == kErrorOk);
+    EXPECT(static_cast<uint8_t*>(rxPtrs[2]) == static_cast<uint8_t*>(rxPtrs[1]) + 256);
+
+    // The most recent allocation can be returned to the arena.
+    EXPECT(allocator.shrinkInArena(arena, rxPtrs[2], 0) == kErrorOk);
+    EXPECT(allocator.statistics().allocationCount() == 2);
+
+    // Other allocations are kept as is.
+    usedSize = allocator.statistics().usedSize();
+    EXPECT(allocator.shrinkInArena(arena, rxPtrs[0], 0) == kErrorOk);
+    EXPECT(allocator.statistics().usedSize() == usedSize);
+    EXPECT(allocator.statistics().allocationCount() == 2);
+
+    EXPECT(allocator.releaseArena(arena) == kErrorOk);
+  }
+
+  INFO("JitAllocator(large areas)");
+  {
+    // Fragment a block by areas of a whole BitWord each, then verify that large allocations are placed into the first
+    // unused area that fits.
+    JitAllocator::CreateParams params {};
+    params.blockSize = 64 * 1024;
+
+    JitAllocator allocator(&params);
+    size_t wordSize = size_t(allocator.granularity()) * Support::kBitWordSizeInBits;
+
+    void* rxPtrs[64];
+    void* rwPtr;
+
+    EXPECT(allocator.alloc(&rxPtrs[0], &rwPtr, wordSize) == kErrorOk);
+    size_t count = Support::min<size_t>(allocator.statistics().reservedSize() / wordSize, ASMJIT_ARRAY_SIZE(rxPtrs));
+    EXPECT(count >= 24);
+
+    for (size_t i = 1; i < count; i++)
+      EXPECT(allocator.alloc(&rxPtrs[i], &rwPtr, wordSize) == kErrorOk);
+    EXPECT(allocator.statistics().blockCount() == 1);
+
+    uint8_t* base = static_cast<uint8_t*>(rxPtrs[0]);
+    static const uint32_t releaseList[] = { 3, 10, 11, 20, 21, 22 };
+
+    for (size_t i = 0; i < ASMJIT_ARRAY_SIZE(releaseList); i++)
+      EXPECT(allocator.release(rxPtrs[releaseList[i]]) == kErrorOk);
+
+    void* rxPtr;
+    EXPECT(allocator.alloc(&rxPtr, &rwPtr, wordSize * 3) == kErrorOk);
+    EXPECT(rxPtr == base + wordSize * 20, "Expected area at offset %zu, got %zu\n", wordSize * 20, size_t(static_cast<uint8_t*>(rxPtr) - base));
+    EXPECT(allocator.release(rxPtr) == kErrorOk);
+
+    EXPECT(allocator.alloc(&rxPtr, &rwPtr, wordSize * 2) == kErrorOk);
+    EXPECT(rxPtr == base + wordSize * 10, "Expected area at offset %zu, got %zu\n", wordSize * 10, size_t(static_cast<uint8_t*>(rxPtr) - base));
+    EXPECT(allocator.release(rxPtr) == kErrorOk);
+
+    // An area that doesn't fit anywhere in the block must be placed into a new block.
+    EXPECT(allocator.alloc(&rxPtr, &rwPtr, wordSize * 4) == kErrorOk);
+    EXPECT(allocator.statistics().blockCount() == 2);
+    EXPECT(allocator.release(rxPtr) == kErrorOk);
+
+    for (size_t i = 0; i < count; i++) {
+      bool released = false;
+      for (size_t j = 0; j < ASMJIT_ARRAY_SIZE(releaseList); j++)
+        released |= releaseList[j] == i;
+
+      if (!released)
+        EXPECT(allocator.release(rxPtrs[i]) == kErrorOk);
+    }
+  }
+
+  INFO("JitAllocator(kDecommitUnusedPages)");
+  {
+    JitAllocator::CreateParams params {};
+    params.options = JitAllocatorOptions::kDecommitUnusedPages | JitAllocatorOptions::kFillUnusedMemory;
+    params.blockSize = 64 * 1024;
+
+    JitAllocator allocator(&params);
+    size_t pageSize = VirtMem::info().pageSize;
+    size_t allocSize = 1024;
+
+    void* rxPtrs[1024];
+    void* rwPtrs[1024];
+
+    // Only pages used by the first allocation of a new block are committed.
+    EXPECT(allocator.alloc(&rxPtrs[0], &rwPtrs[0], allocSize) == kErrorOk);
+    size_t blockSize = allocator.statistics().reservedSize();
+    size_t count = Support::min<size_t>(blockSize / allocSize, ASMJIT_ARRAY_SIZE(rxPtrs));
+    EXPECT(allocator.statistics().decommittedSize() == blockSize - Support::alignUp(allocSize, pageSize));
+
+    uint32_t firstPattern;
+    memcpy(&firstPattern, rxPtrs[0], sizeof(firstPattern));
+    EXPECT(firstPattern == allocator.fillPattern(), "Committed memory at [%p] is not filled\n", rxPtrs[0]);
+
+    // Fill the whole first block.
+
+    for (size_t i = 1; i < count; i++)
+      EXPECT(allocator.alloc(&rxPtrs[i], &rwPtrs[i], allocSize) == kErrorOk);
+
+    EXPECT(allocator.statistics().blockCount() == 1);
+    EXPECT(allocator.statistics().decommittedSize() == 0);
+
+    // Keep only the first allocation, all other pages of the block must be decommitted.
+    for (size_t i = 1; i < count; i++)
+      EXPECT(allocator.release(rxPtrs[i]) == kErrorOk);
+    EXPECT(allocator.statistics().decommittedSize() == Support::alignDown(blockSize - allocSize, pageSize));
+
+    // Allocate again - the memory must be recommitted and filled by the fill pattern.
+    for (size_t i = 1; i < count; i++) {
+      EXPECT(allocator.alloc(&rxPtrs[i], &rwPtrs[i], allocSize) == kErrorOk);
+
+      uint32_t pattern;
+      memcpy(&pattern, rxPtrs[i], sizeof(pattern));
+      EXPECT(pattern == allocator.fillPattern(), "Recommitted memory at [%p] is not filled\n", rxPtrs[i]);
+
+      VirtMem::ProtectJitReadWriteScope scope(rxPtrs[i], allocSize);
+      memset(rwPtrs[i], 0, allocSize);
+    }
+    EXPECT(allocator.statistics().decommittedSize() == 0);
+
+    // The block is kept when it becomes empty, but all its pages must be decommitted.
+    for (size_t i = 0; i < count; i++)
+      EXPECT(allocator.release(rxPtrs[i]) == kErrorOk);
+
+    EXPECT(allocator.statistics().blockCount() == 1);
+    EXPECT(allocator.statistics().decommittedSize() == blockSize);
+  }
+
   for (uint32_t testId = 0; testId < ASMJIT_ARRAY_SIZE(testParams); testId++) {
     INFO("JitAllocator(%s)", testParams[testId].name);
 
@@ -1188,6 +2176,32 @@ UNIT(jit_allocator) {
       wrapper.release(ptrArray[kCount - i - 1]);
     JitAllocatorTest_usage(wrapper._allocator);
 
+    // Large blocks tests...
+    size_t kLargeCount = kCount / 10;
+
+    INFO("  Allocating random large blocks...");
+    for (i = 0; i < kLargeCount; i++)
+      ptrArray[i] = wrapper.alloc((prng.nextUInt32() % 65536) + 8);
+    JitAllocatorTest_usage(wrapper._allocator);
+
+    INFO("  Shuffling allocated blocks...");
+    JitAllocatorTest_shuffle(ptrArray, unsigned(kLargeCount), prng);
+
+    INFO("  Releasing 50%% of allocated blocks...");
+    for (i = 0; i < kLargeCount / 2; i++)
+      wrapper.release(ptrArray[i]);
+    JitAllocatorTest_usage(wrapper._allocator);
+
+    INFO("  Allocating 50%% more random large blocks again...");
+    for (i = 0; i < kLargeCount / 2; i++)
+      ptrArray[i] = wrapper.alloc((prng.nextUInt32() % 65536) + 8);
+    JitAllocatorTest_usage(wrapper._allocator);
+
+    INFO("  Releasing all allocated blocks...");
+    for (i = 0; i < kLargeCount; i++)
+      wrapper.release(ptrArray[i]);
+    JitAllocatorTest_usage(wrapper._allocator);
+
     // Fixed blocks tests...
     INFO("  Allocating %zuB blocks...", fixedBlockSize);
     for (i = 0; i < kCount / 2; i++)
@@ -10,6 +10,7 @@
 #ifndef ASMJIT_NO_JIT
 
 #include "../core/globals.h"
+#include "../core/memallocator.h"
 #include "../core/virtmem.h"
 
 ASMJIT_BEGIN_NAMESPACE
@@ -50,6 +51,46 @@ enum class JitAllocatorOptions : uint32_t {
   //! or have all blocks fully occupied.
   kImmediateRelease = 0x00000008u,
 
+  //! Allocates memory that is not executable (read+write only).
+  //!
+  //! Such allocator is intended for data that is used by JIT code, but must not share pages with it, for example
+  //! data sections placed separately by \ref JitRuntime (see \ref JitRuntimeOptions::kSeparateDataSections). Writing
+  //! to pages that contain code that is being executed is expensive on many CPUs as it triggers self-modifying code
+  //! detection. This option implies that \ref kUseDualMapping is ignored.
+  kNonExecutable = 0x00000010u,
+
+  //! Tags allocated blocks by a memory protection key (see \ref VirtMem::allocProtectionKey()) and enforces W^X per
+  //! thread without dual mapping.
+  //!
+  //! Blocks stay mapped as Read+Write+Execute, but writing to them is only possible within \ref
+  //! VirtMem::ProtectJitReadWriteScope (or between calls to \ref VirtMem::protectJitMemory()), which only changes the
+  //! access rights of the current thread without a syscall. This avoids `mprotect()` calls, which serialize on the
+  //! process-wide mmap lock and cause TLB shootdowns, when many threads generate code concurrently.
+  //!
+  //! Protection keys can only be used when the allocator is created while the process has a single thread, so all
+  //! threads that run the code inherit read access to it, see \ref VirtMem::allocProtectionKey(). Create the
+  //! allocator (or \ref JitRuntime) before starting other threads to use this option.
+  //!
+  //! Signal handlers don't inherit the access rights of the interrupted thread - the kernel enters them with access
+  //! to memory tagged by the key disabled and restores the rights of the thread when the handler returns. A signal
+  //! handler that runs JIT code, which reads data embedded in it, or writes to JIT memory must enable the access by
+  //! itself by calling \ref VirtMem::protectJitMemory(), which is async-signal-safe.
+  //!
+  //! If protection keys are not available (unsupported OS or hardware, the process already has multiple threads, or
+  //! all keys are already in use) the option is cleared at construction time and the allocator works as if it wasn't
+  //! specified. Use \ref hasOption() to check whether the option is active. This option is ignored when combined with
+  //! \ref kUseDualMapping or \ref kNonExecutable.
+  kUseProtectionKeys = 0x00000020u,
+
+  //! Decommits pages of allocated blocks that become entirely unused (see \ref VirtMem::decommit()).
+  //!
+  //! Without this option a block keeps all its pages resident until the whole block is released, which means that
+  //! long-lived blocks with sparse occupancy waste physical memory. When this option is set the allocator tracks
+  //! which pages are unused and returns them to the operating system, they are recommitted when an allocation needs
+  //! them again. This trades additional syscalls during `release()` and `shrink()` for memory usage that follows the
+  //! size of the live code. This option is ignored when combined with \ref kUseDualMapping.
+  kDecommitUnusedPages = 0x00000040u,
+
   //! Use a custom fill pattern, must be combined with `kFlagFillUnusedMemory`.
   kCustomFillPattern = 0x10000000u
 };
@@ -128,6 +169,26 @@ public:
     //! Only used if \ref JitAllocatorOptions::kCustomFillPattern is set.
     uint32_t fillPattern = 0;
 
+    //! Address to place allocated blocks near to (nullptr if blocks can be placed anywhere).
+    //!
+    //! When set, each block is placed within \ref nearDistance bytes of `nearAddress` (see \ref VirtMem::allocNear()).
+    //! Use an address of a function in the host executable to make calls from JIT code to host functions reachable
+    //! by a 32-bit displacement, which avoids address table entries on X86_64. If a block cannot be placed near the
+    //! address the allocator falls back to a regular allocation, which is always correct, but possibly slower.
+    const void* nearAddress = nullptr;
+
+    //! Maximum distance of any allocated byte from \ref nearAddress (default 1GB).
+    //!
+    //! Only used if \ref nearAddress is not null. The default leaves enough headroom to reach any function of an
+    //! executable that is smaller than 1GB by a 32-bit displacement when `nearAddress` points into it.
+    size_t nearDistance = 0;
+
+    //! Allocator of the metadata of the allocator - blocks, bit-arrays, and arenas (null to use \ref
+    //! MemAllocator::host()).
+    //!
+    //! Executable memory is always allocated by \ref VirtMem, this only applies to memory used to manage it.
+    MemAllocator* memAllocator = nullptr;
+
     // Reset the content of `CreateParams`.
     inline void reset() noexcept { memset(this, 0, sizeof(*this)); }
   };
@@ -141,6 +202,8 @@ public:
 
   //! Free all allocated memory - makes all pointers returned by `alloc()` invalid.
   //!
+  //! Memory of all arenas is released as well, however, arenas themselves stay valid and can be used again.
+  //!
   //! \remarks This function is not thread-safe as it's designed to be used when nobody else is using allocator.
   //! The reason is that there is no point of calling `reset()` when the allocator is still in use.
   ASMJIT_API void reset(ResetPolicy resetPolicy = ResetPolicy::kSoft) noexcept;
@@ -174,6 +237,15 @@ public:
   //! point to a Read+Execute region and `rwPtrOut` would point to a Read+Write region of the same memory-mapped block.
   ASMJIT_API Error alloc(void** rxPtrOut, void** rwPtrOut, size_t size) noexcept;
 
+  //! Allocates a new memory block of the requested `size` near `nearPtr`, which is a pointer previously returned by
+  //! `alloc()` or `allocNear()` (for example an entry of a function that calls or is called by the new one).
+  //!
+  //! The allocator places the memory into the same block as `nearPtr` - the first unused area after `nearPtr` is
+  //! preferred, then the closest unused area before it. This keeps functions that call each other within the same
+  //! pages, which saves i-TLB entries and keeps direct calls within reach. If the block doesn't have enough unused
+  //! space, or `nearPtr` is null or not managed by the allocator, this function works exactly as \ref alloc().
+  ASMJIT_API Error allocNear(void** rxPtrOut, void** rwPtrOut, size_t size, const void* nearPtr) noexcept;
+
   //! Releases a memory block returned by `alloc()`.
   //!
   //! \remarks This function is thread-safe.
@@ -195,6 +267,48 @@ public:
 
   //! \}
 
+  //! \name Arenas
+  //! \{
+
+  //! Arena that owns memory of allocations made by \ref allocFromArena() (opaque).
+  //!
+  //! Arenas are designed for code that is always released together, for example all functions of a module. Each
+  //! arena owns continuous chunks of virtual memory and allocations are bump-allocated from them. The whole arena is
+  //! released by a single \ref releaseArena() call, which doesn't touch bit-vectors of any block and doesn't leave
+  //! fragmentation behind. The first chunk has the size of a block (see \ref blockSize()) and each next chunk is
+  //! twice as large as the previous one, or large enough to hold an allocation that doesn't fit into such chunk.
+  class Arena;
+
+  //! Creates a new arena and stores it to `arenaOut`.
+  //!
+  //! \remarks This function is thread-safe.
+  ASMJIT_API Error newArena(Arena** arenaOut) noexcept;
+
+  //! Allocates a new memory block of the requested `size` from the given `arena`.
+  //!
+  //! Works the same way as \ref alloc(), however, the returned memory cannot be released individually - it's only
+  //! released by \ref releaseArena() or \ref reset(). Only the most recent allocation of an arena can be shrunk or
+  //! returned to the arena, see \ref shrinkInArena().
+  //!
+  //! \remarks This function is thread-safe.
+  ASMJIT_API Error allocFromArena(Arena* arena, void** rxPtrOut, void** rwPtrOut, size_t size) noexcept;
+
+  //! Shrinks the memory block pointed to by `rxPtr`, which was allocated from `arena`, to `newSize` bytes. If
+  //! `newSize` is zero the whole block is returned to the arena.
+  //!
+  //! Memory can only be returned to the arena if `rxPtr` is its most recent allocation, otherwise the block is kept
+  //! as is until the arena is released. This is not an error as the memory is still owned by the arena.
+  //!
+  //! \remarks This function is thread-safe.
+  ASMJIT_API Error shrinkInArena(Arena* arena, void* rxPtr, size_t newSize) noexcept;
+
+  //! Releases the `arena` and all memory allocated from it.
+  //!
+  //! \remarks This function is thread-safe.
+  ASMJIT_API Error releaseArena(Arena* arena) noexcept;
+
+  //! \}
+
   //! \name Statistics
   //! \{
 
@@ -210,12 +324,15 @@ public:
     size_t _reservedSize;
     //! Allocation overhead (in bytes) required to maintain all blocks.
     size_t _overheadSize;
+    //! How many bytes of reserved memory are decommitted (see \ref JitAllocatorOptions::kDecommitUnusedPages).
+    size_t _decommittedSize;
 
     inline void reset() noexcept {
       _blockCount = 0;
       _usedSize = 0;
       _reservedSize = 0;
       _overheadSize = 0;
+      _decommittedSize = 0;
     }
 
     //! Returns count of blocks managed by `JitAllocator` at the moment.
@@ -231,6 +348,8 @@ public:
     inline size_t reservedSize() const noexcept { return _reservedSize; }
     //! Returns the number of bytes the allocator needs to manage the allocated memory.
     inline size_t overheadSize() const noexcept { return _overheadSize; }
+    //! Returns the number of reserved bytes that are decommitted and don't consume physical memory.
+    inline size_t decommittedSize() const noexcept { return _decommittedSize; }
 
     inline double usedSizeAsPercent() const noexcept {
       return (double(usedSize()) / (double(reservedSize()) + 1e-16)) * 100.0;
@@ -0,0 +1,331 @@
+// This file is part of AsmJit project <https://asmjit.com>
+//
+// See asmjit.h or LICENSE.md for license and copyright information
+// SPDX-License-Identifier: Zlib
+
+#include "../core/api-build_p.h"
+#ifndef ASMJIT_NO_JIT
+
+#include "../core/jitmodule.h"
+#include "../core/virtmem.h"
+
+#include <atomic>
+
+ASMJIT_BEGIN_NAMESPACE
+
+// JitModule - Function
+// ====================
+
+//! Function of \ref JitModule, the name is stored right after the function.
+class JitModuleFunction : public ZoneHashNode {
+public:
+  ASMJIT_NONCOPYABLE(JitModuleFunction)
+
+  //! Stub (read+execute pointer), which is the entry of the function.
+  uint8_t* _stubRx;
+  //! Stub (read+write pointer).
+  uint8_t* _stubRw;
+  //! Current code of the function or null if the function was only declared.
+  void* _code;
+  //! Size of the function's name.
+  size_t _nameSize;
+
+  inline JitModuleFunction(uint32_t hashCode, uint8_t* stubRx, uint8_t* stubRw, size_t nameSize) noexcept
+    : ZoneHashNode(hashCode),
+      _stubRx(stubRx),
+      _stubRw(stubRw),
+      _code(nullptr),
+      _nameSize(nameSize) {}
+
+  inline char* name() noexcept { return reinterpret_cast<char*>(this + 1); }
+  inline const char* name() const noexcept { return reinterpret_cast<const char*>(this + 1); }
+};
+
+//! Only used to lookup a function from `JitModule::_functions`.
+class JitModuleFunctionByName {
+public:
+  inline JitModuleFunctionByName(const char* name, size_t nameSize) noexcept
+    : _name(name),
+      _nameSize(nameSize),
+      _hashCode(Support::hashString(name, nameSize)) {}
+
+  inline uint32_t hashCode() const noexcept { return _hashCode; }
+
+  inline bool matches(const JitModuleFunction* func) const noexcept {
+    return func->_nameSize == _nameSize && ::memcmp(func->name(), _name, _nameSize) == 0;
+  }
+
+  const char* _name;
+  size_t _nameSize;
+  uint32_t _hashCode;
+};
+
+static inline size_t JitModule_nameSize(const char* name, size_t nameSize) noexcept {
+  if (nameSize == SIZE_MAX)
+    nameSize = name ? strlen(name) : size_t(0);
+  return nameSize;
+}
+
+// JitModule - Stubs
+// =================
+
+static_assert(sizeof(std::atomic<uintptr_t>) == sizeof(uintptr_t), "The slot of a stub must be updatable atomically");
+
+// Updates the slot of the stub atomically, so threads that execute the stub see either the old or new target. The
+// release store makes the new code visible before the target. The runtime only targets the host, so the slot is
+// always pointer-sized.
+static void JitModule_setStubTarget(uint8_t* stubRx, uint8_t* stubRw, const void* target) noexcept {
+  VirtMem::ProtectJitReadWriteScope scope(stubRx, JitModule::kStubSize);
+  reinterpret_cast<std::atomic<uintptr_t>*>(stubRw + 8)->store(uintptr_t(target), std::memory_order_release);
+}
+
+static void JitModule_initStub(Arch arch, uint8_t* stubRx, uint8_t* stubRw, const void* target) noexcept {
+  {
+    VirtMem::ProtectJitReadWriteScope scope(stubRx, JitModule::kStubSize);
+
+    if (Environment::isFamilyX86(arch)) {
+      // jmp [rip + 2] (64-bit) or jmp [slot] (32-bit) followed by padding and the slot.
+      stubRw[0] = 0xFF;
+      stubRw[1] = 0x25;
+      Support::writeU32uLE(stubRw + 2, Environment::is64Bit(arch) ? 2u : uint32_t(uintptr_t(stubRx + 8)));
+      stubRw[6] = 0xCC;
+      stubRw[7] = 0xCC;
+    }
+    else {
+      // ldr x16, [pc + 8]; br x16 followed by the slot.
+      Support::writeU32uLE(stubRw + 0, 0x58000050u);
+      Support::writeU32uLE(stubRw + 4, 0xD61F0200u);
+    }
+  }
+
+  JitModule_setStubTarget(stubRx, stubRw, target);
+}
+
+static Error JitModule_newStub(JitModule* self, uint8_t** rxPtrOut, uint8_t** rwPtrOut) noexcept {
+  Arch arch = self->_runtime->environment().arch();
+  if (ASMJIT_UNLIKELY(!Environment::isFamilyX86(arch) && !Environment::isFamilyAArch64(arch)))
+    return DebugUtils::errored(kErrorInvalidArch);
+
+  if (self->_stubChunks.empty() || self->_stubChunkUsed == JitModule::kStubChunkCount) {
+    ASMJIT_PROPAGATE(self->_stubChunks.willGrow(&self->_allocator));
+
+    void* rx;
+    void* rw;
+    ASMJIT_PROPAGATE(self->_runtime->allocator()->alloc(&rx, &rw, JitModule::kStubChunkCount * JitModule::kStubSize));
+
+    self->_stubChunks.appendUnsafe(rx);
+    self->_stubChunkRw = static_cast<uint8_t*>(rw);
+    self->_stubChunkUsed = 0;
+  }
+
+  size_t offset = size_t(self->_stubChunkUsed++) * JitModule::kStubSize;
+  *rxPtrOut = static_cast<uint8_t*>(self->_stubChunks.last()) + offset;
+  *rwPtrOut = self->_stubChunkRw + offset;
+  return kErrorOk;
+}
+
+// Returns code that traps, which is targeted by stubs of functions that were only declared.
+static Error JitModule_ensureTrap(JitModule* self) noexcept {
+  if (self->_trap)
+    return kErrorOk;
+
+  uint8_t* rx;
+  uint8_t* rw;
+  ASMJIT_PROPAGATE(JitModule_newStub(self, &rx, &rw));
+
+  {
+    VirtMem::ProtectJitReadWriteScope scope(rx, JitModule::kStubSize);
+
+    if (Environment::isFamilyX86(self->_runtime->environment().arch())) {
+      // ud2 followed by int3 padding.
+      memset(rw, 0xCC, JitModule::kStubSize);
+      rw[0] = 0x0F;
+      rw[1] = 0x0B;
+    }
+    else {
+      // brk #0.
+      for (uint32_t i = 0; i < JitModule::kStubSize; i += 4)
+        Support::writeU32uLE(rw + i, 0xD4200000u);
+    }
+  }
+
+  self->_trap = rx;
+  return kErrorOk;
+}
+
+// Creates a new function, its stub, which jumps to `target`, and publishes the stub as a symbol of the runtime.
+static Error JitModule_newFunction(JitModule* self, const JitModuleFunctionByName& key, const void* target, JitModuleFunction** out) noexcept {
+  JitRuntime* rt = self->_runtime;
+
+  if (ASMJIT_UNLIKELY(rt->symbolAddress(key._name, key._nameSize)))
+    return DebugUtils::errored(kErrorLabelAlreadyDefined);
+
+  void* p = self->_allocator.alloc(sizeof(JitModuleFunction) + key._nameSize + 1);
+  if (ASMJIT_UNLIKELY(!p))
+    return DebugUtils::errored(kErrorOutOfMemory);
+
+  uint8_t* stubRx;
+  uint8_t* stubRw;
+
+  Error err = JitModule_newStub(self, &stubRx, &stubRw);
+  if (!err)
+    err = rt->_addSymbol(key._name, key._nameSize, stubRx);
+
+  if (ASMJIT_UNLIKELY(err)) {
+    self->_allocator.release(p, sizeof(JitModuleFunction) + key._nameSize + 1);
+    return err;
+  }
+
+  JitModuleFunction* func = new(p) JitModuleFunction(key.hashCode(), stubRx, stubRw, key._nameSize);
+  memcpy(func->name(), key._name, key._nameSize);
+  func->name()[key._nameSize] = '\0';
+
+  JitModule_initStub(rt->environment().arch(), stubRx, stubRw, target);
+  self->_functions.insert(&self->_allocator, func);
+
+  *out = func;
+  return kErrorOk;
+}
+
+// JitModule - Construction & Destruction
+// ======================================
+
+JitModule::JitModule(JitRuntime* runtime) noexcept
+  : _runtime(runtime),
+    _zone(4096 - Zone::kBlockOverhead),
+    _allocator(&_zone),
+    _stubChunkRw(nullptr),
+    _stubChunkUsed(0),
+    _trap(nullptr) {}
+
+JitModule::~JitModule() noexcept {
+  reset();
+}
+
+void JitModule::reset() noexcept {
+  JitRuntime* rt = _runtime;
+
+  for (uint32_t i = 0; i < _functions._bucketsCount; i++) {
+    for (ZoneHashNode* node = _functions._data[i]; node; node = node->_hashNext) {
+      JitModuleFunction* func = static_cast<JitModuleFunction*>(node);
+
+      rt->removeSymbol(func->name(), func->_nameSize);
+      if (func->_code)
+        rt->_release(func->_code);
+    }
+  }
+
+  for (void* chunk : _stubChunks)
+    rt->allocator()->release(chunk);
+
+  for (void* retired : _retired)
+    rt->_release(retired);
+
+  _functions.reset();
+  _retired.reset();
+  _stubChunks.reset();
+  _stubChunkRw = nullptr;
+  _stubChunkUsed = 0;
+  _trap = nullptr;
+
+  _allocator.reset(&_zone);
+  _zone.reset();
+}
+
+// JitModule - Accessors
+// =====================
+
+void* JitModule::functionEntry(const char* name, size_t nameSize) const noexcept {
+  nameSize = JitModule_nameSize(name, nameSize);
+  if (!nameSize)
+    return nullptr;
+
+  JitModuleFunction* func = _functions.get(JitModuleFunctionByName(name, nameSize));
+  return func ? func->_stubRx : nullptr;
+}
+
+void* JitModule::functionCode(const char* name, size_t nameSize) const noexcept {
+  nameSize = JitModule_nameSize(name, nameSize);
+  if (!nameSize)
+    return nullptr;
+
+  JitModuleFunction* func = _functions.get(JitModuleFunctionByName(name, nameSize));
+  return func ? func->_code : nullptr;
+}
+
+// JitModule - Functions
+// =====================
+
+Error JitModule::declareFunction(const char* name, size_t nameSize) noexcept {
+  nameSize = JitModule_nameSize(name, nameSize);
+  if (ASMJIT_UNLIKELY(!nameSize))
+    return DebugUtils::errored(kErrorInvalidArgument);
+
+  JitModuleFunctionByName key(name, nameSize);
+  if (_functions.get(key))
+    return kErrorOk;
+
+  ASMJIT_PROPAGATE(JitModule_ensureTrap(this));
+
+  JitModuleFunction* func;
+  return JitModule_newFunction(this, key, _trap, &func);
+}
+
+Error JitModule::_addFunction(void** dst, const char* name, size_t nameSize, CodeHolder* code, bool replace) noexcept {
+  if (dst)
+    *dst = nullptr;
+
+  nameSize = JitModule_nameSize(name, nameSize);
+  if (ASMJIT_UNLIKELY(!nameSize))
+    return DebugUtils::errored(kErrorInvalidArgument);
+
+  JitModuleFunctionByName key(name, nameSize);
+  JitModuleFunction* func = _functions.get(key);
+
+  if (replace) {
+    if (ASMJIT_UNLIKELY(!func))
+      return DebugUtils::errored(kErrorSymbolNotFound);
+  }
+  else {
+    if (ASMJIT_UNLIKELY(func && func->_code))
+      return DebugUtils::errored(kErrorLabelAlreadyDefined);
+  }
+
+  // Reserve space for the previous code first, so the function cannot fail after it's replaced.
+  if (func && func->_code)
+    ASMJIT_PROPAGATE(_retired.willGrow(&_allocator));
+
+  void* fn;
+  ASMJIT_PROPAGATE(_runtime->_add(&fn, code));
+
+  if (!func) {
+    Error err = JitModule_newFunction(this, key, fn, &func);
+    if (ASMJIT_UNLIKELY(err)) {
+      _runtime->_release(fn);
+      return err;
+    }
+  }
+  else {
+    // The previous code can still be executed by other threads, so it's only retired.
+    void* prev = func->_code;
+    JitModule_setStubTarget(func->_stubRx, func->_stubRw, fn);
+
+    if (prev)
+      _retired.appendUnsafe(prev);
+  }
+
+  func->_code = fn;
+  if (dst)
+    *dst = func->_stubRx;
+  return kErrorOk;
+}
+
+void JitModule::releaseRetired() noexcept {
+  for (void* retired : _retired)
+    _runtime->_release(retired);
+  _retired.clear();
+}
+
+ASMJIT_END_NAMESPACE
+
+#endif
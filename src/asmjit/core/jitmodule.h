@@ -0,0 +1,160 @@
+// This file is part of AsmJit project <https://asmjit.com>
+//
+// See asmjit.h or LICENSE.md for license and copyright information
+// SPDX-License-Identifier: Zlib
+
+#ifndef ASMJIT_CORE_JITMODULE_H_INCLUDED
+#define ASMJIT_CORE_JITMODULE_H_INCLUDED
+
+#include "../core/api-config.h"
+#ifndef ASMJIT_NO_JIT
+
+#include "../core/jitruntime.h"
+#include "../core/zone.h"
+#include "../core/zonehash.h"
+#include "../core/zonevector.h"
+
+ASMJIT_BEGIN_NAMESPACE
+
+class JitModuleFunction;
+
+//! \addtogroup asmjit_virtual_memory
+//! \{
+
+//! A set of named functions added to \ref JitRuntime, which can be recompiled and replaced individually.
+//!
+//! Each function of the module is entered through a stub, which is an indirect jump through a pointer-sized slot
+//! (`jmp [slot]` on X86 and `ldr x16, slot; br x16` on AArch64). The stub is published as a symbol of the function's
+//! name by \ref JitRuntime::addSymbol(), so functions call each other through external labels (see
+//! \ref BaseEmitter::newExternalLabel()) that resolve to stubs. A function can then be recompiled in its own
+//! \ref CodeHolder and swapped in by \ref replaceFunction(), which only updates the slot of its stub - callers are
+//! neither recompiled nor patched.
+//!
+//! Functions must be either added or declared by \ref declareFunction() before code that calls them is added. Calling
+//! a function that was declared, but not added yet, traps.
+//!
+//! The previous code of a replaced function is not released as other threads may still execute it, it's retired
+//! instead and released by \ref releaseRetired() once the user knows that no thread executes it anymore.
+//!
+//! \note JitModule is not thread-safe, however, functions of the module can be executed while other functions are
+//! being added or replaced.
+class JitModule {
+public:
+  ASMJIT_NONCOPYABLE(JitModule)
+
+  //! \name Constants
+  //! \{
+
+  enum : uint32_t {
+    //! Size of a function stub in bytes.
+    kStubSize = 16,
+    //! Number of stubs allocated at once.
+    kStubChunkCount = 64
+  };
+
+  //! \}
+
+  //! \name Members
+  //! \{
+
+  //! Runtime the functions are added to.
+  JitRuntime* _runtime;
+  //! Zone used to allocate functions.
+  Zone _zone;
+  //! Allocator used to allocate functions and containers.
+  ZoneAllocator _allocator;
+  //! Functions hashed by their names.
+  ZoneHash<JitModuleFunction> _functions;
+  //! Chunks of stubs allocated by the runtime's \ref JitAllocator.
+  ZoneVector<void*> _stubChunks;
+  //! Read+write pointer of the last chunk of stubs.
+  uint8_t* _stubChunkRw;
+  //! Number of stubs used in the last chunk.
+  uint32_t _stubChunkUsed;
+  //! Code that traps, targeted by stubs of declared functions.
+  void* _trap;
+  //! Previous code of replaced functions, which is released by \ref releaseRetired().
+  ZoneVector<void*> _retired;
+
+  //! \}
+
+  //! \name Construction & Destruction
+  //! \{
+
+  //! Creates a module that adds its functions to the given `runtime`.
+  ASMJIT_API explicit JitModule(JitRuntime* runtime) noexcept;
+  //! Destroys the module, see \ref reset().
+  ASMJIT_API ~JitModule() noexcept;
+
+  //! Removes all functions from the module, releases their code (including retired code) and stubs, and removes their
+  //! symbols from the runtime.
+  //!
+  //! \note No function of the module can be executed while the module is being reset.
+  ASMJIT_API void reset() noexcept;
+
+  //! \}
+
+  //! \name Accessors
+  //! \{
+
+  //! Returns the runtime the functions are added to.
+  inline JitRuntime* runtime() const noexcept { return _runtime; }
+
+  //! Returns the number of functions (including declared functions).
+  inline size_t functionCount() const noexcept { return _functions.size(); }
+
+  //! Returns an entry of the function of the given `name` (its stub) or null if the function doesn't exist.
+  ASMJIT_API void* functionEntry(const char* name, size_t nameSize = SIZE_MAX) const noexcept;
+
+  //! Returns the current code of the function of the given `name` or null if the function doesn't exist or it was
+  //! only declared.
+  ASMJIT_API void* functionCode(const char* name, size_t nameSize = SIZE_MAX) const noexcept;
+
+  //! Returns the number of retired functions, which were replaced, but not released yet.
+  inline size_t retiredCount() const noexcept { return _retired.size(); }
+
+  //! \}
+
+  //! \name Functions
+  //! \{
+
+  //! Declares a function of the given `name` so code that calls it can be added before the function itself.
+  //!
+  //! Declaring a function that already exists does nothing.
+  ASMJIT_API Error declareFunction(const char* name, size_t nameSize = SIZE_MAX) noexcept;
+
+  //! Adds a function of the given `name`, which code is stored in `code`, and stores its entry to `dst`.
+  //!
+  //! Returns \ref kErrorLabelAlreadyDefined if the function was already added (use \ref replaceFunction() instead).
+  template<typename Func>
+  inline Error addFunction(Func* dst, const char* name, CodeHolder* code) noexcept {
+    return _addFunction(Support::ptr_cast_impl<void**, Func*>(dst), name, SIZE_MAX, code, false);
+  }
+
+  //! Replaces the code of an existing function of the given `name` by code stored in `code`.
+  //!
+  //! The entry of the function doesn't change, so all callers (and function pointers obtained before) call the new
+  //! code. The previous code of the function is retired as it can still be executed by other threads, use
+  //! \ref releaseRetired() to release it. Returns \ref kErrorSymbolNotFound if the function doesn't exist.
+  inline Error replaceFunction(const char* name, CodeHolder* code) noexcept {
+    return _addFunction(nullptr, name, SIZE_MAX, code, true);
+  }
+
+  //! Type-unsafe version of `addFunction()` and `replaceFunction()`.
+  ASMJIT_API Error _addFunction(void** dst, const char* name, size_t nameSize, CodeHolder* code, bool replace) noexcept;
+
+  //! Releases the previous code of all functions replaced by \ref replaceFunction().
+  //!
+  //! It's up to the user to make sure that no thread executes the retired code, for example by calling this function
+  //! when all threads that executed functions of the module reached a safe point.
+  ASMJIT_API void releaseRetired() noexcept;
+
+  //! \}
+};
+
+//! \}
+
+ASMJIT_END_NAMESPACE
+
+#endif
+#endif
@@ -6,22 +6,943 @@
 #include "../core/api-build_p.h"
 #ifndef ASMJIT_NO_JIT
 
+#include "../core/codewriter_p.h"
 #include "../core/cpuinfo.h"
 #include "../core/jitruntime.h"
+#include "../core/osutils_p.h"
+#include "../core/telemetry_p.h"
+#include "../core/zone.h"
+#include "../core/zonehash.h"
+#include "../core/zonetree.h"
 
 ASMJIT_BEGIN_NAMESPACE
 
-JitRuntime::JitRuntime(const JitAllocator::CreateParams* params) noexcept
-  : _allocator(params) {
+// JitRuntime - Data Placement
+// ===========================
+
+//! Address both code and data allocators place their blocks near to, if the user didn't provide any. Any address
+//! would do as long as both allocators use the same one, so data stays within a reach of 32-bit displacements.
+static const uint8_t JitRuntime_placementAnchor = 0;
+
+//! Maps an address of a function returned by \ref JitRuntime::add() to its separately placed data.
+class JitRuntimeDataRecord : public ZoneTreeNodeT<JitRuntimeDataRecord> {
+public:
+  ASMJIT_NONCOPYABLE(JitRuntimeDataRecord)
+
+  uint8_t* _rxPtr;
+  void* _dataPtr;
+
+  inline JitRuntimeDataRecord(uint8_t* rxPtr, void* dataPtr) noexcept
+    : ZoneTreeNodeT(),
+      _rxPtr(rxPtr),
+      _dataPtr(dataPtr) {}
+
+  inline bool operator<(const JitRuntimeDataRecord& other) const noexcept { return _rxPtr < other._rxPtr; }
+  inline bool operator>(const JitRuntimeDataRecord& other) const noexcept { return _rxPtr > other._rxPtr; }
+
+  inline bool operator<(const uint8_t* key) const noexcept { return _rxPtr < key; }
+  inline bool operator>(const uint8_t* key) const noexcept { return _rxPtr > key; }
+};
+
+//! Companion allocator and bookkeeping used by \ref JitRuntimeOptions::kSeparateDataSections.
+class JitRuntimeDataPlacement {
+public:
+  ASMJIT_NONCOPYABLE(JitRuntimeDataPlacement)
+
+  //! Lock that protects `records`.
+  Lock lock;
+  //! Allocator of non-executable memory for data sections.
+  JitAllocator allocator;
+  //! Zone used to allocate records.
+  Zone zone;
+  //! Allocator used to allocate and reuse records.
+  ZoneAllocator heap;
+  //! Records of functions that have separately placed data.
+  ZoneTree<JitRuntimeDataRecord> records;
+
+  inline explicit JitRuntimeDataPlacement(const JitAllocator::CreateParams* params) noexcept
+    : allocator(params),
+      zone(4096 - Zone::kBlockOverhead),
+      heap(&zone) {
+    zone.setMemAllocator(params->memAllocator);
+  }
+
+  inline void reset(ResetPolicy resetPolicy) noexcept {
+    records.reset();
+    heap.reset(&zone);
+    zone.reset(resetPolicy);
+    allocator.reset(resetPolicy);
+  }
+
+  Error addRecord(uint8_t* rxPtr, void* dataPtr) noexcept {
+    LockGuard guard(lock);
+    JitRuntimeDataRecord* record = heap.newT<JitRuntimeDataRecord>(rxPtr, dataPtr);
+
+    if (ASMJIT_UNLIKELY(!record))
+      return DebugUtils::errored(kErrorOutOfMemory);
+
+    records.insert(record);
+    return kErrorOk;
+  }
+
+  void* removeRecord(void* rxPtr) noexcept {
+    LockGuard guard(lock);
+    JitRuntimeDataRecord* record = records.get(static_cast<uint8_t*>(rxPtr));
+
+    if (!record)
+      return nullptr;
+
+    void* dataPtr = record->_dataPtr;
+    records.remove(record);
+    heap.release(record, sizeof(JitRuntimeDataRecord));
+    return dataPtr;
+  }
+};
+
+// Tests whether the section is placed into data pages by `JitRuntimeOptions::kSeparateDataSections`. The address
+// table is always kept with the code as it's part of the code that uses it (it only contains addresses of targets
+// that were not reachable by `jmp/call rel32`).
+static inline bool JitRuntime_isDataSection(const CodeHolder* code, const Section* section) noexcept {
+  return !section->hasFlag(SectionFlags::kExecutable) && section != code->addressTableSection();
+}
+
+// Assigns offsets (starting at `baseOffset`) to all sections that are either code or data and returns the number
+// of bytes they occupy or `SIZE_MAX` on overflow. Sections keep their order and alignment within their placement.
+static size_t JitRuntime_layoutSections(CodeHolder* code, bool data, uint64_t baseOffset) noexcept {
+  Support::FastUInt8 of = 0;
+  uint64_t offset = 0;
+
+  for (Section* section : code->sectionsByOrder()) {
+    if (JitRuntime_isDataSection(code, section) != data)
+      continue;
+
+    uint64_t realSize = section->realSize();
+    if (realSize)
+      offset = Support::alignUp(offset, section->alignment());
+
+    section->setOffset(baseOffset + offset);
+    offset = Support::addOverflow(offset, realSize, &of);
+  }
+
+  if ((sizeof(uint64_t) > sizeof(size_t) && offset > SIZE_MAX) || of)
+    return SIZE_MAX;
+
+  return size_t(offset);
+}
+
+// Copies sections that are either code or data into `dst`, which corresponds to `baseOffset`.
+static void JitRuntime_copySections(CodeHolder* code, bool data, uint8_t* dst, uint64_t baseOffset) noexcept {
+  for (Section* section : code->sectionsByOrder()) {
+    if (JitRuntime_isDataSection(code, section) != data)
+      continue;
+
+    size_t offset = size_t(section->offset() - baseOffset);
+    size_t bufferSize = size_t(section->bufferSize());
+    size_t virtualSize = size_t(section->virtualSize());
+
+    code->copySectionData(dst + offset, bufferSize, section->id());
+    if (virtualSize > bufferSize)
+      memset(dst + offset + bufferSize, 0, virtualSize - bufferSize);
+  }
+}
+
+// JitRuntime - Symbols
+// ====================
+
+//! Address published by \ref JitRuntime::addSymbol(), the name is stored right after the symbol.
+class JitRuntimeSymbol : public ZoneHashNode {
+public:
+  ASMJIT_NONCOPYABLE(JitRuntimeSymbol)
+
+  const void* _address;
+  size_t _nameSize;
+
+  inline JitRuntimeSymbol(uint32_t hashCode, const void* address, size_t nameSize) noexcept
+    : ZoneHashNode(hashCode),
+      _address(address),
+      _nameSize(nameSize) {}
+
+  inline char* name() noexcept { return reinterpret_cast<char*>(this + 1); }
+  inline const char* name() const noexcept { return reinterpret_cast<const char*>(this + 1); }
+};
+
+//! Only used to lookup a symbol from `JitRuntimeSymbolTable::symbols`.
+class JitRuntimeSymbolByName {
+public:
+  inline JitRuntimeSymbolByName(const char* name, size_t nameSize) noexcept
+    : _name(name),
+      _nameSize(nameSize),
+      _hashCode(Support::hashString(name, nameSize)) {}
+
+  inline uint32_t hashCode() const noexcept { return _hashCode; }
+
+  inline bool matches(const JitRuntimeSymbol* symbol) const noexcept {
+    return symbol->_nameSize == _nameSize && ::memcmp(symbol->name(), _name, _nameSize) == 0;
+  }
+
+  const char* _name;
+  size_t _nameSize;
+  uint32_t _hashCode;
+};
+
+//! Symbol table used to resolve external labels, see \ref JitRuntime::addSymbol().
+class JitRuntimeSymbolTable {
+public:
+  ASMJIT_NONCOPYABLE(JitRuntimeSymbolTable)
+
+  //! Lock that protects `symbols`.
+  Lock lock;
+  //! Zone used to allocate symbols.
+  Zone zone;
+  //! Allocator used to allocate and reuse symbols.
+  ZoneAllocator heap;
+  //! Symbols hashed by their names.
+  ZoneHash<JitRuntimeSymbol> symbols;
+
+  inline explicit JitRuntimeSymbolTable(MemAllocator* memAllocator) noexcept
+    : zone(4096 - Zone::kBlockOverhead),
+      heap(&zone) {
+    zone.setMemAllocator(memAllocator);
+  }
+
+  inline void reset(ResetPolicy resetPolicy) noexcept {
+    LockGuard guard(lock);
+    symbols.reset();
+    heap.reset(&zone);
+    zone.reset(resetPolicy);
+  }
+
+  Error add(const char* name, size_t nameSize, const void* address) noexcept {
+    LockGuard guard(lock);
+    JitRuntimeSymbolByName key(name, nameSize);
+
+    if (ASMJIT_UNLIKELY(symbols.get(key)))
+      return DebugUtils::errored(kErrorLabelAlreadyDefined);
+
+    void* p = heap.alloc(sizeof(JitRuntimeSymbol) + nameSize + 1);
+    if (ASMJIT_UNLIKELY(!p))
+      return DebugUtils::errored(kErrorOutOfMemory);
+
+    JitRuntimeSymbol* symbol = new(p) JitRuntimeSymbol(key.hashCode(), address, nameSize);
+    memcpy(symbol->name(), name, nameSize);
+    symbol->name()[nameSize] = '\0';
+
+    symbols.insert(&heap, symbol);
+    return kErrorOk;
+  }
+
+  Error remove(const char* name, size_t nameSize) noexcept {
+    LockGuard guard(lock);
+    JitRuntimeSymbol* symbol = symbols.get(JitRuntimeSymbolByName(name, nameSize));
+
+    if (ASMJIT_UNLIKELY(!symbol))
+      return DebugUtils::errored(kErrorSymbolNotFound);
+
+    symbols.remove(&heap, symbol);
+    heap.release(symbol, sizeof(JitRuntimeSymbol) + nameSize + 1);
+    return kErrorOk;
+  }
+
+  const void* get(const char* name, size_t nameSize) noexcept {
+    LockGuard guard(lock);
+    JitRuntimeSymbol* symbol = symbols.get(JitRuntimeSymbolByName(name, nameSize));
+    return symbol ? symbol->_address : nullptr;
+  }
+};
+
+// JitRuntime - Stack Maps
+// =======================
+
+//! Stack map of a call site, `offset` is the offset of the return address relative to the start of the function.
+struct JitRuntimeStackMapSite {
+  uint32_t offset;
+  uint32_t entryIndex;
+  uint32_t entryCount;
+
+  inline bool operator<(const JitRuntimeStackMapSite& other) const noexcept { return offset < other.offset; }
+  inline bool operator>(const JitRuntimeStackMapSite& other) const noexcept { return offset > other.offset; }
+};
+
+//! Key used to find a stack map record by a return address.
+//!
+//! A return address is never at the start of a function, but it's at its end if the function ends with a call, so
+//! the record matches addresses in `(start, end]` range.
+struct JitRuntimeReturnAddress {
+  const uint8_t* address;
+};
+
+//! Stack maps of a function added to \ref JitRuntime, the record is keyed by the range of the function's code, sites
+//! sorted by their offsets and all entries are stored right after the record.
+class JitRuntimeStackMapRecord : public ZoneTreeNodeT<JitRuntimeStackMapRecord> {
+public:
+  ASMJIT_NONCOPYABLE(JitRuntimeStackMapRecord)
+
+  const uint8_t* _start;
+  const uint8_t* _end;
+  uint32_t _siteCount;
+  uint32_t _entryCount;
+  //! Arena the function was added to, or null if it was not added to an arena.
+  JitAllocator::Arena* _arena;
+  //! Next record of a function added to an arena, see \ref JitRuntimeStackMapTable::arenaRecords.
+  JitRuntimeStackMapRecord* _arenaNext;
+
+  inline JitRuntimeStackMapRecord(const uint8_t* start, const uint8_t* end, uint32_t siteCount, uint32_t entryCount, JitAllocator::Arena* arena) noexcept
+    : ZoneTreeNodeT(),
+      _start(start),
+      _end(end),
+      _siteCount(siteCount),
+      _entryCount(entryCount),
+      _arena(arena),
+      _arenaNext(nullptr) {}
+
+  static inline size_t sizeOf(uint32_t siteCount, uint32_t entryCount) noexcept {
+    return sizeof(JitRuntimeStackMapRecord) + siteCount * sizeof(JitRuntimeStackMapSite) + entryCount * sizeof(StackMapEntry);
+  }
+
+  inline size_t sizeOf() const noexcept { return sizeOf(_siteCount, _entryCount); }
+
+  inline JitRuntimeStackMapSite* sites() noexcept { return reinterpret_cast<JitRuntimeStackMapSite*>(this + 1); }
+  inline const JitRuntimeStackMapSite* sites() const noexcept { return reinterpret_cast<const JitRuntimeStackMapSite*>(this + 1); }
+
+  inline StackMapEntry* entries() noexcept { return reinterpret_cast<StackMapEntry*>(sites() + _siteCount); }
+  inline const StackMapEntry* entries() const noexcept { return reinterpret_cast<const StackMapEntry*>(sites() + _siteCount); }
+
+  inline bool operator<(const JitRuntimeStackMapRecord& other) const noexcept { return _start < other._start; }
+  inline bool operator>(const JitRuntimeStackMapRecord& other) const noexcept { return _start > other._start; }
+
+  // An address matches the record if it's within the range of the function's code.
+  inline bool operator<(const uint8_t* key) const noexcept { return _end <= key; }
+  inline bool operator>(const uint8_t* key) const noexcept { return _start > key; }
+
+  inline bool operator<(const JitRuntimeReturnAddress& key) const noexcept { return _end < key.address; }
+  inline bool operator>(const JitRuntimeReturnAddress& key) const noexcept { return _start >= key.address; }
+};
+
+//! Stack maps of all functions added to \ref JitRuntime, see \ref JitRuntime::findStackMap().
+class JitRuntimeStackMapTable {
+public:
+  ASMJIT_NONCOPYABLE(JitRuntimeStackMapTable)
+
+  //! Lock that protects `records`.
+  Lock lock;
+  //! Zone used to allocate records.
+  Zone zone;
+  //! Allocator used to allocate and reuse records.
+  ZoneAllocator heap;
+  //! Records of functions that have stack maps.
+  ZoneTree<JitRuntimeStackMapRecord> records;
+  //! Records of functions added to arenas, which are removed by \ref removeArena().
+  JitRuntimeStackMapRecord* arenaRecords = nullptr;
+
+  inline explicit JitRuntimeStackMapTable(MemAllocator* memAllocator) noexcept
+    : zone(4096 - Zone::kBlockOverhead),
+      heap(&zone) {
+    zone.setMemAllocator(memAllocator);
+  }
+
+  inline void reset(ResetPolicy resetPolicy) noexcept {
+    LockGuard guard(lock);
+    records.reset();
+    arenaRecords = nullptr;
+    heap.reset(&zone);
+    zone.reset(resetPolicy);
+  }
+
+  // Adds stack maps of `code`, which was relocated and copied to `[start, start + size)` allocated from `arena`.
+  Error add(const CodeHolder* code, const uint8_t* start, size_t size, JitAllocator::Arena* arena) noexcept {
+    const ZoneVector<StackMap>& stackMaps = code->stackMaps();
+    uint32_t siteCount = stackMaps.size();
+    uint32_t entryCount = code->stackMapEntries().size();
+
+    LockGuard guard(lock);
+    void* p = heap.alloc(JitRuntimeStackMapRecord::sizeOf(siteCount, entryCount));
+
+    if (ASMJIT_UNLIKELY(!p))
+      return DebugUtils::errored(kErrorOutOfMemory);
+
+    JitRuntimeStackMapRecord* record = new(p) JitRuntimeStackMapRecord(start, start + size, siteCount, entryCount, arena);
+    JitRuntimeStackMapSite* sites = record->sites();
+
+    // The code was relocated to its base address, which is not the start of the function if data sections were
+    // placed separately.
+    uint64_t startOffset = uint64_t(uintptr_t(start)) - code->baseAddress();
+    for (uint32_t i = 0; i < siteCount; i++) {
+      const StackMap& stackMap = stackMaps[i];
+      sites[i].offset = uint32_t(code->stackMapOffset(stackMap) - startOffset);
+      sites[i].entryIndex = stackMap.entryIndex();
+      sites[i].entryCount = stackMap.entryCount();
+    }
+
+    Support::qSort(sites, siteCount);
+    if (entryCount)
+      memcpy(record->entries(), code->stackMapEntries().data(), entryCount * sizeof(StackMapEntry));
+
+    if (arena) {
+      record->_arenaNext = arenaRecords;
+      arenaRecords = record;
+    }
+
+    records.insert(record);
+    return kErrorOk;
+  }
+
+  // Removes a record of a function that starts at `start`. Records of functions added to arenas are only removed
+  // together with their arena.
+  void remove(const void* start) noexcept {
+    LockGuard guard(lock);
+    JitRuntimeStackMapRecord* record = records.get(static_cast<const uint8_t*>(start));
+
+    if (!record || record->_arena)
+      return;
+
+    records.remove(record);
+    heap.release(record, record->sizeOf());
+  }
+
+  // Removes records of all functions added to `arena`.
+  void removeArena(JitAllocator::Arena* arena) noexcept {
+    LockGuard guard(lock);
+    JitRuntimeStackMapRecord** pPrev = &arenaRecords;
+
+    while (*pPrev) {
+      JitRuntimeStackMapRecord* record = *pPrev;
+      if (record->_arena != arena) {
+        pPrev = &record->_arenaNext;
+        continue;
+      }
+
+      *pPrev = record->_arenaNext;
+      records.remove(record);
+      heap.release(record, record->sizeOf());
+    }
+  }
+
+  bool find(const void* returnAddress, const StackMapEntry** entriesOut, uint32_t* countOut) noexcept {
+    LockGuard guard(lock);
+    const JitRuntimeStackMapRecord* record = records.get(JitRuntimeReturnAddress{static_cast<const uint8_t*>(returnAddress)});
+
+    if (!record)
+      return false;
+
+    uint32_t offset = uint32_t(static_cast<const uint8_t*>(returnAddress) - record->_start);
+    const JitRuntimeStackMapSite* sites = record->sites();
+
+    // Binary search, sites are sorted by their offsets.
+    uint32_t lo = 0;
+    uint32_t hi = record->_siteCount;
+
+    while (lo < hi) {
+      uint32_t mid = (lo + hi) / 2u;
+      if (sites[mid].offset < offset)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+    if (lo == record->_siteCount || sites[lo].offset != offset)
+      return false;
+
+    *entriesOut = record->entries() + sites[lo].entryIndex;
+    *countOut = sites[lo].entryCount;
+    return true;
+  }
+};
+
+// JitRuntime - Tables
+// ===================
+
+// Returns a table stored in `*tablePtr`, the table is created on its first use if `create` is true. Tables are
+// allocated by the same memory allocator as the metadata of the code allocator.
+template<typename Table>
+static Table* JitRuntime_table(JitRuntime* self, Table** tablePtr, bool create) noexcept {
+  LockGuard guard(self->_tablesLock);
+  Table* table = *tablePtr;
+
+  if (!table && create) {
+    void* p = self->_memAllocator->alloc(sizeof(Table), Globals::kAllocAlignment);
+    if (p) {
+      table = new(p) Table(self->_memAllocator);
+      *tablePtr = table;
+    }
+  }
+
+  return table;
+}
+
+static inline JitRuntimeSymbolTable* JitRuntime_symbolTable(JitRuntime* self, bool create) noexcept {
+  return JitRuntime_table(self, &self->_symbols, create);
+}
+
+static inline JitRuntimeStackMapTable* JitRuntime_stackMapTable(JitRuntime* self, bool create) noexcept {
+  return JitRuntime_table(self, &self->_stackMaps, create);
+}
+
+// Destroys a table created by `JitRuntime_table()`.
+template<typename Table>
+static void JitRuntime_destroyTable(JitRuntime* self, Table* table) noexcept {
+  if (table) {
+    table->~Table();
+    self->_memAllocator->release(table, sizeof(Table), Globals::kAllocAlignment);
+  }
+}
+
+// JitRuntime - Linking
+// ====================
+
+//! Size of a veneer, which is a stub that jumps to an absolute address. It's used by branches to external symbols
+//! that are not within their reach.
+static constexpr uint32_t kJitRuntimeVeneerSize = 16;
+
+//! External label referenced by the code and the address of the symbol it resolves to.
+struct JitRuntimeExternal {
+  LabelEntry* label;
+  uint64_t address;
+  uint32_t veneerSlot;
+};
+
+//! Relocation of an absolute reference to an external label and its original payload.
+struct JitRuntimeExternalReloc {
+  uint32_t relocId;
+  uint64_t payload;
+};
+
+//! External labels of a `CodeHolder` that is being added to `JitRuntime`.
+//!
+//! Absolute references to external labels are turned into absolute relocations while the code is being added, they
+//! are restored when the state is destroyed, so the `CodeHolder` is left intact regardless of whether the code was
+//! added or not. Veneers are not part of the `CodeHolder`, they are written right after the code.
+class JitRuntimeLinkState {
+public:
+  ASMJIT_NONCOPYABLE(JitRuntimeLinkState)
+
+  CodeHolder* code;
+  JitRuntimeExternal* externals;
+  uint32_t externalCount;
+  //! Number of relocations turned into absolute relocations, they are stored in `relocs`.
+  uint32_t relocCount;
+  uint32_t relocCapacity;
+  JitRuntimeExternalReloc* relocs;
+  //! Maximum number of veneers, zero if the target doesn't need them.
+  uint32_t veneerCapacity;
+  //! Number of veneers used by the code.
+  uint32_t veneerCount;
+  //! Offset of veneers relative to the base address of the code.
+  uint64_t veneerOffset;
+
+  inline explicit JitRuntimeLinkState(CodeHolder* code) noexcept
+    : code(code),
+      externals(nullptr),
+      externalCount(0),
+      relocCount(0),
+      relocCapacity(0),
+      relocs(nullptr),
+      veneerCapacity(0),
+      veneerCount(0),
+      veneerOffset(0) {}
+
+  inline ~JitRuntimeLinkState() noexcept {
+    for (uint32_t i = 0; i < relocCount; i++) {
+      RelocEntry* re = code->_relocations[relocs[i].relocId];
+      re->_relocType = RelocType::kRelToAbs;
+      re->_payload = relocs[i].payload;
+    }
+
+    if (relocs)
+      code->allocator()->release(relocs, relocCapacity * sizeof(JitRuntimeExternalReloc));
+    if (externals)
+      code->allocator()->release(externals, externalCount * sizeof(JitRuntimeExternal));
+  }
+
+  //! Places veneers after code of `codeSize` bytes starting at `codeOffset` and returns the size of the code including
+  //! all veneers that may be needed.
+  inline size_t layoutVeneers(uint64_t codeOffset, size_t codeSize) noexcept {
+    if (!veneerCapacity)
+      return codeSize;
+
+    size_t veneerStart = Support::alignUp<size_t>(codeSize, 8);
+    veneerOffset = codeOffset + veneerStart;
+    return veneerStart + size_t(veneerCapacity) * kJitRuntimeVeneerSize;
+  }
+
+  //! Returns the size of the code of `codeSize` bytes starting at `codeOffset` including veneers that were used.
+  inline size_t usedSize(uint64_t codeOffset, size_t codeSize) const noexcept {
+    if (!veneerCount)
+      return codeSize;
+    return size_t(veneerOffset - codeOffset) + size_t(veneerCount) * kJitRuntimeVeneerSize;
+  }
+};
+
+// Tests whether the instruction that uses `link`, whose value starts at `p`, is a relative branch that can be
+// redirected to a veneer.
+static bool JitRuntime_isBranchLink(Arch arch, const uint8_t* p, const LabelLink* link) noexcept {
+  if (Environment::isFamilyX86(arch)) {
+    // CALL|JMP rel32 or Jcc rel32.
+    if (link->format.valueSize() != 4 || link->rel != -4 || link->offset < 2)
+      return false;
+
+    return p[-1] == 0xE8 || p[-1] == 0xE9 || (p[-2] == 0x0F && (p[-1] & 0xF0) == 0x80);
+  }
+
+  if (Environment::isFamilyAArch64(arch)) {
+    // B|BL, B.cond, and CBZ|CBNZ|TBZ|TBNZ.
+    uint32_t insn = Support::readU32uLE(p);
+    return (insn & 0x7C000000u) == 0x14000000u ||
+           (insn & 0xFF000010u) == 0x54000000u ||
+           (insn & 0x7C000000u) == 0x34000000u;
+  }
+
+  return false;
+}
+
+// Writes a veneer that jumps to `address` into `dst`.
+static void JitRuntime_writeVeneer(Arch arch, uint8_t* dst, uint64_t address) noexcept {
+  if (Environment::isFamilyX86(arch)) {
+    // jmp qword ptr [rip] followed by the address and padding.
+    static const uint8_t jmpRip[6] = { 0xFF, 0x25, 0x00, 0x00, 0x00, 0x00 };
+    memcpy(dst, jmpRip, sizeof(jmpRip));
+    Support::writeU64uLE(dst + 6, address);
+    dst[14] = 0xCC;
+    dst[15] = 0xCC;
+  }
+  else {
+    // ldr x16, [pc + 8]; br x16 followed by the address.
+    Support::writeU32uLE(dst + 0, 0x58000050u);
+    Support::writeU32uLE(dst + 4, 0xD61F0200u);
+    Support::writeU64uLE(dst + 8, address);
+  }
+}
+
+// Writes all veneers used by the code to `dst`, which corresponds to the offset of veneers.
+static void JitRuntime_writeVeneers(Arch arch, const JitRuntimeLinkState* state, uint8_t* dst) noexcept {
+  for (uint32_t i = 0; i < state->externalCount; i++) {
+    const JitRuntimeExternal& external = state->externals[i];
+    if (external.veneerSlot != Globals::kInvalidId)
+      JitRuntime_writeVeneer(arch, dst + external.veneerSlot * kJitRuntimeVeneerSize, external.address);
+  }
+}
+
+// Resolves external labels referenced by `code` against the symbol table. Must be called before the code is laid
+// out as it converts absolute references into relocations, which are restored by the destructor of `state`. Relative
+// references are resolved by `JitRuntime_resolveExternals()` after the code has been relocated.
+static Error JitRuntime_prepareExternals(JitRuntime* self, CodeHolder* code, JitRuntimeLinkState* state) noexcept {
+  uint32_t externalCount = 0;
+  uint32_t relocCount = 0;
+
+  for (LabelEntry* le : code->labelEntries()) {
+    if (le->type() != LabelType::kExternal || !le->links())
+      continue;
+
+    externalCount++;
+    for (LabelLink* link = le->links(); link; link = link->next)
+      if (link->relocId != Globals::kInvalidId && code->_relocations[link->relocId]->relocType() == RelocType::kRelToAbs)
+        relocCount++;
+  }
+
+  if (!externalCount)
+    return kErrorOk;
+
+  JitRuntimeSymbolTable* symbols = JitRuntime_symbolTable(self, false);
+  if (!symbols)
+    return DebugUtils::errored(kErrorSymbolNotFound);
+
+  JitRuntimeExternal* externals = code->allocator()->allocT<JitRuntimeExternal>(externalCount * sizeof(JitRuntimeExternal));
+  if (ASMJIT_UNLIKELY(!externals))
+    return DebugUtils::errored(kErrorOutOfMemory);
+
+  state->externals = externals;
+  state->externalCount = externalCount;
+
+  if (relocCount) {
+    JitRuntimeExternalReloc* relocs = code->allocator()->allocT<JitRuntimeExternalReloc>(relocCount * sizeof(JitRuntimeExternalReloc));
+    if (ASMJIT_UNLIKELY(!relocs))
+      return DebugUtils::errored(kErrorOutOfMemory);
+
+    state->relocs = relocs;
+    state->relocCapacity = relocCount;
+  }
+
+  uint32_t i = 0;
+  for (LabelEntry* le : code->labelEntries()) {
+    if (le->type() != LabelType::kExternal || !le->links())
+      continue;
+
+    const void* address = symbols->get(le->name(), le->nameSize());
+    if (ASMJIT_UNLIKELY(!address))
+      return DebugUtils::errored(kErrorSymbolNotFound);
+
+    externals[i].label = le;
+    externals[i].address = uint64_t(uintptr_t(address));
+    externals[i].veneerSlot = Globals::kInvalidId;
+
+    // Absolute references (for example embedded label addresses) are turned into absolute relocations.
+    for (LabelLink* link = le->links(); link; link = link->next) {
+      if (link->relocId == Globals::kInvalidId)
+        continue;
+
+      RelocEntry* re = code->_relocations[link->relocId];
+      if (re->relocType() == RelocType::kRelToAbs) {
+        state->relocs[state->relocCount++] = JitRuntimeExternalReloc{link->relocId, re->_payload};
+        re->_relocType = RelocType::kAbsToAbs;
+        re->_payload += externals[i].address;
+      }
+    }
+
+    i++;
+  }
+
+  // Veneers are only needed when the address space is larger than the reach of a relative branch.
+  Arch arch = code->arch();
+  if (Environment::is64Bit(arch) && (Environment::isFamilyX86(arch) || Environment::isFamilyAArch64(arch)))
+    state->veneerCapacity = externalCount;
+
+  return kErrorOk;
+}
+
+// Patches relative references to external labels. Must be called after the code has been relocated and veneers were
+// placed by `JitRuntimeLinkState::layoutVeneers()`. Branches that cannot reach their target directly are redirected
+// to veneers, which are written by `JitRuntime_writeVeneers()` when the code is copied.
+static Error JitRuntime_resolveExternals(CodeHolder* code, JitRuntimeLinkState* state) noexcept {
+  state->veneerCount = 0;
+  if (!state->externalCount)
+    return kErrorOk;
+
+  Arch arch = code->arch();
+  uint64_t baseAddress = code->baseAddress();
+
+  for (uint32_t i = 0; i < state->externalCount; i++) {
+    JitRuntimeExternal& external = state->externals[i];
+    external.veneerSlot = Globals::kInvalidId;
+
+    for (LabelLink* link = external.label->links(); link; link = link->next) {
+      if (link->relocId != Globals::kInvalidId)
+        continue;
+
+      Section* section = code->sectionById(link->sectionId);
+      uint8_t* p = section->buffer().dataAt(link->offset);
+      uint64_t linkAddress = baseAddress + section->offset() + link->offset;
+
+      int64_t displacement = int64_t(external.address - linkAddress + uint64_t(int64_t(link->rel)));
+      if (Environment::is32Bit(arch))
+        displacement = int64_t(int32_t(uint32_t(displacement & 0xFFFFFFFFu)));
+
+      if (CodeWriterUtils::writeOffset(p, displacement, link->format))
+        continue;
+
+      if (!state->veneerCapacity || !JitRuntime_isBranchLink(arch, p, link))
+        return DebugUtils::errored(kErrorRelocOffsetOutOfRange);
+
+      if (external.veneerSlot == Globals::kInvalidId)
+        external.veneerSlot = state->veneerCount++;
+
+      uint64_t veneerAddress = baseAddress + state->veneerOffset + external.veneerSlot * kJitRuntimeVeneerSize;
+      displacement = int64_t(veneerAddress - linkAddress + uint64_t(int64_t(link->rel)));
+
+      if (!CodeWriterUtils::writeOffset(p, displacement, link->format))
+        return DebugUtils::errored(kErrorRelocOffsetOutOfRange);
+    }
+  }
+
+  return kErrorOk;
+}
+
+// JitRuntime - Construction & Destruction
+// =======================================
+
+// Returns parameters of the code allocator - `tmp` is a temporary that lives until the allocator is constructed.
+static const JitAllocator::CreateParams* JitRuntime_codeParams(JitAllocator::CreateParams&& tmp, const JitAllocator::CreateParams* params, JitRuntimeOptions options) noexcept {
+  if (params)
+    tmp = *params;
+
+  if (Support::test(options, JitRuntimeOptions::kSeparateDataSections) && !tmp.nearAddress)
+    tmp.nearAddress = &JitRuntime_placementAnchor;
+
+  return &tmp;
+}
+
+JitRuntime::JitRuntime(const JitAllocator::CreateParams* params, JitRuntimeOptions options) noexcept
+  : _allocator(JitRuntime_codeParams(JitAllocator::CreateParams{}, params, options)),
+    _options(options),
+    _dataPlacement(nullptr),
+    _memAllocator(params && params->memAllocator ? params->memAllocator : MemAllocator::host()),
+    _symbols(nullptr),
+    _stackMaps(nullptr),
+    _telemetrySink(nullptr) {
   _environment = Environment::host();
   _environment.setObjectFormat(ObjectFormat::kJIT);
+  _cpuInfo = CpuInfo::host();
+
+  if (Support::test(options, JitRuntimeOptions::kSeparateDataSections)) {
+    JitAllocator::CreateParams dataParams = *JitRuntime_codeParams(JitAllocator::CreateParams{}, params, options);
+    dataParams.options |= JitAllocatorOptions::kNonExecutable;
+
+    void* p = _memAllocator->alloc(sizeof(JitRuntimeDataPlacement), Globals::kAllocAlignment);
+    if (p)
+      _dataPlacement = new(p) JitRuntimeDataPlacement(&dataParams);
+  }
 }
 
-JitRuntime::~JitRuntime() noexcept {}
+JitRuntime::~JitRuntime() noexcept {
+  JitRuntime_destroyTable(this, _symbols);
+  JitRuntime_destroyTable(this, _stackMaps);
 
-Error JitRuntime::_add(void** dst, CodeHolder* code) noexcept {
-  *dst = nullptr;
+  if (_dataPlacement) {
+    MemAllocator* memAllocator = _dataPlacement->zone.memAllocator();
+    _dataPlacement->~JitRuntimeDataPlacement();
+    memAllocator->release(_dataPlacement, sizeof(JitRuntimeDataPlacement), Globals::kAllocAlignment);
+  }
+}
+
+void JitRuntime::reset(ResetPolicy resetPolicy) noexcept {
+  _allocator.reset(resetPolicy);
+  if (_dataPlacement)
+    _dataPlacement->reset(resetPolicy);
+  LockGuard guard(_tablesLock);
+  if (_symbols)
+    _symbols->reset(resetPolicy);
+  if (_stackMaps)
+    _stackMaps->reset(resetPolicy);
+}
+
+// JitRuntime - Add & Release
+// ==========================
+
+// Selects telemetry sinks used by `JitRuntime::add()` - stages of the runtime are reported to the sink of the runtime
+// and stages of the code to the sink of the code, each of them falls back to the other one if not set. The sink of
+// the code is temporarily replaced for that purpose.
+class JitRuntimeTelemetryGuard {
+public:
+  ASMJIT_NONCOPYABLE(JitRuntimeTelemetryGuard)
+
+  CodeHolder* _code;
+  TelemetrySink* _sink;
+  bool _restore;
+
+  inline JitRuntimeTelemetryGuard(const JitRuntime* runtime, CodeHolder* code) noexcept
+    : _code(code),
+      _sink(runtime->telemetrySink()),
+      _restore(false) {
+    if (!_sink) {
+      _sink = code->telemetrySink();
+    }
+    else if (!code->telemetrySink()) {
+      code->setTelemetrySink(_sink);
+      _restore = true;
+    }
+  }
+
+  inline ~JitRuntimeTelemetryGuard() noexcept {
+    if (_restore)
+      _code->resetTelemetrySink();
+  }
+
+  inline TelemetrySink* sink() const noexcept { return _sink; }
+};
+
+// Makes the code written to `rx` after `VirtMem::protectJitMemory(kReadWrite)` executable and flushes instruction
+// cache - the same as the destructor of `VirtMem::ProtectJitReadWriteScope`, but reported as a separate stage.
+static void JitRuntime_makeExecutable(TelemetrySink* sink, const CodeHolder* code, void* rx, size_t size) noexcept {
+  TelemetryScope telemetry(sink, TelemetryStage::kJitFlush, code);
+  telemetry.setByteCount(size);
+
+  VirtMem::protectJitMemory(VirtMem::ProtectJitAccess::kReadExecute);
+  VirtMem::flushInstructionCache(rx, size);
+}
+
+// Adds the code with data sections placed into separate pages. Returns `kErrorOk` with `*dst` set to null if the
+// code has no data sections or if the data could not be placed within a reach of the code, in which case the caller
+// falls back to a single allocation.
+static Error JitRuntime_addWithSeparateData(JitRuntime* self, void** dst, CodeHolder* code, JitRuntimeLinkState* linkState, const void* nearPtr, TelemetrySink* sink) noexcept {
+  JitRuntimeDataPlacement* placement = self->_dataPlacement;
+
+  size_t estimatedCodeSize = JitRuntime_layoutSections(code, false, 0);
+  size_t dataSize = JitRuntime_layoutSections(code, true, 0);
+
+  if (ASMJIT_UNLIKELY(estimatedCodeSize == SIZE_MAX || dataSize == SIZE_MAX))
+    return DebugUtils::errored(kErrorTooLarge);
+
+  if (dataSize == 0)
+    return kErrorOk;
+
+  if (ASMJIT_UNLIKELY(estimatedCodeSize == 0))
+    return DebugUtils::errored(kErrorNoCodeGenerated);
+
+  uint8_t* rx;
+  uint8_t* rw;
+  uint8_t* dataPtr;
+  void* dataRwPtr;
+
+  size_t allocSize = linkState->layoutVeneers(0, estimatedCodeSize);
+
+  {
+    TelemetryScope telemetry(sink, TelemetryStage::kJitAlloc, code);
+    telemetry.setByteCount(allocSize + dataSize);
+
+    ASMJIT_PROPAGATE(self->_allocator.allocNear((void**)&rx, (void**)&rw, allocSize, nearPtr));
+    Error err = placement->allocator.alloc((void**)&dataPtr, &dataRwPtr, dataSize);
+    if (ASMJIT_UNLIKELY(err)) {
+      self->_allocator.release(rx);
+      return err;
+    }
+  }
+
+  // Both placements must be within a reach of a 32-bit displacement, otherwise use a single allocation.
+  uint8_t* lo = Support::min(rx, dataPtr);
+  uint8_t* hi = Support::max(rx + allocSize, dataPtr + dataSize);
+
+  if (size_t(hi - lo) > size_t(std::numeric_limits<int32_t>::max())) {
+    placement->allocator.release(dataPtr);
+    self->_allocator.release(rx);
+    return kErrorOk;
+  }
+
+  uint64_t codeOffset = uint64_t(rx - lo);
+  uint64_t dataOffset = uint64_t(dataPtr - lo);
+
+  JitRuntime_layoutSections(code, false, codeOffset);
+  JitRuntime_layoutSections(code, true, dataOffset);
+  linkState->layoutVeneers(codeOffset, estimatedCodeSize);
 
+  Error err = code->resolveUnresolvedLinks();
+  if (!err)
+    err = code->relocateToBase(uintptr_t((void*)lo));
+
+  if (!err)
+    err = JitRuntime_resolveExternals(code, linkState);
+
+  if (!err)
+    err = placement->addRecord(rx, dataPtr);
+
+  if (ASMJIT_UNLIKELY(err)) {
+    placement->allocator.release(dataPtr);
+    self->_allocator.release(rx);
+    return err;
+  }
+
+  // Recalculate the final code size and shrink the memory we allocated for it
+  // in case that some relocations didn't require records in an address table.
+  size_t codeSize = linkState->usedSize(codeOffset, JitRuntime_layoutSections(code, false, codeOffset));
+  if (codeSize < allocSize)
+    self->_allocator.shrink(rx, codeSize);
+
+  {
+    TelemetryScope telemetry(sink, TelemetryStage::kJitCopy, code);
+    telemetry.setByteCount(codeSize + dataSize);
+
+    JitRuntime_copySections(code, true, dataPtr, dataOffset);
+    VirtMem::protectJitMemory(VirtMem::ProtectJitAccess::kReadWrite);
+    JitRuntime_copySections(code, false, rw, codeOffset);
+    JitRuntime_writeVeneers(code->arch(), linkState, rw + size_t(linkState->veneerOffset - codeOffset));
+  }
+  JitRuntime_makeExecutable(sink, code, rx, codeSize);
+
+  *dst = rx;
+  return kErrorOk;
+}
+
+// Adds the code as a single allocation that holds all sections. If `arena` is not null the memory is allocated from
+// it, in that case it cannot be released nor shrunk individually. Otherwise the memory is placed near `nearPtr`, if
+// given.
+static Error JitRuntime_addSingle(JitAllocator& allocator, void** dst, CodeHolder* code, JitRuntimeLinkState* linkState, JitAllocator::Arena* arena, const void* nearPtr, TelemetrySink* sink) noexcept {
   ASMJIT_PROPAGATE(code->flatten());
   ASMJIT_PROPAGATE(code->resolveUnresolvedLinks());
 
@@ -31,50 +952,217 @@ Error JitRuntime::_add(void** dst, CodeHolder* code) noexcept {
 
   uint8_t* rx;
   uint8_t* rw;
-  ASMJIT_PROPAGATE(_allocator.alloc((void**)&rx, (void**)&rw, estimatedCodeSize));
+
+  size_t allocSize = linkState->layoutVeneers(0, estimatedCodeSize);
+
+  {
+    TelemetryScope telemetry(sink, TelemetryStage::kJitAlloc, code);
+    telemetry.setByteCount(allocSize);
+
+    if (arena)
+      ASMJIT_PROPAGATE(allocator.allocFromArena(arena, (void**)&rx, (void**)&rw, allocSize));
+    else
+      ASMJIT_PROPAGATE(allocator.allocNear((void**)&rx, (void**)&rw, allocSize, nearPtr));
+  }
 
   // Relocate the code.
   Error err = code->relocateToBase(uintptr_t((void*)rx));
+  if (!err)
+    err = JitRuntime_resolveExternals(code, linkState);
   if (ASMJIT_UNLIKELY(err)) {
-    _allocator.release(rx);
+    // Memory allocated from an arena can only be returned if no other allocation was made from it in the meantime,
+    // otherwise it's kept until the arena is released.
+    if (arena)
+      allocator.shrinkInArena(arena, rx, 0);
+    else
+      allocator.release(rx);
     return err;
   }
 
   // Recalculate the final code size and shrink the memory we allocated for it
   // in case that some relocations didn't require records in an address table.
-  size_t codeSize = code->codeSize();
-  if (codeSize < estimatedCodeSize)
-    _allocator.shrink(rx, codeSize);
-
-  if (codeSize < estimatedCodeSize)
-    _allocator.shrink(rx, codeSize);
+  size_t codeSize = linkState->usedSize(0, code->codeSize());
+  if (codeSize < allocSize) {
+    if (arena)
+      allocator.shrinkInArena(arena, rx, codeSize);
+    else
+      allocator.shrink(rx, codeSize);
+  }
 
   {
-    VirtMem::ProtectJitReadWriteScope rwScope(rx, codeSize);
+    TelemetryScope telemetry(sink, TelemetryStage::kJitCopy, code);
+    telemetry.setByteCount(codeSize);
 
+    VirtMem::protectJitMemory(VirtMem::ProtectJitAccess::kReadWrite);
     for (Section* section : code->_sections) {
       size_t offset = size_t(section->offset());
       size_t bufferSize = size_t(section->bufferSize());
       size_t virtualSize = size_t(section->virtualSize());
 
       ASMJIT_ASSERT(offset + bufferSize <= codeSize);
-      memcpy(rw + offset, section->data(), bufferSize);
+      code->copySectionData(rw + offset, bufferSize, section->id());
 
       if (virtualSize > bufferSize) {
         ASMJIT_ASSERT(offset + virtualSize <= codeSize);
         memset(rw + offset + bufferSize, 0, virtualSize - bufferSize);
       }
     }
+    JitRuntime_writeVeneers(code->arch(), linkState, rw + size_t(linkState->veneerOffset));
   }
+  JitRuntime_makeExecutable(sink, code, rx, codeSize);
 
   *dst = rx;
   return kErrorOk;
 }
 
+Error JitRuntime::_add(void** dst, CodeHolder* code) noexcept {
+  return _addNear(dst, code, nullptr);
+}
+
+// Retains stack maps of `code` added to `*dst`, the function is released (or returned to `arena`) on failure.
+static Error JitRuntime_addStackMaps(JitRuntime* self, void** dst, CodeHolder* code, size_t codeSize, JitAllocator::Arena* arena = nullptr) noexcept {
+  if (!code->hasStackMaps())
+    return kErrorOk;
+
+  JitRuntimeStackMapTable* stackMaps = JitRuntime_stackMapTable(self, true);
+  Error err = stackMaps ? stackMaps->add(code, static_cast<const uint8_t*>(*dst), codeSize, arena)
+                        : DebugUtils::errored(kErrorOutOfMemory);
+
+  if (ASMJIT_UNLIKELY(err)) {
+    if (arena)
+      self->_allocator.shrinkInArena(arena, *dst, 0);
+    else
+      self->_release(*dst);
+    *dst = nullptr;
+  }
+
+  return err;
+}
+
+Error JitRuntime::_addNear(void** dst, CodeHolder* code, const void* nearPtr) noexcept {
+  *dst = nullptr;
+
+  JitRuntimeTelemetryGuard telemetryGuard(this, code);
+  TelemetryScope telemetry(telemetryGuard.sink(), TelemetryStage::kJitAdd, code);
+
+  JitRuntimeLinkState linkState(code);
+  ASMJIT_PROPAGATE(JitRuntime_prepareExternals(this, code, &linkState));
+
+  if (_dataPlacement) {
+    ASMJIT_PROPAGATE(JitRuntime_addWithSeparateData(this, dst, code, &linkState, nearPtr, telemetryGuard.sink()));
+    if (*dst) {
+      size_t codeSize = JitRuntime_layoutSections(code, false, uint64_t(uintptr_t(*dst)) - code->baseAddress());
+      telemetry.setByteCount(codeSize);
+      return JitRuntime_addStackMaps(this, dst, code, codeSize);
+    }
+  }
+
+  ASMJIT_PROPAGATE(JitRuntime_addSingle(_allocator, dst, code, &linkState, nullptr, nearPtr, telemetryGuard.sink()));
+
+  size_t codeSize = code->codeSize();
+  telemetry.setByteCount(codeSize);
+  return JitRuntime_addStackMaps(this, dst, code, codeSize);
+}
+
+Error JitRuntime::_addToArena(void** dst, CodeHolder* code, JitAllocator::Arena* arena) noexcept {
+  *dst = nullptr;
+
+  if (ASMJIT_UNLIKELY(!arena))
+    return DebugUtils::errored(kErrorInvalidArgument);
+
+  JitRuntimeTelemetryGuard telemetryGuard(this, code);
+  TelemetryScope telemetry(telemetryGuard.sink(), TelemetryStage::kJitAdd, code);
+
+  JitRuntimeLinkState linkState(code);
+  ASMJIT_PROPAGATE(JitRuntime_prepareExternals(this, code, &linkState));
+  ASMJIT_PROPAGATE(JitRuntime_addSingle(_allocator, dst, code, &linkState, arena, nullptr, telemetryGuard.sink()));
+
+  size_t codeSize = code->codeSize();
+  telemetry.setByteCount(codeSize);
+  return JitRuntime_addStackMaps(this, dst, code, codeSize, arena);
+}
+
 Error JitRuntime::_release(void* p) noexcept {
+  JitRuntimeStackMapTable* stackMaps = JitRuntime_stackMapTable(this, false);
+  if (stackMaps)
+    stackMaps->remove(p);
+
+  if (_dataPlacement) {
+    void* dataPtr = _dataPlacement->removeRecord(p);
+    if (dataPtr)
+      _dataPlacement->allocator.release(dataPtr);
+  }
+
   return _allocator.release(p);
 }
 
+// JitRuntime - Arenas
+// ===================
+
+Error JitRuntime::releaseArena(JitAllocator::Arena* arena) noexcept {
+  JitRuntimeStackMapTable* stackMaps = JitRuntime_stackMapTable(this, false);
+  if (stackMaps && arena)
+    stackMaps->removeArena(arena);
+
+  return _allocator.releaseArena(arena);
+}
+
+// JitRuntime - Symbols
+// ====================
+
+Error JitRuntime::_addSymbol(const char* name, size_t nameSize, const void* address) noexcept {
+  if (nameSize == SIZE_MAX)
+    nameSize = name ? strlen(name) : size_t(0);
+
+  if (ASMJIT_UNLIKELY(!nameSize || !address))
+    return DebugUtils::errored(kErrorInvalidArgument);
+
+  JitRuntimeSymbolTable* symbols = JitRuntime_symbolTable(this, true);
+  if (ASMJIT_UNLIKELY(!symbols))
+    return DebugUtils::errored(kErrorOutOfMemory);
+
+  return symbols->add(name, nameSize, address);
+}
+
+Error JitRuntime::removeSymbol(const char* name, size_t nameSize) noexcept {
+  if (nameSize == SIZE_MAX)
+    nameSize = name ? strlen(name) : size_t(0);
+
+  if (ASMJIT_UNLIKELY(!nameSize))
+    return DebugUtils::errored(kErrorInvalidArgument);
+
+  JitRuntimeSymbolTable* symbols = JitRuntime_symbolTable(this, false);
+  if (ASMJIT_UNLIKELY(!symbols))
+    return DebugUtils::errored(kErrorSymbolNotFound);
+
+  return symbols->remove(name, nameSize);
+}
+
+const void* JitRuntime::symbolAddress(const char* name, size_t nameSize) const noexcept {
+  if (nameSize == SIZE_MAX)
+    nameSize = name ? strlen(name) : size_t(0);
+
+  if (!nameSize)
+    return nullptr;
+
+  JitRuntimeSymbolTable* symbols = JitRuntime_symbolTable(const_cast<JitRuntime*>(this), false);
+  return symbols ? symbols->get(name, nameSize) : nullptr;
+}
+
+// JitRuntime - Stack Maps
+// =======================
+
+bool JitRuntime::findStackMap(const void* returnAddress, const StackMapEntry** entriesOut, uint32_t* countOut) const noexcept {
+  *entriesOut = nullptr;
+  *countOut = 0;
+
+  JitRuntimeStackMapTable* stackMaps = JitRuntime_stackMapTable(const_cast<JitRuntime*>(this), false);
+  if (!stackMaps)
+    return false;
+
+  return stackMaps->find(returnAddress, entriesOut, countOut);
+}
+
 ASMJIT_END_NAMESPACE
 
 #endif
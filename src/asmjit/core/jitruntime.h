@@ -11,15 +11,41 @@
 
 #include "../core/codeholder.h"
 #include "../core/jitallocator.h"
+#include "../core/osutils.h"
 #include "../core/target.h"
 
 ASMJIT_BEGIN_NAMESPACE
 
 class CodeHolder;
+class JitRuntimeDataPlacement;
+class JitRuntimeStackMapTable;
+class JitRuntimeSymbolTable;
 
 //! \addtogroup asmjit_virtual_memory
 //! \{
 
+//! Options used by \ref JitRuntime.
+enum class JitRuntimeOptions : uint32_t {
+  //! No options.
+  kNone = 0,
+
+  //! Places sections that are not executable (sections without \ref SectionFlags::kExecutable, except the address
+  //! table) into separate read+write pages, which are allocated by a companion \ref JitAllocator that uses
+  //! \ref JitAllocatorOptions::kNonExecutable.
+  //!
+  //! Data and code would never share a page, so JIT code can write to its data (counters, inline caches, mutable
+  //! tables) without triggering self-modifying code detection, and constant data doesn't pollute i-cache and i-TLB.
+  //! Both allocators place their blocks near the same address so data stays within a reach of 32-bit displacements
+  //! from code. If such placement is not possible \ref JitRuntime::add() falls back to a single allocation.
+  //!
+  //! \note Only sections are separated, data embedded into an executable section stays within the code. Use
+  //! \ref BaseEmitter::section() to emit data (including constant pools embedded by \ref
+  //! BaseEmitter::embedConstPool()) into a data section, and \ref BaseCompiler::setConstPoolSection() to make
+  //! \ref BaseCompiler place its constant pools into a data section.
+  kSeparateDataSections = 0x00000001u
+};
+ASMJIT_DEFINE_ENUM_FLAGS(JitRuntimeOptions)
+
 //! JIT execution runtime is a special `Target` that is designed to store and
 //! execute the generated code.
 class ASMJIT_VIRTAPI JitRuntime : public Target {
@@ -28,18 +54,31 @@ public:
 
   //! Virtual memory allocator.
   JitAllocator _allocator;
+  //! Runtime options.
+  JitRuntimeOptions _options;
+  //! Placement of data sections (only used by \ref JitRuntimeOptions::kSeparateDataSections).
+  JitRuntimeDataPlacement* _dataPlacement;
+  //! Memory allocator used to allocate tables, the same as used by the code allocator.
+  MemAllocator* _memAllocator;
+  //! Lock that protects creation of tables, which are only created when used.
+  Lock _tablesLock;
+  //! Symbols used to resolve external labels, see \ref addSymbol().
+  JitRuntimeSymbolTable* _symbols;
+  //! Stack maps of functions added to the runtime, see \ref findStackMap().
+  JitRuntimeStackMapTable* _stackMaps;
+  //! Attached telemetry sink, see \ref setTelemetrySink().
+  TelemetrySink* _telemetrySink;
 
   //! \name Construction & Destruction
   //! \{
 
   //! Creates a `JitRuntime` instance.
-  ASMJIT_API explicit JitRuntime(const JitAllocator::CreateParams* params = nullptr) noexcept;
+  ASMJIT_API explicit JitRuntime(const JitAllocator::CreateParams* params = nullptr, JitRuntimeOptions options = JitRuntimeOptions::kNone) noexcept;
   //! Destroys the `JitRuntime` instance.
   ASMJIT_API virtual ~JitRuntime() noexcept;
 
-  inline void reset(ResetPolicy resetPolicy = ResetPolicy::kSoft) noexcept {
-    _allocator.reset(resetPolicy);
-  }
+  //! Releases all functions added to the runtime and removes all symbols and stack maps.
+  ASMJIT_API void reset(ResetPolicy resetPolicy = ResetPolicy::kSoft) noexcept;
 
   //! \}
 
@@ -49,6 +88,29 @@ public:
   //! Returns the associated `JitAllocator`.
   inline JitAllocator* allocator() const noexcept { return const_cast<JitAllocator*>(&_allocator); }
 
+  //! Returns runtime options.
+  inline JitRuntimeOptions options() const noexcept { return _options; }
+  //! Tests whether the runtime has the given `option` set.
+  inline bool hasOption(JitRuntimeOptions option) const noexcept { return Support::test(_options, option); }
+
+  //! \}
+
+  //! \name Telemetry
+  //! \{
+
+  //! Returns the attached telemetry sink, see \ref TelemetrySink.
+  inline TelemetrySink* telemetrySink() const noexcept { return _telemetrySink; }
+
+  //! Attaches a telemetry sink to the runtime, which receives events of \ref TelemetryStage::kJitAdd,
+  //! \ref TelemetryStage::kJitAlloc, \ref TelemetryStage::kJitCopy, and \ref TelemetryStage::kJitFlush, and events
+  //! of \ref CodeHolder stages run by \ref add() if the `CodeHolder` has no sink. If the runtime has no sink its
+  //! events are reported to the sink of the `CodeHolder` being added.
+  //!
+  //! \note The sink must be thread-safe if the runtime is used by multiple threads.
+  inline void setTelemetrySink(TelemetrySink* sink) noexcept { _telemetrySink = sink; }
+  //! Resets the telemetry sink to none.
+  inline void resetTelemetrySink() noexcept { setTelemetrySink(nullptr); }
+
   //! \}
 
   //! \name Utilities
@@ -66,6 +128,32 @@ public:
     return _add(Support::ptr_cast_impl<void**, Func*>(dst), code);
   }
 
+  //! Allocates memory needed for a code stored in the `CodeHolder` from the given `arena` and relocates the code to
+  //! the pointer allocated.
+  //!
+  //! The function cannot be released by \ref release(), it's released together with all other functions added to
+  //! the same arena by \ref releaseArena(). All sections are always placed into a single allocation, even when
+  //! \ref JitRuntimeOptions::kSeparateDataSections is used.
+  //!
+  //! If `add()` fails after the memory was allocated, the memory is returned to the arena, unless another thread
+  //! allocated from the same arena in the meantime, in which case it's kept until \ref releaseArena() (see
+  //! \ref JitAllocator::shrinkInArena()).
+  template<typename Func>
+  inline Error add(Func* dst, CodeHolder* code, JitAllocator::Arena* arena) noexcept {
+    return _addToArena(Support::ptr_cast_impl<void**, Func*>(dst), code, arena);
+  }
+
+  //! Allocates memory needed for a code stored in the `CodeHolder` near `nearFunc`, which is a function previously
+  //! added to this runtime, and relocates the code to the pointer allocated.
+  //!
+  //! Use it to co-locate functions that call each other (for example a caller and its hot callees), which keeps them
+  //! within the same pages, see \ref JitAllocator::allocNear(). The placement is only a hint, if the function cannot
+  //! be placed near `nearFunc` it's added the same way as by \ref add().
+  template<typename Func, typename NearFunc>
+  inline Error addNear(Func* dst, CodeHolder* code, NearFunc nearFunc) noexcept {
+    return _addNear(Support::ptr_cast_impl<void**, Func*>(dst), code, Support::ptr_cast_impl<const void*, NearFunc>(nearFunc));
+  }
+
   //! Releases `p` which was obtained by calling `add()`.
   template<typename Func>
   inline Error release(Func p) noexcept {
@@ -78,6 +166,67 @@ public:
   //! Type-unsafe version of `release()`.
   ASMJIT_API virtual Error _release(void* p) noexcept;
 
+  //! Type-unsafe version of `addNear()`.
+  ASMJIT_API Error _addNear(void** dst, CodeHolder* code, const void* nearPtr) noexcept;
+
+  //! Type-unsafe version of `add()` that adds the code to an arena.
+  ASMJIT_API Error _addToArena(void** dst, CodeHolder* code, JitAllocator::Arena* arena) noexcept;
+
+  //! \}
+
+  //! \name Arenas
+  //! \{
+
+  //! Creates a new arena that can be passed to \ref add(), see \ref JitAllocator::Arena.
+  inline Error newArena(JitAllocator::Arena** arenaOut) noexcept { return _allocator.newArena(arenaOut); }
+
+  //! Releases the `arena` and all functions that were added to it, including their stack maps.
+  ASMJIT_API Error releaseArena(JitAllocator::Arena* arena) noexcept;
+
+  //! \}
+
+  //! \name Symbols
+  //! \{
+
+  //! Publishes `func` under the given `name` so code added later can reference it through an external label of the
+  //! same name, see \ref BaseEmitter::newExternalLabel().
+  //!
+  //! When the code is added, branches to external labels are resolved to direct relative branches (`call/jmp rel32`
+  //! on X86 and `b/bl` on AArch64) if the symbol is within their reach, otherwise they branch through a veneer, which
+  //! is appended to the code and jumps to the absolute address of the symbol. Other references to external labels
+  //! are resolved directly. Adding code that references a symbol that is not defined fails with
+  //! \ref kErrorSymbolNotFound.
+  //!
+  //! Returns \ref kErrorLabelAlreadyDefined if the symbol is already defined. Symbols are not removed when a function
+  //! is released, use \ref removeSymbol() to remove them, \ref reset() removes all symbols.
+  template<typename Func>
+  inline Error addSymbol(const char* name, Func func) noexcept {
+    return _addSymbol(name, SIZE_MAX, Support::ptr_cast_impl<const void*, Func>(func));
+  }
+
+  //! Type-unsafe version of `addSymbol()`.
+  ASMJIT_API Error _addSymbol(const char* name, size_t nameSize, const void* address) noexcept;
+
+  //! Removes a symbol of the given `name` added by \ref addSymbol().
+  ASMJIT_API Error removeSymbol(const char* name, size_t nameSize = SIZE_MAX) noexcept;
+
+  //! Returns the address of a symbol of the given `name` or null if the symbol is not defined.
+  ASMJIT_API const void* symbolAddress(const char* name, size_t nameSize = SIZE_MAX) const noexcept;
+
+  //! \}
+
+  //! \name Stack Maps
+  //! \{
+
+  //! Finds a stack map of a call site that returns to `returnAddress`.
+  //!
+  //! Stack maps stored in \ref CodeHolder (see \ref StackMap) are retained by \ref add() and \ref addNear() until
+  //! the function is released, stack maps of functions added to an arena are retained until the arena is released.
+  //! If the stack map was found its entries are stored to `entriesOut` and their count to `countOut` and true is
+  //! returned. Locations of entries are relative to the frame of the function that made the call, see
+  //! \ref StackMapEntry.
+  ASMJIT_API bool findStackMap(const void* returnAddress, const StackMapEntry** entriesOut, uint32_t* countOut) const noexcept;
+
   //! \}
 };
 
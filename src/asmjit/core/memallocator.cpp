@@ -0,0 +1,177 @@
+// This file is part of AsmJit project <https://asmjit.com>
+//
+// See asmjit.h or LICENSE.md for license and copyright information
+// SPDX-License-Identifier: Zlib
+
+#include "../core/api-build_p.h"
+#include "../core/codeholder.h"
+#include "../core/jitallocator.h"
+#include "../core/jitruntime.h"
+#include "../core/memallocator.h"
+#include "../core/zone.h"
+
+ASMJIT_BEGIN_NAMESPACE
+
+// MemAllocator - Construction & Destruction
+// =========================================
+
+MemAllocator::~MemAllocator() noexcept {}
+
+// MemAllocator - Host
+// ===================
+
+class HostMemAllocator : public MemAllocator {
+public:
+  inline constexpr HostMemAllocator() noexcept {}
+
+  void* alloc(size_t size, size_t alignment) noexcept override {
+    ASMJIT_ASSERT(alignment <= Globals::kAllocAlignment);
+    DebugUtils::unused(alignment);
+
+    return ::malloc(size);
+  }
+
+  void* realloc(void* p, size_t oldSize, size_t newSize, size_t alignment) noexcept override {
+    ASMJIT_ASSERT(alignment <= Globals::kAllocAlignment);
+    DebugUtils::unused(oldSize, alignment);
+
+    return ::realloc(p, newSize);
+  }
+
+  void release(void* p, size_t size, size_t alignment) noexcept override {
+    DebugUtils::unused(size, alignment);
+    ::free(p);
+  }
+};
+
+// The host allocator is constant-initialized and never destroyed, so it can be used by constructors and destructors
+// of other static objects.
+union HostMemAllocatorStorage {
+  HostMemAllocator instance;
+
+  inline constexpr HostMemAllocatorStorage() noexcept : instance() {}
+  inline ~HostMemAllocatorStorage() noexcept {}
+};
+
+static HostMemAllocatorStorage MemAllocator_hostStorage;
+
+MemAllocator* MemAllocator::host() noexcept { return &MemAllocator_hostStorage.instance; }
+
+// MemAllocator - Tests
+// ====================
+
+#if defined(ASMJIT_TEST)
+// Allocator that counts live allocations and verifies that sizes passed to `realloc()` and `release()` match.
+class CountingMemAllocator : public MemAllocator {
+public:
+  size_t allocationCount = 0;
+  size_t allocatedSize = 0;
+  size_t totalCount = 0;
+
+  void* alloc(size_t size, size_t alignment) noexcept override {
+    allocationCount++;
+    allocatedSize += size;
+    totalCount++;
+    return MemAllocator::host()->alloc(size, alignment);
+  }
+
+  void* realloc(void* p, size_t oldSize, size_t newSize, size_t alignment) noexcept override {
+    EXPECT(allocatedSize >= oldSize);
+    allocatedSize += newSize - oldSize;
+    totalCount++;
+    return MemAllocator::host()->realloc(p, oldSize, newSize, alignment);
+  }
+
+  void release(void* p, size_t size, size_t alignment) noexcept override {
+    EXPECT(allocationCount > 0);
+    EXPECT(allocatedSize >= size);
+    allocationCount--;
+    allocatedSize -= size;
+    MemAllocator::host()->release(p, size, alignment);
+  }
+};
+
+UNIT(mem_allocator) {
+  CountingMemAllocator counter;
+
+  INFO("Verifying Zone and ZoneAllocator with a custom MemAllocator");
+  {
+    Zone zone(1024);
+    zone.setMemAllocator(&counter);
+    EXPECT(zone.memAllocator() == &counter);
+
+    ZoneAllocator heap(&zone);
+    for (uint32_t i = 0; i < 100; i++)
+      EXPECT(zone.alloc(128) != nullptr);
+
+    void* dynamic = heap.alloc(65536);
+    EXPECT(dynamic != nullptr);
+    heap.release(dynamic, 65536);
+
+    EXPECT(heap.alloc(100000) != nullptr);
+    EXPECT(counter.allocationCount > 1);
+  }
+  EXPECT(counter.allocationCount == 0);
+  EXPECT(counter.allocatedSize == 0);
+
+  INFO("Verifying CodeHolder with a custom MemAllocator");
+  {
+    Environment env;
+    env.init(Arch::kX64);
+
+    CodeHolder code;
+    EXPECT(code.setMemAllocator(&counter) == kErrorOk);
+    EXPECT(code.init(env) == kErrorOk);
+    EXPECT(code.setMemAllocator(nullptr) == kErrorAlreadyInitialized);
+
+    CodeBuffer& buffer = code.textSection()->buffer();
+    size_t totalCount = counter.totalCount;
+
+    EXPECT(code.growBuffer(&buffer, 100) == kErrorOk);
+    EXPECT(code.growBuffer(&buffer, 1000000) == kErrorOk);
+    EXPECT(counter.totalCount > totalCount);
+  }
+  EXPECT(counter.allocationCount == 0);
+  EXPECT(counter.allocatedSize == 0);
+
+#ifndef ASMJIT_NO_JIT
+  INFO("Verifying JitAllocator with a custom MemAllocator");
+  {
+    JitAllocator::CreateParams params {};
+    params.memAllocator = &counter;
+
+    JitAllocator allocator(&params);
+    void* rxPtr;
+    void* rwPtr;
+
+    EXPECT(allocator.alloc(&rxPtr, &rwPtr, 1024) == kErrorOk);
+    EXPECT(counter.allocationCount > 1);
+    EXPECT(allocator.release(rxPtr) == kErrorOk);
+
+    JitAllocator::Arena* arena;
+    EXPECT(allocator.newArena(&arena) == kErrorOk);
+    EXPECT(allocator.allocFromArena(arena, &rxPtr, &rwPtr, 4096) == kErrorOk);
+    EXPECT(allocator.releaseArena(arena) == kErrorOk);
+  }
+  EXPECT(counter.allocationCount == 0);
+  EXPECT(counter.allocatedSize == 0);
+
+  INFO("Verifying JitRuntime with a custom MemAllocator");
+  {
+    JitAllocator::CreateParams params {};
+    params.memAllocator = &counter;
+
+    JitRuntime rt(&params);
+    size_t allocationCount = counter.allocationCount;
+
+    EXPECT(rt.addSymbol("symbol", &counter) == kErrorOk);
+    EXPECT(counter.allocationCount > allocationCount);
+    EXPECT(rt.symbolAddress("symbol") == static_cast<const void*>(&counter));
+  }
+  EXPECT(counter.allocationCount == 0);
+  EXPECT(counter.allocatedSize == 0);
+#endif // !ASMJIT_NO_JIT
+}
+#endif
+
+ASMJIT_END_NAMESPACE
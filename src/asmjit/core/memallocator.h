@@ -0,0 +1,77 @@
+// This file is part of AsmJit project <https://asmjit.com>
+//
+// See asmjit.h or LICENSE.md for license and copyright information
+// SPDX-License-Identifier: Zlib
+
+#ifndef ASMJIT_CORE_MEMALLOCATOR_H_INCLUDED
+#define ASMJIT_CORE_MEMALLOCATOR_H_INCLUDED
+
+#include "../core/globals.h"
+
+ASMJIT_BEGIN_NAMESPACE
+
+//! \addtogroup asmjit_core
+//! \{
+
+//! Memory allocator interface.
+//!
+//! AsmJit allocates memory of \ref Zone blocks, \ref CodeBuffer data, and metadata of \ref JitAllocator (blocks,
+//! bit-arrays, and arenas) through a `MemAllocator`, which can be replaced by the user to route these allocations
+//! to a custom heap, an arena, or preallocated memory, or to account memory used by JIT compilation precisely. The
+//! allocator is configurable per \ref CodeHolder (see \ref CodeHolder::setMemAllocator()), per \ref Zone (see
+//! \ref Zone::setMemAllocator()), and per \ref JitAllocator (see \ref JitAllocator::CreateParams::memAllocator).
+//! Emitters attached to a \ref CodeHolder use its allocator for their zones as well. If no allocator is provided
+//! \ref MemAllocator::host() is used, which uses `malloc()`, `realloc()`, and `free()`.
+//!
+//! Each `release()` and `realloc()` is given the same size and alignment as the `alloc()` or `realloc()` call
+//! that returned the memory, so the implementation doesn't have to store them. AsmJit never requests alignment
+//! greater than \ref Globals::kAllocAlignment. The allocator must outlive all objects that use it and it must be
+//! thread-safe if these objects are used by multiple threads.
+//!
+//! \note Memory returned to the user, like the content of \ref String, is not allocated by `MemAllocator`.
+class ASMJIT_VIRTAPI MemAllocator {
+public:
+  ASMJIT_BASE_CLASS(MemAllocator)
+
+  //! \name Construction & Destruction
+  //! \{
+
+  //! Creates a new `MemAllocator` instance.
+  //!
+  //! \note The constructor is `constexpr` so allocators can be constant-initialized, which makes static allocators
+  //! usable by constructors of other static objects.
+  inline constexpr MemAllocator() noexcept {}
+  //! Destroys the `MemAllocator` instance.
+  ASMJIT_API virtual ~MemAllocator() noexcept;
+
+  //! \}
+
+  //! \name Interface
+  //! \{
+
+  //! Allocates `size` bytes of memory aligned to `alignment` and returns it, or null if the allocation failed.
+  virtual void* alloc(size_t size, size_t alignment) noexcept = 0;
+
+  //! Resizes the memory `p` of `oldSize` bytes to `newSize` bytes and returns it, the content is preserved up to
+  //! the lesser of both sizes. Returns null if the reallocation failed, in which case `p` stays valid.
+  virtual void* realloc(void* p, size_t oldSize, size_t newSize, size_t alignment) noexcept = 0;
+
+  //! Releases the memory `p` of `size` bytes.
+  virtual void release(void* p, size_t size, size_t alignment) noexcept = 0;
+
+  //! \}
+
+  //! \name Host Allocator
+  //! \{
+
+  //! Returns the default allocator, which uses `malloc()`, `realloc()`, and `free()`.
+  static ASMJIT_API MemAllocator* host() noexcept;
+
+  //! \}
+};
+
+//! \}
+
+ASMJIT_END_NAMESPACE
+
+#endif // ASMJIT_CORE_MEMALLOCATOR_H_INCLUDED
@@ -0,0 +1,326 @@
+// This file is part of AsmJit project <https://asmjit.com>
+//
+// See asmjit.h or LICENSE.md for license and copyright information
+// SPDX-License-Identifier: Zlib
+
+#include "../core/api-build_p.h"
+#ifndef ASMJIT_NO_COMPILER
+
+#include "../core/phipass_p.h"
+
+ASMJIT_BEGIN_NAMESPACE
+
+// BasePhiPass - Utilities
+// =======================
+
+static inline bool BasePhiPass_isBlockLabel(const BaseNode* node) noexcept {
+  return node->type() == NodeType::kLabel || node->type() == NodeType::kFunc || node->type() == NodeType::kOsrEntry;
+}
+
+static InstControlFlow BasePhiPass_nodeFlow(const BasePhiPass* self, const BaseNode* node) noexcept {
+  switch (node->type()) {
+    case NodeType::kInst:
+    case NodeType::kJump:
+      return self->controlFlow(node->as<InstNode>());
+
+    case NodeType::kFuncRet:
+      return InstControlFlow::kReturn;
+
+    case NodeType::kInvoke:
+      return InstControlFlow::kCall;
+
+    default:
+      return InstControlFlow::kRegular;
+  }
+}
+
+static inline bool BasePhiPass_isTerminator(InstControlFlow flow) noexcept {
+  return flow == InstControlFlow::kJump || flow == InstControlFlow::kReturn;
+}
+
+// Tests whether `node` is a jump or a branch to `labelId`, the label is always the last operand.
+static inline bool BasePhiPass_isJumpTo(const BaseNode* node, InstControlFlow flow, uint32_t labelId) noexcept {
+  if (flow != InstControlFlow::kJump && flow != InstControlFlow::kBranch)
+    return false;
+
+  const InstNode* inst = node->as<InstNode>();
+  uint32_t opCount = inst->opCount();
+  return opCount && inst->op(opCount - 1).isLabel() && inst->op(opCount - 1).id() == labelId;
+}
+
+// Tests whether `node` is an annotated jump that can reach `labelId`, copies cannot be placed on such edges.
+static inline bool BasePhiPass_isAnnotatedJumpTo(const BaseNode* node, uint32_t labelId) noexcept {
+  if (node->type() != NodeType::kJump || !node->as<JumpNode>()->hasAnnotation())
+    return false;
+  return node->as<JumpNode>()->annotation()->hasLabelId(labelId);
+}
+
+// Emits a parallel copy at the cursor of the Compiler. A source that is overwritten by another copy is saved to a
+// temporary before any destination is written.
+static Error BasePhiPass_emitCopies(BasePhiPass* self, const BasePhiPass::Copy* copies, uint32_t count) noexcept {
+  BaseCompiler* cc = self->cc();
+
+  ZoneVector<BaseReg> sources;
+  ASMJIT_PROPAGATE(sources.reserve(&self->_allocator, count));
+
+  for (uint32_t i = 0; i < count; i++) {
+    BaseReg src = copies[i].src.toReg<BaseReg>();
+
+    for (uint32_t j = 0; j < count; j++) {
+      if (j != i && copies[j].dst.id() == src.id()) {
+        BaseReg tmp;
+        ASMJIT_PROPAGATE(cc->_newReg(&tmp, src));
+        ASMJIT_PROPAGATE(self->emitMove(tmp, src, cc->virtRegById(src.id())->typeId()));
+        src = tmp;
+        break;
+      }
+    }
+
+    sources.appendUnsafe(src);
+  }
+
+  for (uint32_t i = 0; i < count; i++) {
+    BaseReg dst = copies[i].dst.toReg<BaseReg>();
+    ASMJIT_PROPAGATE(self->emitMove(dst, sources[i], cc->virtRegById(dst.id())->typeId()));
+  }
+
+  return kErrorOk;
+}
+
+// Places copies in `_copies` on all edges from the block that starts at `predId` to the block that starts at
+// `blockId`, see \ref BasePhiPass for details.
+static Error BasePhiPass_lowerEdges(BasePhiPass* self, uint32_t predId, uint32_t blockId) noexcept {
+  BaseCompiler* cc = self->cc();
+  const ZoneVector<LabelNode*>& labelNodes = cc->labelNodes();
+
+  if (predId >= labelNodes.size() || !labelNodes[predId] || !labelNodes[predId]->isActive())
+    return DebugUtils::errored(kErrorInvalidLabel);
+
+  uint32_t copyCount = self->_copies.size();
+  uint32_t edgeCount = 0;
+
+  for (BaseNode* node = labelNodes[predId]->next(); node; node = node->next()) {
+    if (node->isInformative() || node->isPhi())
+      continue;
+
+    if (BasePhiPass_isBlockLabel(node)) {
+      // Labels bound next to each other start the same block, check whether the predecessor falls through to it.
+      for (BaseNode* label = node; label && (label->type() == NodeType::kLabel || label->isInformative()); label = label->next()) {
+        if (label->type() == NodeType::kLabel && label->as<LabelNode>()->labelId() == blockId) {
+          cc->_setCursor(node->prev());
+          ASMJIT_PROPAGATE(BasePhiPass_emitCopies(self, self->_copies.data(), copyCount));
+          edgeCount++;
+          break;
+        }
+      }
+      break;
+    }
+
+    InstControlFlow flow = BasePhiPass_nodeFlow(self, node);
+    if (BasePhiPass_isAnnotatedJumpTo(node, blockId))
+      return DebugUtils::errored(kErrorInvalidState);
+
+    if (BasePhiPass_isJumpTo(node, flow, blockId)) {
+      if (flow == InstControlFlow::kJump) {
+        cc->_setCursor(node->prev());
+        ASMJIT_PROPAGATE(BasePhiPass_emitCopies(self, self->_copies.data(), copyCount));
+      }
+      else {
+        // Split the edge - the branch is retargeted to a new block, which is emitted at the end of the function.
+        Label label = cc->newLabel();
+        if (ASMJIT_UNLIKELY(!label.isValid()))
+          return DebugUtils::errored(kErrorOutOfMemory);
+
+        InstNode* inst = node->as<InstNode>();
+        inst->setOp(inst->opCount() - 1, label);
+        // The SHORT form might not be encodable anymore (X86 specific).
+        inst->clearOptions(InstOptions::kShortForm);
+
+        uint32_t copyIndex = self->_splitCopies.size();
+        ASMJIT_PROPAGATE(self->_splitCopies.reserve(&self->_allocator, copyIndex + copyCount));
+        for (uint32_t i = 0; i < copyCount; i++)
+          self->_splitCopies.appendUnsafe(self->_copies[i]);
+
+        ASMJIT_PROPAGATE(self->_splitEdges.append(&self->_allocator, BasePhiPass::SplitEdge{label.id(), blockId, copyIndex, copyCount}));
+      }
+      edgeCount++;
+    }
+
+    if (BasePhiPass_isTerminator(flow))
+      break;
+  }
+
+  // The predecessor must reach the block, otherwise the phi node is malformed.
+  if (!edgeCount)
+    return DebugUtils::errored(kErrorInvalidState);
+
+  return kErrorOk;
+}
+
+// Lowers phi nodes in range [first, last] that belong to the block that starts at `blockLabel`.
+static Error BasePhiPass_lowerBlock(BasePhiPass* self, LabelNode* blockLabel, BaseNode* first, BaseNode* last) noexcept {
+  BaseCompiler* cc = self->cc();
+  BaseNode* stop = last->next();
+  ZoneVector<uint32_t> preds;
+
+  for (BaseNode* node = first; node != stop; node = node->next()) {
+    if (!node->isPhi())
+      continue;
+
+    const PhiNode* phiNode = node->as<PhiNode>();
+    const RegOnly& dst = phiNode->dst();
+
+    if (!dst.isVirtReg() || !cc->isVirtIdValid(dst.id()))
+      return DebugUtils::errored(kErrorInvalidVirtId);
+
+    for (uint32_t i = 0; i < phiNode->incomingCount(); i++) {
+      const PhiNode::Incoming& incoming = phiNode->incoming(i);
+
+      if (!incoming.value.isVirtReg() || !cc->isVirtIdValid(incoming.value.id()))
+        return DebugUtils::errored(kErrorInvalidVirtId);
+
+      if (incoming.value.signature().regGroup() != dst.signature().regGroup())
+        return DebugUtils::errored(kErrorInvalidState);
+
+      if (!cc->isLabelValid(incoming.labelId))
+        return DebugUtils::errored(kErrorInvalidLabel);
+
+      if (!preds.contains(incoming.labelId))
+        ASMJIT_PROPAGATE(preds.append(&self->_allocator, incoming.labelId));
+    }
+  }
+
+  for (uint32_t predId : preds) {
+    self->_copies.clear();
+
+    for (BaseNode* node = first; node != stop; node = node->next()) {
+      if (!node->isPhi())
+        continue;
+
+      const PhiNode* phiNode = node->as<PhiNode>();
+      uint32_t i = 0;
+
+      while (i < phiNode->incomingCount() && phiNode->incoming(i).labelId != predId)
+        i++;
+
+      // Each phi node of a block must provide a value for each of its predecessors.
+      if (i == phiNode->incomingCount())
+        return DebugUtils::errored(kErrorInvalidState);
+
+      const RegOnly& src = phiNode->incoming(i).value;
+      if (src.id() != phiNode->dst().id())
+        ASMJIT_PROPAGATE(self->_copies.append(&self->_allocator, BasePhiPass::Copy{phiNode->dst(), src}));
+    }
+
+    if (!self->_copies.empty())
+      ASMJIT_PROPAGATE(BasePhiPass_lowerEdges(self, predId, blockLabel->labelId()));
+  }
+
+  return kErrorOk;
+}
+
+static Error BasePhiPass_lowerFunction(BasePhiPass* self, FuncNode* func) noexcept {
+  BaseCompiler* cc = self->cc();
+  BaseNode* stop = func->endNode();
+  BaseNode* node = func->next();
+
+  while (node && node != stop) {
+    if (!node->isPhi()) {
+      node = node->next();
+      continue;
+    }
+
+    // Phi nodes must directly follow the label of their block.
+    BaseNode* blockLabel = node->prev();
+    while (blockLabel->isInformative())
+      blockLabel = blockLabel->prev();
+
+    if (!BasePhiPass_isBlockLabel(blockLabel))
+      return DebugUtils::errored(kErrorInvalidState);
+
+    BaseNode* last = node;
+    for (BaseNode* next = node->next(); next != stop && (next->isPhi() || next->isInformative()); next = next->next()) {
+      if (next->isPhi())
+        last = next;
+    }
+
+    ASMJIT_PROPAGATE(BasePhiPass_lowerBlock(self, blockLabel->as<LabelNode>(), node, last));
+
+    // Copies are never inserted between phi nodes of a block, so all of them can be removed now.
+    BaseNode* next = last->next();
+    while (node != next) {
+      BaseNode* phiNext = node->next();
+      if (node->isPhi())
+        cc->removeNode(node);
+      node = phiNext;
+    }
+  }
+
+  // Emit split edges before the exit label, which must not be entered by falling through to them.
+  if (!self->_splitEdges.empty()) {
+    LabelNode* exitNode = func->exitNode();
+    BaseNode* prev = exitNode->prev();
+
+    while (prev->isInformative())
+      prev = prev->prev();
+
+    cc->_setCursor(exitNode->prev());
+    if (!BasePhiPass_isTerminator(BasePhiPass_nodeFlow(self, prev)))
+      ASMJIT_PROPAGATE(self->emitJump(exitNode->label()));
+
+    for (const BasePhiPass::SplitEdge& edge : self->_splitEdges) {
+      ASMJIT_PROPAGATE(cc->bind(Label(edge.labelId)));
+      ASMJIT_PROPAGATE(BasePhiPass_emitCopies(self, self->_splitCopies.data() + edge.copyIndex, edge.copyCount));
+      ASMJIT_PROPAGATE(self->emitJump(Label(edge.targetId)));
+    }
+  }
+
+  return kErrorOk;
+}
+
+// BasePhiPass - Construction & Destruction
+// ========================================
+
+BasePhiPass::BasePhiPass(const char* name) noexcept
+  : FuncPass(name) {}
+BasePhiPass::~BasePhiPass() noexcept {}
+
+// BasePhiPass - Run
+// =================
+
+Error BasePhiPass::runOnFunction(Zone* zone, Logger* logger, FuncNode* func) {
+  DebugUtils::unused(logger);
+
+  // Most functions don't use phi nodes, so don't do anything in that case.
+  BaseNode* node = func->next();
+  BaseNode* stop = func->endNode();
+
+  while (node && node != stop && !node->isPhi())
+    node = node->next();
+
+  if (!node || node == stop)
+    return kErrorOk;
+
+  BaseCompiler* cc = this->cc();
+  BaseNode* prevCursor = cc->cursor();
+
+  _func = func;
+  _allocator.reset(zone);
+
+  Error err = BasePhiPass_lowerFunction(this, func);
+
+  _copies.reset();
+  _splitCopies.reset();
+  _splitEdges.reset();
+  _allocator.reset(nullptr);
+  _func = nullptr;
+
+  zone->reset();
+  cc->_setCursor(prevCursor);
+
+  return err;
+}
+
+ASMJIT_END_NAMESPACE
+
+#endif // !ASMJIT_NO_COMPILER
@@ -0,0 +1,116 @@
+// This file is part of AsmJit project <https://asmjit.com>
+//
+// See asmjit.h or LICENSE.md for license and copyright information
+// SPDX-License-Identifier: Zlib
+
+#ifndef ASMJIT_CORE_PHIPASS_P_H_INCLUDED
+#define ASMJIT_CORE_PHIPASS_P_H_INCLUDED
+
+#include "../core/api-config.h"
+#ifndef ASMJIT_NO_COMPILER
+
+#include "../core/compiler.h"
+#include "../core/zonevector.h"
+
+ASMJIT_BEGIN_NAMESPACE
+
+//! \cond INTERNAL
+//! \addtogroup asmjit_ra
+//! \{
+
+//! Phi node lowering pass.
+//!
+//! Replaces each \ref PhiNode with copies placed on the incoming edges of its block, so the rest of the Compiler
+//! pipeline never sees phi nodes. The pass runs first, before any pass that could change the labels that identify
+//! predecessors. Copies are placed as follows:
+//!
+//!   - An edge that falls through to the block or that ends with an unconditional jump gets its copies right before
+//!     the label of the block or the jump, respectively.
+//!
+//!   - A conditional branch is a critical edge in general, so it's split - the branch is retargeted to a new block
+//!     placed at the end of the function, which performs the copies and jumps to the original target.
+//!
+//! All phi nodes of a block are evaluated in parallel. If a copy would overwrite a register that is read by another
+//! copy on the same edge, the value is saved to a temporary first. The resulting copies are regular moves, which the
+//! register allocator tries to coalesce by assigning the same home register to both of their registers. A move whose
+//! registers were coalesced is removed, so copies only remain on edges where the allocation disagrees.
+class BasePhiPass : public FuncPass {
+public:
+  ASMJIT_NONCOPYABLE(BasePhiPass)
+  typedef FuncPass Base;
+
+  //! A single copy of a parallel copy.
+  struct Copy {
+    RegOnly dst;
+    RegOnly src;
+  };
+
+  //! An edge split by the pass, its copies are emitted at the end of the function.
+  struct SplitEdge {
+    uint32_t labelId;
+    uint32_t targetId;
+    uint32_t copyIndex;
+    uint32_t copyCount;
+  };
+
+  //! \name Members
+  //! \{
+
+  //! Function being processed.
+  FuncNode* _func = nullptr;
+  //! Allocator that uses zone passed to `runOnFunction()`.
+  ZoneAllocator _allocator;
+  //! Copies of the block being processed.
+  ZoneVector<Copy> _copies;
+  //! Copies of all split edges of the function being processed.
+  ZoneVector<Copy> _splitCopies;
+  //! Split edges of the function being processed.
+  ZoneVector<SplitEdge> _splitEdges;
+
+  //! \}
+
+  //! \name Construction & Destruction
+  //! \{
+
+  BasePhiPass(const char* name) noexcept;
+  virtual ~BasePhiPass() noexcept;
+
+  //! \}
+
+  //! \name Accessors
+  //! \{
+
+  //! Returns the associated `BaseCompiler`.
+  inline BaseCompiler* cc() const noexcept { return static_cast<BaseCompiler*>(_cb); }
+  //! Returns the function being processed.
+  inline FuncNode* func() const noexcept { return _func; }
+
+  //! \}
+
+  //! \name Run
+  //! \{
+
+  Error runOnFunction(Zone* zone, Logger* logger, FuncNode* func) override;
+
+  //! \}
+
+  //! \name Architecture Interface
+  //! \{
+
+  //! Returns control flow of the instruction `node`.
+  virtual InstControlFlow controlFlow(const InstNode* node) const noexcept = 0;
+  //! Emits a move of `src` to `dst` of the given `typeId` at the cursor of the Compiler.
+  virtual Error emitMove(const BaseReg& dst, const BaseReg& src, TypeId typeId) noexcept = 0;
+  //! Emits an unconditional jump to `label` at the cursor of the Compiler.
+  virtual Error emitJump(const Label& label) noexcept = 0;
+
+  //! \}
+};
+
+//! \}
+//! \endcond
+
+ASMJIT_END_NAMESPACE
+
+#endif // !ASMJIT_NO_COMPILER
+#endif // ASMJIT_CORE_PHIPASS_P_H_INCLUDED
@@ -199,6 +199,10 @@ public:
                 LabelNode* labelNode;
                 ASMJIT_PROPAGATE(cc()->labelNodeOf(&labelNode, opArray[opCount - 1].as<Label>()));
 
+                // OSR entry is only entered from outside of the function.
+                if (ASMJIT_UNLIKELY(labelNode->isOsrEntry()))
+                  return DebugUtils::errored(kErrorInvalidState);
+
                 RABlock* targetBlock = _pass->newBlockOrExistingAt(labelNode);
                 if (ASMJIT_UNLIKELY(!targetBlock))
                   return DebugUtils::errored(kErrorOutOfMemory);
@@ -222,6 +226,9 @@ public:
                     LabelNode* labelNode;
                     ASMJIT_PROPAGATE(cc()->labelNodeOf(&labelNode, id));
 
+                    if (ASMJIT_UNLIKELY(labelNode->isOsrEntry()))
+                      return DebugUtils::errored(kErrorInvalidState);
+
                     RABlock* targetBlock = _pass->newBlockOrExistingAt(labelNode);
                     if (ASMJIT_UNLIKELY(!targetBlock))
                       return DebugUtils::errored(kErrorOutOfMemory);
@@ -354,7 +361,7 @@ public:
           }
           else {
             // First time we see this label.
-            if (_hasCode || _curBlock == entryBlock) {
+            if (_hasCode || _curBlock == entryBlock || _curBlock->isOsrEntry()) {
               // Cannot continue the current block if it already contains some code or it's a block entry. We need to
               // create a new block and make it a successor.
               ASMJIT_ASSERT(_curBlock->last() != node);
@@ -413,6 +420,24 @@ public:
             return DebugUtils::errored(kErrorInvalidState);
           // PASS if this is the first node.
         }
+        else if (node->type() == NodeType::kOsrEntry) {
+          // OSR entry starts a new block that is only entered from outside of the function, thus the code before it
+          // must not flow to it. It's not targetable, so it's never merged with other blocks.
+          if (ASMJIT_UNLIKELY(_curBlock || node->hasPassData()))
+            return DebugUtils::errored(kErrorInvalidState);
+
+          _curBlock = _pass->newBlock(node);
+          if (ASMJIT_UNLIKELY(!_curBlock))
+            return DebugUtils::errored(kErrorOutOfMemory);
+
+          node->setPassData<RABlock>(_curBlock);
+          _hasCode = false;
+          _blockRegStats.reset();
+
+          ASMJIT_PROPAGATE(_pass->addBlock(_curBlock));
+          ASMJIT_PROPAGATE(_pass->addOsrBlock(_curBlock));
+          logBlock(_curBlock, kRootIndentation);
+        }
         else {
           // PASS if this is a non-interesting or unknown node.
         }
@@ -41,6 +41,7 @@ ASMJIT_BEGIN_NAMESPACE
 
 class BaseRAPass;
 class RABlock;
+class RALocalAllocator;
 class BaseNode;
 struct RAStackSlot;
 
@@ -1060,6 +1061,10 @@ public:
   //! Global hint register ID (provided by RA or user).
   uint8_t _hintRegId = BaseReg::kIdBad;
 
+  //! Work id of a register this register is moved from or to (or `kIdNone`), the global allocator tries to assign
+  //! both the same home register so the move can be removed.
+  uint32_t _copyWorkId = kIdNone;
+
   //! Live spans of the `VirtReg`.
   LiveRegSpans _liveSpans {};
   //! Live statistics.
@@ -1160,6 +1165,10 @@ public:
   inline uint32_t hintRegId() const noexcept { return _hintRegId; }
   inline void setHintRegId(uint32_t physId) noexcept { _hintRegId = uint8_t(physId); }
 
+  inline bool hasCopyWorkId() const noexcept { return _copyWorkId != kIdNone; }
+  inline uint32_t copyWorkId() const noexcept { return _copyWorkId; }
+  inline void setCopyWorkId(uint32_t workId) noexcept { _copyWorkId = workId; }
+
   inline RegMask useIdMask() const noexcept { return _useIdMask; }
   inline bool hasUseIdMask() const noexcept { return _useIdMask != 0u; }
   inline bool hasMultipleUseIds() const noexcept { return _useIdMask != 0u && !Support::isPowerOf2(_useIdMask); }
@@ -124,6 +124,67 @@ Error RALocalAllocator::makeInitialAssignment() noexcept {
   return kErrorOk;
 }
 
+Error RALocalAllocator::makeOsrEntryAssignment(RABlock* block) noexcept {
+  ASMJIT_ASSERT(block->first()->isOsrEntry());
+  const OsrEntryNode* osrNode = block->first()->as<OsrEntryNode>();
+
+  // Nothing but arguments is assigned upon entry, arguments are in registers specified by the calling convention.
+  for (RegGroup group : RegGroupVirtValues{}) {
+    Support::BitWordIterator<RegMask> it(_curAssignment.assigned(group));
+    while (it.hasNext()) {
+      uint32_t physId = it.next();
+      _curAssignment.unassign(group, _curAssignment.physToWorkId(group, physId), physId);
+    }
+  }
+
+  ZoneBitVector& liveIn = block->liveIn();
+  uint32_t argCount = osrNode->argCount();
+
+  for (uint32_t argIndex = 0; argIndex < argCount; argIndex++) {
+    for (uint32_t valueIndex = 0; valueIndex < Globals::kMaxValuePack; valueIndex++) {
+      // Unassigned argument.
+      const RegOnly& regArg = osrNode->argPack(argIndex)[valueIndex];
+      if (!regArg.isReg() || !_cc->isVirtIdValid(regArg.id()))
+        continue;
+
+      // Unreferenced argument.
+      RAWorkReg* workReg = _cc->virtRegById(regArg.id())->workReg();
+      if (!workReg)
+        continue;
+
+      // Overwritten argument.
+      uint32_t workId = workReg->workId();
+      if (!liveIn.bitAt(workId))
+        continue;
+
+      RegGroup group = workReg->group();
+      const FuncValue& arg = osrNode->detail().arg(argIndex, valueIndex);
+
+      if (ASMJIT_UNLIKELY(!arg.isReg() || _archTraits->regTypeToGroup(arg.regType()) != group))
+        return DebugUtils::errored(kErrorInvalidAssignment);
+
+      // Each argument must be assigned to a distinct virtual register that can be allocated in its physical register.
+      uint32_t physId = arg.regId();
+      if (ASMJIT_UNLIKELY(!Support::bitTest(_availableRegs[group], physId) ||
+                          _curAssignment.isPhysAssigned(group, physId) ||
+                          _curAssignment.workToPhysId(group, workId) != RAAssignment::kPhysNone))
+        return DebugUtils::errored(kErrorInvalidAssignment);
+
+      _curAssignment.assign(group, workId, physId, true);
+    }
+  }
+
+  // Every register that is live upon entry must be provided by an argument, otherwise its value would be undefined.
+  ZoneBitVector::ForEachBitSet it(liveIn);
+  while (it.hasNext()) {
+    RAWorkReg* workReg = workRegById(uint32_t(it.next()));
+    if (ASMJIT_UNLIKELY(_curAssignment.workToPhysId(workReg->group(), workReg->workId()) == RAAssignment::kPhysNone))
+      return DebugUtils::errored(kErrorInvalidState);
+  }
+
+  return kErrorOk;
+}
+
 Error RALocalAllocator::replaceAssignment(const PhysToWorkMap* physToWorkMap) noexcept {
   _curAssignment.copyFrom(physToWorkMap);
   return kErrorOk;
@@ -115,6 +115,8 @@ public:
   //! \{
 
   Error makeInitialAssignment() noexcept;
+  //! Makes an assignment of the OSR entry `block`, which only contains arguments of its \ref OsrEntryNode.
+  Error makeOsrEntryAssignment(RABlock* block) noexcept;
 
   Error replaceAssignment(const PhysToWorkMap* physToWorkMap) noexcept;
 
@@ -62,6 +62,7 @@ static void BaseRAPass_reset(BaseRAPass* self, FuncDetail* funcDetail) noexcept
 
   self->_blocks.reset();
   self->_exits.reset();
+  self->_osrBlocks.reset();
   self->_pov.reset();
   self->_workRegs.reset();
   self->_instructionCount = 0;
@@ -84,9 +85,14 @@ static void BaseRAPass_reset(BaseRAPass* self, FuncDetail* funcDetail) noexcept
   self->_workRegsOfGroup.forEach([](RAWorkRegs& regs) { regs.reset(); });
   self->_strategy.forEach([](RAStrategy& strategy) { strategy.reset(); });
   self->_globalLiveSpans.fill(nullptr);
+  self->_fixedLiveSpans.fill(nullptr);
   self->_globalMaxLiveCount.reset();
   self->_temporaryMem.reset();
 
+  self->_taggedWorkRegs.reset();
+  self->_stackMaps.reset();
+  self->_stackMapEntries.reset();
+
   self->_stackAllocator.reset(allocator);
   self->_argsAssignment.reset(funcDetail);
   self->_numStackArgsToStackSlots = 0;
@@ -189,6 +195,7 @@ Error BaseRAPass::onPerformAllSteps() noexcept {
   ASMJIT_PROPAGATE(insertPrologEpilog());
 
   ASMJIT_PROPAGATE(rewrite());
+  ASMJIT_PROPAGATE(addStackMaps());
 
   return kErrorOk;
 }
@@ -381,38 +388,48 @@ Error BaseRAPass::buildCFGViews() noexcept {
   ZoneBitVector visited;
   ASMJIT_PROPAGATE(visited.resize(allocator(), count));
 
-  RABlock* current = _blocks[0];
-  uint32_t i = 0;
+  // OSR entries are roots of the CFG as well. They are visited first so the entry block is always the last block in
+  // POV, which makes it the first block in reverse post-order, and blocks reachable from it have the highest order.
+  uint32_t osrCount = _osrBlocks.size();
+  visited.setBit(_blocks[0]->blockId(), true);
+
+  for (RABlock* osrBlock : _osrBlocks)
+    visited.setBit(osrBlock->blockId(), true);
+
+  for (uint32_t rootIndex = 0; rootIndex <= osrCount; rootIndex++) {
+    RABlock* current = rootIndex < osrCount ? _osrBlocks[rootIndex] : _blocks[0];
+    uint32_t i = 0;
 
-  for (;;) {
     for (;;) {
-      if (i >= current->successors().size())
-        break;
+      for (;;) {
+        if (i >= current->successors().size())
+          break;
 
-      // Skip if already visited.
-      RABlock* child = current->successors()[i++];
-      if (visited.bitAt(child->blockId()))
-        continue;
+        // Skip if already visited.
+        RABlock* child = current->successors()[i++];
+        if (visited.bitAt(child->blockId()))
+          continue;
 
-      // Mark as visited to prevent visiting the same block multiple times.
-      visited.setBit(child->blockId(), true);
+        // Mark as visited to prevent visiting the same block multiple times.
+        visited.setBit(child->blockId(), true);
 
-      // Add the current block on the stack, we will get back to it later.
-      ASMJIT_PROPAGATE(stack.append(RABlockVisitItem(current, i)));
-      current = child;
-      i = 0;
-    }
+        // Add the current block on the stack, we will get back to it later.
+        ASMJIT_PROPAGATE(stack.append(RABlockVisitItem(current, i)));
+        current = child;
+        i = 0;
+      }
 
-    current->makeReachable();
-    current->_povOrder = _pov.size();
-    _pov.appendUnsafe(current);
+      current->makeReachable();
+      current->_povOrder = _pov.size();
+      _pov.appendUnsafe(current);
 
-    if (stack.empty())
-      break;
+      if (stack.empty())
+        break;
 
-    RABlockVisitItem top = stack.pop();
-    current = top.block();
-    i = top.index();
+      RABlockVisitItem top = stack.pop();
+      current = top.block();
+      i = top.index();
+    }
   }
 
   ASMJIT_RA_LOG_COMPLEX({
@@ -459,6 +476,10 @@ Error BaseRAPass::buildCFGDominators() noexcept {
   RABlock* entryBlock = this->entryBlock();
   entryBlock->setIDom(entryBlock);
 
+  // OSR entries have no predecessors, they are treated as if they were entered from the function's entry.
+  for (RABlock* osrBlock : _osrBlocks)
+    osrBlock->setIDom(entryBlock);
+
   bool changed = true;
   uint32_t nIters = 0;
 
@@ -469,7 +490,7 @@ Error BaseRAPass::buildCFGDominators() noexcept {
     uint32_t i = _pov.size();
     while (i) {
       RABlock* block = _pov[--i];
-      if (block == entryBlock)
+      if (block == entryBlock || block->isOsrEntry())
         continue;
 
       RABlock* iDom = nullptr;
@@ -769,6 +790,11 @@ namespace LiveOps {
   }
 }
 
+// Records that `virtId` must be in `physId` at `position` (fixed positions of a register are appended in order).
+static ASMJIT_FORCE_INLINE Error BaseRAPass_addFixedPosition(BaseRAPass* self, RegGroup group, uint32_t physId, uint32_t position, uint32_t virtId) noexcept {
+  return self->_fixedLiveSpans[group][physId]._data.append(self->allocator(), LiveRegSpan(position, position + 1, LiveRegData(virtId)));
+}
+
 ASMJIT_FAVOR_SPEED Error BaseRAPass::buildLiveness() noexcept {
 #ifndef ASMJIT_NO_LOGGING
   Logger* logger = getLoggerIf(DiagnosticOptions::kRADebugLiveness);
@@ -933,6 +959,8 @@ ASMJIT_FAVOR_SPEED Error BaseRAPass::buildLiveness() noexcept {
   // Assign block and instruction positions, build LiveCount and LiveSpans
   // ---------------------------------------------------------------------
 
+  ASMJIT_PROPAGATE(initFixedLiveSpans());
+
   uint32_t position = 2;
   for (i = 0; i < numAllBlocks; i++) {
     RABlock* block = _blocks[i];
@@ -1000,12 +1028,21 @@ ASMJIT_FAVOR_SPEED Error BaseRAPass::buildLiveness() noexcept {
             curLiveCount[group]--;
           }
 
-          // Update `RAWorkReg::useIdMask` and `RAWorkReg::hintRegId`.
+          // Update `RAWorkReg::useIdMask` and `RAWorkReg::hintRegId`, and record fixed register constraints so the
+          // global allocator doesn't assign these registers to other values that are live at this position.
           if (tiedReg->hasUseId()) {
             uint32_t useId = tiedReg->useId();
             workReg->addUseIdMask(Support::bitMask(useId));
             if (!workReg->hasHintRegId() && !Support::bitTest(raInst->_clobberedRegs[group], useId))
               workReg->setHintRegId(useId);
+            ASMJIT_PROPAGATE(BaseRAPass_addFixedPosition(this, group, useId, position, workReg->virtId()));
+          }
+
+          if (tiedReg->hasOutId()) {
+            uint32_t outId = tiedReg->outId();
+            if (!workReg->hasHintRegId())
+              workReg->setHintRegId(outId);
+            ASMJIT_PROPAGATE(BaseRAPass_addFixedPosition(this, group, outId, position + 1, workReg->virtId()));
           }
 
           if (tiedReg->useRegMask()) {
@@ -1026,6 +1063,19 @@ ASMJIT_FAVOR_SPEED Error BaseRAPass::buildLiveness() noexcept {
           }
         }
 
+        // Remember both sides of a register to register move, so the global allocator can coalesce them.
+        if (raInst->hasInstRWFlag(InstRWFlags::kMovOp) && raInst->tiedCount() == 2) {
+          RAWorkReg* a = workRegById(raInst->tiedAt(0)->workId());
+          RAWorkReg* b = workRegById(raInst->tiedAt(1)->workId());
+
+          if (a->group() == b->group()) {
+            if (!a->hasCopyWorkId())
+              a->setCopyWorkId(b->workId());
+            if (!b->hasCopyWorkId())
+              b->setCopyWorkId(a->workId());
+          }
+        }
+
         position += 2;
         maxLiveCount.op<Support::Max>(raInst->_liveCount);
       }
@@ -1105,6 +1155,28 @@ Error BaseRAPass::assignArgIndexToWorkRegs() noexcept {
     }
   }
 
+  // Arguments of OSR entries prefer registers they arrive in, unless they are arguments of the function as well.
+  for (RABlock* osrBlock : _osrBlocks) {
+    const OsrEntryNode* osrNode = osrBlock->first()->as<OsrEntryNode>();
+    uint32_t osrArgCount = osrNode->argCount();
+
+    for (uint32_t argIndex = 0; argIndex < osrArgCount; argIndex++) {
+      for (uint32_t valueIndex = 0; valueIndex < Globals::kMaxValuePack; valueIndex++) {
+        const RegOnly& regArg = osrNode->argPack(argIndex)[valueIndex];
+        if (!regArg.isReg() || !cc()->isVirtIdValid(regArg.id()))
+          continue;
+
+        RAWorkReg* workReg = cc()->virtRegById(regArg.id())->workReg();
+        if (!workReg || workReg->hasHintRegId() || !osrBlock->liveIn().bitAt(workReg->workId()))
+          continue;
+
+        const FuncValue& arg = osrNode->detail().arg(argIndex, valueIndex);
+        if (arg.isReg() && _archTraits->regTypeToGroup(arg.regType()) == workReg->group())
+          workReg->setHintRegId(arg.regId());
+      }
+    }
+  }
+
   return kErrorOk;
 }
 
@@ -1155,6 +1227,54 @@ ASMJIT_FAVOR_SPEED Error BaseRAPass::initGlobalLiveSpans() noexcept {
   return kErrorOk;
 }
 
+ASMJIT_FAVOR_SPEED Error BaseRAPass::initFixedLiveSpans() noexcept {
+  for (RegGroup group : RegGroupVirtValues{}) {
+    size_t physCount = _physRegCount[group];
+    LiveRegSpans* fixedSpans = nullptr;
+
+    if (physCount) {
+      fixedSpans = allocator()->allocT<LiveRegSpans>(physCount * sizeof(LiveRegSpans));
+      if (ASMJIT_UNLIKELY(!fixedSpans))
+        return DebugUtils::errored(kErrorOutOfMemory);
+
+      for (size_t physId = 0; physId < physCount; physId++)
+        new(&fixedSpans[physId]) LiveRegSpans();
+    }
+
+    _fixedLiveSpans[group] = fixedSpans;
+  }
+
+  return kErrorOk;
+}
+
+// Tests whether `workReg` is live at a position where another virtual register must be in the physical register that
+// `fixedSpans` describes. Assigning such register to `workReg` would require moving `workReg` out of it and back.
+static bool RAPass_conflictsWithFixed(const LiveRegSpans& fixedSpans, const RAWorkReg* workReg) noexcept {
+  const LiveRegSpans& liveSpans = workReg->liveSpans();
+  uint32_t virtId = workReg->virtId();
+
+  const LiveRegSpan* fixed = fixedSpans.data();
+  const LiveRegSpan* fixedEnd = fixed + fixedSpans.size();
+  const LiveRegSpan* live = liveSpans.data();
+  const LiveRegSpan* liveEnd = live + liveSpans.size();
+
+  while (fixed != fixedEnd && live != liveEnd) {
+    if (fixed->a < live->a) {
+      fixed++;
+    }
+    else if (fixed->a >= live->b) {
+      live++;
+    }
+    else {
+      if (fixed->id != virtId)
+        return true;
+      fixed++;
+    }
+  }
+
+  return false;
+}
+
 struct RAConsecutiveReg {
   RAWorkReg* workReg;
   RAWorkReg* parentReg;
@@ -1205,7 +1325,7 @@ ASMJIT_FAVOR_SPEED Error BaseRAPass::binPack(RegGroup group) noexcept {
 
       if (workReg->hasHintRegId()) {
         uint32_t physId = workReg->hintRegId();
-        if (Support::bitTest(availableRegs, physId)) {
+        if (Support::bitTest(availableRegs, physId) && !RAPass_conflictsWithFixed(_fixedLiveSpans[group][physId], workReg)) {
           LiveRegSpans& live = _globalLiveSpans[group][physId];
           Error err = tmpSpans.nonOverlappingUnionOf(allocator(), live, workReg->liveSpans(), LiveRegData(workReg->virtId()));
 
@@ -1313,6 +1433,7 @@ ASMJIT_FAVOR_SPEED Error BaseRAPass::binPack(RegGroup group) noexcept {
   // Try to pack the rest.
   if (!workRegs.empty()) {
     uint32_t dstIndex = 0;
+    RegMask preservedRegs = func()->detail().preservedRegs(group);
 
     for (i = 0; i < numWorkRegs; i++) {
       RAWorkReg* workReg = workRegs[i];
@@ -1324,8 +1445,19 @@ ASMJIT_FAVOR_SPEED Error BaseRAPass::binPack(RegGroup group) noexcept {
       if (physRegs & workReg->preferredMask())
         physRegs &= workReg->preferredMask();
 
+      // Registers that don't have to be saved in prolog are tried first, unless the register survives a call.
+      RegMask scratchRegs = workReg->clobberSurvivalMask() ? RegMask(0) : physRegs & ~preservedRegs;
+
+      // The home register of the other side of a move is tried before anything else, which coalesces the move.
+      uint32_t copyHomeId = BaseReg::kIdBad;
+      if (workReg->hasCopyWorkId()) {
+        RAWorkReg* copyReg = workRegById(workReg->copyWorkId());
+        if (copyReg->hasHomeRegId() && !Support::bitTest(workReg->clobberSurvivalMask(), copyReg->homeRegId()))
+          copyHomeId = copyReg->homeRegId();
+      }
+
       while (physRegs) {
-        RegMask preferredMask = physRegs;
+        RegMask preferredMask = (physRegs & scratchRegs) ? physRegs & scratchRegs : physRegs;
         uint32_t physId = Support::ctz(preferredMask);
 
         if (workReg->clobberSurvivalMask()) {
@@ -1334,6 +1466,14 @@ ASMJIT_FAVOR_SPEED Error BaseRAPass::binPack(RegGroup group) noexcept {
             physId = Support::ctz(preferredMask);
         }
 
+        if (copyHomeId != BaseReg::kIdBad && Support::bitTest(physRegs, copyHomeId))
+          physId = copyHomeId;
+
+        if (RAPass_conflictsWithFixed(_fixedLiveSpans[group][physId], workReg)) {
+          physRegs ^= Support::bitMask(physId);
+          continue;
+        }
+
         LiveRegSpans& live = _globalLiveSpans[group][physId];
         Error err = tmpSpans.nonOverlappingUnionOf(allocator(), live, workReg->liveSpans(), LiveRegData(workReg->virtId()));
 
@@ -1419,10 +1559,24 @@ Error BaseRAPass::runLocalAllocator() noexcept {
   // The first block (entry) must always be reachable.
   ASMJIT_ASSERT(block->isReachable());
 
+  // Locations of tagged registers are recorded at each function call, see `recordStackMap()`.
+  for (RAWorkReg* workReg : _workRegs)
+    if (workReg->virtReg()->isTagged())
+      ASMJIT_PROPAGATE(_taggedWorkRegs.append(allocator(), workReg));
+
   // Assign function arguments for the initial block. The `lra` is valid now.
   lra.makeInitialAssignment();
   ASMJIT_PROPAGATE(setBlockEntryAssignment(block, block, lra._curAssignment));
 
+  // OSR entries have no predecessors, so their assignments have to be made upfront as well.
+  if (!_osrBlocks.empty()) {
+    for (RABlock* osrBlock : _osrBlocks) {
+      ASMJIT_PROPAGATE(lra.makeOsrEntryAssignment(osrBlock));
+      ASMJIT_PROPAGATE(setBlockEntryAssignment(osrBlock, osrBlock, lra._curAssignment));
+    }
+    ASMJIT_PROPAGATE(lra.replaceAssignment(block->entryPhysToWorkMap()));
+  }
+
   // The loop starts from the first block and iterates blocks in order, however, the algorithm also allows to jump to
   // any other block when finished if it's a jump target. In-order iteration just makes sure that all blocks are visited.
   for (;;) {
@@ -1470,8 +1624,11 @@ Error BaseRAPass::runLocalAllocator() noexcept {
         }
 
         ASMJIT_PROPAGATE(lra.allocInst(inst));
-        if (inst->type() == NodeType::kInvoke)
+        if (inst->type() == NodeType::kInvoke) {
+          if (!_taggedWorkRegs.empty())
+            ASMJIT_PROPAGATE(recordStackMap(lra, inst->as<InvokeNode>()));
           ASMJIT_PROPAGATE(emitPreCall(inst->as<InvokeNode>()));
+        }
         else
           ASMJIT_PROPAGATE(lra.spillAfterAllocation(inst));
       }
@@ -1654,6 +1811,98 @@ Error BaseRAPass::blockEntryAssigned(const PhysToWorkMap* physToWorkMap) noexcep
   return kErrorOk;
 }
 
+// BaseRAPass - Allocation - Stack Maps
+// ====================================
+
+// Tests whether `liveSpans` cover the given `position`.
+static bool BaseRAPass_isLiveAt(const LiveRegSpans& liveSpans, uint32_t position) noexcept {
+  for (uint32_t i = 0; i < liveSpans.size(); i++) {
+    const LiveRegSpan& span = liveSpans[i];
+    if (position < span.a)
+      return false;
+    if (position < span.b)
+      return true;
+  }
+  return false;
+}
+
+Error BaseRAPass::recordStackMap(RALocalAllocator& lra, InvokeNode* invokeNode) noexcept {
+  // A value survives the call if it's live both before and after it - arguments that are KILLed by the call end at
+  // `position + 1` and return values only start there.
+  uint32_t position = invokeNode->position();
+  uint32_t entryIndex = _stackMapEntries.size();
+
+  for (RAWorkReg* workReg : _taggedWorkRegs) {
+    const LiveRegSpans& liveSpans = workReg->liveSpans();
+    if (!BaseRAPass_isLiveAt(liveSpans, position) || !BaseRAPass_isLiveAt(liveSpans, position + 1))
+      continue;
+
+    RegGroup group = workReg->group();
+    uint32_t workId = workReg->workId();
+    uint32_t physId = lra._curAssignment.workToPhysId(group, workId);
+
+    if (physId != RAAssignment::kPhysNone) {
+      // The value can be changed during the call (for example by a moving garbage collector), so the register must
+      // be saved if it gets spilled later, even if it was not modified by the function.
+      lra._curAssignment.makeDirty(group, workId, physId);
+    }
+    else if (ASMJIT_UNLIKELY(!workReg->hasStackSlot())) {
+      // A live register that is not assigned must have been spilled before the call.
+      return DebugUtils::errored(kErrorInvalidState);
+    }
+
+    ASMJIT_PROPAGATE(_stackMapEntries.append(allocator(), RAStackMapEntry{workId, physId}));
+  }
+
+  LabelNode* labelNode;
+  ASMJIT_PROPAGATE(cc()->newLabelNode(&labelNode));
+  cc()->addAfter(labelNode, invokeNode);
+
+  uint32_t entryCount = _stackMapEntries.size() - entryIndex;
+  return _stackMaps.append(allocator(), RAStackMap{labelNode->labelId(), entryIndex, entryCount});
+}
+
+Error BaseRAPass::addStackMaps() noexcept {
+  if (_stackMaps.empty())
+    return kErrorOk;
+
+  ZoneVector<StackMapEntry> entries;
+  ASMJIT_PROPAGATE(entries.reserve(allocator(), _taggedWorkRegs.size()));
+
+  for (const RAStackMap& stackMap : _stackMaps) {
+    entries.clear();
+
+    for (uint32_t i = 0; i < stackMap.entryCount; i++) {
+      const RAStackMapEntry& raEntry = _stackMapEntries[stackMap.entryIndex + i];
+      RAWorkReg* workReg = workRegById(raEntry.workId);
+
+      StackMapEntry entry {};
+      entry._virtId = workReg->virtId();
+
+      if (raEntry.physId != RAAssignment::kPhysNone) {
+        entry._location = StackMapLocation::kReg;
+        entry._regGroup = workReg->group();
+        entry._regId = uint8_t(raEntry.physId);
+      }
+      else {
+        // Offsets of stack slots are final after `updateStackFrame()`, they are relative to the stack pointer unless
+        // the slot is a stack argument addressed by the frame pointer.
+        const RAStackSlot* slot = workReg->stackSlot();
+        entry._location = StackMapLocation::kStack;
+        entry._regGroup = RegGroup::kGp;
+        entry._regId = uint8_t(slot->baseRegId());
+        entry._offset = slot->offset();
+      }
+
+      entries.appendUnsafe(entry);
+    }
+
+    ASMJIT_PROPAGATE(cc()->code()->addStackMap(Label(stackMap.labelId), entries.data(), entries.size()));
+  }
+
+  return kErrorOk;
+}
+
 // BaseRAPass - Allocation - Utilities
 // ===================================
 
@@ -1793,6 +2042,32 @@ Error BaseRAPass::insertPrologEpilog() noexcept {
   ASMJIT_PROPAGATE(cc()->emitProlog(frame));
   ASMJIT_PROPAGATE(_iEmitHelper->emitArgsAssignment(frame, _argsAssignment));
 
+  // OSR entries share the frame with the function, so each of them sets it up the same way. Arguments are already
+  // where the register allocator expects them, however, the prolog must not clobber them.
+  if (!_osrBlocks.empty()) {
+    uint32_t saRegId = frame.saRegId();
+    bool clobbersSA = saRegId != BaseReg::kIdBad && saRegId != _sp.id() && saRegId != _fp.id();
+
+    for (BaseNode* node = func()->next(); node != _stop; node = node->next()) {
+      if (!node->isOsrEntry())
+        continue;
+
+      const OsrEntryNode* osrNode = node->as<OsrEntryNode>();
+      if (clobbersSA) {
+        for (uint32_t argIndex = 0; argIndex < osrNode->argCount(); argIndex++) {
+          for (uint32_t valueIndex = 0; valueIndex < Globals::kMaxValuePack; valueIndex++) {
+            const FuncValue& arg = osrNode->detail().arg(argIndex, valueIndex);
+            if (ASMJIT_UNLIKELY(arg.isReg() && arg.regId() == saRegId && _archTraits->regTypeToGroup(arg.regType()) == RegGroup::kGp))
+              return DebugUtils::errored(kErrorInvalidState);
+          }
+        }
+      }
+
+      cc()->_setCursor(node);
+      ASMJIT_PROPAGATE(cc()->emitProlog(frame));
+    }
+  }
+
   cc()->_setCursor(func()->exitNode());
   ASMJIT_PROPAGATE(cc()->emitEpilog(frame));
 
@@ -37,6 +37,8 @@ enum class RABlockFlags : uint32_t {
   kIsAllocated = 0x00000008u,
   //! Block is a function-exit.
   kIsFuncExit = 0x00000010u,
+  //! Block is an on-stack replacement entry (starts with \ref OsrEntryNode).
+  kIsOsrEntry = 0x00000020u,
 
   //! Block has a terminator (jump, conditional jump, ret).
   kHasTerminator = 0x00000100u,
@@ -161,6 +163,7 @@ public:
   inline bool isTargetable() const noexcept { return hasFlag(RABlockFlags::kIsTargetable); }
   inline bool isAllocated() const noexcept { return hasFlag(RABlockFlags::kIsAllocated); }
   inline bool isFuncExit() const noexcept { return hasFlag(RABlockFlags::kIsFuncExit); }
+  inline bool isOsrEntry() const noexcept { return hasFlag(RABlockFlags::kIsOsrEntry); }
   inline bool hasTerminator() const noexcept { return hasFlag(RABlockFlags::kHasTerminator); }
   inline bool hasConsecutive() const noexcept { return hasFlag(RABlockFlags::kHasConsecutive); }
   inline bool hasJumpTable() const noexcept { return hasFlag(RABlockFlags::kHasJumpTable); }
@@ -647,6 +650,25 @@ public:
   //! \}
 };
 
+//! Location of a tagged work register recorded by the local allocator at a function call.
+struct RAStackMapEntry {
+  //! Work register id.
+  uint32_t workId;
+  //! Physical register that holds the value or \ref RAAssignment::kPhysNone if the value is in its stack slot.
+  uint32_t physId;
+};
+
+//! Stack map of a function call recorded by the local allocator, it's added to \ref CodeHolder after the stack frame
+//! has been finalized, as offsets of stack slots are not known before.
+struct RAStackMap {
+  //! Label bound right after the function call.
+  uint32_t labelId;
+  //! Index of the first entry in `BaseRAPass::_stackMapEntries`.
+  uint32_t entryIndex;
+  //! Number of entries.
+  uint32_t entryCount;
+};
+
 //! Register allocation pass used by `BaseCompiler`.
 class BaseRAPass : public FuncPass {
 public:
@@ -686,6 +708,8 @@ public:
   RABlocks _blocks {};
   //! Function exit blocks (usually one, but can contain more).
   RABlocks _exits {};
+  //! On-stack replacement entry blocks (secondary entries of the function).
+  RABlocks _osrBlocks {};
   //! Post order view (POV).
   RABlocks _pov {};
 
@@ -729,9 +753,19 @@ public:
   RALiveCount _globalMaxLiveCount = RALiveCount();
   //! Global live spans per register group.
   Support::Array<LiveRegSpans*, Globals::kNumVirtGroups> _globalLiveSpans {};
+  //! Positions where instructions require a value in a fixed physical register (such as a shift count in `cl`), per
+  //! register group and physical register. Each span covers a single position and its data is the virtual register.
+  Support::Array<LiveRegSpans*, Globals::kNumVirtGroups> _fixedLiveSpans {};
   //! Temporary stack slot.
   Operand _temporaryMem = Operand();
 
+  //! Tagged work registers, their locations are recorded at each function call, see \ref VirtReg::isTagged().
+  RAWorkRegs _taggedWorkRegs;
+  //! Stack maps recorded by the local allocator.
+  ZoneVector<RAStackMap> _stackMaps;
+  //! Entries of all stack maps in `_stackMaps`.
+  ZoneVector<RAStackMapEntry> _stackMapEntries;
+
   //! Stack pointer.
   BaseReg _sp = BaseReg();
   //! Frame pointer.
@@ -878,6 +912,11 @@ public:
     return _exits.append(allocator(), block);
   }
 
+  inline Error addOsrBlock(RABlock* block) noexcept {
+    block->addFlags(RABlockFlags::kIsOsrEntry);
+    return _osrBlocks.append(allocator(), block);
+  }
+
   ASMJIT_FORCE_INLINE RAInst* newRAInst(RABlock* block, InstRWFlags instRWFlags, RATiedFlags flags, uint32_t tiedRegCount, const RARegMask& clobberedRegs) noexcept {
     void* p = zone()->alloc(RAInst::sizeOf(tiedRegCount));
     if (ASMJIT_UNLIKELY(!p))
@@ -1093,6 +1132,9 @@ public:
   //! Initializes data structures used for global live spans.
   Error initGlobalLiveSpans() noexcept;
 
+  //! Initializes data structures used to track fixed register constraints, see \ref _fixedLiveSpans.
+  Error initFixedLiveSpans() noexcept;
+
   Error binPack(RegGroup group) noexcept;
 
   //! \}
@@ -1110,6 +1152,10 @@ public:
   //! This cannot change the assignment, but can examine it.
   Error blockEntryAssigned(const PhysToWorkMap* physToWorkMap) noexcept;
 
+  //! Records locations of tagged work registers that are live across the function call `invokeNode`, which has been
+  //! just allocated by `lra`, and binds a new label right after the call.
+  Error recordStackMap(RALocalAllocator& lra, InvokeNode* invokeNode) noexcept;
+
   //! \}
 
   //! \name Register Allocation Utilities
@@ -1127,6 +1173,9 @@ public:
   Error _updateStackArgs() noexcept;
   Error insertPrologEpilog() noexcept;
 
+  //! Adds stack maps recorded by \ref recordStackMap() to \ref CodeHolder.
+  Error addStackMaps() noexcept;
+
   //! \}
 
   //! \name Instruction Rewriter
@@ -7,6 +7,7 @@
 #define ASMJIT_CORE_TARGET_H_INCLUDED
 
 #include "../core/archtraits.h"
+#include "../core/cpuinfo.h"
 #include "../core/func.h"
 
 ASMJIT_BEGIN_NAMESPACE
@@ -22,6 +23,8 @@ public:
 
   //! Target environment information.
   Environment _environment;
+  //! Target CPU information.
+  CpuInfo _cpuInfo;
 
   //! \name Construction & Destruction
   //! \{
@@ -43,6 +46,11 @@ public:
   //! Returns the target sub-architecture.
   inline SubArch subArch() const noexcept { return _environment.subArch(); }
 
+  //! Returns target CPU information, which can be passed to \ref BaseCompiler::setTargetCpuInfo().
+  inline const CpuInfo& cpuInfo() const noexcept { return _cpuInfo; }
+  //! Returns target CPU features.
+  inline const CpuFeatures& cpuFeatures() const noexcept { return _cpuInfo.features(); }
+
   //! \}
 };
 
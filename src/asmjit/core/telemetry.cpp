@@ -0,0 +1,194 @@
+// This file is part of AsmJit project <https://asmjit.com>
+//
+// See asmjit.h or LICENSE.md for license and copyright information
+// SPDX-License-Identifier: Zlib
+
+#include "../core/api-build_p.h"
+#include "../core/osutils_p.h"
+#include "../core/string.h"
+#include "../core/support.h"
+#include "../core/telemetry_p.h"
+
+#include <chrono>
+
+ASMJIT_BEGIN_NAMESPACE
+
+// TelemetrySink - Construction & Destruction
+// ==========================================
+
+TelemetrySink::TelemetrySink() noexcept {}
+TelemetrySink::~TelemetrySink() noexcept {}
+
+// TelemetrySink - Interface
+// =========================
+
+void TelemetrySink::onStageBegin(const TelemetryEvent& event) noexcept {
+  DebugUtils::unused(event);
+}
+
+// TelemetrySink - Utilities
+// =========================
+
+uint64_t TelemetrySink::timestamp() noexcept {
+  auto now = std::chrono::steady_clock::now().time_since_epoch();
+  return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+}
+
+static const char telemetryStageNames[] =
+  "RunPasses\0"
+  "RunPass\0"
+  "Serialize\0"
+  "Flatten\0"
+  "ResolveLinks\0"
+  "Relocate\0"
+  "JitAdd\0"
+  "JitAlloc\0"
+  "JitCopy\0"
+  "JitFlush\0"
+  "<Unknown>\0";
+
+static const uint8_t telemetryStageNameIndex[] = {
+  0, 10, 18, 28, 36, 49, 58, 65, 74, 82, 91
+};
+
+static_assert(ASMJIT_ARRAY_SIZE(telemetryStageNameIndex) == uint32_t(TelemetryStage::kMaxValue) + 2,
+              "TelemetryStage: update 'telemetryStageNameIndex' table");
+
+const char* TelemetrySink::stageName(TelemetryStage stage) noexcept {
+  uint32_t index = Support::min<uint32_t>(uint32_t(stage), uint32_t(TelemetryStage::kMaxValue) + 1);
+  return telemetryStageNames + telemetryStageNameIndex[index];
+}
+
+// TelemetryScope - Begin & End
+// ============================
+
+void TelemetryScope::_begin(TelemetryStage stage, const CodeHolder* code, const char* name, uint64_t instCount) noexcept {
+  _event.stage = stage;
+  _event.name = name;
+  _event.code = code;
+  _event.startTime = TelemetrySink::timestamp();
+  _event.endTime = 0;
+  _event.byteCount = 0;
+  _event.instCount = instCount;
+  _sink->onStageBegin(_event);
+}
+
+void TelemetryScope::_end() noexcept {
+  _event.endTime = TelemetrySink::timestamp();
+  _sink->onStageEnd(_event);
+}
+
+// TelemetryAggregator - Construction & Destruction
+// ================================================
+
+TelemetryAggregator::TelemetryAggregator() noexcept {
+  memset(_statistics, 0, sizeof(_statistics));
+}
+
+TelemetryAggregator::~TelemetryAggregator() noexcept {}
+
+void TelemetryAggregator::reset() noexcept {
+  LockGuard guard(_lock);
+  memset(_statistics, 0, sizeof(_statistics));
+}
+
+// TelemetryAggregator - Accessors
+// ===============================
+
+TelemetryAggregator::Statistics TelemetryAggregator::statistics(TelemetryStage stage) const noexcept {
+  ASMJIT_ASSERT(stage <= TelemetryStage::kMaxValue);
+
+  LockGuard guard(_lock);
+  return _statistics[uint32_t(stage)];
+}
+
+// TelemetryAggregator - Formatting
+// ================================
+
+Error TelemetryAggregator::format(String& sb) const noexcept {
+  Statistics statistics[uint32_t(TelemetryStage::kMaxValue) + 1];
+  {
+    LockGuard guard(_lock);
+    memcpy(statistics, _statistics, sizeof(statistics));
+  }
+
+  ASMJIT_PROPAGATE(sb.appendFormat("%-13s %10s %14s %14s %12s %10s\n", "Stage", "Count", "Total [us]", "Max [us]", "Bytes", "Insts"));
+  for (uint32_t i = 0; i <= uint32_t(TelemetryStage::kMaxValue); i++) {
+    const Statistics& s = statistics[i];
+    if (!s.count)
+      continue;
+
+    ASMJIT_PROPAGATE(sb.appendFormat("%-13s %10llu %14.3f %14.3f %12llu %10llu\n",
+      stageName(TelemetryStage(i)),
+      (unsigned long long)s.count,
+      double(s.totalTime) / 1000.0,
+      double(s.maxTime) / 1000.0,
+      (unsigned long long)s.byteCount,
+      (unsigned long long)s.instCount));
+  }
+
+  return kErrorOk;
+}
+
+// TelemetryAggregator - Interface
+// ===============================
+
+void TelemetryAggregator::onStageEnd(const TelemetryEvent& event) noexcept {
+  ASMJIT_ASSERT(event.stage <= TelemetryStage::kMaxValue);
+  uint64_t duration = event.duration();
+
+  LockGuard guard(_lock);
+  Statistics& s = _statistics[uint32_t(event.stage)];
+
+  s.count++;
+  s.totalTime += duration;
+  s.maxTime = Support::max(s.maxTime, duration);
+  s.byteCount += event.byteCount;
+  s.instCount += event.instCount;
+}
+
+// TelemetryAggregator - Tests
+// ===========================
+
+#if defined(ASMJIT_TEST)
+UNIT(telemetry) {
+  INFO("Checking whether TelemetryScope reports events to a sink");
+  TelemetryAggregator aggregator;
+  {
+    TelemetryScope scope(&aggregator, TelemetryStage::kFlatten, nullptr);
+    EXPECT(scope.isActive());
+    scope.setByteCount(64);
+  }
+  {
+    TelemetryScope scope(&aggregator, TelemetryStage::kFlatten, nullptr);
+    scope.setByteCount(32);
+    scope.setInstCount(3);
+  }
+  {
+    TelemetryScope scope(nullptr, TelemetryStage::kFlatten, nullptr);
+    EXPECT(!scope.isActive());
+    scope.setByteCount(1000);
+  }
+
+  TelemetryAggregator::Statistics s = aggregator.statistics(TelemetryStage::kFlatten);
+  EXPECT(s.count == 2u);
+  EXPECT(s.byteCount == 96u);
+  EXPECT(s.instCount == 3u);
+  EXPECT(s.maxTime <= s.totalTime);
+  EXPECT(aggregator.statistics(TelemetryStage::kJitAdd).count == 0u);
+
+  INFO("Checking whether TelemetryAggregator formats stages that ran");
+  String sb;
+  EXPECT(aggregator.format(sb) == kErrorOk);
+  EXPECT(strstr(sb.data(), "Flatten") != nullptr);
+  EXPECT(strstr(sb.data(), "JitAdd") == nullptr);
+
+  for (uint32_t i = 0; i <= uint32_t(TelemetryStage::kMaxValue); i++)
+    EXPECT(strcmp(TelemetrySink::stageName(TelemetryStage(i)), "<Unknown>") != 0);
+
+  aggregator.reset();
+  EXPECT(aggregator.statistics(TelemetryStage::kFlatten).count == 0u);
+}
+#endif
+
+ASMJIT_END_NAMESPACE
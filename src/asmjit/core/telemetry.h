@@ -0,0 +1,197 @@
+// This file is part of AsmJit project <https://asmjit.com>
+//
+// See asmjit.h or LICENSE.md for license and copyright information
+// SPDX-License-Identifier: Zlib
+
+#ifndef ASMJIT_CORE_TELEMETRY_H_INCLUDED
+#define ASMJIT_CORE_TELEMETRY_H_INCLUDED
+
+#include "../core/globals.h"
+#include "../core/osutils.h"
+
+ASMJIT_BEGIN_NAMESPACE
+
+class CodeHolder;
+class String;
+
+//! \addtogroup asmjit_core
+//! \{
+
+//! Stage of code generation reported to \ref TelemetrySink.
+enum class TelemetryStage : uint32_t {
+  //! \ref BaseBuilder::runPasses() - all passes, `instCount` is the number of instructions after the passes ran (the
+  //! begin event provides the number of instructions created by the user).
+  kRunPasses = 0,
+  //! A single pass run by \ref BaseBuilder::runPasses(), \ref TelemetryEvent::name is the name of the pass.
+  kRunPass,
+  //! \ref BaseBuilder::serializeTo() - `instCount` is the number of instructions serialized and `byteCount` the
+  //! number of bytes emitted.
+  kSerialize,
+  //! \ref CodeHolder::flatten() - `byteCount` is the size of the code after flattening.
+  kFlatten,
+  //! \ref CodeHolder::resolveUnresolvedLinks() - `instCount` is the number of links resolved.
+  kResolveLinks,
+  //! \ref CodeHolder::relocateToBase() - `instCount` is the number of relocations and `byteCount` the code size.
+  kRelocate,
+  //! \ref JitRuntime::add() - the whole operation, `byteCount` is the size of the code added.
+  kJitAdd,
+  //! Allocation of executable memory by \ref JitRuntime::add(), `byteCount` is the number of bytes allocated.
+  kJitAlloc,
+  //! Copying the code to executable memory by \ref JitRuntime::add(), `byteCount` is the number of bytes copied.
+  kJitCopy,
+  //! Making the code executable and flushing the instruction cache by \ref JitRuntime::add().
+  kJitFlush,
+
+  //! Maximum value of `TelemetryStage`.
+  kMaxValue = kJitFlush
+};
+
+//! Event passed to \ref TelemetrySink.
+struct TelemetryEvent {
+  //! \name Members
+  //! \{
+
+  //! Stage that began or ended.
+  TelemetryStage stage;
+  //! Name of the pass of \ref TelemetryStage::kRunPass, null otherwise.
+  const char* name;
+  //! Code holder being processed.
+  const CodeHolder* code;
+  //! Timestamp of the beginning of the stage, see \ref TelemetrySink::timestamp().
+  uint64_t startTime;
+  //! Timestamp of the end of the stage, zero in \ref TelemetrySink::onStageBegin().
+  uint64_t endTime;
+  //! Number of bytes processed by the stage, see \ref TelemetryStage.
+  uint64_t byteCount;
+  //! Number of instructions (or other items) processed by the stage, see \ref TelemetryStage.
+  uint64_t instCount;
+
+  //! \}
+
+  //! \name Accessors
+  //! \{
+
+  //! Returns the duration of the stage in nanoseconds (only valid in \ref TelemetrySink::onStageEnd()).
+  inline uint64_t duration() const noexcept { return endTime - startTime; }
+
+  //! \}
+};
+
+//! Telemetry sink.
+//!
+//! A sink can be attached to \ref CodeHolder (see \ref CodeHolder::setTelemetrySink()) and to \ref JitRuntime (see
+//! \ref JitRuntime::setTelemetrySink()) to receive an event at the beginning and at the end of each stage listed
+//! by \ref TelemetryStage, which makes it possible to find out where the time of a compilation is spent in
+//! production. Stages of \ref CodeHolder run by \ref JitRuntime::add() are reported to the sink of the runtime if
+//! the `CodeHolder` has no sink.
+//!
+//! Nothing is measured if no sink is attached. A sink attached to a \ref JitRuntime must be thread-safe if the
+//! runtime is used by multiple threads, \ref TelemetryAggregator is.
+class ASMJIT_VIRTAPI TelemetrySink {
+public:
+  ASMJIT_BASE_CLASS(TelemetrySink)
+
+  //! \name Construction & Destruction
+  //! \{
+
+  //! Creates a new `TelemetrySink` instance.
+  ASMJIT_API TelemetrySink() noexcept;
+  //! Destroys the `TelemetrySink` instance.
+  ASMJIT_API virtual ~TelemetrySink() noexcept;
+
+  //! \}
+
+  //! \name Interface
+  //! \{
+
+  //! Called at the beginning of a stage, counts of `event` are only provided by \ref TelemetryStage::kRunPasses.
+  ASMJIT_API virtual void onStageBegin(const TelemetryEvent& event) noexcept;
+  //! Called at the end of a stage.
+  virtual void onStageEnd(const TelemetryEvent& event) noexcept = 0;
+
+  //! \}
+
+  //! \name Utilities
+  //! \{
+
+  //! Returns a monotonic timestamp in nanoseconds, which is used by all events.
+  static ASMJIT_API uint64_t timestamp() noexcept;
+
+  //! Returns the name of the given telemetry `stage`.
+  static ASMJIT_API const char* stageName(TelemetryStage stage) noexcept;
+
+  //! \}
+};
+
+//! Telemetry sink that aggregates events of each \ref TelemetryStage - the number of runs, total and maximum time,
+//! and the number of bytes and instructions processed. It's thread-safe.
+class ASMJIT_VIRTAPI TelemetryAggregator : public TelemetrySink {
+public:
+  ASMJIT_NONCOPYABLE(TelemetryAggregator)
+
+  //! Statistics of a single stage.
+  struct Statistics {
+    //! Number of times the stage ran.
+    uint64_t count;
+    //! Total time spent in the stage in nanoseconds.
+    uint64_t totalTime;
+    //! Maximum time spent in a single run of the stage in nanoseconds.
+    uint64_t maxTime;
+    //! Total number of bytes processed by the stage.
+    uint64_t byteCount;
+    //! Total number of instructions processed by the stage.
+    uint64_t instCount;
+  };
+
+  //! \name Members
+  //! \{
+
+  //! Lock that synchronizes events reported by multiple threads.
+  mutable Lock _lock;
+  //! Statistics of all stages.
+  Statistics _statistics[uint32_t(TelemetryStage::kMaxValue) + 1];
+
+  //! \}
+
+  //! \name Construction & Destruction
+  //! \{
+
+  //! Creates a new `TelemetryAggregator` instance.
+  ASMJIT_API TelemetryAggregator() noexcept;
+  //! Destroys the `TelemetryAggregator` instance.
+  ASMJIT_API virtual ~TelemetryAggregator() noexcept;
+
+  //! Resets all statistics.
+  ASMJIT_API void reset() noexcept;
+
+  //! \}
+
+  //! \name Accessors
+  //! \{
+
+  //! Returns statistics of the given `stage`.
+  ASMJIT_API Statistics statistics(TelemetryStage stage) const noexcept;
+
+  //! \}
+
+  //! \name Formatting
+  //! \{
+
+  //! Appends a table with statistics of all stages that ran at least once to `sb`.
+  ASMJIT_API Error format(String& sb) const noexcept;
+
+  //! \}
+
+  //! \name Interface
+  //! \{
+
+  ASMJIT_API void onStageEnd(const TelemetryEvent& event) noexcept override;
+
+  //! \}
+};
+
+//! \}
+
+ASMJIT_END_NAMESPACE
+
+#endif // ASMJIT_CORE_TELEMETRY_H_INCLUDED
@@ -0,0 +1,52 @@
+// This file is part of AsmJit project <https://asmjit.com>
+//
+// See asmjit.h or LICENSE.md for license and copyright information
+// SPDX-License-Identifier: Zlib
+
+#ifndef ASMJIT_CORE_TELEMETRY_P_H_INCLUDED
+#define ASMJIT_CORE_TELEMETRY_P_H_INCLUDED
+
+#include "../core/telemetry.h"
+
+ASMJIT_BEGIN_NAMESPACE
+
+//! \cond INTERNAL
+//! \addtogroup asmjit_core
+//! \{
+
+//! Reports a single stage to a \ref TelemetrySink - the begin event is reported by the constructor and the end event
+//! by the destructor. Does nothing if the sink is null, in which case the counts are ignored, so they should only be
+//! calculated if the scope \ref isActive().
+class TelemetryScope {
+public:
+  ASMJIT_NONCOPYABLE(TelemetryScope)
+
+  TelemetrySink* _sink;
+  TelemetryEvent _event;
+
+  ASMJIT_FORCE_INLINE TelemetryScope(TelemetrySink* sink, TelemetryStage stage, const CodeHolder* code, const char* name = nullptr, uint64_t instCount = 0) noexcept
+    : _sink(sink) {
+    if (ASMJIT_UNLIKELY(sink))
+      _begin(stage, code, name, instCount);
+  }
+
+  ASMJIT_FORCE_INLINE ~TelemetryScope() noexcept {
+    if (ASMJIT_UNLIKELY(_sink))
+      _end();
+  }
+
+  inline bool isActive() const noexcept { return _sink != nullptr; }
+
+  inline void setByteCount(uint64_t byteCount) noexcept { _event.byteCount = byteCount; }
+  inline void setInstCount(uint64_t instCount) noexcept { _event.instCount = instCount; }
+
+  void _begin(TelemetryStage stage, const CodeHolder* code, const char* name, uint64_t instCount) noexcept;
+  void _end() noexcept;
+};
+
+//! \}
+//! \endcond
+
+ASMJIT_END_NAMESPACE
+
+#endif // ASMJIT_CORE_TELEMETRY_P_H_INCLUDED
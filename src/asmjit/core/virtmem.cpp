@@ -63,6 +63,24 @@
   #define ASMJIT_HAS_PTHREAD_JIT_WRITE_PROTECT_NP
 #endif
 
+// Linux 4.17+ provides `MAP_FIXED_NOREPLACE`, which makes `mmap()` fail instead of placing the mapping elsewhere when
+// the address hint cannot be honored. Older kernels ignore the flag, which is fine as the hint is verified anyway.
+#if defined(MAP_FIXED_NOREPLACE)
+  #define ASMJIT_VM_MAP_NOREPLACE MAP_FIXED_NOREPLACE
+#else
+  #define ASMJIT_VM_MAP_NOREPLACE 0
+#endif
+
+// Linux 4.9+ provides memory protection keys (pkeys) on X86 hardware that supports them. The PKRU register is accessed
+// directly (by using opcodes as the assembler may not know RDPKRU/WRPKRU) to make switching write access of JIT memory
+// a user-space operation that doesn't require a syscall.
+#if defined(__linux__) && ASMJIT_ARCH_X86 && (defined(__GNUC__) || defined(__clang__)) && \
+    defined(__NR_pkey_alloc) && defined(__NR_pkey_free) && defined(__NR_pkey_mprotect)
+  #define ASMJIT_VM_PKEYS_AVAILABLE 1
+#else
+  #define ASMJIT_VM_PKEYS_AVAILABLE 0
+#endif
+
 ASMJIT_BEGIN_SUB_NAMESPACE(VirtMem)
 
 // Virtual Memory Utilities
@@ -73,6 +91,58 @@ static const MemoryFlags dualMappingFilter[2] = {
   MemoryFlags::kAccessExecute | MemoryFlags::kMMapMaxAccessExecute
 };
 
+// Probes address hints around `range.anchor` and returns the first mapping that is within `range`. The `tryAlloc`
+// function maps memory at the given hint and returns null on failure; the hint is only advisory on some platforms,
+// so mappings that were placed outside of the range are released by `releaseFunc` and the search continues.
+//
+// Hints are generated on both sides of the anchor. The distance grows linearly at first (to fill the space that is
+// directly adjacent to the anchor, which is the most valuable) and then geometrically to keep the number of probes
+// (syscalls) small even when the area around the anchor is crowded.
+template<typename TryAllocFunc, typename ReleaseFunc>
+static void* allocNearProbe(size_t size, const NearRange& range, size_t granularity, const TryAllocFunc& tryAlloc, const ReleaseFunc& releaseFunc) noexcept {
+  constexpr uintptr_t kMaxAddress = std::numeric_limits<uintptr_t>::max();
+
+  uintptr_t anchor = uintptr_t(range.anchor);
+  uintptr_t lo = anchor >= granularity && anchor - granularity > range.maxDistance ? anchor - range.maxDistance : uintptr_t(granularity);
+  uintptr_t hi = kMaxAddress - anchor > range.maxDistance ? anchor + range.maxDistance : kMaxAddress;
+
+  lo = Support::alignUp(lo, granularity);
+  hi = Support::alignDown(hi, granularity);
+  anchor = Support::alignDown(anchor, granularity);
+
+  size_t step = Support::alignUp(size, granularity);
+  if (ASMJIT_UNLIKELY(step < size || anchor < lo || anchor > hi))
+    return nullptr;
+
+  for (size_t distance = 0;; distance += Support::max(step, distance >> 2)) {
+    uintptr_t candidates[2];
+    uint32_t candidateCount = 0;
+
+    // Below the anchor - the whole mapping must end before the anchor.
+    if (anchor - lo >= distance + step)
+      candidates[candidateCount++] = anchor - distance - step;
+
+    // Above the anchor - skip the page the anchor points to as it's always mapped.
+    if (hi - anchor >= distance + step * 2)
+      candidates[candidateCount++] = anchor + distance + step;
+
+    if (!candidateCount)
+      return nullptr;
+
+    for (uint32_t i = 0; i < candidateCount; i++) {
+      void* ptr = tryAlloc(candidates[i]);
+      if (!ptr)
+        continue;
+
+      uintptr_t p = uintptr_t(ptr);
+      if (p >= lo && p <= hi && hi - p >= size)
+        return ptr;
+
+      releaseFunc(ptr);
+    }
+  }
+}
+
 // Virtual Memory [Windows]
 // ========================
 
@@ -157,7 +227,39 @@ Error protect(void* p, size_t size, MemoryFlags memoryFlags) noexcept {
   return DebugUtils::errored(kErrorInvalidArgument);
 }
 
-Error allocDualMapping(DualMapping* dm, size_t size, MemoryFlags memoryFlags) noexcept {
+Error decommit(void* p, size_t size) noexcept {
+  if (ASMJIT_UNLIKELY(!::VirtualFree(p, size, MEM_DECOMMIT)))
+    return DebugUtils::errored(kErrorInvalidArgument);
+
+  return kErrorOk;
+}
+
+Error recommit(void* p, size_t size, MemoryFlags memoryFlags) noexcept {
+  DWORD protectFlags = protectFlagsFromMemoryFlags(memoryFlags);
+  if (ASMJIT_UNLIKELY(!::VirtualAlloc(p, size, MEM_COMMIT, protectFlags)))
+    return DebugUtils::errored(kErrorOutOfMemory);
+
+  return kErrorOk;
+}
+
+Error allocNear(void** p, size_t size, MemoryFlags memoryFlags, const NearRange& range) noexcept {
+  *p = nullptr;
+  if (size == 0)
+    return DebugUtils::errored(kErrorInvalidArgument);
+
+  DWORD protectFlags = protectFlagsFromMemoryFlags(memoryFlags);
+  void* result = allocNearProbe(size, range, info().pageGranularity,
+    [&](uintptr_t hint) noexcept { return ::VirtualAlloc((void*)hint, size, MEM_COMMIT | MEM_RESERVE, protectFlags); },
+    [&](void* ptr) noexcept { ::VirtualFree(ptr, 0, MEM_RELEASE); });
+
+  if (!result)
+    return DebugUtils::errored(kErrorOutOfMemory);
+
+  *p = result;
+  return kErrorOk;
+}
+
+static Error allocDualMappingInternal(DualMapping* dm, size_t size, MemoryFlags memoryFlags, const NearRange* range) noexcept {
   dm->rx = nullptr;
   dm->rw = nullptr;
 
@@ -180,7 +282,16 @@ Error allocDualMapping(DualMapping* dm, size_t size, MemoryFlags memoryFlags) no
   for (uint32_t i = 0; i < 2; i++) {
     MemoryFlags accessFlags = memoryFlags & ~dualMappingFilter[i];
     DWORD desiredAccess = desiredAccessFromMemoryFlags(accessFlags);
-    ptr[i] = ::MapViewOfFile(handle.value, desiredAccess, 0, 0, size);
+
+    // Only the RX view has to be placed near the anchor, if specified.
+    if (i == 0 && range) {
+      ptr[i] = allocNearProbe(size, *range, info().pageGranularity,
+        [&](uintptr_t hint) noexcept { return ::MapViewOfFileEx(handle.value, desiredAccess, 0, 0, size, (void*)hint); },
+        [&](void* p) noexcept { ::UnmapViewOfFile(p); });
+    }
+    else {
+      ptr[i] = ::MapViewOfFile(handle.value, desiredAccess, 0, 0, size);
+    }
 
     if (ptr[i] == nullptr) {
       if (i == 0)
@@ -194,6 +305,14 @@ Error allocDualMapping(DualMapping* dm, size_t size, MemoryFlags memoryFlags) no
   return kErrorOk;
 }
 
+Error allocDualMapping(DualMapping* dm, size_t size, MemoryFlags memoryFlags) noexcept {
+  return allocDualMappingInternal(dm, size, memoryFlags, nullptr);
+}
+
+Error allocDualMappingNear(DualMapping* dm, size_t size, MemoryFlags memoryFlags, const NearRange& range) noexcept {
+  return allocDualMappingInternal(dm, size, memoryFlags, &range);
+}
+
 Error releaseDualMapping(DualMapping* dm, size_t size) noexcept {
   DebugUtils::unused(size);
   bool failed = false;
@@ -591,6 +710,28 @@ Error alloc(void** p, size_t size, MemoryFlags memoryFlags) noexcept {
   return kErrorOk;
 }
 
+Error allocNear(void** p, size_t size, MemoryFlags memoryFlags, const NearRange& range) noexcept {
+  *p = nullptr;
+  if (size == 0)
+    return DebugUtils::errored(kErrorInvalidArgument);
+
+  int protection = mmProtFromMemoryFlags(memoryFlags) | mmMaxProtFromMemoryFlags(memoryFlags);
+  int mmFlags = MAP_PRIVATE | MAP_ANONYMOUS | mmMapJitFromMemoryFlags(memoryFlags) | ASMJIT_VM_MAP_NOREPLACE;
+
+  void* ptr = allocNearProbe(size, range, info().pageGranularity,
+    [&](uintptr_t hint) noexcept -> void* {
+      void* result = mmap((void*)hint, size, protection, mmFlags, -1, 0);
+      return result != MAP_FAILED ? result : nullptr;
+    },
+    [&](void* result) noexcept { munmap(result, size); });
+
+  if (!ptr)
+    return DebugUtils::errored(kErrorOutOfMemory);
+
+  *p = ptr;
+  return kErrorOk;
+}
+
 Error release(void* p, size_t size) noexcept {
   if (ASMJIT_UNLIKELY(munmap(p, size) != 0))
     return DebugUtils::errored(kErrorInvalidArgument);
@@ -607,7 +748,27 @@ Error protect(void* p, size_t size, MemoryFlags memoryFlags) noexcept {
   return DebugUtils::errored(kErrorInvalidArgument);
 }
 
-Error allocDualMapping(DualMapping* dm, size_t size, MemoryFlags memoryFlags) noexcept {
+Error decommit(void* p, size_t size) noexcept {
+  // Linux frees the pages immediately with MADV_DONTNEED, other systems may keep them resident (MADV_FREE is the
+  // preferred way to tell them that the content of the pages is no longer needed).
+#if !defined(__linux__) && defined(MADV_FREE)
+  int advice = MADV_FREE;
+#else
+  int advice = MADV_DONTNEED;
+#endif
+
+  if (ASMJIT_UNLIKELY(madvise(p, size, advice) != 0))
+    return DebugUtils::errored(kErrorInvalidArgument);
+
+  return kErrorOk;
+}
+
+Error recommit(void* p, size_t size, MemoryFlags memoryFlags) noexcept {
+  DebugUtils::unused(p, size, memoryFlags);
+  return kErrorOk;
+}
+
+static Error allocDualMappingInternal(DualMapping* dm, size_t size, MemoryFlags memoryFlags, const NearRange* range) noexcept {
   dm->rx = nullptr;
   dm->rw = nullptr;
 
@@ -630,6 +791,20 @@ Error allocDualMapping(DualMapping* dm, size_t size, MemoryFlags memoryFlags) no
     MemoryFlags accessFlags = memoryFlags & ~dualMappingFilter[i];
     int protection = mmProtFromMemoryFlags(accessFlags) | mmMaxProtFromMemoryFlags(accessFlags);
 
+    // Only the RX view has to be placed near the anchor, if specified.
+    if (i == 0 && range) {
+      ptr[i] = allocNearProbe(size, *range, info().pageGranularity,
+        [&](uintptr_t hint) noexcept -> void* {
+          void* result = mmap((void*)hint, size, protection, MAP_SHARED | ASMJIT_VM_MAP_NOREPLACE, anonMem.fd(), 0);
+          return result != MAP_FAILED ? result : nullptr;
+        },
+        [&](void* result) noexcept { munmap(result, size); });
+
+      if (!ptr[i])
+        return DebugUtils::errored(kErrorOutOfMemory);
+      continue;
+    }
+
     ptr[i] = mmap(nullptr, size, protection, MAP_SHARED, anonMem.fd(), 0);
     if (ptr[i] == MAP_FAILED) {
       // Get the error now before `munmap()` has a chance to clobber it.
@@ -645,6 +820,14 @@ Error allocDualMapping(DualMapping* dm, size_t size, MemoryFlags memoryFlags) no
   return kErrorOk;
 }
 
+Error allocDualMapping(DualMapping* dm, size_t size, MemoryFlags memoryFlags) noexcept {
+  return allocDualMappingInternal(dm, size, memoryFlags, nullptr);
+}
+
+Error allocDualMappingNear(DualMapping* dm, size_t size, MemoryFlags memoryFlags, const NearRange& range) noexcept {
+  return allocDualMappingInternal(dm, size, memoryFlags, &range);
+}
+
 Error releaseDualMapping(DualMapping* dm, size_t size) noexcept {
   Error err = release(dm->rx, size);
   if (dm->rx != dm->rw)
@@ -706,12 +889,148 @@ HardenedRuntimeInfo hardenedRuntimeInfo() noexcept {
   return HardenedRuntimeInfo { getHardenedRuntimeFlags() };
 }
 
+// Virtual Memory - Protection Keys
+// ================================
+
+#if ASMJIT_VM_PKEYS_AVAILABLE
+// Access rights used by `pkey_alloc()` - not provided by older C libraries.
+static constexpr unsigned kPKeyDisableWrite = 0x2u;
+
+// Maximum number of protection keys supported by PKRU register.
+static constexpr uint32_t kPKeyMaxCount = 16;
+
+// Mask of PKRU bits that belong to protection keys allocated by `allocProtectionKey()`. Each key `k` uses bits `2k`
+// (access disable) and `2k + 1` (write disable) of PKRU register.
+static std::atomic<uint32_t> jitPKRUMask;
+
+static ASMJIT_FORCE_INLINE uint32_t readPKRU() noexcept {
+  uint32_t eax, edx;
+  __asm__ __volatile__(".byte 0x0F, 0x01, 0xEE" : "=a"(eax), "=d"(edx) : "c"(0));
+  return eax;
+}
+
+static ASMJIT_FORCE_INLINE void writePKRU(uint32_t pkru) noexcept {
+  __asm__ __volatile__(".byte 0x0F, 0x01, 0xEF" : : "a"(pkru), "c"(0), "d"(0) : "memory");
+}
+
+// Returns the number of threads of the process read from `/proc/self/status`, or zero if it cannot be determined.
+static uint32_t getProcessThreadCount() noexcept {
+  int fd = ::open("/proc/self/status", O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return 0;
+
+  char buf[4096];
+  size_t size = 0;
+
+  for (;;) {
+    ssize_t n = ::read(fd, buf + size, sizeof(buf) - 1 - size);
+    if (n <= 0)
+      break;
+    size += size_t(n);
+    if (size == sizeof(buf) - 1)
+      break;
+  }
+  ::close(fd);
+  buf[size] = '\0';
+
+  const char* p = strstr(buf, "\nThreads:");
+  if (!p)
+    return 0;
+
+  p += 9;
+  while (*p == ' ' || *p == '\t')
+    p++;
+
+  uint32_t count = 0;
+  while (*p >= '0' && *p <= '9')
+    count = count * 10u + uint32_t(*p++ - '0');
+  return count;
+}
+#endif
+
+Error allocProtectionKey(uint32_t* keyOut) noexcept {
+  *keyOut = 0;
+
+#if ASMJIT_VM_PKEYS_AVAILABLE
+  // `pkey_alloc()` only grants access rights to the calling thread, other threads that already exist would not be
+  // able to even read memory tagged by the key, which JIT code does when it accesses its constants and address tables.
+  // Threads inherit PKRU of the thread that creates them, so if the calling thread is the only thread of the process,
+  // all threads that will ever run the code will have read access.
+  if (getProcessThreadCount() != 1)
+    return DebugUtils::errored(kErrorInvalidState);
+
+  // Write access is disabled in the calling thread by default, the same way as `protectJitMemory()` does.
+  long key = syscall(__NR_pkey_alloc, 0u, kPKeyDisableWrite);
+  if (key < 0) {
+    // ENOSPC means that all keys are already allocated, other errors mean that pkeys are not supported.
+    if (errno == ENOSPC)
+      return DebugUtils::errored(kErrorTooManyHandles);
+    return DebugUtils::errored(kErrorFeatureNotEnabled);
+  }
+
+  if (ASMJIT_UNLIKELY(uint64_t(key) >= kPKeyMaxCount)) {
+    syscall(__NR_pkey_free, key);
+    return DebugUtils::errored(kErrorFeatureNotEnabled);
+  }
+
+  jitPKRUMask.fetch_or(3u << (uint32_t(key) * 2u));
+  *keyOut = uint32_t(key);
+  return kErrorOk;
+#else
+  return DebugUtils::errored(kErrorFeatureNotEnabled);
+#endif
+}
+
+Error releaseProtectionKey(uint32_t key) noexcept {
+#if ASMJIT_VM_PKEYS_AVAILABLE
+  if (ASMJIT_UNLIKELY(key >= kPKeyMaxCount))
+    return DebugUtils::errored(kErrorInvalidArgument);
+
+  jitPKRUMask.fetch_and(~(3u << (key * 2u)));
+  if (syscall(__NR_pkey_free, long(key)) != 0)
+    return DebugUtils::errored(kErrorInvalidArgument);
+
+  return kErrorOk;
+#else
+  DebugUtils::unused(key);
+  return DebugUtils::errored(kErrorFeatureNotEnabled);
+#endif
+}
+
+Error protectWithKey(void* p, size_t size, MemoryFlags memoryFlags, uint32_t key) noexcept {
+#if ASMJIT_VM_PKEYS_AVAILABLE
+  int protection = mmProtFromMemoryFlags(memoryFlags);
+  if (syscall(__NR_pkey_mprotect, p, size, long(protection), long(key)) == 0)
+    return kErrorOk;
+
+  return DebugUtils::errored(kErrorInvalidArgument);
+#else
+  DebugUtils::unused(p, size, memoryFlags, key);
+  return DebugUtils::errored(kErrorFeatureNotEnabled);
+#endif
+}
+
 // Virtual Memory - Project JIT Memory
 // ===================================
 
 void protectJitMemory(ProtectJitAccess access) noexcept {
 #if defined(ASMJIT_HAS_PTHREAD_JIT_WRITE_PROTECT_NP)
   pthread_jit_write_protect_np(static_cast<uint32_t>(access));
+#elif ASMJIT_VM_PKEYS_AVAILABLE
+  // Nothing to do if no protection key has been allocated, which also guarantees that PKRU is never accessed on
+  // hardware that doesn't support it.
+  uint32_t keyMask = jitPKRUMask.load(std::memory_order_relaxed);
+  if (keyMask) {
+    uint32_t pkru = readPKRU();
+    uint32_t newPkru = pkru & ~keyMask;
+
+    // Keep read access (only odd bits are write-disable bits) so data embedded in JIT code can always be accessed.
+    if (access == ProtectJitAccess::kReadExecute)
+      newPkru |= keyMask & 0xAAAAAAAAu;
+
+    if (newPkru != pkru)
+      writePKRU(newPkru);
+  }
 #else
   DebugUtils::unused(access);
 #endif
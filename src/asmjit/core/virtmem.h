@@ -122,6 +122,21 @@ ASMJIT_API Error release(void* p, size_t size) noexcept;
 //! A cross-platform wrapper around `mprotect()` (POSIX) and `VirtualProtect()` (Windows).
 ASMJIT_API Error protect(void* p, size_t size, MemoryFlags flags) noexcept;
 
+//! Decommits pages of virtual memory previously allocated by \ref VirtMem::alloc() without releasing the address range.
+//!
+//! Physical memory backing the pages is returned to the operating system by using `madvise()` (POSIX) or
+//! `VirtualFree(MEM_DECOMMIT)` (Windows). The content of decommitted pages is undefined and the pages must be
+//! recommitted by \ref VirtMem::recommit() before they are accessed again.
+//!
+//! \note `p` and `size` must be aligned to page size. The function cannot be used with memory allocated by
+//! \ref VirtMem::allocDualMapping().
+ASMJIT_API Error decommit(void* p, size_t size) noexcept;
+
+//! Recommits pages previously decommitted by \ref VirtMem::decommit() with the given access `flags`.
+//!
+//! \note This is a no-op on POSIX platforms as pages are committed on the first access.
+ASMJIT_API Error recommit(void* p, size_t size, MemoryFlags flags) noexcept;
+
 //! Dual memory mapping used to map an anonymous memory into two memory regions where one region is read-only, but
 //! executable, and the second region is read+write, but not executable. See \ref VirtMem::allocDualMapping() for
 //! more details.
@@ -149,6 +164,29 @@ ASMJIT_API Error allocDualMapping(DualMapping* dm, size_t size, MemoryFlags flag
 //! \remarks Both pointers in `dm` would be set to `nullptr` if the function succeeds.
 ASMJIT_API Error releaseDualMapping(DualMapping* dm, size_t size) noexcept;
 
+//! Address range used to place virtual memory near a given anchor, see \ref VirtMem::allocNear().
+struct NearRange {
+  //! Anchor address (for example an address of a function in the host executable).
+  const void* anchor;
+  //! Maximum distance (in bytes) of any byte of the allocated memory from `anchor`.
+  size_t maxDistance;
+};
+
+//! Allocates virtual memory like \ref VirtMem::alloc(), but places it within `range`.
+//!
+//! The implementation probes free address ranges close to `range.anchor` by passing address hints to `mmap()`
+//! (POSIX) or `VirtualAlloc()` (Windows). It's intended to place JIT code within a reach of a 32-bit relative
+//! displacement (`call rel32` on X86_64) from functions of the host executable.
+//!
+//! Returns \ref kErrorOutOfMemory if no suitable address range was found.
+ASMJIT_API Error allocNear(void** p, size_t size, MemoryFlags flags, const NearRange& range) noexcept;
+
+//! Allocates a dual mapping like \ref VirtMem::allocDualMapping(), but places the RX view within `range`.
+//!
+//! The RW view can be placed anywhere as the code never executes from it. Use \ref VirtMem::releaseDualMapping()
+//! to release the mapping.
+ASMJIT_API Error allocDualMappingNear(DualMapping* dm, size_t size, MemoryFlags flags, const NearRange& range) noexcept;
+
 //! Hardened runtime flags.
 enum class HardenedRuntimeFlags : uint32_t {
   //! No flags.
@@ -177,6 +215,33 @@ struct HardenedRuntimeInfo {
 //! Returns runtime features provided by the OS.
 ASMJIT_API HardenedRuntimeInfo hardenedRuntimeInfo() noexcept;
 
+//! Allocates a memory protection key that can be used to tag JIT memory by \ref VirtMem::protectWithKey().
+//!
+//! Memory protection keys (pkeys) are only supported on Linux running on X86 hardware that provides them. Memory
+//! tagged by a key allocated by this function is write-protected per thread by \ref VirtMem::protectJitMemory(),
+//! which only writes a thread-local register and doesn't need a syscall like `mprotect()`, which takes a process
+//! wide lock and causes a TLB shootdown on all CPUs that run threads of the process.
+//!
+//! Write access to memory tagged by the key is disabled in the calling thread and read access is granted to it.
+//! The kernel only sets the access rights of the calling thread - threads that already exist would not be able to
+//! even read the memory, which the code does when it accesses its embedded data. Threads inherit the access rights of
+//! the thread that creates them, thus a key can only be allocated when the calling thread is the only thread of the
+//! process, which guarantees that every thread that will run the code has read access to it.
+//!
+//! Returns \ref kErrorFeatureNotEnabled if protection keys are not supported, \ref kErrorInvalidState if the process
+//! has more than one thread, and \ref kErrorTooManyHandles if all keys have been already allocated (there are only
+//! 15 keys available to user-space on X86).
+ASMJIT_API Error allocProtectionKey(uint32_t* keyOut) noexcept;
+
+//! Releases a protection key previously allocated by \ref VirtMem::allocProtectionKey().
+//!
+//! \note The memory tagged by the key must be released before the key itself.
+ASMJIT_API Error releaseProtectionKey(uint32_t key) noexcept;
+
+//! A wrapper around `pkey_mprotect()` - like \ref VirtMem::protect(), but also tags the memory by a protection `key`
+//! allocated by \ref VirtMem::allocProtectionKey().
+ASMJIT_API Error protectWithKey(void* p, size_t size, MemoryFlags flags, uint32_t key) noexcept;
+
 //! Values that can be used with `protectJitMemory()` function.
 enum class ProtectJitAccess : uint32_t {
   //! Protect JIT memory with Read+Write permissions.
@@ -188,7 +253,14 @@ enum class ProtectJitAccess : uint32_t {
 //! Protects access of memory mapped with MAP_JIT flag for the current thread.
 //!
 //! \note This feature is only available on Apple hardware (AArch64) at the moment and and uses a non-portable
-//! `pthread_jit_write_protect_np()` call when available.
+//! `pthread_jit_write_protect_np()` call when available. On Linux it switches write access of memory tagged by
+//! protection keys allocated by \ref VirtMem::allocProtectionKey() (if any) by writing PKRU register.
+//!
+//! \note Linux enters signal handlers with PKRU set to its default value, which disables any access to memory tagged
+//! by protection keys, and restores PKRU of the interrupted thread when the handler returns. On Linux this function
+//! doesn't allocate, lock, or call into the kernel, so it's async-signal-safe. A signal handler that executes JIT code
+//! (which reads data embedded in it) or writes to JIT memory must call it first - `ProtectJitAccess::kReadExecute`
+//! restores read access and `ProtectJitAccess::kReadWrite` enables writing as well.
 //!
 //! This function must be called before and after a memory mapped with MAP_JIT flag is modified. Example:
 //!
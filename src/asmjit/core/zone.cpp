@@ -32,6 +32,7 @@ void Zone::_init(size_t blockSize, size_t blockAlignment, const Support::Tempora
   _blockSize = blockSize & kBlockSizeMask;
   _isTemporary = temporary != nullptr;
   _blockAlignmentShift = Support::ctz(blockAlignment) & kBlockAlignmentShiftMask;
+  _memAllocator = MemAllocator::host();
 
   // Setup the first [temporary] block, if necessary.
   if (temporary) {
@@ -74,14 +75,14 @@ void Zone::reset(ResetPolicy resetPolicy) noexcept {
         break;
       }
 
-      ::free(cur);
+      _memAllocator->release(cur, cur->size + kBlockSize, Globals::kAllocAlignment);
       cur = prev;
     } while (cur);
 
     cur = next;
     while (cur) {
       next = cur->next;
-      ::free(cur);
+      _memAllocator->release(cur, cur->size + kBlockSize, Globals::kAllocAlignment);
       cur = next;
     }
   }
@@ -92,6 +93,18 @@ void Zone::reset(ResetPolicy resetPolicy) noexcept {
   }
 }
 
+void Zone::setMemAllocator(MemAllocator* memAllocator) noexcept {
+  if (!memAllocator)
+    memAllocator = MemAllocator::host();
+
+  // Blocks kept by the previous allocator are only released if the allocator really changes.
+  if (memAllocator == _memAllocator)
+    return;
+
+  reset(ResetPolicy::kHard);
+  _memAllocator = memAllocator;
+}
+
 // Zone - Alloc
 // ============
 
@@ -127,7 +140,7 @@ void* Zone::_alloc(size_t size, size_t alignment) noexcept {
   // Allocate new block - we add alignment overhead to `newSize`, which becomes the new block size, and we also add
   // `kBlockOverhead` to the allocator as it includes members of `Zone::Block` structure.
   newSize += blockAlignmentOverhead;
-  Block* newBlock = static_cast<Block*>(::malloc(newSize + kBlockSize));
+  Block* newBlock = static_cast<Block*>(_memAllocator->alloc(newSize + kBlockSize, Globals::kAllocAlignment));
 
   if (ASMJIT_UNLIKELY(!newBlock))
     return nullptr;
@@ -223,7 +236,7 @@ void ZoneAllocator::reset(Zone* zone) noexcept {
   DynamicBlock* block = _dynamicBlocks;
   while (block) {
     DynamicBlock* next = block->next;
-    ::free(block);
+    _zone->memAllocator()->release(block, block->size, Globals::kAllocAlignment);
     block = next;
   }
 
@@ -292,7 +305,7 @@ void* ZoneAllocator::_alloc(size_t size, size_t& allocatedSize) noexcept {
     if (ASMJIT_UNLIKELY(kBlockOverhead >= SIZE_MAX - size))
       return nullptr;
 
-    void* p = ::malloc(size + kBlockOverhead);
+    void* p = _zone->memAllocator()->alloc(size + kBlockOverhead, Globals::kAllocAlignment);
     if (ASMJIT_UNLIKELY(!p)) {
       allocatedSize = 0;
       return nullptr;
@@ -307,6 +320,7 @@ void* ZoneAllocator::_alloc(size_t size, size_t& allocatedSize) noexcept {
 
     block->prev = nullptr;
     block->next = next;
+    block->size = size + kBlockOverhead;
     _dynamicBlocks = block;
 
     // Align the pointer to the guaranteed alignment and store `DynamicBlock`
@@ -347,7 +361,7 @@ void ZoneAllocator::_releaseDynamic(void* p, size_t size) noexcept {
   if (next)
     next->prev = prev;
 
-  ::free(block);
+  _zone->memAllocator()->release(block, block->size, Globals::kAllocAlignment);
 }
 
 ASMJIT_END_NAMESPACE
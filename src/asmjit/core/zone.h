@@ -6,6 +6,7 @@
 #ifndef ASMJIT_CORE_ZONE_H_INCLUDED
 #define ASMJIT_CORE_ZONE_H_INCLUDED
 
+#include "../core/memallocator.h"
 #include "../core/support.h"
 
 ASMJIT_BEGIN_NAMESPACE
@@ -70,6 +71,9 @@ public:
     size_t _packedData;
   };
 
+  //! Allocator of blocks.
+  MemAllocator* _memAllocator;
+
   static ASMJIT_API const Block _zeroBlock;
 
   //! \endcond
@@ -107,7 +111,8 @@ public:
     : _ptr(other._ptr),
       _end(other._end),
       _block(other._block),
-      _packedData(other._packedData) {
+      _packedData(other._packedData),
+      _memAllocator(other._memAllocator) {
     ASMJIT_ASSERT(!other.isTemporary());
     other._block = const_cast<Block*>(&_zeroBlock);
     other._ptr = other._block->data();
@@ -139,6 +144,15 @@ public:
   inline size_t blockSize() const noexcept { return _blockSize; }
   //! Returns the default block alignment.
   inline size_t blockAlignment() const noexcept { return size_t(1) << _blockAlignmentShift; }
+
+  //! Returns the allocator of blocks, see \ref MemAllocator.
+  inline MemAllocator* memAllocator() const noexcept { return _memAllocator; }
+
+  //! Sets the allocator of blocks to `memAllocator`, or to \ref MemAllocator::host() if it's null.
+  //!
+  //! Blocks allocated by the previous allocator are released first, like \ref reset() does with \ref
+  //! ResetPolicy::kHard. A \ref ZoneAllocator that uses this `Zone` must not hold any dynamic blocks.
+  ASMJIT_API void setMemAllocator(MemAllocator* memAllocator) noexcept;
   //! Returns remaining size of the current block.
   inline size_t remainingSize() const noexcept { return (size_t)(_end - _ptr); }
 
@@ -182,6 +196,7 @@ public:
     std::swap(_end, other._end);
     std::swap(_block, other._block);
     std::swap(_packedData, other._packedData);
+    std::swap(_memAllocator, other._memAllocator);
   }
 
   //! Aligns the current pointer to `alignment`.
@@ -422,6 +437,8 @@ public:
   struct DynamicBlock {
     DynamicBlock* prev;
     DynamicBlock* next;
+    //! Size of the whole allocation, including this header.
+    size_t size;
   };
 
   //! \endcond
@@ -0,0 +1,367 @@
+// This file is part of AsmJit project <https://asmjit.com>
+//
+// See asmjit.h or LICENSE.md for license and copyright information
+// SPDX-License-Identifier: Zlib
+
+#include "../core/api-build_p.h"
+#if !defined(ASMJIT_NO_X86) && !defined(ASMJIT_NO_COMPILER)
+
+#include "../core/compilerutils_p.h"
+#include "../x86/x86addrfoldpass_p.h"
+
+ASMJIT_BEGIN_SUB_NAMESPACE(x86)
+
+// x86::X86AddrFoldPass - Utilities
+// ================================
+
+static constexpr CpuRWFlags kX86StatusFlags =
+  CpuRWFlags::kX86_CF | CpuRWFlags::kX86_OF | CpuRWFlags::kX86_SF |
+  CpuRWFlags::kX86_ZF | CpuRWFlags::kX86_AF | CpuRWFlags::kX86_PF;
+
+// Returns the next node that is not informative (comments are skipped).
+static BaseNode* X86AddrFoldPass_nextNode(BaseNode* node) noexcept {
+  do {
+    node = node->next();
+  } while (node && node->isInformative());
+  return node;
+}
+
+static inline bool X86AddrFoldPass_isVirtGp(const BaseCompiler* cc, const Operand& op) noexcept {
+  return op.isReg() && op.as<BaseReg>().signature() == cc->_gpSignature && Operand::isVirtId(op.id());
+}
+
+// Tests whether `type` and `id` describe a base or index register of a memory operand that can be moved elsewhere.
+static inline bool X86AddrFoldPass_isVirtGpMemReg(const BaseCompiler* cc, RegType type, uint32_t id) noexcept {
+  return type == cc->_gpSignature.regType() && Operand::isVirtId(id);
+}
+
+static inline uint32_t X86AddrFoldPass_countRefs(const BaseNode* node, uint32_t virtId) noexcept {
+  uint32_t n = 0;
+  CompilerUtils::forEachVirtRef(node, [&](uint32_t id) { n += uint32_t(id == virtId); });
+  return n;
+}
+
+// Starts an address computation of `t` by `mov t, base` or `lea t, [mem]`.
+static bool X86AddrFoldPass_matchStart(const BaseCompiler* cc, const InstNode* inst, X86AddrFoldPass::AddrExpr& expr) noexcept {
+  if (inst->opCount() != 2 || inst->options() != InstOptions::kNone || !X86AddrFoldPass_isVirtGp(cc, inst->op(0)))
+    return false;
+
+  uint32_t t = inst->op(0).id();
+  const Operand& src = inst->op(1);
+
+  if (inst->id() == Inst::kIdMov) {
+    if (!X86AddrFoldPass_isVirtGp(cc, src) || src.id() == t)
+      return false;
+
+    expr = X86AddrFoldPass::AddrExpr{src.id(), 0, 0, 0};
+    return true;
+  }
+
+  if (inst->id() == Inst::kIdLea) {
+    if (!src.isMem())
+      return false;
+
+    const Mem& m = src.as<Mem>();
+    if (m.hasSegment() || m.addrType() != Mem::AddrType::kDefault || m.hasBaseLabel() || !(m.hasBase() || m.hasIndex()))
+      return false;
+
+    if (m.hasBase() && (!X86AddrFoldPass_isVirtGpMemReg(cc, m.baseType(), m.baseId()) || m.baseId() == t))
+      return false;
+
+    if (m.hasIndex() && (!X86AddrFoldPass_isVirtGpMemReg(cc, m.indexType(), m.indexId()) || m.indexId() == t))
+      return false;
+
+    expr = X86AddrFoldPass::AddrExpr{m.baseId(), m.indexId(), m.shift(), m.offset()};
+    return true;
+  }
+
+  return false;
+}
+
+// Extends an address computation of `t` by `add t, reg`, `add t, imm`, `sub t, imm`, or `shl t, imm`.
+static bool X86AddrFoldPass_matchNext(const BaseCompiler* cc, const InstNode* inst, uint32_t t, X86AddrFoldPass::AddrExpr& expr) noexcept {
+  if (inst->opCount() != 2 || inst->options() != InstOptions::kNone)
+    return false;
+
+  const Operand& dst = inst->op(0);
+  const Operand& src = inst->op(1);
+
+  if (!X86AddrFoldPass_isVirtGp(cc, dst) || dst.id() != t)
+    return false;
+
+  InstId instId = inst->id();
+  if (src.isImm()) {
+    int64_t imm = src.as<Imm>().value();
+
+    if (instId == Inst::kIdAdd || instId == Inst::kIdSub) {
+      int64_t offset = instId == Inst::kIdAdd ? expr.offset + imm : expr.offset - imm;
+      if (!Support::isInt32(imm) || !Support::isInt32(offset))
+        return false;
+
+      expr.offset = offset;
+      return true;
+    }
+
+    if (instId == Inst::kIdShl) {
+      if (imm < 1 || imm > 3 || expr.offset != 0)
+        return false;
+
+      if (expr.baseId && !expr.indexId) {
+        expr.indexId = expr.baseId;
+        expr.baseId = 0;
+        expr.shift = uint32_t(imm);
+        return true;
+      }
+
+      if (!expr.baseId && expr.indexId && expr.shift + uint32_t(imm) <= 3) {
+        expr.shift += uint32_t(imm);
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  if (instId == Inst::kIdAdd && X86AddrFoldPass_isVirtGp(cc, src) && src.id() != t) {
+    if (!expr.indexId) {
+      expr.indexId = src.id();
+      expr.shift = 0;
+      return true;
+    }
+
+    if (!expr.baseId) {
+      expr.baseId = src.id();
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static inline bool X86AddrFoldPass_isExprReg(const X86AddrFoldPass::AddrExpr& expr, uint32_t id) noexcept {
+  return Operand::isVirtId(id) && (id == expr.baseId || id == expr.indexId);
+}
+
+// Tests whether `inst` writes to a register used by `expr`.
+//
+// Besides register operands this includes base and index registers of memory operands that are updated by the
+// instruction (for example `movs`, `stos`, `lods`, `cmps`, and `scas`) and the extra register, which is a counter
+// decremented by `rep` prefixed instructions.
+static bool X86AddrFoldPass_writesExprReg(Arch arch, InstNode* inst, const X86AddrFoldPass::AddrExpr& expr, bool* failed) noexcept {
+  InstRWInfo rwInfo;
+  if (InstAPI::queryRWInfo(arch, inst->baseInst(), inst->operands(), inst->opCount(), &rwInfo) != kErrorOk) {
+    *failed = true;
+    return true;
+  }
+
+  if (inst->hasExtraReg() && X86AddrFoldPass_isExprReg(expr, inst->extraReg().id()))
+    return true;
+
+  for (uint32_t i = 0; i < inst->opCount(); i++) {
+    const Operand& op = inst->op(i);
+    const OpRWInfo& opRwInfo = rwInfo.operand(i);
+
+    if (op.isReg()) {
+      if (X86AddrFoldPass_isExprReg(expr, op.id()) && opRwInfo.isWrite())
+        return true;
+    }
+    else if (op.isMem()) {
+      const Mem& m = op.as<Mem>();
+      if (m.hasBaseReg() && X86AddrFoldPass_isExprReg(expr, m.baseId()) && opRwInfo.isMemBaseWrite())
+        return true;
+      if (m.hasIndexReg() && X86AddrFoldPass_isExprReg(expr, m.indexId()) && opRwInfo.isMemIndexWrite())
+        return true;
+    }
+  }
+
+  return false;
+}
+
+// Combines `expr` (the value of the base register of `use`) with `use`, returns false if the result isn't encodable.
+static bool X86AddrFoldPass_combine(const BaseCompiler* cc, const X86AddrFoldPass::AddrExpr& expr, const Mem& use, Mem& out) noexcept {
+  int64_t offset = expr.offset + use.offset();
+  if (!Support::isInt32(offset))
+    return false;
+
+  out = use;
+  out.setOffset(offset);
+
+  if (!use.hasIndex()) {
+    // Prefer a base register over an unscaled index, which makes the encoding shorter.
+    if (!expr.baseId && expr.shift == 0) {
+      out.setBase(BaseReg(cc->_gpSignature, expr.indexId));
+      return true;
+    }
+
+    if (expr.baseId)
+      out.setBase(BaseReg(cc->_gpSignature, expr.baseId));
+    else
+      out.resetBase();
+
+    if (expr.indexId)
+      out.setIndex(BaseReg(cc->_gpSignature, expr.indexId), expr.shift);
+    return true;
+  }
+
+  // The index of `use` is kept (it could be a vector index as well), so `expr` can only provide the base register.
+  if (expr.baseId && !expr.indexId) {
+    out.setBase(BaseReg(cc->_gpSignature, expr.baseId));
+    return true;
+  }
+
+  // Unscaled index of `use` becomes the base register.
+  if (!expr.baseId && use.shift() == 0 && use.indexType() == cc->_gpSignature.regType()) {
+    out.setBase(BaseReg(cc->_gpSignature, use.indexId()));
+    out.setIndex(BaseReg(cc->_gpSignature, expr.indexId), expr.shift);
+    return true;
+  }
+
+  return false;
+}
+
+// x86::X86AddrFoldPass - Construction & Destruction
+// =================================================
+
+X86AddrFoldPass::X86AddrFoldPass() noexcept
+  : Pass("X86AddrFoldPass") {}
+X86AddrFoldPass::~X86AddrFoldPass() noexcept {}
+
+// x86::X86AddrFoldPass - Run
+// ==========================
+
+Error X86AddrFoldPass::run(Zone* zone, Logger* logger) {
+  DebugUtils::unused(logger);
+
+  Compiler* cc = this->cc();
+  if (!cc->hasCompilerOption(CompilerOptions::kFoldAddresses))
+    return kErrorOk;
+
+  Arch arch = cc->arch();
+  BaseNode* prevCursor = cc->cursor();
+
+  size_t virtCount = cc->virtRegs().size();
+  _virtRefs = static_cast<uint32_t*>(zone->allocZeroed(Support::max<size_t>(virtCount, 1u) * sizeof(uint32_t)));
+
+  if (ASMJIT_UNLIKELY(!_virtRefs))
+    return DebugUtils::errored(kErrorOutOfMemory);
+
+  for (const BaseNode* node = cc->firstNode(); node; node = node->next()) {
+    CompilerUtils::forEachVirtRef(node, [&](uint32_t virtId) {
+      size_t virtIndex = Operand::virtIdToIndex(virtId);
+      if (virtIndex < virtCount)
+        _virtRefs[virtIndex]++;
+    });
+  }
+
+  BaseNode* node = cc->firstNode();
+  while (node) {
+    BaseNode* next = node->next();
+    AddrExpr expr;
+
+    if (node->type() != NodeType::kInst || !X86AddrFoldPass_matchStart(cc, node->as<InstNode>(), expr)) {
+      node = next;
+      continue;
+    }
+
+    InstNode* first = node->as<InstNode>();
+    uint32_t t = first->op(0).id();
+
+    InstNode* chain[kMaxChainSize];
+    uint32_t chainSize = 1;
+    chain[0] = first;
+
+    for (;;) {
+      BaseNode* candidate = X86AddrFoldPass_nextNode(chain[chainSize - 1]);
+      if (chainSize == kMaxChainSize || !candidate || candidate->type() != NodeType::kInst)
+        break;
+
+      AddrExpr extended = expr;
+      if (!X86AddrFoldPass_matchNext(cc, candidate->as<InstNode>(), t, extended))
+        break;
+
+      expr = extended;
+      chain[chainSize++] = candidate->as<InstNode>();
+    }
+
+    InstNode* last = chain[chainSize - 1];
+    next = last->next();
+
+    bool writesFlags = chainSize > 1;
+    bool flagsDead = !writesFlags || CompilerUtils::areFlagsDead(arch, last, kX86StatusFlags);
+
+    size_t tIndex = Operand::virtIdToIndex(t);
+    uint32_t tUses = tIndex < virtCount ? _virtRefs[tIndex] - chainSize : 0;
+
+    // Fold the computation into a memory operand of its only use.
+    if (tUses == 1 && flagsDead && (chainSize > 1 || first->id() == Inst::kIdLea)) {
+      InstNode* use = nullptr;
+      bool failed = false;
+
+      for (BaseNode* n = X86AddrFoldPass_nextNode(last); n; n = X86AddrFoldPass_nextNode(n)) {
+        if (n->type() != NodeType::kInst)
+          break;
+
+        if (X86AddrFoldPass_countRefs(n, t)) {
+          use = n->as<InstNode>();
+          break;
+        }
+
+        if (X86AddrFoldPass_writesExprReg(arch, n->as<InstNode>(), expr, &failed))
+          break;
+      }
+
+      if (use && !failed && X86AddrFoldPass_countRefs(use, t) == 1) {
+        for (uint32_t i = 0; i < use->opCount(); i++) {
+          const Operand& op = use->op(i);
+          if (!op.isMem() || op.as<Mem>().baseId() != t || !op.as<Mem>().hasBaseReg())
+            continue;
+
+          Mem folded;
+          if (op.as<Mem>().baseType() != cc->_gpSignature.regType() || !X86AddrFoldPass_combine(cc, expr, op.as<Mem>(), folded))
+            break;
+
+          use->setOp(i, folded);
+          for (uint32_t j = 0; j < chainSize; j++)
+            cc->removeNode(chain[j]);
+
+          _virtRefs[tIndex] = 0;
+          chainSize = 0;
+          break;
+        }
+      }
+
+      if (!chainSize) {
+        node = next;
+        continue;
+      }
+    }
+
+    // Use LEA as a three-operand add.
+    if (chainSize == 2 && first->id() == Inst::kIdMov && expr.shift == 0 && flagsDead && chain[1]->id() != Inst::kIdShl) {
+      Mem m;
+      m.setBase(BaseReg(cc->_gpSignature, expr.baseId));
+      if (expr.indexId)
+        m.setIndex(BaseReg(cc->_gpSignature, expr.indexId), 0);
+      m.setOffset(expr.offset);
+
+      first->setId(Inst::kIdLea);
+      first->setOp(1, m);
+      cc->removeNode(chain[1]);
+    }
+
+    node = next;
+  }
+
+  _virtRefs = nullptr;
+
+  // The cursor could have been removed together with the folded nodes.
+  if (prevCursor && !prevCursor->isActive())
+    prevCursor = cc->lastNode();
+  cc->_setCursor(prevCursor);
+
+  return kErrorOk;
+}
+
+ASMJIT_END_SUB_NAMESPACE
+
+#endif // !ASMJIT_NO_X86 && !ASMJIT_NO_COMPILER
@@ -0,0 +1,90 @@
+// This file is part of AsmJit project <https://asmjit.com>
+//
+// See asmjit.h or LICENSE.md for license and copyright information
+// SPDX-License-Identifier: Zlib
+
+#ifndef ASMJIT_X86_X86ADDRFOLDPASS_P_H_INCLUDED
+#define ASMJIT_X86_X86ADDRFOLDPASS_P_H_INCLUDED
+
+#include "../core/api-config.h"
+#ifndef ASMJIT_NO_COMPILER
+
+#include "../core/compiler.h"
+#include "../x86/x86compiler.h"
+
+ASMJIT_BEGIN_SUB_NAMESPACE(x86)
+
+//! \cond INTERNAL
+//! \addtogroup asmjit_x86
+//! \{
+
+//! Address mode selection pass.
+//!
+//! Matches address computations of a virtual register `t` that consist of consecutive instructions, which start with
+//! `mov t, base` or `lea t, [mem]` and continue with `add t, reg`, `add t, imm`, `sub t, imm`, and `shl t, 1..3`,
+//! where all registers are virtual registers of native size. The pass runs before the register allocator and:
+//!
+//!   - Folds the computation into a memory operand `[t + disp]` of a later instruction of the same basic block if
+//!     that's the only use of `t` and registers used by the computation are not modified in between. The result is
+//!     `[base + index * scale + disp]` and the computation is removed.
+//!
+//!   - Replaces `mov t, a` followed by `add t, b` (or an immediate) by a single `lea t, [a + b]` if the computation
+//!     cannot be folded.
+//!
+//! Both rewrites remove instructions that write flags, so they are only done when the flags are overwritten before
+//! they could be read, and the basic block doesn't end before that.
+class X86AddrFoldPass : public Pass {
+public:
+  ASMJIT_NONCOPYABLE(X86AddrFoldPass)
+  typedef Pass Base;
+
+  //! Maximum number of instructions of a single address computation.
+  static constexpr uint32_t kMaxChainSize = 8;
+
+  //! Address computation, register ids are zero if not used.
+  struct AddrExpr {
+    uint32_t baseId;
+    uint32_t indexId;
+    uint32_t shift;
+    int64_t offset;
+  };
+
+  //! \name Members
+  //! \{
+
+  //! Number of uses of each virtual register (only valid during `run()`).
+  uint32_t* _virtRefs = nullptr;
+
+  //! \}
+
+  //! \name Construction & Destruction
+  //! \{
+
+  X86AddrFoldPass() noexcept;
+  virtual ~X86AddrFoldPass() noexcept;
+
+  //! \}
+
+  //! \name Accessors
+  //! \{
+
+  //! Returns the associated `x86::Compiler`.
+  inline Compiler* cc() const noexcept { return static_cast<Compiler*>(_cb); }
+
+  //! \}
+
+  //! \name Run
+  //! \{
+
+  Error run(Zone* zone, Logger* logger) override;
+
+  //! \}
+};
+
+//! \}
+//! \endcond
+
+ASMJIT_END_SUB_NAMESPACE
+
+#endif // !ASMJIT_NO_COMPILER
+#endif // ASMJIT_X86_X86ADDRFOLDPASS_P_H_INCLUDED
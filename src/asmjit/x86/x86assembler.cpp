@@ -7,6 +7,7 @@
 #if !defined(ASMJIT_NO_X86)
 
 #include "../core/assembler.h"
+#include "../core/codesizereport.h"
 #include "../core/codewriter_p.h"
 #include "../core/cpuinfo.h"
 #include "../core/emitterutils_p.h"
@@ -507,7 +508,7 @@ static ASMJIT_FORCE_INLINE bool x86ShouldUseMovabs(Assembler* self, X86BufferWri
     // this is only possible when the base address is known - relative encoding uses RIP+N it has to be calculated.
     if (rmRel.addrType() == Mem::AddrType::kDefault && baseAddress != Globals::kNoBaseAddress && !rmRel.hasSegment()) {
       uint32_t instructionSize = x86GetMovAbsInstSize64Bit(regSize, options, rmRel);
-      uint64_t virtualOffset = uint64_t(writer.offsetFrom(self->_bufferData));
+      uint64_t virtualOffset = uint64_t(self->_bufferOffset + writer.offsetFrom(self->_bufferData));
       uint64_t rip64 = baseAddress + self->_section->offset() + virtualOffset + instructionSize;
       uint64_t rel64 = uint64_t(addrValue) - rip64;
 
@@ -523,6 +524,152 @@ static ASMJIT_FORCE_INLINE bool x86ShouldUseMovabs(Assembler* self, X86BufferWri
   }
 }
 
+// x86::Assembler - Code Size Analysis
+// ===================================
+
+// Opcodes of the primary opcode map that use ModR/M byte - a bit per opcode indexed by the high nibble.
+static const uint16_t x86ModRMMap0[16] = {
+  0x0F0F, 0x0F0F, 0x0F0F, 0x0F0F, 0x0000, 0x0000, 0x0A0C, 0x0000,
+  0xFFFF, 0x0000, 0x0000, 0x0000, 0x00F3, 0xFF0F, 0x0000, 0xC0C0
+};
+
+// Opcodes of the secondary opcode map (0F) that use ModR/M byte - a bit per opcode indexed by the high nibble.
+static const uint16_t x86ModRMMap1[16] = {
+  0xA00F, 0xFFFF, 0xFF0F, 0x0000, 0xFFFF, 0xFFFF, 0xFFFF, 0xFF7F,
+  0x0000, 0xFFFF, 0xF838, 0xFFFF, 0x00FF, 0xFFFF, 0xFFFF, 0xFFFF
+};
+
+static ASMJIT_FORCE_INLINE bool x86IsLegacyPrefix(uint32_t b) noexcept {
+  return b == 0x26 || b == 0x2E || b == 0x36 || b == 0x3E || b == 0x64 || b == 0x65 ||
+         b == 0x66 || b == 0x67 || b == 0xF0 || b == 0xF2 || b == 0xF3;
+}
+
+// Adds an instruction encoded to [start, end) to the code size `report`. The instruction was just encoded, so it's
+// enough to skip prefixes and the opcode, and to decode ModR/M and SIB bytes to find the size of the displacement -
+// all bytes that follow it form an immediate (including the opcode suffix of 3DNow instructions).
+static Error x86AddToCodeSizeReport(CodeSizeReport* report, Arch arch, InstId instId, uint32_t encoding, const uint8_t* start, const uint8_t* end) noexcept {
+  size_t instSize = size_t(end - start);
+  ASMJIT_PROPAGATE(report->_addInst(arch, instId, encoding, instSize, Inst::_kIdCount, InstDB::kEncodingCount));
+
+  bool is64Bit = arch == Arch::kX64;
+  bool hasAddressOverride = false;
+
+  // Legacy prefixes, including FWAIT that precedes some FPU instructions.
+  const uint8_t* p = start;
+  while (p != end && (x86IsLegacyPrefix(p[0]) || (p[0] == 0x9B && end - p > 1))) {
+    hasAddressOverride |= p[0] == 0x67;
+    p++;
+  }
+  report->_addBytes(CodeSizeCategory::kLegacyPrefix, size_t(p - start));
+
+  if (p == end)
+    return kErrorOk;
+
+  const uint8_t* opStart = p;
+  uint32_t op = *p++;
+  uint32_t dispSize = 0;
+  bool hasModRM = false;
+
+  if (encoding >= InstDB::kEncodingVexOp && (op == 0xC5 || op == 0xC4 || op == 0x8F || op == 0x62)) {
+    // VEX, XOP, and EVEX prefixes encode the opcode map, all instructions except VZEROALL and VZEROUPPER use ModR/M.
+    uint32_t prefixSize = op == 0xC5 ? 2u : op == 0x62 ? 4u : 3u;
+    CodeSizeCategory category = op == 0xC5 ? CodeSizeCategory::kVex2 :
+                                op == 0xC4 ? CodeSizeCategory::kVex3 :
+                                op == 0x8F ? CodeSizeCategory::kXop : CodeSizeCategory::kEvex;
+
+    if (ASMJIT_UNLIKELY(size_t(end - opStart) <= prefixSize)) {
+      report->_addBytes(CodeSizeCategory::kOpcode, size_t(end - opStart));
+      return kErrorOk;
+    }
+
+    uint32_t opMap = op == 0xC5 ? 1u : uint32_t(opStart[1] & 0x1Fu);
+    report->_addBytes(category, prefixSize);
+
+    opStart += prefixSize;
+    op = opStart[0];
+    p = opStart + 1;
+    hasModRM = !(opMap == 1 && op == 0x77);
+  }
+  else {
+    if (is64Bit && (op & 0xF0u) == 0x40u && p != end) {
+      report->_addBytes(CodeSizeCategory::kRex, 1);
+      opStart = p;
+      op = *p++;
+    }
+
+    if (op == 0x0F && p != end) {
+      op = *p++;
+      if (op == 0x38 || op == 0x3A) {
+        // Three-byte opcode, always followed by ModR/M.
+        op = 0;
+        p++;
+        hasModRM = true;
+      }
+      else if (op == 0x0F) {
+        // 3DNow instruction.
+        op = 0;
+        hasModRM = true;
+      }
+      else {
+        hasModRM = ((x86ModRMMap1[op >> 4] >> (op & 0xF)) & 1u) != 0;
+        if ((op & 0xF0u) == 0x80u)
+          dispSize = 4; // Jcc rel32.
+        op = 0;
+      }
+    }
+    else {
+      hasModRM = ((x86ModRMMap0[op >> 4] >> (op & 0xF)) & 1u) != 0;
+      if ((op & 0xF0u) == 0x70u || (op >= 0xE0u && op <= 0xE3u) || op == 0xEB)
+        dispSize = 1; // Jcc|JECXZ|LOOP|JMP rel8.
+      else if (op == 0xE8 || op == 0xE9)
+        dispSize = 4; // CALL|JMP rel32.
+      else if (op >= 0xA0 && op <= 0xA3)
+        dispSize = is64Bit ? (hasAddressOverride ? 4u : 8u) : (hasAddressOverride ? 2u : 4u); // MOV moffs.
+    }
+  }
+
+  if (hasModRM && p < end) {
+    uint32_t modRM = *p++;
+    uint32_t mod = modRM >> 6;
+    uint32_t rm = modRM & 0x7u;
+
+    if (mod != 3) {
+      if (!is64Bit && hasAddressOverride) {
+        // 16-bit addressing doesn't use SIB.
+        dispSize = mod == 1 ? 1u : (mod == 2 || (mod == 0 && rm == 6)) ? 2u : 0u;
+      }
+      else {
+        if (rm == 4 && p != end) {
+          uint32_t sib = *p++;
+          if (mod == 0 && (sib & 0x7u) == 5)
+            dispSize = 4;
+        }
+        else if (mod == 0 && rm == 5) {
+          dispSize = 4;
+        }
+
+        if (mod == 1)
+          dispSize = 1;
+        else if (mod == 2)
+          dispSize = 4;
+      }
+    }
+    else if (op == 0xC7 && modRM == 0xF8) {
+      // XBEGIN rel32 (only in the primary opcode map).
+      dispSize = 4;
+    }
+  }
+
+  p = Support::min(p, end);
+  dispSize = Support::min<uint32_t>(dispSize, uint32_t(end - p));
+
+  report->_addBytes(CodeSizeCategory::kOpcode, size_t(p - opStart));
+  report->_addBytes(CodeSizeCategory::kDisplacement, dispSize);
+  report->_addBytes(CodeSizeCategory::kImmediate, size_t(end - p) - dispSize);
+
+  return kErrorOk;
+}
+
 // x86::Assembler - Construction & Destruction
 // ===========================================
 
@@ -4153,7 +4300,7 @@ EmitModSib:
 
         if (addrType == Mem::AddrType::kRel) {
           uint32_t kModRel32Size = 5;
-          uint64_t virtualOffset = uint64_t(writer.offsetFrom(_bufferData)) + immSize + kModRel32Size;
+          uint64_t virtualOffset = uint64_t(_bufferOffset + writer.offsetFrom(_bufferData)) + immSize + kModRel32Size;
 
           if (baseAddress == Globals::kNoBaseAddress || _section->id() != 0) {
             // Create a new RelocEntry as we cannot calculate the offset right now.
@@ -4246,9 +4393,6 @@ EmitModSib:
 
       if (is32Bit()) {
 EmitModSib_LabelRip_X86:
-        if (ASMJIT_UNLIKELY(_code->_relocations.willGrow(_code->allocator()) != kErrorOk))
-          goto OutOfMemory;
-
         relOffset = rmRel->as<Mem>().offsetLo32();
         if (rmInfo & kX86MemInfo_BaseLabel) {
           // [LABEL->ABS].
@@ -4266,10 +4410,13 @@ EmitModSib_LabelRip_X86:
           re->_format.setLeadingAndTrailingSize(writer.offsetFrom(_bufferPtr), immSize);
           re->_payload = uint64_t(int64_t(relOffset));
 
-          if (label->isBound()) {
+          uint64_t labelOffset;
+          Section* labelSection = _code->labelBinding(label, &labelOffset);
+
+          if (labelSection) {
             // Label bound to the current section.
-            re->_payload += label->offset();
-            re->_targetSectionId = label->section()->id();
+            re->_payload += labelOffset;
+            re->_targetSectionId = labelSection->id();
             writer.emit32uLE(0);
           }
           else {
@@ -4304,9 +4451,11 @@ EmitModSib_LabelRip_X86:
             goto InvalidLabel;
 
           relOffset -= (4 + immSize);
-          if (label->isBoundTo(_section)) {
+
+          uint64_t labelOffset;
+          if (_code->labelBinding(label, &labelOffset) == _section) {
             // Label bound to the current section.
-            relOffset += int32_t(label->offset() - writer.offsetFrom(_bufferData));
+            relOffset += int32_t(labelOffset - (_bufferOffset + writer.offsetFrom(_bufferData)));
             writer.emit32uLE(uint32_t(relOffset));
           }
           else {
@@ -4777,7 +4926,7 @@ EmitJmpCall:
     rex &= ~kX86ByteInvalidRex & 0xFF;
     writer.emit8If(rex | kX86ByteRex, rex != 0);
 
-    uint64_t ip = uint64_t(writer.offsetFrom(_bufferData));
+    uint64_t ip = uint64_t(_bufferOffset + writer.offsetFrom(_bufferData));
     uint32_t rel32 = 0;
     uint32_t opCode8 = x86AltOpcodeOf(instInfo);
 
@@ -4799,9 +4948,10 @@ EmitJmpCall:
       if (ASMJIT_UNLIKELY(!label))
         goto InvalidLabel;
 
-      if (label->isBoundTo(_section)) {
+      uint64_t labelOffset;
+      if (_code->labelBinding(label, &labelOffset) == _section) {
         // Label bound to the current section.
-        rel32 = uint32_t((label->offset() - ip - inst32Size) & 0xFFFFFFFFu);
+        rel32 = uint32_t((labelOffset - ip - inst32Size) & 0xFFFFFFFFu);
         goto EmitJmpCallRel;
       }
       else {
@@ -4923,17 +5073,14 @@ EmitRel:
     ASMJIT_ASSERT(relSize == 1 || relSize == 4);
 
     // Chain with label.
-    size_t offset = size_t(writer.offsetFrom(_bufferData));
+    size_t offset = _bufferOffset + writer.offsetFrom(_bufferData);
     OffsetFormat of;
     of.resetToSimpleValue(OffsetType::kSignedOffset, relSize);
 
-    LabelLink* link = _code->newLabelLink(label, _section->id(), offset, relOffset, of);
+    LabelLink* link = _code->newLabelLink(label, _section->id(), offset, relOffset, of, re ? re->id() : uint32_t(Globals::kInvalidId));
     if (ASMJIT_UNLIKELY(!link))
       goto OutOfMemory;
 
-    if (re)
-      link->relocId = re->id();
-
     // Emit dummy zeros, must be patched later when the reference becomes known.
     writer.emitZeros(relSize);
   }
@@ -4944,6 +5091,13 @@ EmitRel:
 
 EmitDone:
   if (Support::test(options, InstOptions::kReserved)) {
+    CodeSizeReport* codeSizeReport = _code->codeSizeReport();
+    if (codeSizeReport) {
+      err = x86AddToCodeSizeReport(codeSizeReport, arch(), instId, instInfo->_encoding, _bufferPtr, writer.cursor());
+      if (ASMJIT_UNLIKELY(err))
+        goto Failed;
+    }
+
 #ifndef ASMJIT_NO_LOGGING
     if (_logger)
       EmitterUtils::logInstructionEmitted(this, instId, options, o0, o1, o2, opExt, relSize, immSize, writer.cursor());
@@ -5015,6 +5169,9 @@ Error Assembler::align(AlignMode alignMode, uint32_t alignment) {
     CodeWriter writer(this);
     ASMJIT_PROPAGATE(writer.ensureSpace(this, i));
 
+    if (_code->codeSizeReport())
+      _code->codeSizeReport()->_addBytes(CodeSizeCategory::kAlignment, i);
+
     uint8_t pattern = 0x00;
     switch (alignMode) {
       case AlignMode::kCode: {
@@ -5105,6 +5262,89 @@ Error Assembler::onDetach(CodeHolder* code) noexcept {
   return Base::onDetach(code);
 }
 
+// x86::Assembler - Tests
+// ======================
+
+#if defined(ASMJIT_TEST)
+UNIT(x86_code_size_report) {
+  CodeSizeReport report;
+  CodeHolder code;
+  code.init(Environment(Arch::kX64));
+  code.setCodeSizeReport(&report);
+
+  Assembler a(&code);
+  Label L = a.newLabel();
+
+  INFO("Checking whether CodeSizeReport attributes bytes of X64 instructions to categories");
+  a.bind(L);
+  a.mov(rax, ptr(rbx, 0x100));          // 48 8B 83 00 01 00 00
+  a.add(eax, 1);                        // 83 C0 01
+  a.pshufd(xmm0, xmm1, 0);              // 66 0F 70 C1 00
+  a.vaddps(ymm0, ymm1, ymm2);           // C5 F4 58 C2
+  a.vaddps(zmm0, zmm1, zmm2);           // 62 F1 74 48 58 C2
+  a.jmp(L);                             // EB xx
+  a.align(AlignMode::kZero, 8);
+  a.embedUInt32(0x12345678u);
+
+  EXPECT(report.arch() == Arch::kX64);
+  EXPECT(report.instCount() == 6u);
+  EXPECT(report.categorySize(CodeSizeCategory::kLegacyPrefix) == 1u);
+  EXPECT(report.categorySize(CodeSizeCategory::kRex) == 1u);
+  EXPECT(report.categorySize(CodeSizeCategory::kVex2) == 2u);
+  EXPECT(report.categorySize(CodeSizeCategory::kVex3) == 0u);
+  EXPECT(report.categorySize(CodeSizeCategory::kEvex) == 4u);
+  EXPECT(report.categorySize(CodeSizeCategory::kOpcode) == 12u);
+  EXPECT(report.categorySize(CodeSizeCategory::kDisplacement) == 5u);
+  EXPECT(report.categorySize(CodeSizeCategory::kImmediate) == 2u);
+  EXPECT(report.categorySize(CodeSizeCategory::kAlignment) == 5u);
+  EXPECT(report.categorySize(CodeSizeCategory::kData) == 4u);
+  EXPECT(report.totalSize() == a.offset());
+
+  EXPECT(report.instStats(Inst::kIdVaddps).count == 2u);
+  EXPECT(report.instStats(Inst::kIdVaddps).size == 10u);
+  EXPECT(report.instStats(Inst::kIdMov).size == 7u);
+  EXPECT(report.instStats(Inst::kIdNop).count == 0u);
+
+  uint64_t encodingSize = 0;
+  for (uint32_t i = 0; i < report.encodingIdCount(); i++)
+    encodingSize += report.encodingStats(i).size;
+  EXPECT(encodingSize == 27u);
+
+  INFO("Checking whether CodeSizeReport formats the report");
+  String sb;
+  EXPECT(report.format(sb) == kErrorOk);
+  EXPECT(strstr(sb.data(), "Evex") != nullptr);
+#ifndef ASMJIT_NO_TEXT
+  EXPECT(strstr(sb.data(), "vaddps") != nullptr);
+#endif
+
+  INFO("Checking whether CodeSizeReport rejects instructions of a different architecture family");
+  EXPECT(report._addInst(Arch::kAArch64, 1, 0, 4, Inst::_kIdCount, InstDB::kEncodingCount) == kErrorInvalidArch);
+
+  report.reset();
+  EXPECT(report.totalSize() == 0u);
+  EXPECT(report.instStats(Inst::kIdMov).count == 0u);
+
+  INFO("Checking whether CodeSizeReport accounts address table entries once if the code is relocated twice");
+  CodeHolder farCode;
+  farCode.init(Environment(Arch::kX64));
+  farCode.setCodeSizeReport(&report);
+
+  Assembler b(&farCode);
+  b.jmp(Imm(uint64_t(0x7FFF00000000u)));   // FF 25 xx xx xx xx (through the address table)
+
+  EXPECT(farCode.flatten() == kErrorOk);
+  EXPECT(farCode.resolveUnresolvedLinks() == kErrorOk);
+  EXPECT(farCode.relocateToBase(0x10000) == kErrorOk);
+  EXPECT(report.categorySize(CodeSizeCategory::kAddressTable) == 8u);
+
+  EXPECT(farCode.relocateToBase(0x20000) == kErrorOk);
+  EXPECT(report.categorySize(CodeSizeCategory::kAddressTable) == 8u);
+  EXPECT(farCode.addressTableSection()->bufferSize() == 8u);
+  EXPECT(report.totalSize() == farCode.textSection()->bufferSize() + farCode.addressTableSection()->bufferSize());
+}
+#endif
+
 ASMJIT_END_SUB_NAMESPACE
 
 #endif // !ASMJIT_NO_X86
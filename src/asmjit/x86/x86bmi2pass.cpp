@@ -0,0 +1,120 @@
+// This file is part of AsmJit project <https://asmjit.com>
+//
+// See asmjit.h or LICENSE.md for license and copyright information
+// SPDX-License-Identifier: Zlib
+
+#include "../core/api-build_p.h"
+#if !defined(ASMJIT_NO_X86) && !defined(ASMJIT_NO_COMPILER)
+
+#include "../core/compilerutils_p.h"
+#include "../core/cpuinfo.h"
+#include "../x86/x86bmi2pass_p.h"
+
+ASMJIT_BEGIN_SUB_NAMESPACE(x86)
+
+// x86::X86Bmi2Pass - Utilities
+// ============================
+
+static constexpr CpuRWFlags kX86StatusFlags =
+  CpuRWFlags::kX86_CF | CpuRWFlags::kX86_OF | CpuRWFlags::kX86_SF |
+  CpuRWFlags::kX86_ZF | CpuRWFlags::kX86_AF | CpuRWFlags::kX86_PF;
+
+static inline bool X86Bmi2Pass_isGp32Or64(const Operand& op) noexcept {
+  return op.isReg() && (op.as<Reg>().isGpd() || op.as<Reg>().isGpq());
+}
+
+static InstId X86Bmi2Pass_shiftToBmi2(InstId instId) noexcept {
+  switch (instId) {
+    case Inst::kIdShl: return Inst::kIdShlx;
+    case Inst::kIdShr: return Inst::kIdShrx;
+    case Inst::kIdSar: return Inst::kIdSarx;
+    default:
+      return Inst::kIdNone;
+  }
+}
+
+// `shl|shr|sar r, count` -> `shlx|shrx|sarx r, r, count`.
+//
+// The count operand is widened to the size of `r` - only its low bits are used by both forms.
+static bool X86Bmi2Pass_rewriteShift(InstNode* inst, InstId newId) noexcept {
+  if (inst->opCount() != 2 || !X86Bmi2Pass_isGp32Or64(inst->op(0)) || !inst->op(1).isReg() || !inst->op(1).as<Reg>().isGp())
+    return false;
+
+  Gp dst = inst->op(0).as<Gp>();
+  Gp count = Gp::fromTypeAndId(dst.type(), inst->op(1).id());
+
+  inst->setId(newId);
+  inst->setOp(1, dst);
+  inst->setOp(2, count);
+  inst->setOpCount(3);
+  return true;
+}
+
+// `mul hi, lo, src` -> `mulx hi, lo, src, lo`.
+static bool X86Bmi2Pass_rewriteMul(InstNode* inst) noexcept {
+  if (inst->opCount() != 3 || inst->opCapacity() < 4)
+    return false;
+
+  const Operand& hi = inst->op(0);
+  const Operand& lo = inst->op(1);
+  const Operand& src = inst->op(2);
+
+  if (!X86Bmi2Pass_isGp32Or64(hi) || !X86Bmi2Pass_isGp32Or64(lo) || hi.as<Reg>().type() != lo.as<Reg>().type() || hi.id() == lo.id())
+    return false;
+
+  if (!(src.isMem() || (src.isReg() && src.as<Reg>().type() == lo.as<Reg>().type())))
+    return false;
+
+  inst->setId(Inst::kIdMulx);
+  inst->setOp(3, lo);
+  inst->setOpCount(4);
+  return true;
+}
+
+// x86::X86Bmi2Pass - Construction & Destruction
+// =============================================
+
+X86Bmi2Pass::X86Bmi2Pass() noexcept
+  : Pass("X86Bmi2Pass") {}
+X86Bmi2Pass::~X86Bmi2Pass() noexcept {}
+
+// x86::X86Bmi2Pass - Run
+// ======================
+
+Error X86Bmi2Pass::run(Zone* zone, Logger* logger) {
+  DebugUtils::unused(zone, logger);
+
+  Compiler* cc = this->cc();
+  if (!cc->hasCompilerOption(CompilerOptions::kPreferBmi2) || cc->hasEncodingOption(EncodingOptions::kOptimizeForSize))
+    return kErrorOk;
+
+  if (!cc->targetCpuFeatures().has(CpuFeatures::X86::kBMI2))
+    return kErrorOk;
+
+  Arch arch = cc->arch();
+  for (BaseNode* node = cc->firstNode(); node; node = node->next()) {
+    if (node->type() != NodeType::kInst)
+      continue;
+
+    InstNode* inst = node->as<InstNode>();
+    InstId instId = inst->id();
+    InstId shiftId = X86Bmi2Pass_shiftToBmi2(instId);
+
+    if ((shiftId == Inst::kIdNone && instId != Inst::kIdMul) || inst->hasOption(InstOptions::kX86_Lock))
+      continue;
+
+    if (!CompilerUtils::areFlagsDead(arch, inst, kX86StatusFlags))
+      continue;
+
+    if (shiftId != Inst::kIdNone)
+      X86Bmi2Pass_rewriteShift(inst, shiftId);
+    else
+      X86Bmi2Pass_rewriteMul(inst);
+  }
+
+  return kErrorOk;
+}
+
+ASMJIT_END_SUB_NAMESPACE
+
+#endif // !ASMJIT_NO_X86 && !ASMJIT_NO_COMPILER
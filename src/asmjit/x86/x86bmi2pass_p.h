@@ -0,0 +1,69 @@
+// This file is part of AsmJit project <https://asmjit.com>
+//
+// See asmjit.h or LICENSE.md for license and copyright information
+// SPDX-License-Identifier: Zlib
+
+#ifndef ASMJIT_X86_X86BMI2PASS_P_H_INCLUDED
+#define ASMJIT_X86_X86BMI2PASS_P_H_INCLUDED
+
+#include "../core/api-config.h"
+#ifndef ASMJIT_NO_COMPILER
+
+#include "../core/compiler.h"
+#include "../x86/x86compiler.h"
+
+ASMJIT_BEGIN_SUB_NAMESPACE(x86)
+
+//! \cond INTERNAL
+//! \addtogroup asmjit_x86
+//! \{
+
+//! BMI2 instruction selection pass.
+//!
+//! Variable shifts and unsigned widening multiplication have implicit register operands (the shift count must be in
+//! `cl` and `mul` uses `rdx:rax`), which the register allocator must honor by moving values in and out of these
+//! registers. BMI2 provides forms that accept any register, so the pass runs before the register allocator and:
+//!
+//!   - Replaces `shl|shr|sar r, count` with `shlx|shrx|sarx r, r, count` if `r` is a 32-bit or 64-bit register.
+//!
+//!   - Replaces `mul hi, lo, src` with `mulx hi, lo, src, lo`, which only keeps `lo` input in `rdx`.
+//!
+//! BMI2 instructions don't modify flags, so an instruction is only replaced if the flags it writes are overwritten
+//! before they could be read. The pass does nothing if BMI2 is not in \ref BaseCompiler::targetCpuFeatures() or when
+//! \ref EncodingOptions::kOptimizeForSize is set as VEX encoded instructions are longer.
+class X86Bmi2Pass : public Pass {
+public:
+  ASMJIT_NONCOPYABLE(X86Bmi2Pass)
+  typedef Pass Base;
+
+  //! \name Construction & Destruction
+  //! \{
+
+  X86Bmi2Pass() noexcept;
+  virtual ~X86Bmi2Pass() noexcept;
+
+  //! \}
+
+  //! \name Accessors
+  //! \{
+
+  //! Returns the associated `x86::Compiler`.
+  inline Compiler* cc() const noexcept { return static_cast<Compiler*>(_cb); }
+
+  //! \}
+
+  //! \name Run
+  //! \{
+
+  Error run(Zone* zone, Logger* logger) override;
+
+  //! \}
+};
+
+//! \}
+//! \endcond
+
+ASMJIT_END_SUB_NAMESPACE
+
+#endif // !ASMJIT_NO_COMPILER
+#endif // ASMJIT_X86_X86BMI2PASS_P_H_INCLUDED
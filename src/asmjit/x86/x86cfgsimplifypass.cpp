@@ -0,0 +1,63 @@
+// This file is part of AsmJit project <https://asmjit.com>
+//
+// See asmjit.h or LICENSE.md for license and copyright information
+// SPDX-License-Identifier: Zlib
+
+#include "../core/api-build_p.h"
+#if !defined(ASMJIT_NO_X86) && !defined(ASMJIT_NO_COMPILER)
+
+#include "../x86/x86cfgsimplifypass_p.h"
+#include "../x86/x86instdb.h"
+
+ASMJIT_BEGIN_SUB_NAMESPACE(x86)
+
+// x86::X86CFGSimplifyPass - Utilities
+// ===================================
+
+// Returns the condition of `instId` if it's a conditional jump (JCC) or 16 if it's not.
+static inline uint32_t X86CFGSimplifyPass_jccCond(InstId instId) noexcept {
+  uint32_t cond = 0;
+  while (cond < 16 && Inst::jccFromCond(CondCode(cond)) != instId)
+    cond++;
+  return cond;
+}
+
+// x86::X86CFGSimplifyPass - Construction & Destruction
+// ====================================================
+
+X86CFGSimplifyPass::X86CFGSimplifyPass(bool afterRA) noexcept
+  : BaseCFGSimplifyPass(afterRA ? "X86CFGSimplifyPass(PostRA)" : "X86CFGSimplifyPass") {}
+X86CFGSimplifyPass::~X86CFGSimplifyPass() noexcept {}
+
+// x86::X86CFGSimplifyPass - Interface
+// ===================================
+
+InstControlFlow X86CFGSimplifyPass::controlFlow(const InstNode* node) const noexcept {
+  InstId instId = node->realId();
+  if (!Inst::isDefinedId(instId))
+    return InstControlFlow::kRegular;
+  return InstDB::infoById(instId).controlFlow();
+}
+
+bool X86CFGSimplifyPass::canInvertBranch(const InstNode* node) const noexcept {
+  // JECXZ and LOOPxx are branches as well, but they have no inverse and LOOPxx modifies its counter.
+  return X86CFGSimplifyPass_jccCond(node->realId()) < 16;
+}
+
+void X86CFGSimplifyPass::invertBranch(InstNode* node) noexcept {
+  uint32_t cond = X86CFGSimplifyPass_jccCond(node->realId());
+  ASMJIT_ASSERT(cond < 16);
+
+  node->setId(Inst::jccFromCond(negateCond(CondCode(cond))));
+
+  // Branch prediction hints describe the original condition.
+  InstOptions hints = node->options() & (InstOptions::kTaken | InstOptions::kNotTaken);
+  if (hints != InstOptions::kNone && hints != (InstOptions::kTaken | InstOptions::kNotTaken)) {
+    node->clearOptions(hints);
+    node->addOptions(hints ^ (InstOptions::kTaken | InstOptions::kNotTaken));
+  }
+}
+
+ASMJIT_END_SUB_NAMESPACE
+
+#endif // !ASMJIT_NO_X86 && !ASMJIT_NO_COMPILER
@@ -0,0 +1,52 @@
+// This file is part of AsmJit project <https://asmjit.com>
+//
+// See asmjit.h or LICENSE.md for license and copyright information
+// SPDX-License-Identifier: Zlib
+
+#ifndef ASMJIT_X86_X86CFGSIMPLIFYPASS_P_H_INCLUDED
+#define ASMJIT_X86_X86CFGSIMPLIFYPASS_P_H_INCLUDED
+
+#include "../core/api-config.h"
+#ifndef ASMJIT_NO_COMPILER
+
+#include "../core/cfgsimplifypass_p.h"
+#include "../x86/x86compiler.h"
+
+ASMJIT_BEGIN_SUB_NAMESPACE(x86)
+
+//! \cond INTERNAL
+//! \addtogroup asmjit_x86
+//! \{
+
+//! X86 control flow graph simplification pass, see \ref BaseCFGSimplifyPass.
+class X86CFGSimplifyPass : public BaseCFGSimplifyPass {
+public:
+  ASMJIT_NONCOPYABLE(X86CFGSimplifyPass)
+  typedef BaseCFGSimplifyPass Base;
+
+  //! \name Construction & Destruction
+  //! \{
+
+  //! Creates the pass, `afterRA` specifies whether the pass runs after the register allocation pass.
+  explicit X86CFGSimplifyPass(bool afterRA) noexcept;
+  virtual ~X86CFGSimplifyPass() noexcept;
+
+  //! \}
+
+  //! \name Interface
+  //! \{
+
+  InstControlFlow controlFlow(const InstNode* node) const noexcept override;
+  bool canInvertBranch(const InstNode* node) const noexcept override;
+  void invertBranch(InstNode* node) noexcept override;
+
+  //! \}
+};
+
+//! \}
+//! \endcond
+
+ASMJIT_END_SUB_NAMESPACE
+
+#endif // !ASMJIT_NO_COMPILER
+#endif // ASMJIT_X86_X86CFGSIMPLIFYPASS_P_H_INCLUDED
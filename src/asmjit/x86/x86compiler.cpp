@@ -6,9 +6,15 @@
 #include "../core/api-build_p.h"
 #if !defined(ASMJIT_NO_X86) && !defined(ASMJIT_NO_COMPILER)
 
+#include "../x86/x86addrfoldpass_p.h"
 #include "../x86/x86assembler.h"
+#include "../x86/x86bmi2pass_p.h"
+#include "../x86/x86cfgsimplifypass_p.h"
 #include "../x86/x86compiler.h"
+#include "../x86/x86depbreakpass_p.h"
+#include "../x86/x86ifconvertpass_p.h"
 #include "../x86/x86instapi_p.h"
+#include "../x86/x86phipass_p.h"
 #include "../x86/x86rapass_p.h"
 
 ASMJIT_BEGIN_SUB_NAMESPACE(x86)
@@ -16,7 +22,8 @@ ASMJIT_BEGIN_SUB_NAMESPACE(x86)
 // x86::Compiler - Construction & Destruction
 // ==========================================
 
-Compiler::Compiler(CodeHolder* code) noexcept : BaseCompiler() {
+Compiler::Compiler(CodeHolder* code) noexcept
+  : BaseCompiler() {
   _archMask = (uint64_t(1) << uint32_t(Arch::kX86)) |
               (uint64_t(1) << uint32_t(Arch::kX64)) ;
   assignEmitterFuncs(this);
@@ -26,12 +33,67 @@ Compiler::Compiler(CodeHolder* code) noexcept : BaseCompiler() {
 }
 Compiler::~Compiler() noexcept {}
 
+// x86::Compiler - Target
+// ======================
+
+CompilerUArch Compiler::uarchOf(const CpuInfo& cpu) noexcept {
+  if (cpu.isVendor("INTEL") && cpu.familyId() == 0x06u) {
+    switch (cpu.modelId()) {
+      case 0x2Au: // Sandy Bridge.
+      case 0x2Du: // Sandy Bridge-E.
+      case 0x3Au: // Ivy Bridge.
+      case 0x3Eu: // Ivy Bridge-E.
+        return CompilerUArch::kIntelSNB;
+
+      case 0x3Cu: // Haswell.
+      case 0x3Fu: // Haswell-E.
+      case 0x45u: // Haswell-ULT.
+      case 0x46u: // Haswell-GT3E.
+      case 0x3Du: // Broadwell.
+      case 0x47u: // Broadwell-GT3E.
+      case 0x4Fu: // Broadwell-E.
+      case 0x56u: // Broadwell-DE.
+        return CompilerUArch::kIntelHSW;
+
+      case 0x4Eu: // Skylake-U/Y.
+      case 0x5Eu: // Skylake-S/H.
+      case 0x55u: // Skylake-X, Cascade Lake, Cooper Lake.
+      case 0x8Eu: // Kaby Lake-U/Y, Coffee Lake-U, Comet Lake-U.
+      case 0x9Eu: // Kaby Lake-S/H, Coffee Lake-S/H.
+      case 0xA5u: // Comet Lake-S/H.
+      case 0xA6u: // Comet Lake-U.
+        return CompilerUArch::kIntelSKL;
+
+      default:
+        break;
+    }
+  }
+
+  return CompilerUArch::kOther;
+}
+
 // x86::Compiler - Events
 // ======================
 
 Error Compiler::onAttach(CodeHolder* code) noexcept {
   ASMJIT_PROPAGATE(Base::onAttach(code));
-  Error err = addPassT<X86RAPass>();
+  Error err = addPassT<X86PhiPass>();
+  if (!err)
+    err = addPassT<X86IfConvertPass>();
+  if (!err)
+    err = addPassT<X86CFGSimplifyPass>(false);
+  if (!err)
+    err = addPassT<X86AddrFoldPass>();
+  if (!err)
+    err = addPassT<X86Bmi2Pass>();
+  if (!err)
+    err = addPassT<X86DepBreakPass>(false);
+  if (!err)
+    err = addPassT<X86RAPass>();
+  if (!err)
+    err = addPassT<X86CFGSimplifyPass>(true);
+  if (!err)
+    err = addPassT<X86DepBreakPass>(true);
 
   if (ASMJIT_UNLIKELY(err)) {
     onDetach(code);
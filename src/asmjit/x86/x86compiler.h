@@ -18,6 +18,21 @@ ASMJIT_BEGIN_SUB_NAMESPACE(x86)
 //! \addtogroup asmjit_x86
 //! \{
 
+//! Microarchitecture the code generated by \ref Compiler is tuned for, see \ref Compiler::targetUArch().
+enum class CompilerUArch : uint32_t {
+  //! Unknown microarchitecture or a microarchitecture that doesn't need any specific tuning (default).
+  kOther = 0,
+  //! Intel Sandy Bridge and Ivy Bridge.
+  kIntelSNB = 1,
+  //! Intel Haswell and Broadwell.
+  kIntelHSW = 2,
+  //! Intel Skylake and its derivatives (Kaby Lake, Coffee Lake, Comet Lake).
+  kIntelSKL = 3,
+
+  //! Maximum value of `CompilerUArch`.
+  kMaxValue = kIntelSKL
+};
+
 //! X86/X64 compiler implementation.
 //!
 //! ### Compiler Basics
@@ -493,6 +508,21 @@ public:
 
   //! \}
 
+  //! \name Target
+  //! \{
+
+  //! Returns the microarchitecture the code is tuned for, which enables rewrites that only help on that
+  //! microarchitecture (for example breaking false output dependencies of `popcnt`, `lzcnt`, and `tzcnt`).
+  //!
+  //! The microarchitecture is derived from \ref targetCpuInfo(), which describes no CPU by default, so the default
+  //! is \ref CompilerUArch::kOther.
+  inline CompilerUArch targetUArch() const noexcept { return uarchOf(_targetCpuInfo); }
+
+  //! Returns the microarchitecture of the given `cpu`.
+  static ASMJIT_API CompilerUArch uarchOf(const CpuInfo& cpu) noexcept;
+
+  //! \}
+
   //! \name Virtual Registers
   //! \{
 
@@ -648,6 +678,8 @@ public:
 
   //! Force the compiler to not follow the conditional or unconditional jump.
   inline Compiler& unfollow() noexcept { addInstOptions(InstOptions::kUnfollow); return *this; }
+  //! Tell the compiler that the conditional jump is unpredictable, see \ref InstOptions::kUnpredictable.
+  inline Compiler& unpredictable() noexcept { addInstOptions(InstOptions::kUnpredictable); return *this; }
   //! Tell the compiler that the destination variable will be overwritten.
   inline Compiler& overwrite() noexcept { addInstOptions(InstOptions::kOverwrite); return *this; }
 
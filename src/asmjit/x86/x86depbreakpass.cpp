@@ -0,0 +1,276 @@
+// This file is part of AsmJit project <https://asmjit.com>
+//
+// See asmjit.h or LICENSE.md for license and copyright information
+// SPDX-License-Identifier: Zlib
+
+#include "../core/api-build_p.h"
+#if !defined(ASMJIT_NO_X86) && !defined(ASMJIT_NO_COMPILER)
+
+#include "../x86/x86depbreakpass_p.h"
+
+ASMJIT_BEGIN_SUB_NAMESPACE(x86)
+
+// x86::X86DepBreakPass - Table
+// ============================
+
+//! Describes how the dependency of an instruction on its destination is broken.
+enum class X86DepBreakKind : uint8_t {
+  //! Legacy SSE scalar instruction that merges its result into the destination (op0).
+  kSseMerge = 0,
+  //! AVX scalar instruction that merges its result into the first source (op1), only handled when op1 is op0.
+  kAvxMerge = 1,
+  //! GP instruction that has a false dependency on its destination (op0), handled after register allocation.
+  kGpOutput = 2
+};
+
+//! Instruction that has a dependency on its destination register that can be broken.
+struct X86DepBreakEntry {
+  //! Instruction id.
+  uint16_t instId;
+  //! Kind of the dependency, see \ref X86DepBreakKind.
+  X86DepBreakKind kind;
+  //! Number of bytes written to the destination, the rest is merged.
+  uint8_t writeSize;
+  //! Microarchitectures that have the dependency, see \ref X86DepBreakPass::UArch.
+  uint8_t uarchMask;
+};
+
+static constexpr uint32_t kUArchAll = X86DepBreakPass::kUArchAll;
+static constexpr uint32_t kUArchHSW = X86DepBreakPass::kUArchIntelHSW;
+static constexpr uint32_t kUArchSNBToSKL = X86DepBreakPass::kUArchIntelSNB | X86DepBreakPass::kUArchIntelHSW | X86DepBreakPass::kUArchIntelSKL;
+
+#define E(INST_ID, KIND, WRITE_SIZE, UARCH) \
+  { Inst::kId##INST_ID, X86DepBreakKind::k##KIND, WRITE_SIZE, uint8_t(UARCH) }
+
+// Must be sorted by instruction id (which is alphabetical), verified by unit tests.
+static const X86DepBreakEntry X86DepBreakPass_table[] = {
+  E(Cvtsd2ss  , SseMerge, 4, kUArchAll     ),
+  E(Cvtsi2sd  , SseMerge, 8, kUArchAll     ),
+  E(Cvtsi2ss  , SseMerge, 4, kUArchAll     ),
+  E(Cvtss2sd  , SseMerge, 8, kUArchAll     ),
+  E(Lzcnt     , GpOutput, 0, kUArchHSW     ),
+  E(Popcnt    , GpOutput, 0, kUArchSNBToSKL),
+  E(Rcpss     , SseMerge, 4, kUArchAll     ),
+  E(Roundsd   , SseMerge, 8, kUArchAll     ),
+  E(Roundss   , SseMerge, 4, kUArchAll     ),
+  E(Rsqrtss   , SseMerge, 4, kUArchAll     ),
+  E(Sqrtsd    , SseMerge, 8, kUArchAll     ),
+  E(Sqrtss    , SseMerge, 4, kUArchAll     ),
+  E(Tzcnt     , GpOutput, 0, kUArchHSW     ),
+  E(Vcvtsd2ss , AvxMerge, 4, kUArchAll     ),
+  E(Vcvtsi2sd , AvxMerge, 8, kUArchAll     ),
+  E(Vcvtsi2ss , AvxMerge, 4, kUArchAll     ),
+  E(Vcvtss2sd , AvxMerge, 8, kUArchAll     ),
+  E(Vcvtusi2sd, AvxMerge, 8, kUArchAll     ),
+  E(Vcvtusi2ss, AvxMerge, 4, kUArchAll     ),
+  E(Vrcpss    , AvxMerge, 4, kUArchAll     ),
+  E(Vroundsd  , AvxMerge, 8, kUArchAll     ),
+  E(Vroundss  , AvxMerge, 4, kUArchAll     ),
+  E(Vrsqrtss  , AvxMerge, 4, kUArchAll     ),
+  E(Vsqrtsd   , AvxMerge, 8, kUArchAll     ),
+  E(Vsqrtss   , AvxMerge, 4, kUArchAll     )
+};
+
+#undef E
+
+static const X86DepBreakEntry* X86DepBreakPass_findEntry(InstId instId) noexcept {
+  size_t lo = 0;
+  size_t hi = ASMJIT_ARRAY_SIZE(X86DepBreakPass_table);
+
+  while (lo < hi) {
+    size_t mid = (lo + hi) / 2u;
+    uint32_t midId = X86DepBreakPass_table[mid].instId;
+
+    if (midId == instId)
+      return &X86DepBreakPass_table[mid];
+
+    if (midId < instId)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return nullptr;
+}
+
+// x86::X86DepBreakPass - Utilities
+// ================================
+
+// Tests whether `op` is a virtual register that only holds `size` bytes, so the rest of the register is unused.
+static inline bool X86DepBreakPass_isNarrowVirtReg(const BaseCompiler* cc, const Operand& op, uint32_t size) noexcept {
+  if (!op.isReg() || !Operand::isVirtId(op.id()) || !cc->isVirtIdValid(op.id()))
+    return false;
+  return cc->virtRegById(op.id())->virtSize() <= size;
+}
+
+static inline bool X86DepBreakPass_isGpType(RegType type) noexcept {
+  return type >= RegType::kX86_GpbLo && type <= RegType::kX86_Gpq;
+}
+
+// Tests whether any operand of `inst` starting at `startIndex` uses register `reg`.
+static bool X86DepBreakPass_usesReg(const InstNode* inst, uint32_t startIndex, const BaseReg& reg) noexcept {
+  for (uint32_t i = startIndex; i < inst->opCount(); i++) {
+    const Operand& op = inst->op(i);
+    if (op.isReg()) {
+      if (op.as<BaseReg>().group() == reg.group() && op.id() == reg.id())
+        return true;
+    }
+    else if (op.isMem() && reg.isGp()) {
+      const Mem& mem = op.as<Mem>();
+      if (X86DepBreakPass_isGpType(mem.baseType()) && mem.baseId() == reg.id())
+        return true;
+      if (X86DepBreakPass_isGpType(mem.indexType()) && mem.indexId() == reg.id())
+        return true;
+    }
+  }
+  return false;
+}
+
+// Widens `mov r8|r16, m8|m16|imm` to `movzx r32, m8|m16` or `mov r32, imm` if the register is not wider than the move.
+static void X86DepBreakPass_widenPartialMove(const BaseCompiler* cc, InstNode* inst) noexcept {
+  if (inst->opCount() != 2 || !inst->op(0).isReg())
+    return;
+
+  const BaseReg& dst = inst->op(0).as<BaseReg>();
+  if (!(dst.isType(RegType::kX86_GpbLo) || dst.isType(RegType::kX86_Gpw)))
+    return;
+
+  uint32_t size = dst.size();
+  if (!X86DepBreakPass_isNarrowVirtReg(cc, dst, size))
+    return;
+
+  const Operand& src = inst->op(1);
+  if (src.isMem()) {
+    Mem m = src.as<Mem>();
+    m.setSize(size);
+
+    inst->setId(Inst::kIdMovzx);
+    inst->setOp(0, gpd(dst.id()));
+    inst->setOp(1, m);
+  }
+  else if (src.isImm()) {
+    uint64_t value = src.as<Imm>().valueAs<uint64_t>() & Support::lsbMask<uint64_t>(size * 8u);
+
+    inst->setOp(0, gpd(dst.id()));
+    inst->setOp(1, Imm(value));
+  }
+}
+
+// x86::X86DepBreakPass - Construction & Destruction
+// =================================================
+
+X86DepBreakPass::X86DepBreakPass(bool afterRA) noexcept
+  : Pass(afterRA ? "X86DepBreakPass(PostRA)" : "X86DepBreakPass"),
+    _afterRA(afterRA) {}
+X86DepBreakPass::~X86DepBreakPass() noexcept {}
+
+// x86::X86DepBreakPass - UArch
+// ============================
+
+static uint32_t X86DepBreakPass_uarchMask(CompilerUArch uarch) noexcept {
+  switch (uarch) {
+    case CompilerUArch::kIntelSNB: return X86DepBreakPass::kUArchIntelSNB;
+    case CompilerUArch::kIntelHSW: return X86DepBreakPass::kUArchIntelHSW;
+    case CompilerUArch::kIntelSKL: return X86DepBreakPass::kUArchIntelSKL;
+    default:
+      return X86DepBreakPass::kUArchOther;
+  }
+}
+
+// x86::X86DepBreakPass - Run
+// ==========================
+
+Error X86DepBreakPass::run(Zone* zone, Logger* logger) {
+  DebugUtils::unused(zone, logger);
+
+  Compiler* cc = this->cc();
+  if (!cc->hasCompilerOption(CompilerOptions::kBreakDependencies))
+    return kErrorOk;
+
+  if (cc->hasEncodingOption(EncodingOptions::kOptimizeForSize))
+    return kErrorOk;
+
+  uint32_t uarch = X86DepBreakPass_uarchMask(cc->targetUArch());
+  BaseNode* prevCursor = cc->cursor();
+  Error err = kErrorOk;
+
+  for (BaseNode* node = cc->firstNode(); node; node = node->next()) {
+    if (node->type() != NodeType::kInst)
+      continue;
+
+    InstNode* inst = node->as<InstNode>();
+    InstId instId = inst->id();
+
+    if (instId == Inst::kIdMov) {
+      if (!_afterRA)
+        X86DepBreakPass_widenPartialMove(cc, inst);
+      continue;
+    }
+
+    const X86DepBreakEntry* entry = X86DepBreakPass_findEntry(instId);
+    if (!entry || !(entry->uarchMask & uarch) || inst->opCount() < 2 || !inst->op(0).isReg())
+      continue;
+
+    const BaseReg& dst = inst->op(0).as<BaseReg>();
+    cc->_setCursor(inst->prev());
+
+    switch (entry->kind) {
+      case X86DepBreakKind::kSseMerge: {
+        if (_afterRA || !X86DepBreakPass_isNarrowVirtReg(cc, dst, entry->writeSize) || X86DepBreakPass_usesReg(inst, 1, dst))
+          break;
+
+        err = cc->emit(Inst::kIdXorps, dst, dst);
+        break;
+      }
+
+      case X86DepBreakKind::kAvxMerge: {
+        if (_afterRA || inst->opCount() < 3 || !inst->op(1).isReg() || inst->op(1).id() != dst.id())
+          break;
+
+        if (!X86DepBreakPass_isNarrowVirtReg(cc, dst, entry->writeSize) || X86DepBreakPass_usesReg(inst, 2, dst))
+          break;
+
+        // VXORPS is VEX encoded unless the register was allocated to XMM16..31, which is only possible with AVX-512.
+        err = cc->emit(Inst::kIdVxorps, dst, dst, dst);
+        break;
+      }
+
+      case X86DepBreakKind::kGpOutput: {
+        // 16-bit forms keep the upper part of the destination, thus only 32-bit and 64-bit forms can be zeroed.
+        if (!_afterRA || !dst.isGp() || dst.size() < 4 || X86DepBreakPass_usesReg(inst, 1, dst))
+          break;
+
+        // Flags are overwritten by the instruction itself, so clobbering them before it is fine.
+        err = cc->emit(Inst::kIdXor, gpd(dst.id()), gpd(dst.id()));
+        break;
+      }
+    }
+
+    if (ASMJIT_UNLIKELY(err))
+      break;
+  }
+
+  cc->_setCursor(prevCursor);
+  return err;
+}
+
+// x86::X86DepBreakPass - Tests
+// ============================
+
+#if defined(ASMJIT_TEST)
+UNIT(x86_dep_break_pass) {
+  INFO("Checking whether the table of X86DepBreakPass is sorted");
+
+  for (size_t i = 1; i < ASMJIT_ARRAY_SIZE(X86DepBreakPass_table); i++)
+    EXPECT(X86DepBreakPass_table[i - 1].instId < X86DepBreakPass_table[i].instId);
+
+  for (const X86DepBreakEntry& entry : X86DepBreakPass_table)
+    EXPECT(X86DepBreakPass_findEntry(entry.instId) == &entry);
+
+  EXPECT(X86DepBreakPass_findEntry(Inst::kIdMov) == nullptr);
+}
+#endif
+
+ASMJIT_END_SUB_NAMESPACE
+
+#endif // !ASMJIT_NO_X86 && !ASMJIT_NO_COMPILER
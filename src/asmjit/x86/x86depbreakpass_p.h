@@ -0,0 +1,96 @@
+// This file is part of AsmJit project <https://asmjit.com>
+//
+// See asmjit.h or LICENSE.md for license and copyright information
+// SPDX-License-Identifier: Zlib
+
+#ifndef ASMJIT_X86_X86DEPBREAKPASS_P_H_INCLUDED
+#define ASMJIT_X86_X86DEPBREAKPASS_P_H_INCLUDED
+
+#include "../core/api-config.h"
+#ifndef ASMJIT_NO_COMPILER
+
+#include "../core/compiler.h"
+#include "../x86/x86compiler.h"
+
+ASMJIT_BEGIN_SUB_NAMESPACE(x86)
+
+//! \cond INTERNAL
+//! \addtogroup asmjit_x86
+//! \{
+
+//! False dependency breaking pass.
+//!
+//! Some instructions depend on the previous content of their destination register although the result doesn't need
+//! it, which creates loop-carried dependencies in otherwise independent computations. The pass runs twice and uses a
+//! table of affected instructions, where each entry specifies microarchitectures that suffer from the dependency:
+//!
+//!   - Before register allocation scalar SSE/AVX instructions that merge into a destination that holds a scalar
+//!     (its virtual size fits the written part) get a zero idiom (`xorps` or `vxorps`) and 8-bit and 16-bit moves
+//!     to a virtual register that is not wider than the move are widened to `movzx` or a 32-bit `mov`. Only virtual
+//!     registers tell whether the rest of the register is unused, so this can't be done after allocation.
+//!
+//!   - After register allocation `popcnt`, `lzcnt`, and `tzcnt` get a `xor` zero idiom of their destination on
+//!     microarchitectures that have a false output dependency, if the destination is not also a source.
+//!
+//! The microarchitecture is taken from \ref Compiler::targetUArch(). The pass only runs when \ref
+//! CompilerOptions::kBreakDependencies is enabled and does nothing when \ref EncodingOptions::kOptimizeForSize is
+//! set as all rewrites make the code larger.
+class X86DepBreakPass : public Pass {
+public:
+  ASMJIT_NONCOPYABLE(X86DepBreakPass)
+  typedef Pass Base;
+
+  //! Microarchitectures (as a mask) that the table of affected instructions refers to.
+  enum UArch : uint32_t {
+    //! All microarchitectures (the dependency is architectural).
+    kUArchAll = 0xFFu,
+    //! Intel Sandy Bridge and Ivy Bridge.
+    kUArchIntelSNB = 0x01u,
+    //! Intel Haswell and Broadwell.
+    kUArchIntelHSW = 0x02u,
+    //! Intel Skylake and its derivatives (Kaby Lake, Coffee Lake, Comet Lake).
+    kUArchIntelSKL = 0x04u,
+    //! Unknown microarchitecture or a microarchitecture without false output dependencies.
+    kUArchOther = 0x80u
+  };
+
+  //! \name Members
+  //! \{
+
+  //! Whether the pass runs after the register allocation pass.
+  bool _afterRA;
+
+  //! \}
+
+  //! \name Construction & Destruction
+  //! \{
+
+  //! Creates the pass, `afterRA` specifies whether the pass runs after the register allocation pass.
+  explicit X86DepBreakPass(bool afterRA) noexcept;
+  virtual ~X86DepBreakPass() noexcept;
+
+  //! \}
+
+  //! \name Accessors
+  //! \{
+
+  //! Returns the associated `x86::Compiler`.
+  inline Compiler* cc() const noexcept { return static_cast<Compiler*>(_cb); }
+
+  //! \}
+
+  //! \name Run
+  //! \{
+
+  Error run(Zone* zone, Logger* logger) override;
+
+  //! \}
+};
+
+//! \}
+//! \endcond
+
+ASMJIT_END_SUB_NAMESPACE
+
+#endif // !ASMJIT_NO_COMPILER
+#endif // ASMJIT_X86_X86DEPBREAKPASS_P_H_INCLUDED
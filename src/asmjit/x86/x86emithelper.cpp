@@ -600,10 +600,18 @@ static Error ASMJIT_CDECL Emitter_emitArgsAssignment(BaseEmitter* emitter, const
   return emitHelper.emitArgsAssignment(frame, args);
 }
 
+static Error ASMJIT_CDECL Emitter_emitPreserveWrapper(BaseEmitter* emitter, const FuncFrame& frame, const void* target) {
+  EmitHelper emitHelper(emitter, frame.isAvxEnabled(), frame.isAvx512Enabled());
+  ASMJIT_PROPAGATE(emitHelper.emitProlog(frame));
+  ASMJIT_PROPAGATE(emitter->emit(Inst::kIdCall, Imm(target)));
+  return emitHelper.emitEpilog(frame);
+}
+
 void assignEmitterFuncs(BaseEmitter* emitter) {
   emitter->_funcs.emitProlog = Emitter_emitProlog;
   emitter->_funcs.emitEpilog = Emitter_emitEpilog;
   emitter->_funcs.emitArgsAssignment = Emitter_emitArgsAssignment;
+  emitter->_funcs.emitPreserveWrapper = Emitter_emitPreserveWrapper;
 
 #ifndef ASMJIT_NO_LOGGING
   emitter->_funcs.formatInstruction = FormatterInternal::formatInstruction;
@@ -96,6 +96,11 @@ ASMJIT_FAVOR_SIZE Error initCallConv(CallConv& cc, CallConvId ccId, const Enviro
         cc.setPassedOrder(RegGroup::kGp, kZax, kZdx, kZcx);
         break;
 
+      case CallConvId::kPreserveMost:
+      case CallConvId::kPreserveAll:
+        ccId = CallConvId::kCDecl;
+        break;
+
       case CallConvId::kLightCall2:
       case CallConvId::kLightCall3:
       case CallConvId::kLightCall4: {
@@ -146,7 +151,12 @@ ASMJIT_FAVOR_SIZE Error initCallConv(CallConv& cc, CallConvId ccId, const Enviro
     if (shouldThreatAsCDeclIn64BitMode(ccId))
       ccId = winABI ? CallConvId::kX64Windows : CallConvId::kX64SystemV;
 
-    switch (ccId) {
+    // PreserveMost and PreserveAll pass arguments the same way as the platform's native calling convention.
+    CallConvId baseId = ccId;
+    if (ccId == CallConvId::kPreserveMost || ccId == CallConvId::kPreserveAll)
+      baseId = winABI ? CallConvId::kX64Windows : CallConvId::kX64SystemV;
+
+    switch (baseId) {
       case CallConvId::kX64SystemV: {
         cc.setFlags(CallConvFlags::kPassFloatsByVec |
                     CallConvFlags::kPassMmxByXmm    |
@@ -209,6 +219,12 @@ ASMJIT_FAVOR_SIZE Error initCallConv(CallConv& cc, CallConvId ccId, const Enviro
       default:
         return DebugUtils::errored(kErrorInvalidArgument);
     }
+
+    if (baseId != ccId) {
+      cc.setPreservedRegs(RegGroup::kGp, Support::lsbMask<uint32_t>(16) & ~Support::bitMask(11));
+      if (ccId == CallConvId::kPreserveAll)
+        cc.setPreservedRegs(RegGroup::kVec, Support::lsbMask<uint32_t>(16));
+    }
   }
 
   cc.setId(ccId);
@@ -0,0 +1,117 @@
+// This file is part of AsmJit project <https://asmjit.com>
+//
+// See asmjit.h or LICENSE.md for license and copyright information
+// SPDX-License-Identifier: Zlib
+
+#include "../core/api-build_p.h"
+#if !defined(ASMJIT_NO_X86) && !defined(ASMJIT_NO_COMPILER)
+
+#include "../x86/x86compiler.h"
+#include "../x86/x86ifconvertpass_p.h"
+
+ASMJIT_BEGIN_SUB_NAMESPACE(x86)
+
+// x86::X86IfConvertPass - Utilities
+// =================================
+
+static inline bool X86IfConvertPass_isDst(const Operand& op, const BaseReg& dst) noexcept {
+  return op.isReg() && op.id() == dst.id();
+}
+
+static inline bool X86IfConvertPass_isZeroOrOne(const Operand& op) noexcept {
+  return op.isImm() && uint64_t(op.as<Imm>().value()) <= 1u;
+}
+
+// x86::X86IfConvertPass - Construction & Destruction
+// ==================================================
+
+X86IfConvertPass::X86IfConvertPass() noexcept
+  : BaseIfConvertPass("X86IfConvertPass") {}
+X86IfConvertPass::~X86IfConvertPass() noexcept {}
+
+// x86::X86IfConvertPass - Interface
+// =================================
+
+bool X86IfConvertPass::isCondJump(const InstNode* node, uint32_t* condOut) const noexcept {
+  if (node->opCount() != 1 || !node->op(0).isLabel())
+    return false;
+
+  for (uint32_t cond = 0; cond < 16; cond++) {
+    if (Inst::jccFromCond(CondCode(cond)) == node->id()) {
+      *condOut = cond;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool X86IfConvertPass::isJump(const InstNode* node) const noexcept {
+  return node->id() == Inst::kIdJmp && node->opCount() == 1 && node->op(0).isLabel();
+}
+
+bool X86IfConvertPass::isMove(const InstNode* node) const noexcept {
+  if (node->id() != Inst::kIdMov || node->opCount() != 2)
+    return false;
+
+  // CMOV doesn't support 8-bit and 16-bit registers and a 32-bit CMOV always clears the upper part of 64-bit register
+  // even when the condition is false, so only moves that write the whole virtual register can be selected.
+  const Operand& dst = node->op(0);
+  const Operand& src = node->op(1);
+
+  if (!(Reg::isGpd(dst) || Reg::isGpq(dst)) || !cc()->isVirtIdValid(dst.id()))
+    return false;
+
+  if (cc()->virtRegById(dst.id())->virtSize() != dst.as<Reg>().size())
+    return false;
+
+  return src.isImm() || (src.isReg() && src.as<Reg>().type() == dst.as<Reg>().type());
+}
+
+Error X86IfConvertPass::emitSelect(uint32_t cond, const Select& select) noexcept {
+  Compiler* cc = this->cc();
+  CondCode condCode = CondCode(cond);
+
+  Gp dst = select.dst.as<Gp>();
+  Operand taken = select.taken;
+  Operand notTaken = select.notTaken;
+
+  // Make `notTaken` the destination if the destination is not written by one of the blocks, only `cmovcc` is needed.
+  if (X86IfConvertPass_isDst(taken, dst)) {
+    std::swap(taken, notTaken);
+    condCode = negateCond(condCode);
+  }
+
+  if (!X86IfConvertPass_isDst(notTaken, dst)) {
+    if (X86IfConvertPass_isZeroOrOne(taken) && X86IfConvertPass_isZeroOrOne(notTaken) &&
+        taken.as<Imm>().value() != notTaken.as<Imm>().value()) {
+      // Select of 0 and 1 is `setcc` - MOV is used to clear the destination as XOR would change flags.
+      if (taken.as<Imm>().value() == 0)
+        condCode = negateCond(condCode);
+
+      ASMJIT_PROPAGATE(cc->emit(Inst::kIdMov, dst, Imm(0)));
+      return cc->emit(Inst::setccFromCond(condCode), dst.r8());
+    }
+
+    if (taken.isImm() && notTaken.isReg()) {
+      std::swap(taken, notTaken);
+      condCode = negateCond(condCode);
+    }
+
+    ASMJIT_PROPAGATE(cc->emit(Inst::kIdMov, dst, notTaken));
+  }
+
+  // CMOV doesn't have an immediate form.
+  if (taken.isImm()) {
+    Gp tmp;
+    ASMJIT_PROPAGATE(cc->_newReg(&tmp, dst));
+    ASMJIT_PROPAGATE(cc->emit(Inst::kIdMov, tmp, taken));
+    taken = tmp;
+  }
+
+  return cc->emit(Inst::cmovccFromCond(condCode), dst, taken);
+}
+
+ASMJIT_END_SUB_NAMESPACE
+
+#endif // !ASMJIT_NO_X86 && !ASMJIT_NO_COMPILER
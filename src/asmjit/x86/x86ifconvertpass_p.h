@@ -0,0 +1,62 @@
+// This file is part of AsmJit project <https://asmjit.com>
+//
+// See asmjit.h or LICENSE.md for license and copyright information
+// SPDX-License-Identifier: Zlib
+
+#ifndef ASMJIT_X86_X86IFCONVERTPASS_P_H_INCLUDED
+#define ASMJIT_X86_X86IFCONVERTPASS_P_H_INCLUDED
+
+#include "../core/api-config.h"
+#ifndef ASMJIT_NO_COMPILER
+
+#include "../core/ifconvertpass_p.h"
+#include "../x86/x86compiler.h"
+
+ASMJIT_BEGIN_SUB_NAMESPACE(x86)
+
+//! \cond INTERNAL
+//! \addtogroup asmjit_x86
+//! \{
+
+//! X86 if-conversion pass.
+//!
+//! Converts branches marked by \ref InstOptions::kUnpredictable into `cmovcc` and `setcc` instructions.
+class X86IfConvertPass : public BaseIfConvertPass {
+public:
+  ASMJIT_NONCOPYABLE(X86IfConvertPass)
+  typedef BaseIfConvertPass Base;
+
+  //! \name Construction & Destruction
+  //! \{
+
+  X86IfConvertPass() noexcept;
+  virtual ~X86IfConvertPass() noexcept;
+
+  //! \}
+
+  //! \name Accessors
+  //! \{
+
+  //! Returns the compiler casted to `x86::Compiler`.
+  inline Compiler* cc() const noexcept { return static_cast<Compiler*>(_cb); }
+
+  //! \}
+
+  //! \name Interface
+  //! \{
+
+  bool isCondJump(const InstNode* node, uint32_t* condOut) const noexcept override;
+  bool isJump(const InstNode* node) const noexcept override;
+  bool isMove(const InstNode* node) const noexcept override;
+  Error emitSelect(uint32_t cond, const Select& select) noexcept override;
+
+  //! \}
+};
+
+//! \}
+//! \endcond
+
+ASMJIT_END_SUB_NAMESPACE
+
+#endif // !ASMJIT_NO_COMPILER
+#endif // ASMJIT_X86_X86IFCONVERTPASS_P_H_INCLUDED
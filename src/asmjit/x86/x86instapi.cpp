@@ -92,6 +92,199 @@ InstId InstInternal::stringToInstId(Arch arch, const char* s, size_t len) noexce
 
   return Inst::kIdNone;
 }
+
+// Names of `InstDB::EncodingId` values, see `encodingIdToString()`.
+static const char encodingNameData[] =
+  "None\0"
+  "X86Op\0"
+  "X86Op_Mod11RM\0"
+  "X86Op_Mod11RM_I8\0"
+  "X86Op_xAddr\0"
+  "X86Op_xAX\0"
+  "X86Op_xDX_xAX\0"
+  "X86Op_MemZAX\0"
+  "X86I_xAX\0"
+  "X86M\0"
+  "X86M_NoMemSize\0"
+  "X86M_NoSize\0"
+  "X86M_GPB\0"
+  "X86M_GPB_MulDiv\0"
+  "X86M_Only\0"
+  "X86M_Only_EDX_EAX\0"
+  "X86M_Nop\0"
+  "X86R_Native\0"
+  "X86R_FromM\0"
+  "X86R32_EDX_EAX\0"
+  "X86Rm\0"
+  "X86Rm_Raw66H\0"
+  "X86Rm_NoSize\0"
+  "X86Mr\0"
+  "X86Mr_NoSize\0"
+  "X86Arith\0"
+  "X86Bswap\0"
+  "X86Bt\0"
+  "X86Call\0"
+  "X86Cmpxchg\0"
+  "X86Cmpxchg8b_16b\0"
+  "X86Crc\0"
+  "X86Enter\0"
+  "X86Imul\0"
+  "X86In\0"
+  "X86Ins\0"
+  "X86IncDec\0"
+  "X86Int\0"
+  "X86Jcc\0"
+  "X86JecxzLoop\0"
+  "X86Jmp\0"
+  "X86JmpRel\0"
+  "X86LcallLjmp\0"
+  "X86Lea\0"
+  "X86Mov\0"
+  "X86Movabs\0"
+  "X86MovsxMovzx\0"
+  "X86MovntiMovdiri\0"
+  "X86EnqcmdMovdir64b\0"
+  "X86Out\0"
+  "X86Outs\0"
+  "X86Push\0"
+  "X86Pop\0"
+  "X86Ret\0"
+  "X86Rot\0"
+  "X86Set\0"
+  "X86ShldShrd\0"
+  "X86StrRm\0"
+  "X86StrMr\0"
+  "X86StrMm\0"
+  "X86Test\0"
+  "X86Xadd\0"
+  "X86Xchg\0"
+  "X86Fence\0"
+  "X86Bndmov\0"
+  "FpuOp\0"
+  "FpuArith\0"
+  "FpuCom\0"
+  "FpuFldFst\0"
+  "FpuM\0"
+  "FpuR\0"
+  "FpuRDef\0"
+  "FpuStsw\0"
+  "ExtRm\0"
+  "ExtRm_XMM0\0"
+  "ExtRm_ZDI\0"
+  "ExtRm_P\0"
+  "ExtRm_Wx\0"
+  "ExtRm_Wx_GpqOnly\0"
+  "ExtRmRi\0"
+  "ExtRmRi_P\0"
+  "ExtRmi\0"
+  "ExtRmi_P\0"
+  "ExtPextrw\0"
+  "ExtExtract\0"
+  "ExtMov\0"
+  "ExtMovbe\0"
+  "ExtMovd\0"
+  "ExtMovq\0"
+  "ExtExtrq\0"
+  "ExtInsertq\0"
+  "Ext3dNow\0"
+  "VexOp\0"
+  "VexOpMod\0"
+  "VexKmov\0"
+  "VexR_Wx\0"
+  "VexM\0"
+  "VexM_VM\0"
+  "VexMr_Lx\0"
+  "VexMr_VM\0"
+  "VexMri\0"
+  "VexMri_Lx\0"
+  "VexMri_Vpextrw\0"
+  "VexRm\0"
+  "VexRm_ZDI\0"
+  "VexRm_Wx\0"
+  "VexRm_Lx\0"
+  "VexRm_Lx_Narrow\0"
+  "VexRm_Lx_Bcst\0"
+  "VexRm_VM\0"
+  "VexRm_T1_4X\0"
+  "VexRmi\0"
+  "VexRmi_Wx\0"
+  "VexRmi_Lx\0"
+  "VexRvm\0"
+  "VexRvm_Wx\0"
+  "VexRvm_ZDX_Wx\0"
+  "VexRvm_Lx\0"
+  "VexRvm_Lx_KEvex\0"
+  "VexRvm_Lx_2xK\0"
+  "VexRvmr\0"
+  "VexRvmr_Lx\0"
+  "VexRvmi\0"
+  "VexRvmi_KEvex\0"
+  "VexRvmi_Lx\0"
+  "VexRvmi_Lx_KEvex\0"
+  "VexRmv\0"
+  "VexRmv_Wx\0"
+  "VexRmv_VM\0"
+  "VexRmvRm_VM\0"
+  "VexRmvi\0"
+  "VexRmMr\0"
+  "VexRmMr_Lx\0"
+  "VexRvmRmv\0"
+  "VexRvmRmi\0"
+  "VexRvmRmi_Lx\0"
+  "VexRvmRmvRmi\0"
+  "VexRvmMr\0"
+  "VexRvmMvr\0"
+  "VexRvmMvr_Lx\0"
+  "VexRvmVmi\0"
+  "VexRvmVmi_Lx\0"
+  "VexRvmVmi_Lx_MEvex\0"
+  "VexVm\0"
+  "VexVm_Wx\0"
+  "VexVmi\0"
+  "VexVmi_Lx\0"
+  "VexVmi4_Wx\0"
+  "VexVmi_Lx_MEvex\0"
+  "VexRvrmRvmr\0"
+  "VexRvrmRvmr_Lx\0"
+  "VexRvrmiRvmri_Lx\0"
+  "VexMovdMovq\0"
+  "VexMovssMovsd\0"
+  "Fma4\0"
+  "Fma4_Lx\0"
+  "AmxCfg\0"
+  "AmxR\0"
+  "AmxRm\0"
+  "AmxMr\0"
+  "AmxRmv\0"
+  ;
+
+static const uint16_t encodingNameIndex[] = {
+  0, 5, 11, 25, 42, 54, 64, 78, 91, 100, 105, 120,
+  132, 141, 157, 167, 185, 194, 206, 217, 232, 238, 251, 264,
+  270, 283, 292, 301, 307, 315, 326, 343, 350, 359, 367, 373,
+  380, 390, 397, 404, 417, 424, 434, 447, 454, 461, 471, 485,
+  502, 521, 528, 536, 544, 551, 558, 565, 572, 584, 593, 602,
+  611, 619, 627, 635, 644, 654, 660, 669, 676, 686, 691, 696,
+  704, 712, 718, 729, 739, 747, 756, 773, 781, 791, 798, 807,
+  817, 828, 835, 844, 852, 860, 869, 880, 889, 895, 904, 912,
+  920, 925, 933, 942, 951, 958, 968, 983, 989, 999, 1008, 1017,
+  1033, 1047, 1056, 1068, 1075, 1085, 1095, 1102, 1112, 1126, 1136, 1152,
+  1166, 1174, 1185, 1193, 1207, 1218, 1235, 1242, 1252, 1262, 1274, 1282,
+  1290, 1301, 1311, 1321, 1334, 1347, 1356, 1366, 1379, 1389, 1402, 1421,
+  1427, 1436, 1443, 1453, 1464, 1480, 1492, 1507, 1524, 1536, 1550, 1555,
+  1563, 1570, 1575, 1581, 1587
+};
+static_assert(ASMJIT_ARRAY_SIZE(encodingNameIndex) == InstDB::kEncodingCount,
+              "InstDB::EncodingId: update 'encodingNameIndex' table");
+
+Error InstInternal::encodingIdToString(Arch arch, uint32_t encodingId, String& output) noexcept {
+  DebugUtils::unused(arch);
+
+  if (ASMJIT_UNLIKELY(encodingId >= ASMJIT_ARRAY_SIZE(encodingNameIndex)))
+    return DebugUtils::errored(kErrorInvalidArgument);
+
+  return output.append(encodingNameData + encodingNameIndex[encodingId]);
+}
 #endif // !ASMJIT_NO_TEXT
 
 // x86::InstInternal - Validate
@@ -0,0 +1,44 @@
+// This file is part of AsmJit project <https://asmjit.com>
+//
+// See asmjit.h or LICENSE.md for license and copyright information
+// SPDX-License-Identifier: Zlib
+
+#include "../core/api-build_p.h"
+#if !defined(ASMJIT_NO_X86) && !defined(ASMJIT_NO_COMPILER)
+
+#include "../x86/x86emithelper_p.h"
+#include "../x86/x86instdb.h"
+#include "../x86/x86phipass_p.h"
+
+ASMJIT_BEGIN_SUB_NAMESPACE(x86)
+
+// x86::X86PhiPass - Construction & Destruction
+// ============================================
+
+X86PhiPass::X86PhiPass() noexcept
+  : BasePhiPass("X86PhiPass") {}
+X86PhiPass::~X86PhiPass() noexcept {}
+
+// x86::X86PhiPass - Interface
+// ===========================
+
+InstControlFlow X86PhiPass::controlFlow(const InstNode* node) const noexcept {
+  InstId instId = node->realId();
+  if (!Inst::isDefinedId(instId))
+    return InstControlFlow::kRegular;
+  return InstDB::infoById(instId).controlFlow();
+}
+
+Error X86PhiPass::emitMove(const BaseReg& dst, const BaseReg& src, TypeId typeId) noexcept {
+  const FuncFrame& frame = func()->frame();
+  EmitHelper emitHelper(cc(), frame.isAvxEnabled() || frame.isAvx512Enabled(), frame.isAvx512Enabled());
+  return emitHelper.emitRegMove(dst, src, typeId);
+}
+
+Error X86PhiPass::emitJump(const Label& label) noexcept {
+  return cc()->emit(Inst::kIdJmp, label);
+}
+
+ASMJIT_END_SUB_NAMESPACE
+
+#endif // !ASMJIT_NO_X86 && !ASMJIT_NO_COMPILER
@@ -0,0 +1,51 @@
+// This file is part of AsmJit project <https://asmjit.com>
+//
+// See asmjit.h or LICENSE.md for license and copyright information
+// SPDX-License-Identifier: Zlib
+
+#ifndef ASMJIT_X86_X86PHIPASS_P_H_INCLUDED
+#define ASMJIT_X86_X86PHIPASS_P_H_INCLUDED
+
+#include "../core/api-config.h"
+#ifndef ASMJIT_NO_COMPILER
+
+#include "../core/phipass_p.h"
+#include "../x86/x86compiler.h"
+
+ASMJIT_BEGIN_SUB_NAMESPACE(x86)
+
+//! \cond INTERNAL
+//! \addtogroup asmjit_x86
+//! \{
+
+//! X86 phi node lowering pass, see \ref BasePhiPass.
+class X86PhiPass : public BasePhiPass {
+public:
+  ASMJIT_NONCOPYABLE(X86PhiPass)
+  typedef BasePhiPass Base;
+
+  //! \name Construction & Destruction
+  //! \{
+
+  X86PhiPass() noexcept;
+  virtual ~X86PhiPass() noexcept;
+
+  //! \}
+
+  //! \name Interface
+  //! \{
+
+  InstControlFlow controlFlow(const InstNode* node) const noexcept override;
+  Error emitMove(const BaseReg& dst, const BaseReg& src, TypeId typeId) noexcept override;
+  Error emitJump(const Label& label) noexcept override;
+
+  //! \}
+};
+
+//! \}
+//! \endcond
+
+ASMJIT_END_SUB_NAMESPACE
+
+#endif // !ASMJIT_NO_COMPILER
+#endif // ASMJIT_X86_X86PHIPASS_P_H_INCLUDED
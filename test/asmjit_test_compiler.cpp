@@ -126,6 +126,8 @@ int TestApp::run() {
       cc.addDiagnosticOptions(DiagnosticOptions::kRAAnnotate | DiagnosticOptions::kRADebugAll);
 #endif
 
+      cc.setTargetCpuInfo(runtime.cpuInfo());
+
       compileTimer.start();
       test->compile(cc);
       compileTimer.stop();
@@ -400,6 +400,328 @@ public:
   }
 };
 
+// a64::Compiler - A64Test_IfConvert
+// =================================
+
+class A64Test_IfConvert : public A64TestCase {
+public:
+  A64Test_IfConvert()
+    : A64TestCase("IfConvert") {}
+
+  static void add(TestApp& app) {
+    app.add(new A64Test_IfConvert());
+  }
+
+  virtual void compile(a64::Compiler& cc) {
+    FuncNode* funcNode = cc.addFunc(FuncSignatureT<int, int, int>());
+
+    arm::Gp a = cc.newInt32("a");
+    arm::Gp b = cc.newInt32("b");
+    arm::Gp r = cc.newInt32("r");
+    arm::Gp s = cc.newInt32("s");
+
+    Label L_MaxElse = cc.newLabel();
+    Label L_MaxEnd = cc.newLabel();
+    Label L_ClampEnd = cc.newLabel();
+    Label L_EqElse = cc.newLabel();
+    Label L_EqEnd = cc.newLabel();
+
+    funcNode->setArg(0, a);
+    funcNode->setArg(1, b);
+
+    // Diamond: r = max(a, b).
+    cc.cmp(a, b);
+    cc.unpredictable().b_lt(L_MaxElse);
+    cc.mov(r, a);
+    cc.b(L_MaxEnd);
+    cc.bind(L_MaxElse);
+    cc.mov(r, b);
+    cc.bind(L_MaxEnd);
+
+    // Triangle: r = min(r, 100).
+    cc.cmp(r, 100);
+    cc.unpredictable().b_le(L_ClampEnd);
+    cc.mov(r, 100);
+    cc.bind(L_ClampEnd);
+
+    // Diamond of 0 and 1: s = a == b.
+    cc.cmp(a, b);
+    cc.unpredictable().b_eq(L_EqElse);
+    cc.mov(s, 0);
+    cc.b(L_EqEnd);
+    cc.bind(L_EqElse);
+    cc.mov(s, 1);
+    cc.bind(L_EqEnd);
+
+    cc.add(r, r, s, a64::lsl(10));
+    cc.ret(r);
+    cc.endFunc();
+  }
+
+  virtual bool run(void* _func, String& result, String& expect) {
+    typedef int (*Func)(int, int);
+    Func func = ptr_as_func<Func>(_func);
+
+    static const int args[][2] = { { 1, 2 }, { 5, -3 }, { 7, 7 }, { 200, 1 }, { -8, 150 } };
+
+    result.clear();
+    expect.clear();
+
+    for (size_t i = 0; i < ASMJIT_ARRAY_SIZE(args); i++) {
+      int a = args[i][0];
+      int b = args[i][1];
+      int r = a > b ? a : b;
+      r = r < 100 ? r : 100;
+
+      result.appendFormat("%s%d", i ? ", " : "ret={", func(a, b));
+      expect.appendFormat("%s%d", i ? ", " : "ret={", r + (a == b ? 1024 : 0));
+    }
+
+    result.append('}');
+    expect.append('}');
+    return result == expect;
+  }
+};
+
+// a64::Compiler - A64Test_Peephole
+// =================================
+
+class A64Test_Peephole : public A64TestCase {
+public:
+  A64Test_Peephole()
+    : A64TestCase("Peephole") {}
+
+  static void add(TestApp& app) {
+    app.add(new A64Test_Peephole());
+  }
+
+  virtual void compile(a64::Compiler& cc) {
+    FuncNode* funcNode = cc.addFunc(FuncSignatureT<int64_t, int64_t, int64_t, const int64_t*>());
+
+    arm::Gp a = cc.newInt64("a");
+    arm::Gp b = cc.newInt64("b");
+    arm::Gp p = cc.newIntPtr("p");
+    arm::Gp t = cc.newInt64("t");
+    arm::Gp u = cc.newInt64("u");
+    arm::Gp r = cc.newInt64("r");
+
+    Label L_Zero = cc.newLabel();
+    Label L_Bit = cc.newLabel();
+    Label L_And = cc.newLabel();
+    Label L_Sign = cc.newLabel();
+
+    funcNode->setArg(0, a);
+    funcNode->setArg(1, b);
+    funcNode->setArg(2, p);
+
+    cc.mov(r, 0);
+
+    // cmp + b.ne -> cbnz.
+    cc.cmp(a, 0);
+    cc.b_ne(L_Zero);
+    cc.add(r, r, 1);
+    cc.bind(L_Zero);
+
+    // tst + b.eq -> tbz.
+    cc.tst(b, 8);
+    cc.b_eq(L_Bit);
+    cc.add(r, r, 2);
+    cc.bind(L_Bit);
+
+    // and + cmp + b.ne -> tst + b.ne.
+    cc.and_(t, a, b);
+    cc.cmp(t, 0);
+    cc.b_ne(L_And);
+    cc.add(r, r, 4);
+    cc.bind(L_And);
+
+    // cmp + b.lt -> tbnz of the sign bit.
+    cc.cmp(a, 0);
+    cc.b_lt(L_Sign);
+    cc.add(r, r, 8);
+    cc.bind(L_Sign);
+
+    // ldr + add -> post-index ldr.
+    cc.ldr(t, a64::ptr(p));
+    cc.add(p, p, 8);
+    cc.ldr(u, a64::ptr(p));
+    cc.add(p, p, 8);
+
+    // mul + add|sub -> madd|msub.
+    cc.mul(t, t, u);
+    cc.add(t, t, r);
+    cc.ldr(u, a64::ptr(p));
+    cc.mul(u, u, b);
+    cc.sub(u, t, u);
+
+    cc.lsl(u, u, 4);
+    cc.add(r, r, u);
+    cc.ret(r);
+    cc.endFunc();
+  }
+
+  virtual bool run(void* _func, String& result, String& expect) {
+    typedef int64_t (*Func)(int64_t, int64_t, const int64_t*);
+    Func func = ptr_as_func<Func>(_func);
+
+    static const int64_t args[][2] = { { 0, 0 }, { 3, 8 }, { -5, 12 }, { 6, 1 }, { -16, 16 } };
+    static const int64_t data[3] = { 3, -7, 11 };
+
+    result.clear();
+    expect.clear();
+
+    for (size_t i = 0; i < ASMJIT_ARRAY_SIZE(args); i++) {
+      int64_t a = args[i][0];
+      int64_t b = args[i][1];
+      int64_t r = (a == 0 ? 1 : 0) + ((b & 8) != 0 ? 2 : 0) + ((a & b) == 0 ? 4 : 0) + (a >= 0 ? 8 : 0);
+      int64_t u = data[0] * data[1] + r - data[2] * b;
+
+      result.appendFormat("%s%lld", i ? ", " : "ret={", (long long)func(a, b, data));
+      expect.appendFormat("%s%lld", i ? ", " : "ret={", (long long)(r + u * 16));
+    }
+
+    result.append('}');
+    expect.append('}');
+    return result == expect;
+  }
+};
+
+// a64::Compiler - A64Test_PeepholeFlagsAtTarget
+// ==============================================
+
+class A64Test_PeepholeFlagsAtTarget : public A64TestCase {
+public:
+  A64Test_PeepholeFlagsAtTarget()
+    : A64TestCase("PeepholeFlagsAtTarget") {}
+
+  static void add(TestApp& app) {
+    app.add(new A64Test_PeepholeFlagsAtTarget());
+  }
+
+  virtual void compile(a64::Compiler& cc) {
+    FuncNode* funcNode = cc.addFunc(FuncSignatureT<int64_t, int64_t, int64_t, int64_t>());
+
+    arm::Gp a = cc.newInt64("a");
+    arm::Gp b = cc.newInt64("b");
+    arm::Gp c = cc.newInt64("c");
+    arm::Gp r = cc.newInt64("r");
+
+    Label L_Target = cc.newLabel();
+    Label L_Exit = cc.newLabel();
+
+    funcNode->setArg(0, a);
+    funcNode->setArg(1, b);
+    funcNode->setArg(2, c);
+
+    cc.cmp(b, 1234);
+    cc.cset(r, arm::CondCode::kEQ);
+
+    // The fall-through overwrites flags, but the target reads them, so `cmp + b.eq` must not become `cbz`.
+    cc.cmp(a, 0);
+    cc.b_eq(L_Target);
+    cc.cmp(b, 1);
+    cc.cset(r, arm::CondCode::kEQ);
+    cc.b(L_Exit);
+
+    cc.bind(L_Target);
+    cc.csel(r, b, c, arm::CondCode::kEQ);
+
+    cc.bind(L_Exit);
+    cc.ret(r);
+    cc.endFunc();
+  }
+
+  virtual bool run(void* _func, String& result, String& expect) {
+    typedef int64_t (*Func)(int64_t, int64_t, int64_t);
+    Func func = ptr_as_func<Func>(_func);
+
+    int64_t r0 = func(0, 5, 7);
+    int64_t r1 = func(3, 1, 7);
+    int64_t r2 = func(3, 2, 7);
+
+    result.assignFormat("ret={%lld, %lld, %lld}", (long long)r0, (long long)r1, (long long)r2);
+    expect.assignFormat("ret={%lld, %lld, %lld}", 5ll, 1ll, 0ll);
+
+    return result == expect;
+  }
+};
+
+// a64::Compiler - A64Test_Phi
+// ===========================
+
+class A64Test_Phi : public A64TestCase {
+public:
+  A64Test_Phi()
+    : A64TestCase("Phi") {}
+
+  static void add(TestApp& app) {
+    app.add(new A64Test_Phi());
+  }
+
+  virtual void compile(a64::Compiler& cc) {
+    FuncNode* funcNode = cc.addFunc(FuncSignatureT<int64_t, int64_t>());
+
+    arm::Gp n = cc.newInt64("n");
+    arm::Gp a0 = cc.newInt64("a0");
+    arm::Gp b0 = cc.newInt64("b0");
+    arm::Gp a = cc.newInt64("a");
+    arm::Gp b = cc.newInt64("b");
+    arm::Gp i = cc.newInt64("i");
+    arm::Gp t = cc.newInt64("t");
+    arm::Gp i1 = cc.newInt64("i1");
+    arm::Gp r = cc.newInt64("r");
+
+    Label L_Loop = cc.newLabel();
+    Label L_Exit = cc.newLabel();
+
+    funcNode->setArg(0, n);
+
+    cc.mov(a0, 0);
+    cc.mov(b0, 1);
+
+    // `a` and `b` are swapped on the back edge and the branch to `L_Exit` is a critical edge.
+    cc.bind(L_Loop);
+    cc.phi(a, a0, funcNode->label(), b, L_Loop);
+    cc.phi(b, b0, funcNode->label(), t, L_Loop);
+    cc.phi(i, n, funcNode->label(), i1, L_Loop);
+    cc.cbz(i, L_Exit);
+    cc.add(t, a, b);
+    cc.sub(i1, i, 1);
+    cc.b(L_Loop);
+
+    cc.bind(L_Exit);
+    PhiNode* phiNode;
+    cc.addPhiNode(&phiNode, r, 1);
+    phiNode->setIncoming(0, a, L_Loop);
+    cc.ret(r);
+    cc.endFunc();
+  }
+
+  virtual bool run(void* _func, String& result, String& expect) {
+    typedef int64_t (*Func)(int64_t);
+    Func func = ptr_as_func<Func>(_func);
+
+    result.clear();
+    expect.clear();
+
+    int64_t a = 0;
+    int64_t b = 1;
+
+    for (int64_t n = 0; n < 12; n++) {
+      result.appendFormat("%s%lld", n ? ", " : "ret={", (long long)func(n));
+      expect.appendFormat("%s%lld", n ? ", " : "ret={", (long long)a);
+
+      int64_t t = a + b;
+      a = b;
+      b = t;
+    }
+
+    result.append('}');
+    expect.append('}');
+    return result == expect;
+  }
+};
+
 // a64::Compiler - A64Test_Invoke1
 // ===============================
 
@@ -681,6 +1003,10 @@ void compiler_add_a64_tests(TestApp& app) {
   app.addT<A64Test_Simd1>();
   app.addT<A64Test_Adr>();
   app.addT<A64Test_Branch1>();
+  app.addT<A64Test_IfConvert>();
+  app.addT<A64Test_Peephole>();
+  app.addT<A64Test_PeepholeFlagsAtTarget>();
+  app.addT<A64Test_Phi>();
   app.addT<A64Test_Invoke1>();
   app.addT<A64Test_Invoke2>();
   app.addT<A64Test_Invoke3>();
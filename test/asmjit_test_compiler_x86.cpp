@@ -518,6 +518,136 @@ public:
   }
 };
 
+// x86::Compiler - X86Test_JumpThreading
+// =====================================
+
+class X86Test_JumpThreading : public X86TestCase {
+public:
+  X86Test_JumpThreading() : X86TestCase("JumpThreading") {}
+
+  static void add(TestApp& app) {
+    app.add(new X86Test_JumpThreading());
+  }
+
+  virtual void compile(x86::Compiler& cc) {
+    FuncNode* funcNode = cc.addFunc(FuncSignatureT<int, int, int>(CallConvId::kHost));
+
+    Label L_Less = cc.newLabel();
+    Label L_LessChain = cc.newLabel();
+    Label L_Zero = cc.newLabel();
+    Label L_NotZero = cc.newLabel();
+    Label L_Merge = cc.newLabel();
+    Label L_MergeChain = cc.newLabel();
+    Label L_Exit = cc.newLabel();
+
+    x86::Gp a = cc.newInt32("a");
+    x86::Gp b = cc.newInt32("b");
+    x86::Gp r = cc.newInt32("r");
+
+    funcNode->setArg(0, a);
+    funcNode->setArg(1, b);
+
+    // Jump to a chain of jumps.
+    cc.cmp(a, b);
+    cc.jl(L_LessChain);
+
+    // Branch over an unconditional jump.
+    cc.test(a, a);
+    cc.jz(L_Zero);
+    cc.jmp(L_NotZero);
+
+    cc.bind(L_Zero);
+    cc.mov(r, 10);
+    cc.jmp(L_MergeChain);
+
+    // Dead code after an unconditional jump.
+    cc.mov(r, 99);
+    cc.add(r, a);
+
+    cc.bind(L_LessChain);
+    cc.jmp(L_Less);
+
+    cc.bind(L_NotZero);
+    cc.mov(r, 20);
+    cc.jmp(L_Merge);
+
+    cc.bind(L_Less);
+    cc.mov(r, 30);
+    cc.jmp(L_Merge);
+
+    cc.bind(L_MergeChain);
+    cc.jmp(L_Merge);
+
+    // Block that is only entered by a jump.
+    cc.bind(L_Merge);
+    cc.add(r, b);
+    cc.jmp(L_Exit);
+
+    cc.bind(L_Exit);
+    cc.ret(r);
+    cc.endFunc();
+  }
+
+  virtual bool run(void* _func, String& result, String& expect) {
+    typedef int (*Func)(int, int);
+    Func func = ptr_as_func<Func>(_func);
+
+    int r0 = func(1, 2);
+    int r1 = func(0, 0);
+    int r2 = func(5, 1);
+
+    result.assignFormat("ret={%d, %d, %d}", r0, r1, r2);
+    expect.assignFormat("ret={%d, %d, %d}", 32, 10, 21);
+
+    return result == expect;
+  }
+};
+
+// x86::Compiler - X86Test_JumpThreadingLabels
+// ===========================================
+
+class X86Test_JumpThreadingLabels : public X86TestCase {
+public:
+  X86Test_JumpThreadingLabels() : X86TestCase("JumpThreadingLabels") {}
+
+  static void add(TestApp& app) {
+    app.add(new X86Test_JumpThreadingLabels());
+  }
+
+  CodeHolder* _code = nullptr;
+  Label _target;
+  Label _offset;
+
+  virtual void compile(x86::Compiler& cc) {
+    cc.addFunc(FuncSignatureT<int>(CallConvId::kHost));
+
+    x86::Gp r = cc.newInt32("r");
+    _code = cc.code();
+    _target = cc.newLabel();
+    _offset = cc.newLabel();
+
+    // The jump is removed together with its target, which lost all its references, but a label that was not
+    // referenced before the pass must stay bound.
+    cc.mov(r, 1);
+    cc.jmp(_target);
+    cc.bind(_target);
+    cc.bind(_offset);
+    cc.add(r, 2);
+    cc.ret(r);
+    cc.endFunc();
+  }
+
+  virtual bool run(void* _func, String& result, String& expect) {
+    typedef int (*Func)(void);
+    Func func = ptr_as_func<Func>(_func);
+
+    result.assignFormat("ret=%d target=%d offset=%d", func(), int(_code->isLabelBound(_target)), int(_code->isLabelBound(_offset)));
+    expect.assignFormat("ret=%d target=%d offset=%d", 3, 0, 1);
+
+    return result == expect;
+  }
+};
+
 // x86::Compiler - X86Test_JumpTable1
 // ==================================
 
@@ -3937,6 +4067,308 @@ public:
   }
 };
 
+// x86::Compiler - X86Test_FuncCallPreserveMost
+// ============================================
+
+class X86Test_FuncCallPreserveMost : public X86TestCase {
+public:
+  X86Test_FuncCallPreserveMost() : X86TestCase("FuncCallPreserveMost") {}
+
+  static void add(TestApp& app) {
+    app.add(new X86Test_FuncCallPreserveMost());
+  }
+
+  virtual void compile(x86::Compiler& cc) {
+    cc.addFunc(FuncSignatureT<int>(CallConvId::kHost));
+
+    // 32-bit targets have no register based PreserveMost convention (it maps to CDecl), so the wrapper is only
+    // required on 64-bit targets, where it adapts the regular C function to the PreserveMost convention.
+    const void* target = (void*)calledFunc;
+    if (cc.is64Bit()) {
+      target = wrapperFunc();
+      if (!target) {
+        cc.ret(cc.newInt32("invalid"));
+        cc.endFunc();
+        return;
+      }
+    }
+
+    uint32_t i, regCount = cc.is64Bit() ? 12 : 4;
+    x86::Gp vars[12];
+
+    for (i = 0; i < regCount; i++) {
+      vars[i] = cc.newInt32("%%%u", unsigned(i));
+      cc.mov(vars[i], i + 1);
+    }
+
+    x86::Gp r = cc.newInt32("r");
+    InvokeNode* invokeNode;
+
+    cc.invoke(&invokeNode, imm(target), FuncSignatureT<int, int, int>(CallConvId::kPreserveMost));
+    invokeNode->setArg(0, vars[0]);
+    invokeNode->setArg(1, vars[1]);
+    invokeNode->setRet(0, r);
+
+    for (i = 0; i < regCount; i++)
+      cc.add(r, vars[i]);
+    cc.ret(r);
+
+    cc.endFunc();
+  }
+
+  virtual bool run(void* _func, String& result, String& expect) {
+    typedef int (*Func)(void);
+    Func func = ptr_as_func<Func>(_func);
+
+    int regCount = sizeof(void*) == 4 ? 4 : 12;
+    int resultRet = func();
+    int expectRet = 1 * 2 + 3 + regCount * (regCount + 1) / 2;
+
+    result.assignFormat("ret=%d", resultRet);
+    expect.assignFormat("ret=%d", expectRet);
+
+    return resultRet == expectRet;
+  }
+
+  static int calledFunc(int a, int b) { return a * b + 3; }
+
+  static const void* wrapperFunc() {
+    static JitRuntime rt;
+    static const void* wrapper = nullptr;
+
+    if (!wrapper) {
+      CodeHolder code;
+      code.init(rt.environment());
+
+      x86::Assembler a(&code);
+      if (a.emitPreserveWrapper(FuncSignatureT<int, int, int>(CallConvId::kPreserveMost), (void*)calledFunc) != kErrorOk)
+        return nullptr;
+
+      void* fn;
+      if (rt.add(&fn, &code) != kErrorOk)
+        return nullptr;
+      wrapper = fn;
+    }
+
+    return wrapper;
+  }
+};
+
+// x86::Compiler - X86Test_FuncCallStackMap
+// =========================================
+
+class X86Test_FuncCallStackMap : public X86TestCase {
+public:
+  X86Test_FuncCallStackMap() : X86TestCase("FuncCallStackMap") {}
+
+  enum : uint32_t { kTaggedCount = 12 };
+
+  static void add(TestApp& app) {
+    app.add(new X86Test_FuncCallStackMap());
+  }
+
+  virtual void compile(x86::Compiler& cc) {
+    cc.addFunc(FuncSignatureT<intptr_t>(CallConvId::kHost));
+
+    x86::Gp r = cc.newIntPtr("r");
+    const void* target = tracedFunc();
+
+    if (target) {
+      InvokeNode* invokeNode;
+      cc.invoke(&invokeNode, imm(target), FuncSignatureT<intptr_t>(CallConvId::kHost));
+      invokeNode->setRet(0, r);
+    }
+    else {
+      cc.mov(r, -1);
+    }
+
+    cc.ret(r);
+    cc.endFunc();
+  }
+
+  virtual bool run(void* _func, String& result, String& expect) {
+    typedef intptr_t (*Func)(void);
+    Func func = ptr_as_func<Func>(_func);
+
+    state().stackCount = 0;
+    state().regCount = 0;
+
+    intptr_t resultRet = func();
+    intptr_t expectRet = 1000 + kTaggedCount * (kTaggedCount + 1) / 2 + 100 * intptr_t(state().stackCount);
+
+    result.assignFormat("ret=%lld entries=%u", (long long)resultRet, state().stackCount + state().regCount);
+    expect.assignFormat("ret=%lld entries=%u", (long long)expectRet, unsigned(kTaggedCount));
+
+    return resultRet == expectRet && state().stackCount + state().regCount == kTaggedCount;
+  }
+
+  struct State {
+    const StackMapEntry* entries;
+    uint32_t entryCount;
+    uint32_t stackCount;
+    uint32_t regCount;
+  };
+
+  static State& state() {
+    static State s;
+    return s;
+  }
+
+  // Simulates a moving garbage collector - moves all tagged values that are in memory by 100.
+  static void collect(void* sp) {
+    State& s = state();
+
+    for (uint32_t i = 0; i < s.entryCount; i++) {
+      const StackMapEntry& entry = s.entries[i];
+      if (entry.isStack() && entry.regId() == x86::Gp::kIdSp) {
+        *reinterpret_cast<intptr_t*>(static_cast<uint8_t*>(sp) + entry.offset()) += 100;
+        s.stackCount++;
+      }
+      else if (entry.isReg()) {
+        s.regCount++;
+      }
+    }
+  }
+
+  // Generates a function that has tagged values live across a call to `collect()` and finds its stack map.
+  static const void* tracedFunc() {
+    static JitRuntime rt;
+    static const void* traced = nullptr;
+
+    if (!traced) {
+      CodeHolder code;
+      code.init(rt.environment());
+
+      x86::Compiler cc(&code);
+      cc.addFunc(FuncSignatureT<intptr_t>(CallConvId::kHost));
+
+      x86::Gp vars[kTaggedCount];
+      for (uint32_t i = 0; i < kTaggedCount; i++) {
+        vars[i] = cc.newIntPtr("t%u", unsigned(i));
+        cc.setTagged(vars[i]);
+        cc.mov(vars[i], i + 1);
+      }
+
+      x86::Gp untagged = cc.newIntPtr("u");
+      x86::Gp sp = cc.newIntPtr("sp");
+
+      cc.mov(untagged, 1000);
+      cc.lea(sp, x86::ptr(cc.zsp()));
+
+      InvokeNode* invokeNode;
+      cc.invoke(&invokeNode, imm((void*)collect), FuncSignatureT<void, void*>(CallConvId::kHost));
+      invokeNode->setArg(0, sp);
+
+      for (uint32_t i = 0; i < kTaggedCount; i++)
+        cc.add(untagged, vars[i]);
+
+      cc.ret(untagged);
+      cc.endFunc();
+
+      if (cc.finalize() != kErrorOk || code.stackMaps().size() != 1)
+        return nullptr;
+
+      uint64_t offset = code.stackMapOffset(code.stackMaps()[0]);
+
+      void* fn;
+      if (rt.add(&fn, &code) != kErrorOk)
+        return nullptr;
+
+      // Stack maps are retained by the runtime and keyed by the return address of the call.
+      State& s = state();
+      const uint8_t* returnAddress = static_cast<const uint8_t*>(fn) + offset;
+
+      if (!rt.findStackMap(returnAddress, &s.entries, &s.entryCount) || s.entryCount != kTaggedCount)
+        return nullptr;
+
+      const StackMapEntry* unused;
+      uint32_t unusedCount;
+      if (rt.findStackMap(returnAddress - 1, &unused, &unusedCount))
+        return nullptr;
+
+      traced = fn;
+    }
+
+    return traced;
+  }
+};
+
+// x86::Compiler - X86Test_FuncOsrEntry
+// =====================================
+
+class X86Test_FuncOsrEntry : public X86TestCase {
+public:
+  X86Test_FuncOsrEntry() : X86TestCase("FuncOsrEntry") {}
+
+  enum : int { kIterations = 100 };
+
+  CodeHolder* _code = nullptr;
+  Label _osrLabel;
+
+  static void add(TestApp& app) {
+    app.add(new X86Test_FuncOsrEntry());
+  }
+
+  virtual void compile(x86::Compiler& cc) {
+    FuncNode* funcNode = cc.addFunc(FuncSignatureT<int, int>(CallConvId::kFastCall));
+
+    x86::Gp n = cc.newInt32("n");
+    x86::Gp i = cc.newInt32("i");
+    x86::Gp sum = cc.newInt32("sum");
+
+    Label L_Loop = cc.newLabel();
+    Label L_Done = cc.newLabel();
+
+    funcNode->setArg(0, n);
+    cc.xor_(i, i);
+    cc.xor_(sum, sum);
+    cc.cmp(i, n);
+    cc.jge(L_Done);
+
+    cc.bind(L_Loop);
+    cc.add(sum, i);
+    cc.inc(i);
+    cc.cmp(i, n);
+    cc.jl(L_Loop);
+
+    cc.bind(L_Done);
+    cc.ret(sum);
+
+    // Entered in the middle of the loop with the state of an interpreted loop - `i` and `sum` are passed in registers
+    // and `n` has to be initialized after the entry as it's live at the loop header.
+    OsrEntryNode* osrNode = cc.addOsrEntry(FuncSignatureT<int, int, int>(CallConvId::kFastCall));
+    osrNode->setArg(0, i);
+    osrNode->setArg(1, sum);
+    cc.mov(n, kIterations);
+    cc.jmp(L_Loop);
+
+    cc.endFunc();
+
+    _code = cc.code();
+    _osrLabel = osrNode->label();
+  }
+
+  virtual bool run(void* _func, String& result, String& expect) {
+    typedef int (ASMJIT_FASTCALL *Func)(int);
+    typedef int (ASMJIT_FASTCALL *OsrFunc)(int, int);
+
+    Func func = ptr_as_func<Func>(_func);
+    OsrFunc osrFunc = ptr_as_func<OsrFunc>(static_cast<uint8_t*>(_func) + _code->labelOffset(_osrLabel));
+
+    int expectRet = kIterations * (kIterations - 1) / 2;
+    int resultRet[3] = {
+      func(kIterations),
+      osrFunc(40, 40 * 39 / 2),
+      osrFunc(kIterations - 1, (kIterations - 1) * (kIterations - 2) / 2)
+    };
+
+    result.assignFormat("ret={%d, %d, %d}", resultRet[0], resultRet[1], resultRet[2]);
+    expect.assignFormat("ret={%d, %d, %d}", expectRet, expectRet, expectRet);
+
+    return resultRet[0] == expectRet && resultRet[1] == expectRet && resultRet[2] == expectRet;
+  }
+};
+
 // x86::Compiler - X86Test_MiscLocalConstPool
 // ==========================================
 
@@ -4229,6 +4661,480 @@ public:
   static void ASMJIT_FASTCALL handler() { longjmp(globalJmpBuf, 1); }
 };
 
+// x86::Compiler - X86Test_MiscIfConvert
+// =====================================
+
+class X86Test_MiscIfConvert : public X86TestCase {
+public:
+  X86Test_MiscIfConvert() : X86TestCase("MiscIfConvert") {}
+
+  static void add(TestApp& app) {
+    app.add(new X86Test_MiscIfConvert());
+  }
+
+  virtual void compile(x86::Compiler& cc) {
+    x86::Gp a = cc.newInt32("a");
+    x86::Gp b = cc.newInt32("b");
+    x86::Gp r = cc.newInt32("r");
+    x86::Gp s = cc.newInt32("s");
+
+    Label L_MaxElse = cc.newLabel();
+    Label L_MaxEnd = cc.newLabel();
+    Label L_ClampEnd = cc.newLabel();
+    Label L_EqElse = cc.newLabel();
+    Label L_EqEnd = cc.newLabel();
+
+    FuncNode* funcNode = cc.addFunc(FuncSignatureT<int, int, int>(CallConvId::kHost));
+    funcNode->setArg(0, a);
+    funcNode->setArg(1, b);
+
+    // Diamond: r = max(a, b).
+    cc.cmp(a, b);
+    cc.unpredictable().jl(L_MaxElse);
+    cc.mov(r, a);
+    cc.jmp(L_MaxEnd);
+    cc.bind(L_MaxElse);
+    cc.mov(r, b);
+    cc.bind(L_MaxEnd);
+
+    // Triangle: r = min(r, 100).
+    cc.cmp(r, 100);
+    cc.unpredictable().jle(L_ClampEnd);
+    cc.mov(r, 100);
+    cc.bind(L_ClampEnd);
+
+    // Diamond of 0 and 1: s = a == b.
+    cc.cmp(a, b);
+    cc.unpredictable().je(L_EqElse);
+    cc.mov(s, 0);
+    cc.jmp(L_EqEnd);
+    cc.bind(L_EqElse);
+    cc.mov(s, 1);
+    cc.bind(L_EqEnd);
+
+    cc.imul(s, s, 1000);
+    cc.add(r, s);
+    cc.ret(r);
+    cc.endFunc();
+  }
+
+  virtual bool run(void* _func, String& result, String& expect) {
+    typedef int (*Func)(int, int);
+    Func func = ptr_as_func<Func>(_func);
+
+    static const int args[][2] = { { 1, 2 }, { 5, -3 }, { 7, 7 }, { 200, 1 }, { -8, 150 } };
+
+    result.clear();
+    expect.clear();
+
+    for (size_t i = 0; i < ASMJIT_ARRAY_SIZE(args); i++) {
+      int a = args[i][0];
+      int b = args[i][1];
+      int r = a > b ? a : b;
+      r = r < 100 ? r : 100;
+
+      result.appendFormat("%s%d", i ? ", " : "ret={", func(a, b));
+      expect.appendFormat("%s%d", i ? ", " : "ret={", r + (a == b ? 1000 : 0));
+    }
+
+    result.append('}');
+    expect.append('}');
+    return result == expect;
+  }
+};
+
+// x86::Compiler - X86Test_MiscDepBreak
+// ====================================
+
+class X86Test_MiscDepBreak : public X86TestCase {
+public:
+  X86Test_MiscDepBreak() : X86TestCase("MiscDepBreak") {}
+
+  static void add(TestApp& app) {
+    app.add(new X86Test_MiscDepBreak());
+  }
+
+  virtual void compile(x86::Compiler& cc) {
+    cc.addCompilerOptions(CompilerOptions::kBreakDependencies);
+
+    FuncNode* funcNode = cc.addFunc(FuncSignatureT<double, int, const uint8_t*>(CallConvId::kHost));
+
+    x86::Gp a = cc.newInt32("a");
+    x86::Gp p = cc.newIntPtr("p");
+    x86::Gp b = cc.newUInt8("b");
+    x86::Gp c = cc.newUInt16("c");
+    x86::Gp t = cc.newUInt32("t");
+    x86::Xmm x = cc.newXmmSd("x");
+    x86::Xmm y = cc.newXmmSd("y");
+
+    funcNode->setArg(0, a);
+    funcNode->setArg(1, p);
+
+    // Scalar merges into virtual registers that only hold a scalar get a zero idiom.
+    cc.cvtsi2sd(x, a);
+    cc.sqrtsd(x, x);
+
+    // Partial register writes to 8-bit and 16-bit virtual registers are widened.
+    cc.mov(b, x86::ptr(p));
+    cc.mov(c, 0x1234);
+    cc.movzx(t, b);
+    cc.add(t, c.r32());
+    cc.cvtsi2sd(y, t);
+    cc.addsd(x, y);
+
+    cc.ret(x);
+    cc.endFunc();
+  }
+
+  virtual bool run(void* _func, String& result, String& expect) {
+    typedef double (*Func)(int, const uint8_t*);
+    Func func = ptr_as_func<Func>(_func);
+
+    uint8_t data[1] = { 200 };
+    double resultRet = func(16, data);
+    double expectRet = 4.0 + 200.0 + double(0x1234);
+
+    result.assignFormat("ret={%g}", resultRet);
+    expect.assignFormat("ret={%g}", expectRet);
+
+    return resultRet == expectRet;
+  }
+};
+
+// x86::Compiler - X86Test_MiscAddrFold
+// ====================================
+
+class X86Test_MiscAddrFold : public X86TestCase {
+public:
+  X86Test_MiscAddrFold() : X86TestCase("MiscAddrFold") {}
+
+  static void add(TestApp& app) {
+    app.add(new X86Test_MiscAddrFold());
+  }
+
+  virtual void compile(x86::Compiler& cc) {
+    FuncNode* funcNode = cc.addFunc(FuncSignatureT<intptr_t, const intptr_t*, intptr_t, intptr_t>(CallConvId::kHost));
+
+    x86::Gp arr = cc.newIntPtr("arr");
+    x86::Gp i = cc.newIntPtr("i");
+    x86::Gp j = cc.newIntPtr("j");
+    x86::Gp t = cc.newIntPtr("t");
+    x86::Gp u = cc.newIntPtr("u");
+    x86::Gp v = cc.newIntPtr("v");
+    x86::Gp w = cc.newIntPtr("w");
+    x86::Gp x = cc.newIntPtr("x");
+    x86::Gp y = cc.newIntPtr("y");
+
+    funcNode->setArg(0, arr);
+    funcNode->setArg(1, i);
+    funcNode->setArg(2, j);
+
+    Label L_Skip = cc.newLabel();
+    uint32_t scale = cc.registerSize() == 8 ? 3 : 2;
+
+    // Folded to [arr + i * scale + registerSize].
+    cc.mov(t, i);
+    cc.shl(t, scale);
+    cc.add(t, arr);
+    cc.mov(x, x86::ptr(t, int32_t(cc.registerSize())));
+
+    // Folded to [arr + j * scale + registerSize * 2].
+    cc.lea(u, x86::ptr(arr, j, scale));
+    cc.add(u, int32_t(cc.registerSize()));
+    cc.mov(y, x86::ptr(u, int32_t(cc.registerSize())));
+
+    // Three-operand add becomes LEA as `v` is used twice.
+    cc.mov(v, x);
+    cc.add(v, y);
+    cc.add(x, v);
+    cc.add(x, v);
+
+    // Flags of the ADD are used, so the computation must be kept.
+    cc.mov(w, i);
+    cc.add(w, j);
+    cc.jz(L_Skip);
+    cc.add(x, 1000);
+    cc.bind(L_Skip);
+
+    cc.ret(x);
+    cc.endFunc();
+  }
+
+  virtual bool run(void* _func, String& result, String& expect) {
+    typedef intptr_t (*Func)(const intptr_t*, intptr_t, intptr_t);
+    Func func = ptr_as_func<Func>(_func);
+
+    static const intptr_t data[] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+
+    intptr_t r0 = func(data, 1, 3);
+    intptr_t r1 = func(data, 2, -2);
+
+    result.assignFormat("ret={%lld, %lld}", (long long)r0, (long long)r1);
+    expect.assignFormat("ret={%lld, %lld}", (long long)(3 + 2 * (3 + 6) + 1000), (long long)(4 + 2 * (4 + 1)));
+
+    return result == expect;
+  }
+};
+
+// x86::Compiler - X86Test_MiscAddrFoldRep
+// =======================================
+
+class X86Test_MiscAddrFoldRep : public X86TestCase {
+public:
+  X86Test_MiscAddrFoldRep() : X86TestCase("MiscAddrFoldRep") {}
+
+  static void add(TestApp& app) {
+    app.add(new X86Test_MiscAddrFoldRep());
+  }
+
+  virtual void compile(x86::Compiler& cc) {
+    FuncNode* funcNode = cc.addFunc(FuncSignatureT<uint32_t, uint8_t*, const uint8_t*, const uint8_t*, size_t>(CallConvId::kHost));
+
+    x86::Gp dst = cc.newIntPtr("dst");
+    x86::Gp src = cc.newIntPtr("src");
+    x86::Gp tab = cc.newIntPtr("tab");
+    x86::Gp cnt = cc.newIntPtr("cnt");
+    x86::Gp t = cc.newIntPtr("t");
+    x86::Gp u = cc.newIntPtr("u");
+    x86::Gp x = cc.newUInt32("x");
+    x86::Gp y = cc.newUInt32("y");
+
+    funcNode->setArg(0, dst);
+    funcNode->setArg(1, src);
+    funcNode->setArg(2, tab);
+    funcNode->setArg(3, cnt);
+
+    // Both computations must not be folded across `rep movsb`, which advances `src` and decrements `cnt`.
+    cc.mov(t, src);
+    cc.add(t, 2);
+    cc.lea(u, x86::ptr(tab, cnt));
+
+    cc.rep(cnt).movs(x86::byte_ptr(dst), x86::byte_ptr(src));
+
+    cc.movzx(x, x86::byte_ptr(t));
+    cc.movzx(y, x86::byte_ptr(u));
+    cc.shl(x, 8);
+    cc.or_(x, y);
+
+    cc.ret(x);
+    cc.endFunc();
+  }
+
+  virtual bool run(void* _func, String& result, String& expect) {
+    typedef uint32_t (*Func)(uint8_t*, const uint8_t*, const uint8_t*, size_t);
+    Func func = ptr_as_func<Func>(_func);
+
+    static const uint8_t src[] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    static const uint8_t tab[] = { 11, 12, 13, 14, 15, 16, 17, 18 };
+    uint8_t dst[8] {};
+
+    uint32_t resultRet = func(dst, src, tab, 4);
+    uint32_t expectRet = (uint32_t(src[2]) << 8) | uint32_t(tab[4]);
+
+    result.assignFormat("ret={%u} dst={%u, %u, %u, %u}", resultRet, dst[0], dst[1], dst[2], dst[3]);
+    expect.assignFormat("ret={%u} dst={%u, %u, %u, %u}", expectRet, src[0], src[1], src[2], src[3]);
+
+    return result == expect;
+  }
+};
+
+// x86::Compiler - X86Test_MiscFixedRegs
+// ======================================
+
+class X86Test_MiscFixedRegs : public X86TestCase {
+public:
+  X86Test_MiscFixedRegs() : X86TestCase("MiscFixedRegs") {}
+
+  static void add(TestApp& app) {
+    app.add(new X86Test_MiscFixedRegs());
+  }
+
+  virtual void compile(x86::Compiler& cc) {
+    FuncNode* funcNode = cc.addFunc(FuncSignatureT<uint32_t, uint32_t, uint32_t, uint32_t>(CallConvId::kHost));
+
+    x86::Gp a = cc.newUInt32("a");
+    x86::Gp b = cc.newUInt32("b");
+    x86::Gp c = cc.newUInt32("c");
+    x86::Gp n = cc.newUInt32("n");
+    x86::Gp m = cc.newUInt32("m");
+    x86::Gp hi = cc.newUInt32("hi");
+    x86::Gp lo = cc.newUInt32("lo");
+    x86::Gp q = cc.newUInt32("q");
+    x86::Gp r = cc.newUInt32("r");
+    x86::Gp u = cc.newUInt32("u");
+
+    funcNode->setArg(0, a);
+    funcNode->setArg(1, b);
+    funcNode->setArg(2, c);
+
+    Label L_Zero = cc.newLabel();
+
+    // Shift counts, the product, and the division operands are all live at the same time.
+    cc.mov(n, b);
+    cc.and_(n, 31);
+    cc.mov(m, b);
+    cc.shr(m, 5);
+    cc.and_(m, 15);
+    cc.or_(m, 1);
+
+    cc.mov(lo, a);
+    cc.shl(lo, n.r8());
+    cc.mul(hi, lo, c);
+    cc.add(lo, hi);
+
+    cc.or_(c, 1);
+    cc.xor_(r, r);
+    cc.mov(q, lo);
+    cc.div(r, q, c);
+    cc.add(q, r);
+    cc.sar(q, m.r8());
+    cc.shr(q, n.r8());
+
+    // Flags of the shift are used, so it must stay.
+    cc.mov(u, a);
+    cc.shl(u, m.r8());
+    cc.jz(L_Zero);
+    cc.add(q, 1000);
+    cc.bind(L_Zero);
+
+    cc.add(q, n);
+    cc.ret(q);
+    cc.endFunc();
+  }
+
+  virtual bool run(void* _func, String& result, String& expect) {
+    typedef uint32_t (*Func)(uint32_t, uint32_t, uint32_t);
+    Func func = ptr_as_func<Func>(_func);
+
+    static const uint32_t args[][3] = {
+      { 7u, 3u, 100u },
+      { 0x80000000u, 33u, 0x12345678u },
+      { 0xFFFFFFFFu, 0x1FFu, 0xFFFFFFFFu },
+      { 12345u, 0x2A4u, 6u }
+    };
+
+    result.clear();
+    expect.clear();
+
+    for (size_t i = 0; i < ASMJIT_ARRAY_SIZE(args); i++) {
+      uint32_t a = args[i][0];
+      uint32_t b = args[i][1];
+      uint32_t c = args[i][2];
+
+      uint32_t n = b & 31u;
+      uint32_t m = ((b >> 5) & 15u) | 1u;
+      uint64_t product = uint64_t(a << n) * c;
+      uint32_t t = uint32_t(product) + uint32_t(product >> 32);
+      uint32_t q = t / (c | 1u) + t % (c | 1u);
+      q = uint32_t(int32_t(q) >> m) >> n;
+      q += (a << m) != 0 ? 1000u : 0u;
+      q += n;
+
+      result.appendFormat("%s%u", i ? ", " : "ret={", func(a, b, c));
+      expect.appendFormat("%s%u", i ? ", " : "ret={", q);
+    }
+
+    result.append('}');
+    expect.append('}');
+    return result == expect;
+  }
+};
+
+// x86::Compiler - X86Test_MiscPhi
+// ===============================
+
+class X86Test_MiscPhi : public X86TestCase {
+public:
+  X86Test_MiscPhi() : X86TestCase("MiscPhi") {}
+
+  static void add(TestApp& app) {
+    app.add(new X86Test_MiscPhi());
+  }
+
+  virtual void compile(x86::Compiler& cc) {
+    FuncNode* funcNode = cc.addFunc(FuncSignatureT<int, int>(CallConvId::kHost));
+
+    x86::Gp n = cc.newInt32("n");
+    x86::Gp a0 = cc.newInt32("a0");
+    x86::Gp b0 = cc.newInt32("b0");
+    x86::Gp a = cc.newInt32("a");
+    x86::Gp b = cc.newInt32("b");
+    x86::Gp i = cc.newInt32("i");
+    x86::Gp t = cc.newInt32("t");
+    x86::Gp i1 = cc.newInt32("i1");
+    x86::Gp fib = cc.newInt32("fib");
+    x86::Gp odd = cc.newInt32("odd");
+    x86::Gp even = cc.newInt32("even");
+    x86::Gp r = cc.newInt32("r");
+
+    Label L_Loop = cc.newLabel();
+    Label L_Exit = cc.newLabel();
+    Label L_Even = cc.newLabel();
+    Label L_Join = cc.newLabel();
+
+    funcNode->setArg(0, n);
+
+    cc.mov(a0, 0);
+    cc.mov(b0, 1);
+
+    // Loop - `a` and `b` are swapped on the back edge, which requires a parallel copy.
+    cc.bind(L_Loop);
+    cc.phi(a, a0, funcNode->label(), b, L_Loop);
+    cc.phi(b, b0, funcNode->label(), t, L_Loop);
+    cc.phi(i, n, funcNode->label(), i1, L_Loop);
+    cc.test(i, i);
+    cc.jz(L_Exit);
+    cc.mov(t, a);
+    cc.add(t, b);
+    cc.mov(i1, i);
+    cc.sub(i1, 1);
+    cc.jmp(L_Loop);
+
+    // Diamond - the conditional branch to `L_Join` is a critical edge.
+    cc.bind(L_Exit);
+    PhiNode* phiNode;
+    cc.addPhiNode(&phiNode, fib, 1);
+    phiNode->setIncoming(0, a, L_Loop);
+    cc.mov(odd, 100);
+    cc.test(n, 1);
+    cc.jnz(L_Join);
+
+    cc.bind(L_Even);
+    cc.mov(even, 200);
+
+    cc.bind(L_Join);
+    cc.phi(r, odd, L_Exit, even, L_Even);
+    cc.add(r, fib);
+    cc.ret(r);
+
+    cc.endFunc();
+  }
+
+  virtual bool run(void* _func, String& result, String& expect) {
+    typedef int (*Func)(int);
+    Func func = ptr_as_func<Func>(_func);
+
+    result.clear();
+    expect.clear();
+
+    int a = 0;
+    int b = 1;
+
+    for (int n = 0; n < 12; n++) {
+      result.appendFormat("%s%d", n ? ", " : "ret={", func(n));
+      expect.appendFormat("%s%d", n ? ", " : "ret={", a + ((n & 1) ? 100 : 200));
+
+      int t = a + b;
+      a = b;
+      b = t;
+    }
+
+    result.append('}');
+    expect.append('}');
+    return result == expect;
+  }
+};
+
 // x86::Compiler - Tests
 // =====================
 
@@ -4244,6 +5150,8 @@ void compiler_add_x86_tests(TestApp& app) {
   app.addT<X86Test_JumpMany>();
   app.addT<X86Test_JumpUnreachable1>();
   app.addT<X86Test_JumpUnreachable2>();
+  app.addT<X86Test_JumpThreading>();
+  app.addT<X86Test_JumpThreadingLabels>();
   app.addT<X86Test_JumpTable1>();
   app.addT<X86Test_JumpTable2>();
 
@@ -4305,6 +5213,9 @@ void compiler_add_x86_tests(TestApp& app) {
   app.addT<X86Test_FuncCallMisc5>();
   app.addT<X86Test_FuncCallMisc6>();
   app.addT<X86Test_FuncCallAVXClobber>();
+  app.addT<X86Test_FuncCallPreserveMost>();
+  app.addT<X86Test_FuncCallStackMap>();
+  app.addT<X86Test_FuncOsrEntry>();
 
   // Miscellaneous tests.
   app.addT<X86Test_MiscLocalConstPool>();
@@ -4312,6 +5223,12 @@ void compiler_add_x86_tests(TestApp& app) {
   app.addT<X86Test_MiscMultiRet>();
   app.addT<X86Test_MiscMultiFunc>();
   app.addT<X86Test_MiscUnfollow>();
+  app.addT<X86Test_MiscIfConvert>();
+  app.addT<X86Test_MiscDepBreak>();
+  app.addT<X86Test_MiscAddrFold>();
+  app.addT<X86Test_MiscAddrFoldRep>();
+  app.addT<X86Test_MiscFixedRegs>();
+  app.addT<X86Test_MiscPhi>();
 }
 
 #endif // !ASMJIT_NO_X86 && ASMJIT_ARCH_X86
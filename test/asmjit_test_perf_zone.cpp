@@ -0,0 +1,519 @@
+// This file is part of AsmJit project <https://asmjit.com>
+//
+// See asmjit.h or LICENSE.md for license and copyright information
+// SPDX-License-Identifier: Zlib
+
+#include <asmjit/core.h>
+
+#include <limits>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cmdline.h"
+#include "performancetimer.h"
+
+using namespace asmjit;
+
+// Accumulates results of benchmarks so the compiler cannot optimize them out.
+static uint64_t benchChecksum;
+
+// Simple LCG used to generate keys in a pseudo-random order, which is the same in each run.
+class Random {
+public:
+  uint32_t _state;
+
+  inline explicit Random(uint32_t seed) noexcept
+    : _state(seed) {}
+
+  inline uint32_t next() noexcept {
+    _state = _state * 1664525u + 1013904223u;
+    return _state;
+  }
+};
+
+// Fills `keys` with `count` unique keys in a pseudo-random order (a random permutation of [0, count)).
+static void makeKeys(ZoneAllocator* allocator, ZoneVector<uint32_t>& keys, uint32_t count) noexcept {
+  if (keys.reserve(allocator, count) != kErrorOk) {
+    printf("ERROR: Out of memory\n");
+    abort();
+  }
+
+  for (uint32_t i = 0; i < count; i++)
+    keys.appendUnsafe(i);
+
+  Random rnd(0x12345678u);
+  for (uint32_t i = count; i > 1; i--) {
+    uint32_t j = rnd.next() % i;
+    std::swap(keys[i - 1], keys[j]);
+  }
+}
+
+// Runs `func` `numIterations` times and reports the best time and the number of operations per second. The function
+// must return the number of operations it performed.
+template<typename FuncT>
+static void bench(uint32_t numIterations, const char* group, const char* testName, const FuncT& func) noexcept {
+  PerformanceTimer timer;
+  double duration = std::numeric_limits<double>::infinity();
+  uint64_t opCount = 0;
+
+  for (uint32_t r = 0; r < numIterations; r++) {
+    timer.start();
+    opCount = func();
+    timer.stop();
+
+    duration = Support::min(duration, timer.duration());
+  }
+
+  printf("  [%-13s] %-34s | Ops:%9llu | Time:%9.4f [ms]", group, testName, (unsigned long long)opCount, duration);
+  if (duration > 0.0)
+    printf(" | Speed:%9.3f [Mops/s]", double(opCount) / (duration * 1000.0));
+  printf("\n");
+}
+
+// Zone
+// ====
+
+static void benchZone(uint32_t numIterations, uint32_t count) noexcept {
+  static const uint32_t sizes[] = { 8, 24, 64, 256, 1024 };
+  static const uint32_t alignments[] = { 1, 8, 16, 64 };
+
+  Zone zone(65536 - Zone::kBlockOverhead);
+  char testName[64];
+
+  for (uint32_t size : sizes) {
+    for (uint32_t alignment : alignments) {
+      snprintf(testName, sizeof(testName), "Alloc (size=%u align=%u)", size, alignment);
+      bench(numIterations, "Zone", testName, [&]() {
+        uintptr_t sum = 0;
+        for (uint32_t i = 0; i < count; i++)
+          sum += reinterpret_cast<uintptr_t>(zone.alloc(size, alignment));
+
+        zone.reset();
+        benchChecksum += sum;
+        return uint64_t(count);
+      });
+    }
+  }
+
+  bench(numIterations, "Zone", "AllocZeroed (size=64 align=8)", [&]() {
+    uintptr_t sum = 0;
+    for (uint32_t i = 0; i < count; i++)
+      sum += reinterpret_cast<uintptr_t>(zone.allocZeroed(64, 8));
+
+    zone.reset();
+    benchChecksum += sum;
+    return uint64_t(count);
+  });
+
+  bench(numIterations, "Zone", "Alloc & Reset (hard)", [&]() {
+    uintptr_t sum = 0;
+    for (uint32_t i = 0; i < count; i++)
+      sum += reinterpret_cast<uintptr_t>(zone.alloc(64, 8));
+
+    zone.reset(ResetPolicy::kHard);
+    benchChecksum += sum;
+    return uint64_t(count);
+  });
+}
+
+// ZoneAllocator
+// =============
+
+static void benchZoneAllocator(uint32_t numIterations, uint32_t count) noexcept {
+  // Sizes served by low and high granularity slots, and a size that requires a dynamic block.
+  static const uint32_t sizes[] = { 16, 96, 320, 1024 };
+
+  Zone zone(65536 - Zone::kBlockOverhead);
+  ZoneAllocator allocator(&zone);
+  void** ptrs = static_cast<void**>(malloc(count * sizeof(void*)));
+
+  if (!ptrs) {
+    printf("ERROR: Out of memory\n");
+    abort();
+  }
+
+  char testName[64];
+  for (uint32_t size : sizes) {
+    snprintf(testName, sizeof(testName), "Alloc (size=%u)", size);
+    bench(numIterations, "ZoneAllocator", testName, [&]() {
+      uintptr_t sum = 0;
+      for (uint32_t i = 0; i < count; i++)
+        sum += reinterpret_cast<uintptr_t>(allocator.alloc(size));
+
+      allocator.reset(&zone);
+      zone.reset();
+      benchChecksum += sum;
+      return uint64_t(count);
+    });
+
+    // Allocates all blocks first, and then releases and allocates them again - the second round reuses slots.
+    snprintf(testName, sizeof(testName), "Release & Reuse (size=%u)", size);
+    bench(numIterations, "ZoneAllocator", testName, [&]() {
+      uintptr_t sum = 0;
+      for (uint32_t i = 0; i < count; i++)
+        ptrs[i] = allocator.alloc(size);
+
+      for (uint32_t i = 0; i < count; i++)
+        allocator.release(ptrs[i], size);
+
+      for (uint32_t i = 0; i < count; i++)
+        sum += reinterpret_cast<uintptr_t>(allocator.alloc(size));
+
+      allocator.reset(&zone);
+      zone.reset();
+      benchChecksum += sum;
+      return uint64_t(count) * 3u;
+    });
+  }
+
+  free(ptrs);
+}
+
+// ZoneVector
+// ==========
+
+static void benchZoneVector(uint32_t numIterations, uint32_t count) noexcept {
+  Zone zone(65536 - Zone::kBlockOverhead);
+  ZoneAllocator allocator(&zone);
+
+  bench(numIterations, "ZoneVector", "Append (grow)", [&]() {
+    ZoneVector<uint32_t> vec;
+    for (uint32_t i = 0; i < count; i++)
+      vec.append(&allocator, i);
+
+    benchChecksum += vec.size();
+    allocator.reset(&zone);
+    zone.reset();
+    return uint64_t(count);
+  });
+
+  bench(numIterations, "ZoneVector", "Append (reserved)", [&]() {
+    ZoneVector<uint32_t> vec;
+    vec.reserve(&allocator, count);
+    for (uint32_t i = 0; i < count; i++)
+      vec.append(&allocator, i);
+
+    benchChecksum += vec.size();
+    allocator.reset(&zone);
+    zone.reset();
+    return uint64_t(count);
+  });
+
+  bench(numIterations, "ZoneVector", "AppendUnsafe (willGrow)", [&]() {
+    ZoneVector<uint32_t> vec;
+    for (uint32_t i = 0; i < count; i++) {
+      vec.willGrow(&allocator);
+      vec.appendUnsafe(i);
+    }
+
+    benchChecksum += vec.size();
+    allocator.reset(&zone);
+    zone.reset();
+    return uint64_t(count);
+  });
+
+  bench(numIterations, "ZoneVector", "Append (pointers, 64 vectors)", [&]() {
+    // Many small vectors that grow at the same time, which is common in Compiler and RA.
+    ZoneVector<void*> vecs[64];
+    for (uint32_t i = 0; i < count; i++)
+      vecs[i % 64u].append(&allocator, &vecs[i % 64u]);
+
+    benchChecksum += vecs[0].size();
+    allocator.reset(&zone);
+    zone.reset();
+    return uint64_t(count);
+  });
+}
+
+// ZoneBitVector
+// =============
+
+static void benchZoneBitVector(uint32_t numIterations, uint32_t count) noexcept {
+  Zone zone(65536 - Zone::kBlockOverhead);
+  ZoneAllocator allocator(&zone);
+
+  bench(numIterations, "ZoneBitVector", "Append", [&]() {
+    ZoneBitVector bits;
+    for (uint32_t i = 0; i < count; i++)
+      bits.append(&allocator, (i & 3u) == 0);
+
+    benchChecksum += bits.size();
+    allocator.reset(&zone);
+    zone.reset();
+    return uint64_t(count);
+  });
+
+  ZoneBitVector a;
+  ZoneBitVector b;
+  a.resize(&allocator, count);
+  b.resize(&allocator, count, true);
+
+  bench(numIterations, "ZoneBitVector", "SetBit & BitAt", [&]() {
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < count; i++)
+      a.setBit(i, (i & 1u) != 0);
+
+    for (uint32_t i = 0; i < count; i++)
+      sum += uint32_t(a.bitAt(i));
+
+    benchChecksum += sum;
+    return uint64_t(count) * 2u;
+  });
+
+  // Operations on whole vectors are measured in bits processed.
+  const uint32_t kRounds = 64;
+
+  bench(numIterations, "ZoneBitVector", "And / Or / AndNot (bits)", [&]() {
+    for (uint32_t i = 0; i < kRounds; i++) {
+      a.or_(b);
+      a.and_(b);
+      a.andNot(b);
+    }
+
+    benchChecksum += a.bitAt(0);
+    return uint64_t(count) * kRounds * 3u;
+  });
+
+  bench(numIterations, "ZoneBitVector", "FillBits / ClearBits (bits)", [&]() {
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < kRounds; i++) {
+      if (i & 1u)
+        a.clearBits(i, count - i);
+      else
+        a.fillBits(i, count - i);
+      sum += uint32_t(a.bitAt(count - 1u - i));
+    }
+
+    benchChecksum += sum;
+    return uint64_t(count) * kRounds;
+  });
+
+  // The last bit differs in each other round, so the whole vector has to be compared.
+  b.fillAll();
+  a.fillAll();
+
+  bench(numIterations, "ZoneBitVector", "Eq (bits)", [&]() {
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < kRounds; i++) {
+      a.flipBit(count - 1u);
+      sum += uint32_t(a.eq(b));
+    }
+
+    benchChecksum += sum;
+    return uint64_t(count) * kRounds;
+  });
+}
+
+// ZoneHash
+// ========
+
+class BenchHashNode : public ZoneHashNode {
+public:
+  inline explicit BenchHashNode(uint32_t key) noexcept
+    : ZoneHashNode(key),
+      _key(key) {}
+
+  uint32_t _key;
+};
+
+struct BenchHashMatcher {
+  inline explicit BenchHashMatcher(uint32_t key) noexcept
+    : _key(key) {}
+
+  inline uint32_t hashCode() const noexcept { return _key; }
+  inline bool matches(const BenchHashNode* node) const noexcept { return node->_key == _key; }
+
+  uint32_t _key;
+};
+
+static void benchZoneHash(uint32_t numIterations, uint32_t count) noexcept {
+  Zone zone(65536 - Zone::kBlockOverhead);
+  ZoneAllocator allocator(&zone);
+
+  Zone keysZone(65536 - Zone::kBlockOverhead);
+  ZoneAllocator keysAllocator(&keysZone);
+  ZoneVector<uint32_t> keys;
+  makeKeys(&keysAllocator, keys, count);
+
+  // Keys are spread over the whole 32-bit range to not produce a perfect hash distribution.
+  for (uint32_t& key : keys)
+    key *= 2654435761u;
+
+  bench(numIterations, "ZoneHash", "Insert", [&]() {
+    ZoneHash<BenchHashNode> hash;
+    for (uint32_t key : keys)
+      hash.insert(&allocator, zone.newT<BenchHashNode>(key));
+
+    benchChecksum += hash.size();
+    allocator.reset(&zone);
+    zone.reset();
+    return uint64_t(count);
+  });
+
+  ZoneHash<BenchHashNode> hash;
+  for (uint32_t key : keys)
+    hash.insert(&allocator, zone.newT<BenchHashNode>(key));
+
+  bench(numIterations, "ZoneHash", "Lookup (hit)", [&]() {
+    uint32_t sum = 0;
+    for (uint32_t key : keys)
+      sum += hash.get(BenchHashMatcher(key))->_key;
+
+    benchChecksum += sum;
+    return uint64_t(count);
+  });
+
+  bench(numIterations, "ZoneHash", "Lookup (miss)", [&]() {
+    uint32_t sum = 0;
+    for (uint32_t key : keys)
+      sum += uint32_t(hash.get(BenchHashMatcher(key + 1u)) != nullptr);
+
+    benchChecksum += sum;
+    return uint64_t(count);
+  });
+
+  bench(numIterations, "ZoneHash", "Remove & Insert", [&]() {
+    for (uint32_t key : keys) {
+      BenchHashNode* node = hash.get(BenchHashMatcher(key));
+      hash.remove(&allocator, node);
+      hash.insert(&allocator, node);
+    }
+
+    benchChecksum += hash.size();
+    return uint64_t(count) * 3u;
+  });
+}
+
+// ZoneTree
+// ========
+
+class BenchTreeNode : public ZoneTreeNodeT<BenchTreeNode> {
+public:
+  ASMJIT_NONCOPYABLE(BenchTreeNode)
+
+  inline explicit BenchTreeNode(uint32_t key) noexcept
+    : _key(key) {}
+
+  inline bool operator<(const BenchTreeNode& other) const noexcept { return _key < other._key; }
+  inline bool operator>(const BenchTreeNode& other) const noexcept { return _key > other._key; }
+
+  inline bool operator<(uint32_t queryKey) const noexcept { return _key < queryKey; }
+  inline bool operator>(uint32_t queryKey) const noexcept { return _key > queryKey; }
+
+  uint32_t _key;
+};
+
+static void benchZoneTree(uint32_t numIterations, uint32_t count) noexcept {
+  Zone zone(65536 - Zone::kBlockOverhead);
+
+  Zone keysZone(65536 - Zone::kBlockOverhead);
+  ZoneAllocator keysAllocator(&keysZone);
+  ZoneVector<uint32_t> keys;
+  makeKeys(&keysAllocator, keys, count);
+
+  bench(numIterations, "ZoneTree", "Insert (sequential)", [&]() {
+    ZoneTree<BenchTreeNode> tree;
+    for (uint32_t key = 0; key < count; key++)
+      tree.insert(zone.newT<BenchTreeNode>(key));
+
+    benchChecksum += tree.root()->_key;
+    zone.reset();
+    return uint64_t(count);
+  });
+
+  bench(numIterations, "ZoneTree", "Insert (random)", [&]() {
+    ZoneTree<BenchTreeNode> tree;
+    for (uint32_t key : keys)
+      tree.insert(zone.newT<BenchTreeNode>(key));
+
+    benchChecksum += tree.root()->_key;
+    zone.reset();
+    return uint64_t(count);
+  });
+
+  ZoneTree<BenchTreeNode> tree;
+  for (uint32_t key : keys)
+    tree.insert(zone.newT<BenchTreeNode>(key));
+
+  bench(numIterations, "ZoneTree", "Lookup (hit)", [&]() {
+    uint32_t sum = 0;
+    for (uint32_t key : keys)
+      sum += tree.get(key)->_key;
+
+    benchChecksum += sum;
+    return uint64_t(count);
+  });
+
+  bench(numIterations, "ZoneTree", "Lookup (miss)", [&]() {
+    uint32_t sum = 0;
+    for (uint32_t key : keys)
+      sum += uint32_t(tree.get(key + count) != nullptr);
+
+    benchChecksum += sum;
+    return uint64_t(count);
+  });
+
+  bench(numIterations, "ZoneTree", "Remove & Insert", [&]() {
+    // A removed node keeps its links, so a new node is inserted instead of it.
+    for (uint32_t key : keys) {
+      tree.remove(tree.get(key));
+      tree.insert(zone.newT<BenchTreeNode>(key));
+    }
+
+    benchChecksum += tree.root()->_key;
+    return uint64_t(count) * 3u;
+  });
+}
+
+int main(int argc, char* argv[]) {
+  CmdLine cmdLine(argc, argv);
+  uint32_t numIterations = 100;
+  uint32_t count = 100000;
+
+  printf("AsmJit Zone Performance Suite v%u.%u.%u:\n\n",
+    unsigned((ASMJIT_LIBRARY_VERSION >> 16)       ),
+    unsigned((ASMJIT_LIBRARY_VERSION >>  8) & 0xFF),
+    unsigned((ASMJIT_LIBRARY_VERSION      ) & 0xFF));
+
+  printf("Usage:\n");
+  printf("  --help        Show usage only\n");
+  printf("  --quick       Decrease the number of iterations to make tests quicker\n");
+  printf("  --count=<N>   Number of operations of each iteration (%u by default)\n", count);
+  printf("  --test=<NAME> Select container to benchmark ('all' by default)\n");
+  printf("\n");
+
+  if (cmdLine.hasArg("--help"))
+    return 0;
+
+  if (cmdLine.hasArg("--quick"))
+    numIterations = 5;
+
+  count = Support::max(cmdLine.valueAsUInt("--count", count), 64u);
+  const char* test = cmdLine.valueOf("--test", "all");
+
+  auto shouldRun = [&](const char* name) noexcept {
+    return strcmp(test, "all") == 0 || strcmp(test, name) == 0;
+  };
+
+  if (shouldRun("zone"))
+    benchZone(numIterations, count);
+
+  if (shouldRun("allocator"))
+    benchZoneAllocator(numIterations, count);
+
+  if (shouldRun("vector"))
+    benchZoneVector(numIterations, count);
+
+  if (shouldRun("bitvector"))
+    benchZoneBitVector(numIterations, count);
+
+  if (shouldRun("hash"))
+    benchZoneHash(numIterations, count);
+
+  if (shouldRun("tree"))
+    benchZoneTree(numIterations, count);
+
+  printf("\nChecksum: %llu\n", (unsigned long long)benchChecksum);
+  return 0;
+}
@@ -0,0 +1,630 @@
+// This file is part of AsmJit project <https://asmjit.com>
+//
+// See asmjit.h or LICENSE.md for license and copyright information
+// SPDX-License-Identifier: Zlib
+
+// ----------------------------------------------------------------------------
+// Unit tests of JitRuntime and related features that need to execute the
+// generated code, which is only possible on the host architecture.
+// ----------------------------------------------------------------------------
+
+#include <asmjit/core.h>
+
+#if !defined(ASMJIT_NO_X86) && !defined(ASMJIT_NO_JIT) && ASMJIT_ARCH_X86
+#include <asmjit/x86.h>
+
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+#include "broken.h"
+
+using namespace asmjit;
+
+// Tests whether `ptr` is within any page that contains [start, start + size).
+static bool isWithinPages(const uint8_t* ptr, const uint8_t* start, size_t size) {
+  size_t pageMask = ~size_t(VirtMem::info().pageSize - 1);
+  uintptr_t firstPage = uintptr_t(start) & pageMask;
+  uintptr_t lastPage = (uintptr_t(start) + Support::max<size_t>(size, 1u) - 1u) & pageMask;
+  uintptr_t page = uintptr_t(ptr) & pageMask;
+  return page >= firstPage && page <= lastPage;
+}
+
+// JitRuntime - Separate Data Sections
+// ===================================
+
+UNIT(jit_runtime_data_sections) {
+  typedef size_t (*Func)(void);
+
+  INFO("Verifying whether a writable .data section is placed outside of the code");
+  {
+    JitRuntime rt(nullptr, JitRuntimeOptions::kSeparateDataSections);
+    CodeHolder code;
+    code.init(rt.environment());
+
+    Section* dataSection;
+    EXPECT(code.newSection(&dataSection, ".data", SIZE_MAX, SectionFlags::kNone, 8) == kErrorOk);
+
+    x86::Assembler a(&code);
+    Label counter = a.newLabel();
+
+    a.mov(a.zax(), x86::ptr(counter));
+    a.inc(a.zax());
+    a.mov(x86::ptr(counter), a.zax());
+    a.ret();
+
+    a.section(dataSection);
+    a.bind(counter);
+    a.embedUInt64(0);
+
+    Func fn;
+    EXPECT(rt.add(&fn, &code) == kErrorOk);
+
+    uint8_t* codePtr = reinterpret_cast<uint8_t*>(fn);
+    uint8_t* dataPtr = codePtr + (dataSection->offset() - code.textSection()->offset());
+
+    EXPECT(!isWithinPages(dataPtr, codePtr, size_t(code.textSection()->realSize())));
+    EXPECT(fn() == 1u);
+    EXPECT(fn() == 2u);
+    EXPECT(fn() == 3u);
+    EXPECT(rt.release(fn) == kErrorOk);
+  }
+
+#ifndef ASMJIT_NO_COMPILER
+  INFO("Verifying whether constant pools of Compiler are placed outside of the code");
+  {
+    typedef uint64_t (*ConstFunc)(void);
+
+    JitRuntime rt(nullptr, JitRuntimeOptions::kSeparateDataSections);
+    CodeHolder code;
+    code.init(rt.environment());
+
+    Section* dataSection;
+    EXPECT(code.newSection(&dataSection, ".rodata", SIZE_MAX, SectionFlags::kReadOnly, 8) == kErrorOk);
+
+    x86::Compiler cc(&code);
+    cc.setConstPoolSection(dataSection);
+
+    cc.addFunc(FuncSignatureT<uint64_t>());
+    x86::Gp result = cc.newUInt64("result");
+
+    cc.mov(result, cc.newQWordConst(ConstPoolScope::kLocal, 0x1111111111111111u));
+    cc.add(result, cc.newQWordConst(ConstPoolScope::kGlobal, 0x2222222222222222u));
+    cc.ret(result);
+    cc.endFunc();
+
+    EXPECT(cc.finalize() == kErrorOk);
+    EXPECT(dataSection->realSize() >= 16u);
+
+    ConstFunc fn;
+    EXPECT(rt.add(&fn, &code) == kErrorOk);
+
+    uint8_t* codePtr = reinterpret_cast<uint8_t*>(fn);
+    uint8_t* dataPtr = codePtr + (dataSection->offset() - code.textSection()->offset());
+
+    EXPECT(!isWithinPages(dataPtr, codePtr, size_t(code.textSection()->realSize())));
+    EXPECT(fn() == 0x3333333333333333u);
+    EXPECT(rt.release(fn) == kErrorOk);
+  }
+#endif // !ASMJIT_NO_COMPILER
+}
+
+// JitRuntime - Arenas
+// ===================
+
+UNIT(jit_runtime_arena) {
+  typedef size_t (*Func)(void);
+
+  INFO("Verifying whether functions added to an arena are released together");
+  JitRuntime rt;
+  JitAllocator::Arena* arena;
+  EXPECT(rt.newArena(&arena) == kErrorOk);
+
+  Func funcs[100];
+  for (size_t i = 0; i < ASMJIT_ARRAY_SIZE(funcs); i++) {
+    CodeHolder code;
+    code.init(rt.environment());
+
+    x86::Assembler a(&code);
+    a.mov(a.zax(), i);
+    a.ret();
+
+    EXPECT(rt.add(&funcs[i], &code, arena) == kErrorOk);
+  }
+
+  for (size_t i = 0; i < ASMJIT_ARRAY_SIZE(funcs); i++)
+    EXPECT(funcs[i]() == i, "Function #%zu returned incorrect result", i);
+
+  EXPECT(rt.releaseArena(arena) == kErrorOk);
+  EXPECT(rt.allocator()->statistics().allocationCount() == 0u);
+}
+
+// JitRuntime - Symbols
+// ====================
+
+static size_t hostAnswer() { return 100; }
+
+UNIT(jit_runtime_symbols) {
+  typedef size_t (*Func)(void);
+
+  JitRuntime rt;
+  Func jitAnswer;
+  Func caller;
+  Func tail;
+
+  {
+    CodeHolder code;
+    code.init(rt.environment());
+
+    x86::Assembler a(&code);
+    a.mov(a.zax(), 42);
+    a.ret();
+
+    EXPECT(rt.add(&jitAnswer, &code) == kErrorOk);
+  }
+
+  INFO("Verifying whether symbols can be added only once");
+  EXPECT(rt.addSymbol("jitAnswer", jitAnswer) == kErrorOk);
+  EXPECT(rt.addSymbol("hostAnswer", hostAnswer) == kErrorOk);
+  EXPECT(rt.addSymbol("jitAnswer", jitAnswer) == kErrorLabelAlreadyDefined);
+
+  // The host function is usually out of reach of `call rel32` on 64-bit targets, so such call goes through a veneer.
+  INFO("Verifying whether functions can call symbols through external labels");
+  {
+    CodeHolder code;
+    code.init(rt.environment());
+
+    x86::Assembler a(&code);
+    bool is64Bit = code.environment().is64Bit();
+
+    // Keep the stack aligned to 16 bytes and reserve a shadow space on Windows.
+    int32_t frameSize = is64Bit ? 40 : 28;
+    int32_t slot = is64Bit ? 32 : 16;
+
+    a.sub(a.zsp(), frameSize);
+    a.call(a.newExternalLabel("jitAnswer"));
+    a.mov(x86::ptr(a.zsp(), slot), a.zax());
+    a.call(a.newExternalLabel("hostAnswer"));
+    a.add(a.zax(), x86::ptr(a.zsp(), slot));
+    a.add(a.zsp(), frameSize);
+    a.ret();
+
+    EXPECT(rt.add(&caller, &code) == kErrorOk);
+  }
+
+  {
+    CodeHolder code;
+    code.init(rt.environment());
+
+    x86::Assembler a(&code);
+    a.jmp(a.newExternalLabel("jitAnswer"));
+
+    EXPECT(rt.add(&tail, &code) == kErrorOk);
+  }
+
+  EXPECT(caller() == 142u);
+  EXPECT(tail() == 42u);
+
+  INFO("Verifying whether code referencing an undefined symbol is rejected");
+  {
+    CodeHolder code;
+    code.init(rt.environment());
+
+    x86::Assembler a(&code);
+    a.jmp(a.newExternalLabel("missing"));
+
+    Func missing;
+    EXPECT(rt.add(&missing, &code) == kErrorSymbolNotFound);
+  }
+
+  INFO("Verifying whether add() leaves CodeHolder intact so it can be added again");
+  {
+    CodeHolder code;
+    code.init(rt.environment());
+
+    x86::Assembler a(&code);
+    Label data = a.newLabel();
+    Label address = a.newExternalLabel("lateAnswer");
+
+    a.sub(a.zsp(), code.environment().is64Bit() ? 8 : 12);
+    a.call(address);
+    a.add(a.zax(), x86::ptr(data));
+    a.add(a.zsp(), code.environment().is64Bit() ? 8 : 12);
+    a.ret();
+    a.align(AlignMode::kData, 8);
+    a.bind(data);
+    a.embedLabel(address);
+
+    Func late[2];
+    EXPECT(rt.add(&late[0], &code) == kErrorSymbolNotFound);
+    EXPECT(code.sectionCount() == 1u);
+
+    EXPECT(rt.addSymbol("lateAnswer", hostAnswer) == kErrorOk);
+    for (Func& fn : late)
+      EXPECT(rt.add(&fn, &code) == kErrorOk);
+
+    size_t expected = size_t(100) + size_t(uintptr_t((void*)hostAnswer));
+    EXPECT(late[0]() == expected);
+    EXPECT(late[1]() == expected);
+    EXPECT(code.sectionCount() == 1u);
+  }
+
+  INFO("Verifying whether symbols can be removed");
+  EXPECT(rt.removeSymbol("jitAnswer") == kErrorOk);
+  EXPECT(rt.symbolAddress("jitAnswer") == nullptr);
+  EXPECT(rt.symbolAddress("hostAnswer") == (const void*)hostAnswer);
+}
+
+// JitRuntime - Stack Maps
+// =======================
+
+// Emits a function that calls itself twice (it's never executed) and records a stack map of each call site, which
+// consists of a single entry that describes a value of `virtId` in a register. The function ends with the second
+// call, so its return address is the end of the function.
+static void emitStackMapFunction(CodeHolder& code, uint32_t virtId, Label* sitesOut) {
+  x86::Assembler a(&code);
+  Label entry = a.newLabel();
+
+  a.bind(entry);
+  for (uint32_t i = 0; i < 2; i++) {
+    sitesOut[i] = a.newLabel();
+    a.call(entry);
+    a.bind(sitesOut[i]);
+  }
+
+  StackMapEntry mapEntry {};
+  mapEntry._virtId = virtId;
+  mapEntry._location = StackMapLocation::kReg;
+  mapEntry._regGroup = RegGroup::kGp;
+  mapEntry._regId = uint8_t(x86::Gp::kIdBx);
+
+  for (uint32_t i = 0; i < 2; i++)
+    EXPECT(code.addStackMap(sitesOut[i], &mapEntry, 1) == kErrorOk);
+}
+
+// Tests whether a stack map of a call site that returns to `returnAddress` describes a value of `virtId`.
+static bool hasStackMap(const JitRuntime& rt, const void* returnAddress, uint32_t virtId) {
+  const StackMapEntry* entries;
+  uint32_t count;
+  return rt.findStackMap(returnAddress, &entries, &count) && count == 1 && entries[0].virtId() == virtId;
+}
+
+UNIT(jit_runtime_stack_maps) {
+  JitRuntime rt;
+  Label sites[2];
+
+  INFO("Verifying whether stack maps are retained until the function is released");
+  {
+    CodeHolder code;
+    code.init(rt.environment());
+    emitStackMapFunction(code, 1, sites);
+
+    void* fn;
+    EXPECT(rt._add(&fn, &code) == kErrorOk);
+
+    const uint8_t* start = static_cast<const uint8_t*>(fn);
+    for (uint32_t i = 0; i < 2; i++)
+      EXPECT(hasStackMap(rt, start + code.labelOffsetFromBase(sites[i]), 1));
+
+    EXPECT(code.labelOffsetFromBase(sites[1]) == code.codeSize());
+    EXPECT(!hasStackMap(rt, start, 1));
+
+    EXPECT(rt._release(fn) == kErrorOk);
+    EXPECT(!hasStackMap(rt, start + code.labelOffsetFromBase(sites[0]), 1));
+  }
+
+  INFO("Verifying whether stack maps of functions added to an arena are retained until the arena is released");
+  {
+    JitAllocator::Arena* arena;
+    EXPECT(rt.newArena(&arena) == kErrorOk);
+
+    const uint8_t* returnAddresses[4];
+    for (uint32_t i = 0; i < 2; i++) {
+      CodeHolder code;
+      code.init(rt.environment());
+      emitStackMapFunction(code, 2 + i, sites);
+
+      void* fn;
+      EXPECT(rt._addToArena(&fn, &code, arena) == kErrorOk);
+
+      returnAddresses[i * 2 + 0] = static_cast<const uint8_t*>(fn) + code.labelOffsetFromBase(sites[0]);
+      returnAddresses[i * 2 + 1] = static_cast<const uint8_t*>(fn) + code.labelOffsetFromBase(sites[1]);
+    }
+
+    for (uint32_t i = 0; i < 4; i++)
+      EXPECT(hasStackMap(rt, returnAddresses[i], 2 + i / 2));
+
+    EXPECT(rt.releaseArena(arena) == kErrorOk);
+    for (uint32_t i = 0; i < 4; i++)
+      EXPECT(!hasStackMap(rt, returnAddresses[i], 2 + i / 2));
+  }
+}
+
+// JitModule
+// =========
+
+// Emits a function that returns `value`.
+static void emitReturnValue(CodeHolder& code, JitRuntime& rt, size_t value) {
+  code.init(rt.environment());
+
+  x86::Assembler a(&code);
+  a.mov(a.zax(), value);
+  a.ret();
+}
+
+UNIT(jit_module) {
+  typedef size_t (*Func)(void);
+
+  JitRuntime rt;
+  JitModule module(&rt);
+
+  Func caller;
+  Func leaf;
+
+  INFO("Verifying whether a function can call a function declared and added later");
+  EXPECT(module.declareFunction("leaf") == kErrorOk);
+
+  {
+    CodeHolder code;
+    code.init(rt.environment());
+
+    x86::Assembler a(&code);
+    bool is64Bit = code.environment().is64Bit();
+
+    a.sub(a.zsp(), is64Bit ? 40 : 28);
+    a.call(a.newExternalLabel("leaf"));
+    a.add(a.zax(), 10);
+    a.add(a.zsp(), is64Bit ? 40 : 28);
+    a.ret();
+
+    EXPECT(module.addFunction(&caller, "caller", &code) == kErrorOk);
+  }
+
+  {
+    CodeHolder code;
+    emitReturnValue(code, rt, 1);
+    EXPECT(module.addFunction(&leaf, "leaf", &code) == kErrorOk);
+  }
+
+  EXPECT(caller() == 11u);
+
+  INFO("Verifying whether a replaced function is called without relinking its caller");
+  {
+    CodeHolder code;
+    emitReturnValue(code, rt, 2);
+    EXPECT(module.replaceFunction("leaf", &code) == kErrorOk);
+  }
+
+  EXPECT(caller() == 12u);
+  EXPECT(leaf() == 2u);
+
+  INFO("Verifying whether the previous code of a replaced function is retired until released");
+  size_t allocationCount = rt.allocator()->statistics().allocationCount();
+  EXPECT(module.retiredCount() == 1u);
+
+  module.releaseRetired();
+  EXPECT(module.retiredCount() == 0u);
+  EXPECT(rt.allocator()->statistics().allocationCount() == allocationCount - 1u);
+
+  {
+    CodeHolder code;
+    emitReturnValue(code, rt, 3);
+    EXPECT(module.addFunction(&leaf, "leaf", &code) == kErrorLabelAlreadyDefined);
+  }
+
+  module.reset();
+  EXPECT(rt.symbolAddress("leaf") == nullptr);
+  EXPECT(rt.allocator()->statistics().allocationCount() == 0u);
+}
+
+// CodeHolder - Thread Safety
+// ==========================
+
+UNIT(code_holder_thread_safe) {
+  constexpr uint32_t kThreadCount = 4;
+  constexpr uint32_t kLocalLabelCount = 1000;
+
+  JitRuntime rt;
+  CodeHolder code;
+  code.init(rt.environment());
+  code.setThreadSafe(true);
+
+  Section* sections[kThreadCount];
+  Label entries[kThreadCount];
+  std::vector<x86::Assembler*> assemblers;
+
+  for (uint32_t i = 0; i < kThreadCount; i++) {
+    if (i == 0) {
+      sections[i] = code.textSection();
+    }
+    else {
+      char name[16];
+      snprintf(name, sizeof(name), ".text%u", i);
+      EXPECT(code.newSection(&sections[i], name, SIZE_MAX, SectionFlags::kExecutable, 16) == kErrorOk);
+    }
+
+    // Emitters must be attached before they are used concurrently.
+    x86::Assembler* a = new x86::Assembler(&code);
+    a->section(sections[i]);
+    entries[i] = a->newLabel();
+    assemblers.push_back(a);
+  }
+
+  // Each thread emits a function into its own section, which calls a function emitted by another thread into another
+  // section. Threads also create and bind many local labels concurrently.
+  INFO("Verifying whether threads can emit code into separate sections of one CodeHolder");
+  std::vector<std::thread> threads;
+  for (uint32_t i = 0; i < kThreadCount; i++) {
+    threads.emplace_back([&, i]() {
+      x86::Assembler& a = *assemblers[i];
+      a.bind(entries[i]);
+
+      for (uint32_t j = 0; j < kLocalLabelCount; j++) {
+        Label local = a.newLabel();
+        a.jmp(local);
+        a.bind(local);
+      }
+
+      // Function `i` returns the sum of all function indexes up to `i`.
+      if (i == 0) {
+        a.xor_(x86::eax, x86::eax);
+      }
+      else {
+        a.call(entries[i - 1]);
+        a.add(a.zax(), i);
+      }
+      a.ret();
+    });
+  }
+
+  for (std::thread& thread : threads)
+    thread.join();
+
+  for (x86::Assembler* a : assemblers)
+    delete a;
+
+  typedef size_t (*Func)(void);
+  Func fn;
+  EXPECT(rt.add(&fn, &code) == kErrorOk);
+
+  size_t result = ptr_as_func<Func>((uint8_t*)(void*)fn + code.labelOffsetFromBase(entries[kThreadCount - 1]))();
+  EXPECT(result == (kThreadCount - 1) * kThreadCount / 2);
+  EXPECT(code.labelCount() == kThreadCount * (kLocalLabelCount + 1));
+}
+
+// CodeBuffer - Segmented Buffer
+// =============================
+
+// Emits a function that spans many segments of a segmented buffer - it sums values embedded at its end, which are
+// reached by a forward jump emitted into the first segment.
+static void emitSegmentedFunction(CodeHolder& code, uint32_t count) {
+  x86::Assembler a(&code);
+  Label done = a.newLabel();
+  Label data = a.newLabel();
+
+  a.xor_(x86::eax, x86::eax);
+  a.lea(a.zcx(), x86::ptr(data));
+
+  for (uint32_t i = 0; i < count; i++) {
+    Label next = a.newLabel();
+    a.add(x86::eax, x86::dword_ptr(a.zcx(), int32_t((i % 4) * 4)));
+    a.jmp(next);
+    a.int3();
+    a.bind(next);
+  }
+
+  a.jmp(done);
+  a.align(AlignMode::kData, 4);
+  a.bind(data);
+  for (uint32_t i = 0; i < 4; i++)
+    a.embedUInt32(i + 1);
+  a.bind(done);
+  a.ret();
+}
+
+UNIT(code_buffer_segmented) {
+  constexpr uint32_t kCount = 4000;
+
+  JitRuntime rt;
+  CodeHolder contiguous;
+  CodeHolder segmented;
+
+  contiguous.init(rt.environment());
+  segmented.init(rt.environment());
+  segmented.setBufferSegmentSize(4096);
+
+  emitSegmentedFunction(contiguous, kCount);
+  emitSegmentedFunction(segmented, kCount);
+
+  INFO("Verifying whether only the buffer with the segment size set is segmented");
+  const CodeBuffer& buffer = segmented.textSection()->buffer();
+  EXPECT(!contiguous.textSection()->buffer().isSegmented());
+  EXPECT(buffer.isSegmented());
+
+  INFO("Verifying whether the segmented buffer matches the contiguous buffer");
+  size_t size = contiguous.textSection()->bufferSize();
+  std::vector<uint8_t> expected(size);
+  std::vector<uint8_t> actual(size);
+
+  EXPECT(contiguous.copySectionData(expected.data(), size, 0) == kErrorOk);
+  EXPECT(segmented.copySectionData(actual.data(), size, 0) == kErrorOk);
+  EXPECT(buffer.size() == size);
+  EXPECT(expected == actual);
+
+  INFO("Verifying whether the code emitted to the segmented buffer works");
+  typedef uint32_t (*Func)(void);
+  Func fn;
+
+  EXPECT(rt.add(&fn, &segmented) == kErrorOk);
+  EXPECT(fn() == kCount / 4 * 10);
+}
+
+// JitRuntime - Telemetry
+// ======================
+
+#ifndef ASMJIT_NO_COMPILER
+static void emitTelemetryFunction(CodeHolder& code) {
+  x86::Compiler cc(&code);
+  cc.addFunc(FuncSignatureT<uint32_t>());
+
+  x86::Gp x = cc.newUInt32("x");
+  cc.mov(x, 42);
+  cc.ret(x);
+
+  cc.endFunc();
+  EXPECT(cc.finalize() == kErrorOk);
+}
+
+UNIT(jit_runtime_telemetry) {
+  typedef uint32_t (*Func)(void);
+
+  JitRuntime rt;
+  TelemetryAggregator codeTelemetry;
+  TelemetryAggregator rtTelemetry;
+  rt.setTelemetrySink(&rtTelemetry);
+
+  Func fn;
+  CodeHolder code;
+  code.init(rt.environment());
+  code.setTelemetrySink(&codeTelemetry);
+  emitTelemetryFunction(code);
+
+  EXPECT(rt.add(&fn, &code) == kErrorOk);
+  EXPECT(fn() == 42u);
+
+  static const TelemetryStage codeStages[] = {
+    TelemetryStage::kRunPasses, TelemetryStage::kRunPass, TelemetryStage::kSerialize,
+    TelemetryStage::kFlatten, TelemetryStage::kResolveLinks, TelemetryStage::kRelocate
+  };
+
+  static const TelemetryStage jitStages[] = {
+    TelemetryStage::kJitAdd, TelemetryStage::kJitAlloc, TelemetryStage::kJitCopy, TelemetryStage::kJitFlush
+  };
+
+  INFO("Verifying whether stages of CodeHolder are only reported to its own sink");
+  for (TelemetryStage stage : codeStages) {
+    EXPECT(codeTelemetry.statistics(stage).count != 0u, "Stage '%s' not reported", TelemetrySink::stageName(stage));
+    EXPECT(rtTelemetry.statistics(stage).count == 0u, "Stage '%s' reported", TelemetrySink::stageName(stage));
+  }
+
+  INFO("Verifying whether stages of JitRuntime are only reported to its own sink");
+  for (TelemetryStage stage : jitStages) {
+    EXPECT(rtTelemetry.statistics(stage).count != 0u, "Stage '%s' not reported", TelemetrySink::stageName(stage));
+    EXPECT(codeTelemetry.statistics(stage).count == 0u, "Stage '%s' reported", TelemetrySink::stageName(stage));
+  }
+
+  EXPECT(codeTelemetry.statistics(TelemetryStage::kSerialize).byteCount != 0u);
+  EXPECT(rtTelemetry.statistics(TelemetryStage::kJitAdd).byteCount == code.codeSize());
+
+  INFO("Verifying whether stages of CodeHolder without a sink are reported to the sink of JitRuntime");
+  CodeHolder noSinkCode;
+  noSinkCode.init(rt.environment());
+  emitTelemetryFunction(noSinkCode);
+
+  EXPECT(rt.add(&fn, &noSinkCode) == kErrorOk);
+  EXPECT(rtTelemetry.statistics(TelemetryStage::kRelocate).count == 1u);
+  EXPECT(noSinkCode.telemetrySink() == nullptr);
+}
+#endif // !ASMJIT_NO_COMPILER
+
+#endif // !ASMJIT_NO_X86 && !ASMJIT_NO_JIT && ASMJIT_ARCH_X86